@@ -7,6 +7,7 @@
 #include <stddef.h>
 #include <unistd.h>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdarg>
 #include <cstdio>
@@ -29,12 +30,14 @@
 
 #include <time.h>
 #include <string.h>
+#if defined(ANDROID)
 #include <android/log.h>
 
 #include <android_native_app_glue.h>
 #include <android/native_window.h>
 #include <jni.h>
 #include <sys/system_properties.h>
+#endif
 
 inline std::string Fmt(const char* fmt, ...) {
     va_list vl;
@@ -61,4 +64,27 @@ template <typename T, size_t Size>
 constexpr size_t ArraySize(const T (&/*unused*/)[Size]) noexcept {
     return Size;
 }
+
+// CLOCK_MONOTONIC in nanoseconds, the time base for sample and frame timestamps.
+inline uint64_t MonotonicNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Writes path.tmp with writer, which returns false on a failed write, and renames it over
+// path, so a crash never leaves a torn file and readers never see half of one. On failure
+// the temporary file is removed and path is left as it was.
+inline bool WriteFileAtomically(const std::string& path, const std::function<bool(FILE*)>& writer) {
+    const std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = writer(file);
+    if (fclose(file) != 0 || !written || rename(temporary.c_str(), path.c_str()) != 0) {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
 #include "logger.h"
@@ -0,0 +1,87 @@
+#include "common.h"
+#include "dynamicresolution.h"
+
+namespace {
+const double TargetUtilization = 0.85;  // of the frame budget, leaves room for spikes
+const double OverBand = 1.05;           // scale down when smoothed GPU time is above this
+const double UnderBand = 0.85;          // consider scaling up when below this
+const int UnderFramesToGrow = 45;       // ...for this many frames in a row
+const int CooldownFrames = 10;          // GPU times lag a few frames behind a change
+const double Smoothing = 0.1;           // EWMA weight of a new GPU time
+}  // namespace
+
+void DynamicResolution::SetCeiling(float ceiling) {
+    m_ceiling = ceiling;
+    m_scale = std::min(m_scale, Upper());
+}
+
+float DynamicResolution::Upper() const { return std::max(MinScale, std::min(MaxScale, m_ceiling)); }
+
+float DynamicResolution::Quantize(float scale) const {
+    scale = std::floor(scale / ScaleQuantum) * ScaleQuantum;
+    return std::max(MinScale, std::min(Upper(), scale));
+}
+
+float DynamicResolution::Update(uint64_t gpuNs, uint64_t upscaleNs, uint64_t targetNs) {
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    m_scaleSum.fetch_add((uint64_t)(m_scale * 1000.0f), std::memory_order_relaxed);
+
+    // Only fresh timings count; the plugin repeats the last one until a new query lands.
+    if (gpuNs == 0 || targetNs == 0 || gpuNs == m_lastGpuNs) {
+        return m_scale;
+    }
+    m_lastGpuNs = gpuNs;
+    const double gpuMs = gpuNs / 1e6;
+    m_gpuMs = m_gpuMs == 0.0 ? gpuMs : m_gpuMs + Smoothing * (gpuMs - m_gpuMs);
+    if (upscaleNs != 0) {
+        const double upscaleMs = upscaleNs / 1e6;
+        m_upscaleMs = m_upscaleMs == 0.0 ? upscaleMs : m_upscaleMs + Smoothing * (upscaleMs - m_upscaleMs);
+    }
+    if (m_cooldownFrames > 0) {
+        m_cooldownFrames--;
+        return m_scale;
+    }
+
+    const double targetMs = targetNs / 1e6 * TargetUtilization;
+    const double load = m_gpuMs / targetMs;
+    // Rendering time goes with pixel count, i.e. with scale squared; any scale below the
+    // maximum pays for the upscale on top.
+    const double renderMs = std::max(0.0, m_gpuMs - UpscaleMs(m_scale));
+    float scale = m_scale;
+    if (load > OverBand) {
+        const double budgetMs = targetMs - m_upscaleMs;
+        scale = budgetMs > 0.0 && renderMs > 0.0 ? Quantize(m_scale * (float)std::sqrt(budgetMs / renderMs))
+                                                 : MinScale;
+        m_underFrames = 0;
+    } else if (load < UnderBand) {
+        if (++m_underFrames >= UnderFramesToGrow) {
+            scale = Quantize(m_scale + ScaleQuantum);
+            m_underFrames = 0;
+        }
+    } else {
+        m_underFrames = 0;
+    }
+
+    if (scale != m_scale) {
+        // Pretend the new scale was already in effect so the next decision is not made on
+        // timings of the old one.
+        m_gpuMs = renderMs * (scale * scale) / (m_scale * m_scale) + UpscaleMs(scale);
+        m_scale = scale;
+        m_cooldownFrames = CooldownFrames;
+        m_changes.fetch_add(1, std::memory_order_relaxed);
+    }
+    return m_scale;
+}
+
+void DynamicResolution::Report(std::ostringstream& out, double /*elapsedSeconds*/) {
+    const uint64_t frames = m_frames.load(std::memory_order_relaxed);
+    const uint64_t scaleSum = m_scaleSum.load(std::memory_order_relaxed);
+    const uint64_t changes = m_changes.load(std::memory_order_relaxed);
+    if (frames > m_reportedFrames) {
+        out << "avgScale=" << (scaleSum - m_reportedScaleSum) / 1000.0 / (frames - m_reportedFrames);
+    }
+    out << " changes=" << (changes - m_reportedChanges);
+    m_reportedFrames = frames;
+    m_reportedScaleSum = scaleSum;
+    m_reportedChanges = changes;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+
+// Picks the per-frame render scale from GPU time. Scale is relative to the eye buffers,
+// which are allocated once at the recommended size: 1 renders straight into them, anything
+// in [MinScale, 1) renders a smaller viewport that the plugin then upscales. The upscale
+// costs about the same at any scale, so it is tracked apart from the rendering time, which
+// goes with pixel count.
+//
+// GPU time is smoothed, and the scale only moves when the smoothed time leaves a band
+// around the target utilization: down at once (proportionally) when over, up one step at a
+// time after the time has stayed well under for a while. Scales are quantized, so tiny
+// corrections do not shuffle the viewport every frame.
+class DynamicResolution {
+public:
+    static constexpr float MinScale = 0.6f;
+    static constexpr float MaxScale = 1.0f;
+    static constexpr float ScaleQuantum = 1.0f / 32.0f;
+
+    // Upper bound from the performance governor; at most MaxScale.
+    void SetCeiling(float ceiling);
+
+    // gpuNs is the latest known GPU frame time (0 if none) and upscaleNs the part of it
+    // spent upscaling; returns the scale for this frame.
+    float Update(uint64_t gpuNs, uint64_t upscaleNs, uint64_t targetNs);
+
+    float Scale() const { return m_scale; }
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    float Quantize(float scale) const;
+    float Upper() const;
+    double UpscaleMs(float scale) const { return scale < MaxScale ? m_upscaleMs : 0.0; }
+
+    float m_ceiling{1.0f};
+    float m_scale{1.0f};
+    double m_gpuMs{0.0};
+    double m_upscaleMs{0.0};  // last known upscale time, kept while rendering at full size
+    uint64_t m_lastGpuNs{0};
+    int m_underFrames{0};
+    int m_cooldownFrames{0};
+
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_scaleSum{0};  // scale * 1000, summed over frames
+    std::atomic<uint64_t> m_changes{0};
+    uint64_t m_reportedFrames{0};
+    uint64_t m_reportedScaleSum{0};
+    uint64_t m_reportedChanges{0};
+};
@@ -0,0 +1,61 @@
+#include "common.h"
+#include "eventqueue.h"
+
+EventQueue::EventQueue(Poll poll) : m_poll(poll) {
+    for (int i = 0; i < Capacity; i++) {
+        m_pointers[i] = &m_slots[i].event;
+    }
+}
+
+void EventQueue::Subscribe(PxrStructureType type, Handler handler) {
+    if (type <= PXR_TYPE_UNKNOWN || type >= TypeCount) {
+        Log::Write(Log::Level::Error, Fmt("EventQueue: cannot subscribe to event type %d", type));
+        return;
+    }
+    m_handlers[type].push_back(std::move(handler));
+}
+
+int EventQueue::Dispatch() {
+    int total = 0;
+    for (int poll = 0; poll < MaxPollsPerDispatch; poll++) {
+        int count = 0;
+        if (!m_poll(Capacity, &count, m_pointers) || count <= 0) {
+            break;
+        }
+        count = std::min(count, Capacity);
+        total += count;
+        for (int i = 0; i < count; i++) {
+            const PxrEventDataBuffer& event = *m_pointers[i];
+            const int type = event.type;
+            if (type == PXR_TYPE_EVENT_DATA_EVENTS_LOST) {
+                m_lost.fetch_add(As<PxrEventDataEventsLost>(event).lostEventCount, std::memory_order_relaxed);
+            }
+            if (type <= PXR_TYPE_UNKNOWN || type >= TypeCount || m_handlers[type].empty()) {
+                m_unhandled.fetch_add(1, std::memory_order_relaxed);
+                if (type > PXR_TYPE_UNKNOWN && type < TypeCount && !m_unhandledLogged[type]) {
+                    m_unhandledLogged[type] = true;
+                    Log::Write(Log::Level::Info, Fmt("EventQueue: no handler for event type %d", type));
+                }
+                continue;
+            }
+            for (const Handler& handler : m_handlers[type]) {
+                handler(event);
+            }
+        }
+        if (count < Capacity) {
+            break;
+        }
+        m_fullPolls.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_received.fetch_add(total, std::memory_order_relaxed);
+    return total;
+}
+
+void EventQueue::Report(std::ostringstream& out, double elapsedSeconds) {
+    const uint64_t received = m_received.load(std::memory_order_relaxed);
+    out << "events/s=" << (received - m_reportedReceived) / elapsedSeconds
+        << " unhandled=" << m_unhandled.load(std::memory_order_relaxed)
+        << " lost=" << m_lost.load(std::memory_order_relaxed)
+        << " fullPolls=" << m_fullPolls.load(std::memory_order_relaxed);
+    m_reportedReceived = received;
+}
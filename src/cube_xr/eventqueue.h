@@ -0,0 +1,92 @@
+#pragma once
+#include "pxr/PxrApi.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <vector>
+
+// The event struct the runtime writes for each PxrStructureType.
+template <typename T> struct EventType;
+#define EVENT_TYPE(STRUCT, TYPE) \
+    template <> struct EventType<STRUCT> { static const PxrStructureType value = TYPE; };
+EVENT_TYPE(PxrEventDataInstanceLossPending, PXR_TYPE_EVENT_DATA_INSTANCE_LOSS_PENDING)
+EVENT_TYPE(PxrEventDataSessionStateChanged, PXR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED)
+EVENT_TYPE(PxrEventDataEventsLost, PXR_TYPE_EVENT_DATA_EVENTS_LOST)
+EVENT_TYPE(PxrEventDataInteractionProfileChanged, PXR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED)
+EVENT_TYPE(PxrEventDataPerfSettings, PXR_TYPE_EVENT_DATA_PERF_SETTINGS_EXT)
+EVENT_TYPE(PxrEventDataControllerChanged, PXR_TYPE_EVENT_DATA_CONTROLLER)
+EVENT_TYPE(PxrEventDataSessionReady, PXR_TYPE_EVENT_DATA_SESSION_STATE_READY)
+EVENT_TYPE(PxrEventDataSessionStopping, PXR_TYPE_EVENT_DATA_SESSION_STATE_STOPPING)
+EVENT_TYPE(PxrEventDataSeethroughStateChanged, PXR_TYPE_EVENT_DATA_SEETHROUGH_STATE_CHANGED)
+EVENT_TYPE(PxrEventDataHardIPDStateChanged, PXR_TYPE_EVENT_HARDIPD_STATE_CHANGED)
+EVENT_TYPE(PxrEventDataFoveationLevelChanged, PXR_TYPE_EVENT_FOVEATION_LEVEL_CHANGED)
+EVENT_TYPE(PxrEventDataFrustumChanged, PXR_TYPE_EVENT_FRUSTUM_STATE_CHANGED)
+EVENT_TYPE(PxrEventDataRenderTextureChanged, PXR_TYPE_EVENT_RENDER_TEXTURE_CHANGED)
+EVENT_TYPE(PxrEventDataTargetFrameRateChanged, PXR_TYPE_EVENT_TARGET_FRAME_RATE_STATE_CHANGED)
+EVENT_TYPE(PxrEventDataHmdKey, PXR_TYPE_EVENT_DATA_HMD_KEY)
+EVENT_TYPE(PxrEventDataMrcStatusChanged, PXR_TYPE_EVENT_DATA_MRC_STATUS)
+EVENT_TYPE(PxrEventDataRefreshRateChanged, PXR_TYPE_EVENT_DATA_REFRESH_RATE_CHANGED)
+EVENT_TYPE(PXrEventDataMainSessionVisibilityChangedEXTX, PXR_TYPE_EVENT_DATA_MAIN_SESSION_VISIBILITY_CHANGED_EXTX)
+#undef EVENT_TYPE
+
+// Receives runtime events into buffers allocated once with the queue and routes each to
+// the handlers subscribed to its type, through a table indexed by PxrStructureType.
+// Handlers get a typed view of the runtime's buffer, not a copy; it is only valid during
+// the call.
+class EventQueue {
+public:
+    static constexpr int Capacity = 20;   // events fetched per Pxr_PollEvent call
+    static constexpr int MaxPollsPerDispatch = 4;
+    static constexpr int TypeCount = PXR_TYPE_EVENT_DATA_MAIN_SESSION_VISIBILITY_CHANGED_EXTX + 1;
+
+    using Poll = bool (*)(int eventCountMax, int* eventCountOutput, PxrEventDataBuffer** events);
+    using Handler = std::function<void(const PxrEventDataBuffer& event)>;
+
+    explicit EventQueue(Poll poll = Pxr_PollEvent);
+
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    // The buffer seen as the event struct of its type.
+    template <typename T>
+    static const T& As(const PxrEventDataBuffer& event) {
+        static_assert(sizeof(T) <= sizeof(PxrEventDataBuffer), "event does not fit the runtime's buffer");
+        return *reinterpret_cast<const T*>(&event);
+    }
+
+    // Handlers run on the dispatching thread in subscription order. Subscribe before the
+    // first Dispatch().
+    void Subscribe(PxrStructureType type, Handler handler);
+
+    template <typename T>
+    void Subscribe(std::function<void(const T&)> handler) {
+        Subscribe(EventType<T>::value, [handler](const PxrEventDataBuffer& event) { handler(As<T>(event)); });
+    }
+
+    // Polls the runtime until it has no more events (at most MaxPollsPerDispatch rounds)
+    // and dispatches each. Returns the number of events received.
+    int Dispatch();
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    // A buffer is read as any event struct, and some of those hold 64-bit fields.
+    struct alignas(8) Slot {
+        PxrEventDataBuffer event;
+    };
+
+    Poll m_poll;
+    Slot m_slots[Capacity];
+    PxrEventDataBuffer* m_pointers[Capacity];
+    std::vector<Handler> m_handlers[TypeCount];
+
+    std::atomic<uint64_t> m_received{0};
+    std::atomic<uint64_t> m_unhandled{0};
+    std::atomic<uint64_t> m_lost{0};       // as reported by PXR_TYPE_EVENT_DATA_EVENTS_LOST
+    std::atomic<uint64_t> m_fullPolls{0};  // polls that filled every buffer, so more may have been waiting
+    bool m_unhandledLogged[TypeCount] = {};
+    uint64_t m_reportedReceived{0};
+};
@@ -0,0 +1,119 @@
+#include "common.h"
+#include "framearena.h"
+
+#include <cstdlib>
+
+namespace {
+const size_t BlockAlignment = 64;
+
+void* AlignedAlloc(size_t size, size_t alignment) {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, std::max(alignment, sizeof(void*)), std::max<size_t>(size, 1)) != 0) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+}  // namespace
+
+FrameArena::FrameArena(size_t capacity) : m_block((uint8_t*)AlignedAlloc(capacity, BlockAlignment)), m_capacity(capacity) {}
+
+FrameArena::~FrameArena() {
+    // Not Reset(): that would grow the block after a spill, allocating on the way out.
+    for (void* spill : m_spills) {
+        free(spill);
+    }
+    free(m_block);
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+    const size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+    if (offset + size <= m_capacity) {
+        m_offset = offset + size;
+        if (m_offset > m_highWater.load(std::memory_order_relaxed)) {
+            m_highWater.store(m_offset, std::memory_order_relaxed);
+        }
+        return m_block + offset;
+    }
+
+    // Out of space for this frame: spill to the heap and grow on the next Reset().
+    void* memory = AlignedAlloc(size, alignment);
+    m_spills.push_back(memory);
+    m_spilledBytes += size + alignment;
+    m_overflows.fetch_add(1, std::memory_order_relaxed);
+    return memory;
+}
+
+void FrameArena::Reset() {
+    for (void* spill : m_spills) {
+        free(spill);
+    }
+    m_spills.clear();
+
+    if (m_spilledBytes > 0) {
+        const size_t capacity = (m_capacity + m_spilledBytes) * 3 / 2;
+        Log::Write(Log::Level::Warning, Fmt("FrameArena: growing from %zu to %zu bytes", m_capacity, capacity));
+        free(m_block);
+        m_block = (uint8_t*)AlignedAlloc(capacity, BlockAlignment);
+        m_capacity = capacity;
+        m_spilledBytes = 0;
+    }
+    m_offset = 0;
+}
+
+#if defined(ETVR_COUNT_HEAP_ALLOCATIONS)
+namespace {
+thread_local uint64_t t_heapAllocations = 0;
+}
+
+uint64_t ThreadHeapAllocationCount() { return t_heapAllocations; }
+
+namespace {
+void* CountedAlloc(size_t size, size_t alignment) noexcept {
+    t_heapAllocations++;
+    void* memory = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        memory = malloc(size ? size : 1);
+    } else if (posix_memalign(&memory, alignment, size ? size : 1) != 0) {
+        memory = nullptr;
+    }
+    return memory;
+}
+
+void* CountedAllocOrThrow(size_t size, size_t alignment) {
+    if (void* memory = CountedAlloc(size, alignment)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+}  // namespace
+
+// Every replaceable form is covered, so aligned and nothrow allocations are counted too;
+// all of them come from malloc / posix_memalign and go back through free().
+void* operator new(size_t size) { return CountedAllocOrThrow(size, 0); }
+void* operator new[](size_t size) { return CountedAllocOrThrow(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return CountedAllocOrThrow(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return CountedAllocOrThrow(size, (size_t)alignment); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, (size_t)alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, (size_t)alignment);
+}
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { free(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { free(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { free(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { free(memory); }
+#else
+uint64_t ThreadHeapAllocationCount() { return 0; }
+#endif
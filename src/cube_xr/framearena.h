@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define FRAME_ARENA_HAS_PMR 1
+#endif
+
+// Bump allocator for data that only lives for one frame. Allocation is a pointer bump,
+// deallocation is a no-op and Reset() releases everything at once. Requests that don't
+// fit spill to the heap; the spill is remembered so the next Reset() can grow the block,
+// after which steady-state frames stay off the global heap.
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity = 64 * 1024);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    void Reset();
+
+    template <typename T>
+    T* AllocateArray(size_t count) {
+        T* items = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; i++) {
+            new (&items[i]) T();
+        }
+        return items;
+    }
+
+    size_t Capacity() const { return m_capacity; }
+    size_t Used() const { return m_offset; }
+    size_t HighWater() const { return m_highWater.load(std::memory_order_relaxed); }
+    uint64_t Overflows() const { return m_overflows.load(std::memory_order_relaxed); }
+
+private:
+    uint8_t* m_block{nullptr};
+    size_t m_capacity{0};
+    size_t m_offset{0};
+    size_t m_spilledBytes{0};
+    std::vector<void*> m_spills;
+    std::atomic<size_t> m_highWater{0};
+    std::atomic<uint64_t> m_overflows{0};
+};
+
+// One arena per in-flight frame. BeginFrame() recycles the arena last used FramesInFlight
+// frames ago, so data handed to the GPU or compositor for earlier frames stays valid.
+template <int FramesInFlight>
+class FrameArenaRing {
+public:
+    explicit FrameArenaRing(size_t capacity = 64 * 1024) {
+        for (auto& arena : m_arenas) {
+            arena.reset(new FrameArena(capacity));
+        }
+        m_current = m_arenas[0].get();
+    }
+
+    FrameArena& BeginFrame(uint64_t frameIndex) {
+        FrameArena& arena = *m_arenas[frameIndex % FramesInFlight];
+        arena.Reset();
+        m_current = &arena;
+        return arena;
+    }
+
+    FrameArena& Current() { return *m_current; }
+    const FrameArena& At(int index) const { return *m_arenas[index]; }
+
+private:
+    std::unique_ptr<FrameArena> m_arenas[FramesInFlight];
+    FrameArena* m_current{nullptr};
+};
+
+// Standard allocator over a FrameArena, for STL containers that live within one frame.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena& arena) noexcept : m_arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.Arena()) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(m_arena->Allocate(sizeof(T) * count, alignof(T))); }
+    void deallocate(T*, size_t) noexcept {}
+
+    FrameArena* Arena() const noexcept { return m_arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return m_arena == other.Arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return m_arena != other.Arena(); }
+
+private:
+    FrameArena* m_arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#if defined(FRAME_ARENA_HAS_PMR)
+// std::pmr adaptor, so std::pmr containers can draw from a frame arena.
+class FrameMemoryResource : public std::pmr::memory_resource {
+public:
+    explicit FrameMemoryResource(FrameArena& arena) : m_arena(&arena) {}
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override { return m_arena->Allocate(bytes, alignment); }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    FrameArena* m_arena;
+};
+#endif
+
+// Allocation-counting hook. Built with ETVR_COUNT_HEAP_ALLOCATIONS, the global operator
+// new counts calls per thread so frames can assert they did not touch the heap.
+// Otherwise it always returns 0.
+uint64_t ThreadHeapAllocationCount();
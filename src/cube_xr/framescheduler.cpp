@@ -0,0 +1,169 @@
+#include "common.h"
+#include "framescheduler.h"
+
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+namespace {
+const uint64_t NotDue = UINT64_MAX;
+const double PeriodTolerance = 0.1;   // a measured period further off the nominal one is not trusted
+const double PeriodSmoothing = 0.05;  // EWMA weight of a new period measurement
+}  // namespace
+
+FrameScheduler::~FrameScheduler() {
+    if (m_timerFd >= 0) {
+        close(m_timerFd);
+    }
+    if (m_signalFd >= 0) {
+        close(m_signalFd);
+    }
+}
+
+bool FrameScheduler::Initialize() {
+    m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    m_signalFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_timerFd < 0 || m_signalFd < 0) {
+        Log::Write(Log::Level::Error, Fmt("FrameScheduler: cannot create timerfd/eventfd: %s", strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+void FrameScheduler::Arm(Mode mode) {
+    if (mode != m_mode) {
+        m_mode = mode;
+        m_dueNs = mode == Mode::Stopped ? NotDue : 0;
+        m_lastDisplayTimeMs = 0.0;
+    }
+    ArmTimer(m_dueNs);
+}
+
+bool FrameScheduler::Due(uint64_t nowNs) const { return m_timerFd < 0 || nowNs >= m_dueNs; }
+
+void FrameScheduler::ArmTimer(uint64_t dueNs) {
+    if (m_timerFd < 0 || dueNs == m_armedNs) {
+        return;
+    }
+    // Zero disarms; a due time in the past fires at once.
+    itimerspec spec = {};
+    if (dueNs != NotDue) {
+        const uint64_t when = std::max<uint64_t>(dueNs, 1);
+        spec.it_value.tv_sec = (time_t)(when / 1000000000);
+        spec.it_value.tv_nsec = (long)(when % 1000000000);
+    }
+    timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    m_armedNs = dueNs;
+}
+
+void FrameScheduler::OnFrameStarted(uint64_t startNs, double predictedDisplayTimeMs, uint64_t nominalPeriodNs) {
+    const uint64_t nominal = nominalPeriodNs != 0 ? nominalPeriodNs : DefaultPeriodNs;
+    if (nominal != m_nominalPeriodNs) {
+        // Refresh rate changed; start over from the new nominal period.
+        m_nominalPeriodNs = m_periodNs = nominal;
+    }
+
+    // Consecutive display times are a whole number of periods apart; more than one means
+    // vsyncs went by without a frame. Their spacing also refines the period estimate.
+    if (m_lastDisplayTimeMs > 0.0 && predictedDisplayTimeMs > m_lastDisplayTimeMs) {
+        const double deltaNs = (predictedDisplayTimeMs - m_lastDisplayTimeMs) * 1e6;
+        const double periods = std::max(1.0, std::round(deltaNs / m_periodNs));
+        const double measured = deltaNs / periods;
+        if (std::fabs(measured - nominal) < nominal * PeriodTolerance) {
+            m_periodNs = (uint64_t)(m_periodNs + PeriodSmoothing * (measured - (double)m_periodNs));
+        }
+        // Vsyncs left out on purpose by the frame interval are not skips.
+        m_skippedVsyncs.fetch_add((uint64_t)std::max(0.0, periods - m_frameInterval), std::memory_order_relaxed);
+    }
+    m_lastDisplayTimeMs = predictedDisplayTimeMs;
+    m_lastStartNs = startNs;
+
+    // The runtime releases the next frame one period after this one.
+    m_dueNs = startNs + m_frameInterval * m_periodNs - std::min(WakeLeadNs, m_periodNs / 2);
+    m_frameStarted = true;
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameScheduler::SetFrameInterval(int vsyncs) {
+    vsyncs = std::max(vsyncs, 1);
+    if (vsyncs == m_frameInterval) {
+        return;
+    }
+    m_frameInterval = vsyncs;
+    if (m_mode == Mode::Running && m_lastStartNs != 0) {
+        m_dueNs = m_lastStartNs + m_frameInterval * m_periodNs - std::min(WakeLeadNs, m_periodNs / 2);
+    }
+}
+
+void FrameScheduler::WorkDone(uint64_t nowNs) {
+    if (m_mode == Mode::Idle) {
+        m_dueNs = nowNs + IdleTickNs;
+    } else if (m_mode == Mode::Running && !m_frameStarted) {
+        // The runtime did not give us a frame; try again next period rather than spinning.
+        m_dueNs = nowNs + m_periodNs;
+    }
+    m_frameStarted = false;
+}
+
+void FrameScheduler::Signal() {
+    if (m_signalFd >= 0) {
+        const uint64_t one = 1;
+        (void)!write(m_signalFd, &one, sizeof(one));
+    }
+}
+
+void FrameScheduler::Waited(uint64_t waitNs) {
+    m_wakeups.fetch_add(1, std::memory_order_relaxed);
+    m_waitNs.fetch_add(waitNs, std::memory_order_relaxed);
+}
+
+void FrameScheduler::OnTimer() {
+    uint64_t expirations;
+    (void)!read(m_timerFd, &expirations, sizeof(expirations));
+    // A one-shot timer is spent once it fired.
+    m_armedNs = 0;
+    m_timerWakeups.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameScheduler::OnSignal() {
+    uint64_t signals;
+    (void)!read(m_signalFd, &signals, sizeof(signals));
+    m_signalWakeups.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameScheduler::OnLooperEvent() { m_looperWakeups.fetch_add(1, std::memory_order_relaxed); }
+
+void FrameScheduler::AccountCpu() {
+    timespec now;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0) {
+        m_cpuNs.store((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec, std::memory_order_relaxed);
+    }
+}
+
+void FrameScheduler::Report(std::ostringstream& out, double elapsedSeconds) {
+    const uint64_t wakeups = m_wakeups.load(std::memory_order_relaxed);
+    const uint64_t timerWakeups = m_timerWakeups.load(std::memory_order_relaxed);
+    const uint64_t signalWakeups = m_signalWakeups.load(std::memory_order_relaxed);
+    const uint64_t looperWakeups = m_looperWakeups.load(std::memory_order_relaxed);
+    const uint64_t waitNs = m_waitNs.load(std::memory_order_relaxed);
+    const uint64_t cpuNs = m_cpuNs.load(std::memory_order_relaxed);
+    const uint64_t frames = m_frames.load(std::memory_order_relaxed);
+    const uint64_t skipped = m_skippedVsyncs.load(std::memory_order_relaxed);
+    const double elapsedNs = elapsedSeconds * 1e9;
+
+    out << "wakeups/s=" << (wakeups - m_reportedWakeups) / elapsedSeconds
+        << " (timer=" << (timerWakeups - m_reportedTimerWakeups) / elapsedSeconds
+        << " signal=" << (signalWakeups - m_reportedSignalWakeups) / elapsedSeconds
+        << " looper=" << (looperWakeups - m_reportedLooperWakeups) / elapsedSeconds << ")"
+        << " mainCpu%=" << 100.0 * (cpuNs - m_reportedCpuNs) / elapsedNs
+        << " blocked%=" << 100.0 * (waitNs - m_reportedWaitNs) / elapsedNs
+        << " frames/s=" << (frames - m_reportedFrames) / elapsedSeconds
+        << " skippedVsyncs=" << (skipped - m_reportedSkippedVsyncs);
+    m_reportedWakeups = wakeups;
+    m_reportedTimerWakeups = timerWakeups;
+    m_reportedSignalWakeups = signalWakeups;
+    m_reportedLooperWakeups = looperWakeups;
+    m_reportedWaitNs = waitNs;
+    m_reportedCpuNs = cpuNs;
+    m_reportedFrames = frames;
+    m_reportedSkippedVsyncs = skipped;
+}
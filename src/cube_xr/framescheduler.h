@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+
+// Decides when the main loop has work and arms a timerfd for it, so the loop can block in
+// the looper instead of polling it with a zero timeout. The loop adds TimerFd() and
+// SignalFd() to its looper and sleeps until one of them or a looper source (lifecycle,
+// input) is readable.
+//
+//  - Running: the next frame is due WakeLeadNs before the runtime is expected to release
+//    it, one display period (or frame interval) after the previous release. The period
+//    follows the predicted display times, so it tracks refresh rate changes and counts
+//    skipped vsyncs.
+//  - Idle (resumed, session not running yet): a slow tick, just to poll runtime events.
+//  - Stopped: nothing is due; only looper sources or Signal() wake the loop.
+//
+// Signal() wakes the loop from any thread (e.g. when a producer has data for it). Only
+// timerfd and eventfd are used, so the scheduler runs unchanged on desktop Linux.
+class FrameScheduler {
+public:
+    enum class Mode { Stopped, Idle, Running };
+
+    static constexpr uint64_t WakeLeadNs = 2000000;
+    static constexpr uint64_t IdleTickNs = 100000000;
+    static constexpr uint64_t DefaultPeriodNs = 1000000000 / 72;
+
+    FrameScheduler() = default;
+    ~FrameScheduler();
+
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+    // Creates the descriptors. Without them, Due() is always true and the loop degrades
+    // to the old polling behavior.
+    bool Initialize();
+    int TimerFd() const { return m_timerFd; }
+    int SignalFd() const { return m_signalFd; }
+
+    // Switches mode and (re)arms the timer for the next due time; cheap when nothing changed.
+    void Arm(Mode mode);
+    bool Due(uint64_t nowNs) const;
+
+    // The runtime released a frame at startNs for display at predictedDisplayTimeMs. Only
+    // differences of display times are used, so their clock does not matter here (the app
+    // checks it is CLOCK_MONOTONIC before keying the head pose history with them).
+    // nominalPeriodNs is the expected display period, 0 if unknown.
+    void OnFrameStarted(uint64_t startNs, double predictedDisplayTimeMs, uint64_t nominalPeriodNs);
+    // Render only every vsyncs-th display period (1 renders every one). Takes effect at once,
+    // so going back to 1 makes a frame due right away if one is overdue.
+    void SetFrameInterval(int vsyncs);
+
+    // The due work ran; schedules the next idle tick, or one period on if no frame started.
+    void WorkDone(uint64_t nowNs);
+
+    void Signal();
+
+    // Accounting, called by the loop: a blocking wait and what ended it.
+    void Waited(uint64_t waitNs);
+    void OnTimer();
+    void OnSignal();
+    void OnLooperEvent();
+    // Samples the calling thread's CPU time; call from the loop thread once per iteration.
+    void AccountCpu();
+
+    // Totals since construction: frames started, and vsyncs that went by without one.
+    uint64_t Frames() const { return m_frames.load(std::memory_order_relaxed); }
+    uint64_t SkippedVsyncs() const { return m_skippedVsyncs.load(std::memory_order_relaxed); }
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    void ArmTimer(uint64_t dueNs);
+
+    int m_timerFd{-1};
+    int m_signalFd{-1};
+    Mode m_mode{Mode::Stopped};
+    uint64_t m_dueNs{0};
+    uint64_t m_armedNs{0};
+    uint64_t m_nominalPeriodNs{DefaultPeriodNs};
+    uint64_t m_periodNs{DefaultPeriodNs};
+    double m_lastDisplayTimeMs{0.0};
+    uint64_t m_lastStartNs{0};
+    int m_frameInterval{1};
+    bool m_frameStarted{false};
+
+    std::atomic<uint64_t> m_wakeups{0};
+    std::atomic<uint64_t> m_timerWakeups{0};
+    std::atomic<uint64_t> m_signalWakeups{0};
+    std::atomic<uint64_t> m_looperWakeups{0};
+    std::atomic<uint64_t> m_waitNs{0};
+    std::atomic<uint64_t> m_cpuNs{0};
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_skippedVsyncs{0};
+    uint64_t m_reportedWakeups{0};
+    uint64_t m_reportedTimerWakeups{0};
+    uint64_t m_reportedSignalWakeups{0};
+    uint64_t m_reportedLooperWakeups{0};
+    uint64_t m_reportedWaitNs{0};
+    uint64_t m_reportedCpuNs{0};
+    uint64_t m_reportedFrames{0};
+    uint64_t m_reportedSkippedVsyncs{0};
+};
@@ -0,0 +1,413 @@
+#include "common.h"
+#include "gazecalibration.h"
+#include "simd4.h"
+
+#include <cstdio>
+
+namespace {
+const uint32_t CalibrationMagic = 0x4c414347;  // 'GCAL'
+const uint32_t CalibrationVersion = 1;
+const size_t BlockSize = 64;
+const double Degrees = 180.0 / 3.14159265358979323846;
+const float MinForward = 0.1f;   // z below which a direction is too far sideways for the plane
+const double Ridge = 1e-3;       // per target, pulling the fit towards no correction
+const int AffineTerms = 3;
+const float MinCosine = std::cos(GazeCalibration::MaxErrorDegrees / (float)Degrees);
+
+struct ProfileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t channels;
+    uint32_t terms;
+    uint64_t checksum;
+};
+
+// FNV-1a
+uint64_t Hash(const void* data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<const uint8_t*>(data)[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void Features(double u, double v, double* features) {
+    features[0] = 1.0;
+    features[1] = u;
+    features[2] = v;
+    features[3] = u * v;
+    features[4] = u * u;
+    features[5] = v * v;
+}
+
+// Solves A x = b for symmetric positive definite A, in place in the leading n x n block.
+bool Cholesky(double (&a)[GazeCalibration::Terms][GazeCalibration::Terms], int n, double* x) {
+    for (int j = 0; j < n; j++) {
+        double d = a[j][j];
+        for (int k = 0; k < j; k++) {
+            d -= a[j][k] * a[j][k];
+        }
+        if (d <= 0.0) {
+            return false;
+        }
+        a[j][j] = std::sqrt(d);
+        for (int i = j + 1; i < n; i++) {
+            double s = a[i][j];
+            for (int k = 0; k < j; k++) {
+                s -= a[i][k] * a[j][k];
+            }
+            a[i][j] = s / a[j][j];
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < i; k++) {
+            x[i] -= a[i][k] * x[k];
+        }
+        x[i] /= a[i][i];
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        for (int k = i + 1; k < n; k++) {
+            x[i] -= a[k][i] * x[k];
+        }
+        x[i] /= a[i][i];
+    }
+    return true;
+}
+
+int32_t Status(const GazeSample& sample, int channel) {
+    return channel == GazeCalibration::Left    ? sample.leftEyePoseStatus
+           : channel == GazeCalibration::Right ? sample.rightEyePoseStatus
+                                               : sample.combinedEyePoseStatus;
+}
+
+const float* Vector(const GazeSample& sample, int channel) {
+    return channel == GazeCalibration::Left    ? sample.leftEyeGazeVector
+           : channel == GazeCalibration::Right ? sample.rightEyeGazeVector
+                                               : sample.combinedEyeGazeVector;
+}
+
+float* Vector(GazeSample& sample, int channel) {
+    return const_cast<float*>(Vector(const_cast<const GazeSample&>(sample), channel));
+}
+}  // namespace
+
+struct GazeCalibration::ProfileFile {
+    ProfileHeader header;
+    Coefficients coefficients;
+};
+
+void GazeCalibration::Equations::Clear() { *this = Equations(); }
+
+void GazeCalibration::Equations::Add(const double* features, double tu, double tv) {
+    for (int i = 0; i < Terms; i++) {
+        for (int j = 0; j <= i; j++) {
+            a[i][j] += features[i] * features[j];
+        }
+        bu[i] += features[i] * tu;
+        bv[i] += features[i] * tv;
+    }
+    tt += tu * tu + tv * tv;
+    weight += 1.0;
+}
+
+void GazeCalibration::Equations::Add(const Equations& other, double scale) {
+    for (int i = 0; i < Terms; i++) {
+        for (int j = 0; j <= i; j++) {
+            a[i][j] += scale * other.a[i][j];
+        }
+        bu[i] += scale * other.bu[i];
+        bv[i] += scale * other.bv[i];
+    }
+    tt += scale * other.tt;
+    weight += scale * other.weight;
+}
+
+void GazeCalibration::BeginTarget(const float direction[3], uint64_t timeNs) {
+    const float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+    if (length <= 0.0f || direction[2] / length > -MinForward) {
+        Log::Write(Log::Level::Warning, "Gaze calibration target is not in front of the viewer");
+        m_collecting.store(false, std::memory_order_release);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (int i = 0; i < 3; i++) {
+        m_direction[i] = direction[i] / length;
+    }
+    m_target[0] = m_direction[0] / -m_direction[2];
+    m_target[1] = m_direction[1] / -m_direction[2];
+    m_targetStartNs = timeNs;
+    for (int c = 0; c < ChannelCount; c++) {
+        m_current[c].Clear();
+        m_currentSamples[c] = 0;
+    }
+    m_collecting.store(true, std::memory_order_release);
+}
+
+void GazeCalibration::AddSample(const GazeSample& sample) {
+    if (!m_collecting.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_collecting.load(std::memory_order_relaxed) || sample.timestampNs < m_targetStartNs + SettleNs) {
+        return;
+    }
+    for (int c = 0; c < ChannelCount; c++) {
+        if (!(Status(sample, c) & GAZE_STATUS_GAZE_VECTOR_VALID)) {
+            continue;
+        }
+        const float* v = Vector(sample, c);
+        const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (length <= 0.0f || v[2] / length > -MinForward ||
+            v[0] * m_direction[0] + v[1] * m_direction[1] + v[2] * m_direction[2] < MinCosine * length) {
+            continue;
+        }
+        double features[Terms];
+        Features(v[0] / -(double)v[2], v[1] / -(double)v[2], features);
+        m_current[c].Add(features, m_target[0], m_target[1]);
+        m_currentSamples[c]++;
+    }
+}
+
+bool GazeCalibration::EndTarget() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_collecting.exchange(false, std::memory_order_acq_rel)) {
+        return false;
+    }
+    bool used = false;
+    for (int c = 0; c < ChannelCount; c++) {
+        if (m_currentSamples[c] >= MinTargetSamples) {
+            m_total[c].Add(m_current[c], 1.0 / m_currentSamples[c]);
+            m_targets[c]++;
+            used = true;
+        }
+    }
+    return used;
+}
+
+void GazeCalibration::ClearTargets() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_collecting.store(false, std::memory_order_relaxed);
+    for (int c = 0; c < ChannelCount; c++) {
+        m_total[c].Clear();
+        m_targets[c] = 0;
+    }
+}
+
+bool GazeCalibration::Solve() {
+    Coefficients fit = {};
+    bool solved = false;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        for (int c = 0; c < ChannelCount; c++) {
+            // No correction unless there is something to fit.
+            fit.u[c][1] = 1.0f;
+            fit.v[c][2] = 1.0f;
+            const Equations& e = m_total[c];
+            const int n = m_targets[c] >= MinQuadraticTargets ? Terms
+                          : m_targets[c] >= MinAffineTargets  ? AffineTerms
+                                                              : 0;
+            if (n == 0) {
+                continue;
+            }
+            // (A + r I) c = b + r c0, with c0 the identity mapping.
+            const double ridge = Ridge * e.weight;
+            double a[Terms][Terms] = {};
+            double u[Terms], v[Terms];
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j <= i; j++) {
+                    a[i][j] = e.a[i][j] + (i == j ? ridge : 0.0);
+                }
+                u[i] = e.bu[i] + (i == 1 ? ridge : 0.0);
+                v[i] = e.bv[i] + (i == 2 ? ridge : 0.0);
+            }
+            double factor[Terms][Terms];
+            memcpy(factor, a, sizeof(a));
+            if (!Cholesky(factor, n, u)) {
+                continue;
+            }
+            memcpy(factor, a, sizeof(a));
+            Cholesky(factor, n, v);
+
+            // Residual sum of squares: t.t - 2 c.b + c'Ac, over both coordinates.
+            double squares = e.tt;
+            for (int i = 0; i < n; i++) {
+                squares -= 2.0 * (u[i] * e.bu[i] + v[i] * e.bv[i]);
+                for (int j = 0; j < n; j++) {
+                    const double aij = i >= j ? e.a[i][j] : e.a[j][i];
+                    squares += aij * (u[i] * u[j] + v[i] * v[j]);
+                }
+            }
+            for (int i = 0; i < n; i++) {
+                fit.u[c][i] = (float)u[i];
+                fit.v[c][i] = (float)v[i];
+            }
+            fit.residualDegrees[c] = (float)(std::atan(std::sqrt(std::max(squares, 0.0) / e.weight)) * Degrees);
+            Log::Write(Log::Level::Info, Fmt("Gaze calibration channel %d: %s fit over %u targets, %.2f deg RMS", c,
+                                             n == Terms ? "quadratic" : "affine", m_targets[c],
+                                             fit.residualDegrees[c]));
+            solved = true;
+        }
+    }
+    if (solved) {
+        Install(fit);
+    }
+    return solved;
+}
+
+void GazeCalibration::Install(const Coefficients& coefficients) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    const uint32_t generation = m_installed.load(std::memory_order_relaxed) + 1;
+    Snapshot& slot = m_snapshots[(generation - 1) & (Snapshots - 1)];
+    const uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.generation = generation;
+    slot.coefficients = coefficients;
+
+    slot.seq.store(seq + 2, std::memory_order_release);
+    m_installed.store(generation, std::memory_order_release);
+}
+
+bool GazeCalibration::Current(Coefficients* coefficients) const {
+    for (;;) {
+        const uint32_t generation = m_installed.load(std::memory_order_acquire);
+        if (generation == 0) {
+            return false;
+        }
+        const Snapshot& slot = m_snapshots[(generation - 1) & (Snapshots - 1)];
+        const uint32_t seq0 = slot.seq.load(std::memory_order_acquire);
+        if (seq0 & 1u) {
+            continue;
+        }
+        const uint32_t slotGeneration = slot.generation;
+        memcpy(coefficients, &slot.coefficients, sizeof(Coefficients));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // A slot written over since is a newer correction; start again from the latest.
+        if (slot.seq.load(std::memory_order_relaxed) == seq0 && slotGeneration == generation) {
+            return true;
+        }
+    }
+}
+
+void GazeCalibration::Apply(GazeSample* samples, size_t count) const {
+    using namespace Simd;
+    Coefficients k;
+    if (!Current(&k)) {
+        return;
+    }
+
+    alignas(16) float x[ChannelCount][BlockSize], y[ChannelCount][BlockSize], z[ChannelCount][BlockSize];
+    alignas(16) float valid[ChannelCount][BlockSize];
+    for (size_t base = 0; base < count; base += BlockSize) {
+        const size_t n = std::min(BlockSize, count - base);
+        const size_t padded = (n + 3) & ~(size_t)3;
+        for (int c = 0; c < ChannelCount; c++) {
+            for (size_t i = 0; i < padded; i++) {
+                if (i < n && (Status(samples[base + i], c) & GAZE_STATUS_GAZE_VECTOR_VALID)) {
+                    const float* v = Vector(samples[base + i], c);
+                    x[c][i] = v[0];
+                    y[c][i] = v[1];
+                    z[c][i] = v[2];
+                    valid[c][i] = 1.0f;
+                } else {
+                    x[c][i] = 0.0f;
+                    y[c][i] = 0.0f;
+                    z[c][i] = -1.0f;
+                    valid[c][i] = 0.0f;
+                }
+            }
+        }
+
+        for (int c = 0; c < ChannelCount; c++) {
+            const Float4 u0 = Splat(k.u[c][0]), u1 = Splat(k.u[c][1]), u2 = Splat(k.u[c][2]), u3 = Splat(k.u[c][3]),
+                         u4 = Splat(k.u[c][4]), u5 = Splat(k.u[c][5]);
+            const Float4 v0 = Splat(k.v[c][0]), v1 = Splat(k.v[c][1]), v2 = Splat(k.v[c][2]), v3 = Splat(k.v[c][3]),
+                         v4 = Splat(k.v[c][4]), v5 = Splat(k.v[c][5]);
+            const Float4 half = Splat(0.5f), one = Splat(1.0f);
+            for (size_t i = 0; i < padded; i += 4) {
+                // Simd::Load, as Load() here is the profile's.
+                const Float4 px = Simd::Load(x[c] + i), py = Simd::Load(y[c] + i), pz = Simd::Load(z[c] + i);
+                const Float4 length = Sqrt(px * px + py * py + pz * pz);
+                // Sideways directions have no point on the plane; they pass unchanged.
+                const Mask4 use = (half < Simd::Load(valid[c] + i)) & (pz < Splat(-MinForward) * length);
+                const Float4 scale = Reciprocal(Select(use, Splat(0.0f) - pz, one));
+                const Float4 u = px * scale, v = py * scale;
+                const Float4 uv = u * v, uu = u * u, vv = v * v;
+                const Float4 cu = u0 + u1 * u + u2 * v + u3 * uv + u4 * uu + u5 * vv;
+                const Float4 cv = v0 + v1 * u + v2 * v + v3 * uv + v4 * uu + v5 * vv;
+                // Back to a direction of the original length.
+                const Float4 norm = length * RSqrt(cu * cu + cv * cv + one);
+                Store(x[c] + i, Select(use, cu * norm, px));
+                Store(y[c] + i, Select(use, cv * norm, py));
+                Store(z[c] + i, Select(use, Splat(0.0f) - norm, pz));
+            }
+        }
+
+        for (int c = 0; c < ChannelCount; c++) {
+            for (size_t i = 0; i < n; i++) {
+                if (valid[c][i] != 0.0f) {
+                    float* v = Vector(samples[base + i], c);
+                    v[0] = x[c][i];
+                    v[1] = y[c][i];
+                    v[2] = z[c][i];
+                }
+            }
+        }
+    }
+}
+
+std::string GazeCalibration::Path(const std::string& user) const {
+    // The key becomes a file name.
+    std::string name = user.empty() ? "default" : user;
+    for (char& c : name) {
+        if (!isalnum((unsigned char)c) && c != '-' && c != '_') {
+            c = '_';
+        }
+    }
+    return m_directory + "/" + name + ".gazecal";
+}
+
+bool GazeCalibration::Load(const std::string& user) {
+    if (m_directory.empty()) {
+        return false;
+    }
+    const uint64_t start = MonotonicNs();
+    const std::string path = Path(user);
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        Log::Write(Log::Level::Info, Fmt("No gaze calibration profile for '%s'", user.c_str()));
+        return false;
+    }
+    ProfileFile profile;
+    const bool valid = fread(&profile, sizeof(profile), 1, file) == 1 && profile.header.magic == CalibrationMagic &&
+                       profile.header.version == CalibrationVersion && profile.header.channels == ChannelCount &&
+                       profile.header.terms == Terms &&
+                       profile.header.checksum == Hash(&profile.coefficients, sizeof(profile.coefficients));
+    fclose(file);
+    if (!valid) {
+        Log::Write(Log::Level::Warning, Fmt("Gaze calibration profile %s is not valid", path.c_str()));
+        return false;
+    }
+    Install(profile.coefficients);
+    Log::Write(Log::Level::Info, Fmt("Gaze calibration profile '%s' loaded in %.3f ms, %.2f deg RMS", user.c_str(),
+                                     (MonotonicNs() - start) / 1e6, profile.coefficients.residualDegrees[Combined]));
+    return true;
+}
+
+bool GazeCalibration::Save(const std::string& user) const {
+    ProfileFile profile = {};
+    if (m_directory.empty() || !Current(&profile.coefficients)) {
+        return false;
+    }
+    profile.header = {CalibrationMagic, CalibrationVersion, ChannelCount, Terms,
+                      Hash(&profile.coefficients, sizeof(profile.coefficients))};
+
+    const std::string path = Path(user);
+    if (!WriteFileAtomically(path, [&](FILE* file) { return fwrite(&profile, sizeof(profile), 1, file) == 1; })) {
+        Log::Write(Log::Level::Warning, Fmt("Cannot write gaze calibration profile %s", path.c_str()));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "gazesample.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Per-user correction of the tracker's gaze directions. Each channel (left eye, right
+// eye, combined) sees its direction as the point (u, v) = (x, y) / -z on the plane one
+// meter ahead and maps it through a polynomial:
+//   u' = c0 + c1 u + c2 v + c3 u v + c4 u^2 + c5 v^2, and the same for v'.
+//
+// Calibration shows targets at known head space directions. Samples arriving SettleNs
+// after BeginTarget() that point within MaxErrorDegrees of the target are accumulated, and
+// EndTarget() adds them to fixed-size normal equations, weighted so every target counts
+// the same. Solve() fits them by Cholesky, pulled lightly towards no correction so the
+// edges cannot bend away; with fewer than MinQuadraticTargets only the affine part is
+// fitted.
+//
+// Apply() corrects samples in place, four at a time for all channels. Installed corrections
+// go round a small ring of snapshots, each slot behind its own seqlock like the head pose
+// history's: Apply() copies the latest one out without locking and retries if Install()
+// was writing it. Profiles are one small fixed-size record per user, read with a single
+// fread(). Nothing is allocated after construction.
+class GazeCalibration {
+public:
+    enum Channel { Left, Right, Combined, ChannelCount };
+
+    static constexpr int Terms = 6;
+    static constexpr uint32_t MinAffineTargets = 4;
+    static constexpr uint32_t MinQuadraticTargets = 9;  // a 3x3 grid
+    static constexpr uint32_t MinTargetSamples = 10;
+    static constexpr uint64_t SettleNs = 300000000;  // the eyes are still moving to the target
+    static constexpr float MaxErrorDegrees = 8.0f;
+    static constexpr uint32_t Snapshots = 4;  // a power of two
+
+    // Without a directory profiles are neither loaded nor saved.
+    void SetDirectory(const std::string& directory) { m_directory = directory; }
+    bool Load(const std::string& user);
+    bool Save(const std::string& user) const;
+
+    // Collection; may run on another thread than AddSample().
+    void BeginTarget(const float direction[3], uint64_t timeNs);
+    void AddSample(const GazeSample& sample);
+    // Returns false if no channel had enough usable samples for the target.
+    bool EndTarget();
+    void ClearTargets();
+    // Fits and installs the correction from the targets so far.
+    bool Solve();
+
+    bool Calibrated() const { return m_installed.load(std::memory_order_acquire) != 0; }
+    void Apply(GazeSample* samples, size_t count) const;
+
+private:
+    struct Coefficients {
+        float u[ChannelCount][Terms];
+        float v[ChannelCount][Terms];
+        float residualDegrees[ChannelCount];  // RMS error left on the calibration targets
+    };
+    struct ProfileFile;
+
+    struct alignas(64) Snapshot {
+        std::atomic<uint32_t> seq{0};  // odd while Install() is inside the slot
+        uint32_t generation{0};        // install number, to tell a slot that was written over
+        Coefficients coefficients;
+    };
+
+    // Normal equations of one channel, A c = b, with u and v sharing A.
+    struct Equations {
+        double a[Terms][Terms] = {};  // lower triangle
+        double bu[Terms] = {};
+        double bv[Terms] = {};
+        double tt = 0.0;  // sum of the squared targets, for the residual
+        double weight = 0.0;
+        void Clear();
+        void Add(const double* features, double tu, double tv);
+        void Add(const Equations& other, double scale);
+    };
+
+    std::string Path(const std::string& user) const;
+    void Install(const Coefficients& coefficients);
+    // Copies out the latest installed correction; false before the first one.
+    bool Current(Coefficients* coefficients) const;
+
+    std::string m_directory;
+
+    mutable std::mutex m_lock;
+    Snapshot m_snapshots[Snapshots];        // written under m_lock
+    std::atomic<uint32_t> m_installed{0};  // corrections installed so far; the latest is slot m_installed - 1
+
+    // Collection, under m_lock
+    std::atomic<bool> m_collecting{false};
+    float m_direction[3] = {};
+    double m_target[2] = {};
+    uint64_t m_targetStartNs{0};
+    Equations m_current[ChannelCount];
+    Equations m_total[ChannelCount];
+    uint32_t m_currentSamples[ChannelCount] = {};
+    uint32_t m_targets[ChannelCount] = {};
+};
@@ -0,0 +1,275 @@
+#include "common.h"
+#include "gazeheatmap.h"
+#include "simd4.h"
+
+#include <cstdio>
+#include <zlib.h>
+
+namespace {
+const double Degrees = 180.0 / 3.14159265358979323846;
+// Tiles get a new base once the heat written to them is scaled up this much.
+const double MaxGrowth = 8.0;
+
+// Where a face's cells start in the object atlas, by face: +X, -X, +Y, -Y, +Z, -Z.
+const int FaceColumn[6] = {0, 1, 2, 0, 1, 2};
+const int FaceRow[6] = {0, 0, 0, 1, 1, 1};
+
+void PutBigEndian(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)(value >> 24);
+    p[1] = (uint8_t)(value >> 16);
+    p[2] = (uint8_t)(value >> 8);
+    p[3] = (uint8_t)value;
+}
+
+bool WriteChunk(FILE* file, const char* type, const uint8_t* data, uint32_t length) {
+    uint8_t header[8];
+    PutBigEndian(header, length);
+    memcpy(header + 4, type, 4);
+    // crc32() of a null buffer would restart at the initial value.
+    uLong checksum = crc32(0, header + 4, 4);
+    if (length != 0) {
+        checksum = crc32(checksum, data, length);
+    }
+    uint8_t crc[4];
+    PutBigEndian(crc, (uint32_t)checksum);
+    return fwrite(header, sizeof(header), 1, file) == 1 && (length == 0 || fwrite(data, length, 1, file) == 1) &&
+           fwrite(crc, sizeof(crc), 1, file) == 1;
+}
+}  // namespace
+
+GazeHeatmap::Grid::Grid(int width, int height, bool wrap)
+    : tilesX(width / TileSize), tilesY(height / TileSize), wrapX(wrap), tiles(tilesX * tilesY) {}
+
+GazeHeatmap::GazeHeatmap() : m_world(Width, Height, true) {
+    // One normalized 1D Gaussian per sub-cell offset of the sample within its cell; the
+    // taps past Taps stay 0 for the whole Float4s that run over them.
+    for (int phase = 0; phase < Phases; phase++) {
+        const float offset = (phase + 0.5f) / Phases;
+        float sum = 0.0f;
+        for (int i = 0; i < KernelStride; i++) {
+            const float d = i - Radius + 0.5f - offset;
+            m_kernel[phase][i] = i < Taps ? std::exp(-0.5f * d * d / (SigmaCells * SigmaCells)) : 0.0f;
+            sum += m_kernel[phase][i];
+        }
+        for (int i = 0; i < Taps; i++) {
+            m_kernel[phase][i] /= sum;
+        }
+    }
+}
+
+void GazeHeatmap::Add(const WorldGaze& ray, uint64_t timeNs, float weight) {
+    if (!ray.valid) {
+        return;
+    }
+    const PxrVector3f& d = ray.direction;
+    const float length = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+    if (length <= 0.0f) {
+        return;
+    }
+    const float yaw = std::atan2(d.x, -d.z) * (float)Degrees;
+    const float pitch = std::asin(std::min(1.0f, std::max(-1.0f, d.y / length))) * (float)Degrees;
+    const float x = (yaw + 180.0f) / CellDegrees;
+    const float y = (90.0f - pitch) / CellDegrees;
+    std::lock_guard<std::mutex> lock(m_lock);
+    Splat(m_world, x, y, 0, 0, Width, Height, timeNs, weight);
+}
+
+void GazeHeatmap::AddObject(int32_t object, const float local[3], uint64_t timeNs, float weight) {
+    if (object < 0) {
+        return;
+    }
+    // The face is the dominant axis; its other two axes span it, upwards in the image.
+    int axis = 0;
+    for (int i = 1; i < 3; i++) {
+        if (std::fabs(local[i]) > std::fabs(local[axis])) {
+            axis = i;
+        }
+    }
+    const int face = 2 * axis + (local[axis] < 0.0f ? 1 : 0);
+    const float u = axis == 0 ? local[2] : local[0];
+    const float v = axis == 1 ? local[2] : local[1];
+    const int x0 = FaceColumn[face] * FaceCells;
+    const int y0 = FaceRow[face] * FaceCells;
+    const float x = x0 + 0.5f * (std::min(1.0f, std::max(-1.0f, u)) + 1.0f) * FaceCells;
+    const float y = y0 + 0.5f * (1.0f - std::min(1.0f, std::max(-1.0f, v))) * FaceCells;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    if ((size_t)object >= m_objects.size() || !m_objects[object]) {
+        if (m_objectCount >= MaxObjects) {
+            m_droppedObjects.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if ((size_t)object >= m_objects.size()) {
+            m_objects.resize(object + 1);
+        }
+        m_objects[object].reset(new Grid(ObjectWidth, ObjectHeight, false));
+        m_objectCount++;
+    }
+    // Heat stays on its face.
+    Splat(*m_objects[object], x, y, x0, y0, x0 + FaceCells, y0 + FaceCells, timeNs, weight);
+}
+
+void GazeHeatmap::Splat(Grid& grid, float x, float y, int x0, int y0, int x1, int y1, uint64_t timeNs,
+                        float weight) {
+    using namespace Simd;
+    const uint64_t startNs = MonotonicNs();
+    const int cellX = (int)std::floor(x);
+    const int cellY = (int)std::floor(y);
+    const float* kernelX = m_kernel[std::min(Phases - 1, (int)((x - cellX) * Phases))];
+    const float* kernelY = m_kernel[std::min(Phases - 1, (int)((y - cellY) * Phases))];
+    // The kernel's first cell, and the cells it covers after clipping.
+    const int firstX = cellX - Radius;
+    const int firstY = cellY - Radius;
+    const int fromX = grid.wrapX ? firstX : std::max(firstX, x0);
+    const int toX = grid.wrapX ? firstX + Taps : std::min(firstX + Taps, x1);
+    const int fromY = std::max(firstY, y0);
+    const int toY = std::min(firstY + Taps, y1);
+    const int width = grid.tilesX * TileSize;
+
+    for (int tileStartY = fromY - (fromY % TileSize); tileStartY < toY; tileStartY += TileSize) {
+        const int rowFrom = std::max(fromY, tileStartY);
+        const int rowTo = std::min(toY, tileStartY + TileSize);
+        // x runs unwrapped here; floor division, as it may start below 0.
+        const int firstTileX = (fromX >= 0 ? fromX : fromX - TileSize + 1) / TileSize * TileSize;
+        for (int tileStartX = firstTileX; tileStartX < toX; tileStartX += TileSize) {
+            const int columnFrom = std::max(fromX, tileStartX);
+            const int columnTo = std::min(toX, tileStartX + TileSize);
+            const int wrappedX = ((tileStartX % width) + width) % width;
+            Tile& tile = grid.tiles[(tileStartY / TileSize) * grid.tilesX + wrappedX / TileSize];
+
+            // Heat is stored as of the tile's base time: scale the new sample up to it.
+            double growth = timeNs > tile.baseNs ? (double)(timeNs - tile.baseNs) / DecayNs
+                                                 : -(double)(tile.baseNs - timeNs) / DecayNs;
+            if (growth > MaxGrowth) {
+                const Float4 decay = Simd::Splat((float)std::exp(-growth));
+                for (int i = 0; i < TileSize * TileStride; i += 4) {
+                    Store(tile.values + i, Load(tile.values + i) * decay);
+                }
+                tile.baseNs = timeNs;
+                growth = 0.0;
+            }
+            const float scale = weight * (float)std::exp(growth);
+
+            const int count = columnTo - columnFrom;
+            const float* kernel = kernelX + (columnFrom - firstX);
+            for (int row = rowFrom; row < rowTo; row++) {
+                const Float4 rowWeight = Simd::Splat(scale * kernelY[row - firstY]);
+                // Whole Float4s may run past the tile's columns, into its padding.
+                float* cells = tile.values + (row - tileStartY) * TileStride + (columnFrom - tileStartX);
+                for (int i = 0; i < count; i += 4) {
+                    Store(cells + i, MulAdd(Load(kernel + i), rowWeight, Load(cells + i)));
+                }
+            }
+        }
+    }
+    m_splats.fetch_add(1, std::memory_order_relaxed);
+    m_splatNs.fetch_add(MonotonicNs() - startNs, std::memory_order_relaxed);
+}
+
+void GazeHeatmap::Read(Grid& grid, uint64_t timeNs, std::vector<float>* values) {
+    using namespace Simd;
+    const int width = grid.tilesX * TileSize;
+    values->resize((size_t)width * grid.tilesY * TileSize);
+    for (int tileY = 0; tileY < grid.tilesY; tileY++) {
+        for (int tileX = 0; tileX < grid.tilesX; tileX++) {
+            Tile& tile = grid.tiles[tileY * grid.tilesX + tileX];
+            // The decay catches up here, once for the whole tile.
+            if (timeNs > tile.baseNs) {
+                const Float4 decay = Simd::Splat((float)std::exp(-(double)(timeNs - tile.baseNs) / DecayNs));
+                for (int i = 0; i < TileSize * TileStride; i += 4) {
+                    Store(tile.values + i, Load(tile.values + i) * decay);
+                }
+                tile.baseNs = timeNs;
+            }
+            for (int row = 0; row < TileSize; row++) {
+                memcpy(values->data() + (size_t)(tileY * TileSize + row) * width + tileX * TileSize,
+                       tile.values + row * TileStride, TileSize * sizeof(float));
+            }
+        }
+    }
+}
+
+bool GazeHeatmap::Snapshot(uint64_t timeNs, std::vector<float>* values) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    Read(m_world, timeNs, values);
+    return true;
+}
+
+bool GazeHeatmap::SnapshotObject(int32_t object, uint64_t timeNs, std::vector<float>* values) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (object < 0 || (size_t)object >= m_objects.size() || !m_objects[object]) {
+        return false;
+    }
+    Read(*m_objects[object], timeNs, values);
+    return true;
+}
+
+bool GazeHeatmap::Export(const std::string& path, uint64_t timeNs) const {
+    std::vector<float> values;
+    return Snapshot(timeNs, &values) && WritePng(path, values, Width, Height);
+}
+
+bool GazeHeatmap::ExportObject(int32_t object, const std::string& path, uint64_t timeNs) const {
+    std::vector<float> values;
+    return SnapshotObject(object, timeNs, &values) && WritePng(path, values, ObjectWidth, ObjectHeight);
+}
+
+bool GazeHeatmap::WritePng(const std::string& path, const std::vector<float>& values, int width, int height) {
+    const float peak = *std::max_element(values.begin(), values.end());
+    const float scale = peak > 0.0f ? 255.0f / peak : 0.0f;
+    // Each row starts with its filter type: 1, each byte as the difference to the one on
+    // its left, which leaves smooth heat mostly zeros for deflate.
+    std::vector<uint8_t> rows((size_t)(width + 1) * height);
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = rows.data() + (size_t)y * (width + 1);
+        row[0] = 1;
+        uint8_t left = 0;
+        for (int x = 0; x < width; x++) {
+            const uint8_t value = (uint8_t)std::lround(std::min(255.0f, values[(size_t)y * width + x] * scale));
+            row[1 + x] = (uint8_t)(value - left);
+            left = value;
+        }
+    }
+    uLongf compressedLength = compressBound(rows.size());
+    std::vector<uint8_t> compressed(compressedLength);
+    if (compress2(compressed.data(), &compressedLength, rows.data(), rows.size(), Z_BEST_COMPRESSION) != Z_OK) {
+        return false;
+    }
+
+    static const uint8_t Signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    uint8_t header[13];
+    PutBigEndian(header, width);
+    PutBigEndian(header + 4, height);
+    header[8] = 8;    // bits per sample
+    header[9] = 0;    // grayscale
+    header[10] = 0;   // deflate
+    header[11] = 0;   // adaptive filtering
+    header[12] = 0;   // not interlaced
+
+    if (!WriteFileAtomically(path, [&](FILE* file) {
+            return fwrite(Signature, sizeof(Signature), 1, file) == 1 &&
+                   WriteChunk(file, "IHDR", header, sizeof(header)) &&
+                   WriteChunk(file, "IDAT", compressed.data(), (uint32_t)compressedLength) &&
+                   WriteChunk(file, "IEND", nullptr, 0);
+        })) {
+        Log::Write(Log::Level::Warning, Fmt("Cannot write heatmap %s", path.c_str()));
+        return false;
+    }
+    return true;
+}
+
+void GazeHeatmap::Report(std::ostringstream& out, double elapsedSeconds) {
+    const uint64_t splats = m_splats.load(std::memory_order_relaxed);
+    const uint64_t splatNs = m_splatNs.load(std::memory_order_relaxed);
+    const uint64_t newSplats = splats - m_reportedSplats;
+    size_t objects;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        objects = m_objectCount;
+    }
+    out << "splats/s=" << newSplats / elapsedSeconds
+        << " splatUs=" << (newSplats != 0 ? (splatNs - m_reportedSplatNs) / 1e3 / newSplats : 0.0)
+        << " objects=" << objects << " droppedObjects=" << m_droppedObjects.load(std::memory_order_relaxed);
+    m_reportedSplats = splats;
+    m_reportedSplatNs = splatNs;
+}
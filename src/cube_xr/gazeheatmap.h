@@ -0,0 +1,95 @@
+#pragma once
+#include "headposehistory.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Where the gaze has been, as decaying heat. World space gaze rays land on an
+// equirectangular grid of yaw and pitch, CellDegrees per cell (cells near the poles are
+// narrower than they look); hits on objects can also land on a per-object atlas of the
+// cube's six faces, FaceCells square each.
+//
+// Each sample is splatted with a precomputed separable Gaussian, picked from Phases
+// sub-cell offsets, one row of SIMD multiply-adds per kernel row. Grids are split into
+// TileSize square tiles, and heat decays with DecayNs as time constant, but never per
+// frame: each tile stores its values as of its own base time. Writes scale the sample up
+// to that base, and reads (Snapshot, export) decay the tile to the read time and move its
+// base there. A tile nobody touches costs nothing.
+//
+// Adding and reading are thread safe; neither is meant for the render thread.
+class GazeHeatmap {
+public:
+    static constexpr float CellDegrees = 1.25f;
+    static constexpr int Width = 288;   // 360 degrees of yaw
+    static constexpr int Height = 144;  // 180 degrees of pitch
+    static constexpr int TileSize = 16;
+    static constexpr int FaceCells = TileSize;
+    static constexpr int ObjectWidth = 3 * FaceCells;   // faces +X, -X, +Y in the top row,
+    static constexpr int ObjectHeight = 2 * FaceCells;  // -Y, +Z, -Z in the bottom one
+    static constexpr float SigmaCells = 1.5f;
+    static constexpr int Radius = 4;
+    static constexpr int Phases = 8;
+    static constexpr uint64_t DecayNs = 60000000000;
+    static constexpr size_t MaxObjects = 256;  // object grids beyond this are not kept
+
+    GazeHeatmap();
+
+    void Add(const WorldGaze& ray, uint64_t timeNs, float weight = 1.0f);
+    // local: the hit point in the object's frame, -1 to 1 on each axis (GazeHit::local).
+    void AddObject(int32_t object, const float local[3], uint64_t timeNs, float weight = 1.0f);
+
+    // The heat at timeNs, row by row from the top (pitch +90 degrees, yaw -180 degrees).
+    // Returns false for an object without a grid.
+    bool Snapshot(uint64_t timeNs, std::vector<float>* values) const;
+    bool SnapshotObject(int32_t object, uint64_t timeNs, std::vector<float>* values) const;
+
+    // 8-bit grayscale PNG of a snapshot, scaled to its peak.
+    bool Export(const std::string& path, uint64_t timeNs) const;
+    bool ExportObject(int32_t object, const std::string& path, uint64_t timeNs) const;
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    static constexpr int Taps = 2 * Radius + 1;
+    static constexpr int KernelStride = (Taps + 3 + 3) & ~3;  // whole Float4s from any start tap
+    static constexpr int TileStride = TileSize + 4;           // rows run on by up to 3 cells
+
+    struct Tile {
+        uint64_t baseNs = 0;
+        alignas(16) float values[TileSize * TileStride] = {};
+    };
+
+    struct Grid {
+        int tilesX;
+        int tilesY;
+        bool wrapX;
+        std::vector<Tile> tiles;
+        Grid(int width, int height, bool wrap);
+    };
+
+    // Splats at cell coordinates (x, y), clipped to the cells [x0, x1) x [y0, y1); with
+    // wrapX, x is not clipped but wraps around.
+    void Splat(Grid& grid, float x, float y, int x0, int y0, int x1, int y1, uint64_t timeNs, float weight);
+    static void Read(Grid& grid, uint64_t timeNs, std::vector<float>* values);
+    static bool WritePng(const std::string& path, const std::vector<float>& values, int width, int height);
+
+    alignas(16) float m_kernel[Phases][KernelStride];
+
+    mutable std::mutex m_lock;
+    mutable Grid m_world;
+    mutable std::vector<std::unique_ptr<Grid>> m_objects;
+    size_t m_objectCount{0};
+
+    std::atomic<uint64_t> m_splats{0};
+    std::atomic<uint64_t> m_splatNs{0};
+    std::atomic<uint64_t> m_droppedObjects{0};
+    uint64_t m_reportedSplats{0};
+    uint64_t m_reportedSplatNs{0};
+};
@@ -0,0 +1,161 @@
+#include "common.h"
+#include "gazemetrics.h"
+
+namespace {
+const double Degrees = 180.0 / 3.14159265358979323846;
+const uint64_t SecondNs = 1000000000;
+const double FixationWeight = 0.05;  // the SD precision follows about the last 20 fixations
+
+bool Has(int32_t status, int bits) { return (status & bits) == bits; }
+}  // namespace
+
+void GazeMetrics::Ewma::Add(double x, double alpha) {
+    if (!primed) {
+        mean = x;
+        variance = 0.0;
+        primed = true;
+        return;
+    }
+    const double diff = x - mean;
+    const double increment = alpha * diff;
+    mean += increment;
+    variance = (1.0 - alpha) * (variance + diff * increment);
+}
+
+void GazeMetrics::Welford::Add(double x) {
+    count++;
+    const double delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+}
+
+GazeMetrics::Event GazeMetrics::OnSample(const GazeSample& sample) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    const uint64_t timeNs = sample.timestampNs;
+    const uint64_t dtNs = m_samples != 0 && timeNs > m_lastNs ? timeNs - m_lastNs : 0;
+    const double alpha = 1.0 - std::exp(-(double)dtNs / m_parameters.windowNs);
+    if (m_samples == 0) {
+        m_firstNs = timeNs;
+    }
+    m_lastNs = std::max(m_lastNs, timeNs);
+    m_samples++;
+
+    const bool combined = Has(sample.combinedEyePoseStatus, GAZE_STATUS_GAZE_VECTOR_VALID);
+    m_combinedLoss.Add(combined ? 0.0 : 1.0, alpha);
+    m_leftLoss.Add(Has(sample.leftEyePoseStatus, GAZE_STATUS_GAZE_VECTOR_VALID) ? 0.0 : 1.0, alpha);
+    m_rightLoss.Add(Has(sample.rightEyePoseStatus, GAZE_STATUS_GAZE_VECTOR_VALID) ? 0.0 : 1.0, alpha);
+
+    if (Has(sample.leftEyePoseStatus, GAZE_STATUS_PUPIL_DILATION_VALID)) {
+        m_leftPupil.Add(sample.leftEyePupilDilation, alpha);
+    }
+    if (Has(sample.rightEyePoseStatus, GAZE_STATUS_PUPIL_DILATION_VALID)) {
+        m_rightPupil.Add(sample.rightEyePupilDilation, alpha);
+    }
+
+    bool closed = false;
+    if (Has(sample.leftEyePoseStatus, GAZE_STATUS_OPENNESS_VALID) &&
+        Has(sample.rightEyePoseStatus, GAZE_STATUS_OPENNESS_VALID)) {
+        closed = std::max(sample.leftEyeOpenness, sample.rightEyeOpenness) < m_parameters.closedOpenness;
+        if (closed && !m_closed) {
+            m_closedSinceNs = timeNs;
+        } else if (!closed && m_closed) {
+            const uint64_t closedNs = timeNs - m_closedSinceNs;
+            if (closedNs >= m_parameters.blinkMinNs && closedNs <= m_parameters.blinkMaxNs) {
+                CountBlink(timeNs);
+            }
+        }
+        m_closed = closed;
+    }
+
+    if (!combined) {
+        return closed ? Closed : Lost;
+    }
+    const float* v = sample.combinedEyeGazeVector;
+    const double length = std::sqrt((double)v[0] * v[0] + (double)v[1] * v[1] + (double)v[2] * v[2]);
+    if (length < 0.5) {
+        return closed ? Closed : Lost;
+    }
+    const double direction[3] = {v[0] / length, v[1] / length, v[2] / length};
+
+    bool fixating = false;
+    if (m_hasPrevious && timeNs > m_previousNs && timeNs - m_previousNs <= m_parameters.maxGapNs) {
+        // atan2 of |a x b| and a.b stays accurate for the tiny angles of a fixation.
+        const double* p = m_previous;
+        const double cross[3] = {p[1] * direction[2] - p[2] * direction[1], p[2] * direction[0] - p[0] * direction[2],
+                                 p[0] * direction[1] - p[1] * direction[0]};
+        const double dot = p[0] * direction[0] + p[1] * direction[1] + p[2] * direction[2];
+        const double angle =
+            std::atan2(std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]), dot) * Degrees;
+        fixating = angle / ((timeNs - m_previousNs) / 1e9) < m_parameters.saccadeDegreesPerSecond;
+        if (fixating) {
+            m_s2sSquared.Add(angle * angle, alpha);
+        }
+    }
+    if (!fixating) {
+        EndFixation();
+    }
+    m_yaw.Add(std::atan2(direction[0], -direction[2]) * Degrees);
+    m_pitch.Add(std::asin(std::max(-1.0, std::min(1.0, direction[1]))) * Degrees);
+
+    memcpy(m_previous, direction, sizeof(direction));
+    m_previousNs = timeNs;
+    m_hasPrevious = true;
+    return closed ? Closed : fixating ? Fixation : Saccade;
+}
+
+uint64_t GazeMetrics::Fixations() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_fixations;
+}
+
+uint64_t GazeMetrics::Blinks() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_blinks;
+}
+
+void GazeMetrics::EndFixation() {
+    if (m_yaw.count >= m_parameters.minFixationSamples) {
+        m_sd.Add(std::sqrt(m_yaw.Variance() + m_pitch.Variance()), FixationWeight);
+        m_fixations++;
+    }
+    m_yaw = Welford();
+    m_pitch = Welford();
+}
+
+void GazeMetrics::CountBlink(uint64_t timeNs) {
+    const uint64_t second = timeNs / SecondNs;
+    const int bucket = (int)(second % BlinkBuckets);
+    if (m_blinkSecond[bucket] != second) {
+        m_blinkSecond[bucket] = second;
+        m_blinkCount[bucket] = 0;
+    }
+    m_blinkCount[bucket]++;
+    m_blinks++;
+}
+
+uint32_t GazeMetrics::BlinksInLastMinute(uint64_t timeNs) const {
+    const uint64_t second = timeNs / SecondNs;
+    uint32_t blinks = 0;
+    for (int i = 0; i < BlinkBuckets; i++) {
+        if (m_blinkSecond[i] + BlinkBuckets > second) {
+            blinks += m_blinkCount[i];
+        }
+    }
+    return blinks;
+}
+
+void GazeMetrics::Report(std::ostringstream& out, double elapsedSeconds) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    // Until a minute has gone by, the rate is over the time there is.
+    const double minutes = std::max(1.0, std::min((double)BlinkBuckets, (m_lastNs - m_firstNs) / 1e9)) / 60.0;
+    // Precision is a fraction of a degree; the rest reads fine with the default one decimal.
+    const std::streamsize precision = out.precision();
+    out << "samples/s=" << (m_samples - m_reportedSamples) / elapsedSeconds << std::setprecision(3)
+        << " s2sRmsDeg=" << std::sqrt(m_s2sSquared.mean) << " sdDeg=" << m_sd.mean << std::setprecision(precision)
+        << " fixations=" << m_fixations << " loss%=" << 100.0 * m_combinedLoss.mean << " (L=" << 100.0 * m_leftLoss.mean
+        << " R=" << 100.0 * m_rightLoss.mean << ")"
+        << " blinks/min=" << (m_samples != 0 ? BlinksInLastMinute(m_lastNs) / minutes : 0.0)
+        << std::setprecision(2) << " pupilMm L=" << m_leftPupil.mean << "+-" << std::sqrt(m_leftPupil.variance)
+        << " R=" << m_rightPupil.mean << "+-" << std::sqrt(m_rightPupil.variance) << std::setprecision(precision);
+    m_reportedSamples = m_samples;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "gazesample.h"
+
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+
+// Running tracking quality of the eye tracker, updated with every gaze sample in O(1) and
+// read by the instrumentation reporter, so neither side ever touches the render thread:
+//
+//  - precision as RMS sample-to-sample angle and as the standard deviation of gaze angles
+//    around their mean, both within fixations only (a saccade, or a gap, starts a new one);
+//  - data loss, per eye and combined, from the pose status bits;
+//  - blinks per minute, from both eyes' openness closing for blinkMinNs..blinkMaxNs;
+//  - pupil dilation of each eye, mean and standard deviation.
+//
+// Rates and statistics are exponentially weighted over windowNs (West's weighted
+// Welford update), the SD precision over about the last 20 fixations; the blink rate
+// counts the last minute in one-second buckets. Time comes from the samples, so
+// recordings can be replayed through it, also with other parameters.
+struct GazeMetricsParameters {
+    uint64_t windowNs = 10000000000;         // time constant of the running statistics
+    double saccadeDegreesPerSecond = 100.0;  // above tracker noise at 120 Hz
+    uint64_t maxGapNs = 100000000;           // longer gaps end a fixation
+    uint32_t minFixationSamples = 5;
+    float closedOpenness = 0.1f;
+    uint64_t blinkMinNs = 50000000;
+    uint64_t blinkMaxNs = 500000000;
+};
+
+class GazeMetrics {
+public:
+    explicit GazeMetrics(const GazeMetricsParameters& parameters = GazeMetricsParameters()) : m_parameters(parameters) {}
+
+    const GazeMetricsParameters& Parameters() const { return m_parameters; }
+
+    // What a sample was classified as.
+    enum Event : uint8_t {
+        Lost,      // no usable combined gaze, eyes not known to be closed
+        Fixation,
+        Saccade,   // also the first sample after a gap
+        Closed,    // both eyes closed
+    };
+
+    Event OnSample(const GazeSample& sample);
+
+    // Totals since construction: fixations of at least minFixationSamples that have
+    // ended, and blinks.
+    uint64_t Fixations();
+    uint64_t Blinks();
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    // Exponentially weighted mean and variance.
+    struct Ewma {
+        double mean = 0.0;
+        double variance = 0.0;
+        bool primed = false;
+        void Add(double x, double alpha);
+    };
+
+    // Plain Welford accumulator, for one fixation.
+    struct Welford {
+        uint32_t count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+        void Add(double x);
+        double Variance() const { return count > 1 ? m2 / (count - 1) : 0.0; }
+    };
+
+    static constexpr int BlinkBuckets = 60;  // one per second
+
+    void EndFixation();
+    void CountBlink(uint64_t timeNs);
+    uint32_t BlinksInLastMinute(uint64_t timeNs) const;
+
+    const GazeMetricsParameters m_parameters;
+    std::mutex m_lock;
+    uint64_t m_firstNs{0};
+    uint64_t m_lastNs{0};
+    uint64_t m_samples{0};
+    uint64_t m_reportedSamples{0};
+
+    // Precision
+    bool m_hasPrevious{false};
+    uint64_t m_previousNs{0};
+    double m_previous[3] = {};
+    Welford m_yaw;
+    Welford m_pitch;
+    Ewma m_s2sSquared;  // squared sample-to-sample angle
+    Ewma m_sd;          // per fixation standard deviation
+    uint64_t m_fixations{0};
+
+    // Data loss, as the weighted fraction of samples without the data
+    Ewma m_combinedLoss;
+    Ewma m_leftLoss;
+    Ewma m_rightLoss;
+
+    // Blinks
+    bool m_closed{false};
+    uint64_t m_closedSinceNs{0};
+    uint64_t m_blinkSecond[BlinkBuckets] = {};
+    uint32_t m_blinkCount[BlinkBuckets] = {};
+    uint64_t m_blinks{0};
+
+    // Pupils
+    Ewma m_leftPupil;
+    Ewma m_rightPupil;
+};
@@ -0,0 +1,329 @@
+#include "common.h"
+#include "gazepicker.h"
+#include "simd4.h"
+
+#include <cfloat>
+
+namespace {
+const uint32_t LeafSize = 4;
+const int MaxStack = 128;
+const float MinDirection = 1e-12f;  // keeps slab distances finite for axis-parallel rays
+
+float Inverse(float d) { return 1.0f / (std::fabs(d) < MinDirection ? std::copysign(MinDirection, d) : d); }
+}  // namespace
+
+struct GazePicker::BuildInput {
+    const std::vector<Cube>& cubes;
+    std::vector<float> bounds;     // min xyz, max xyz per cube
+    std::vector<float> centroids;  // xyz per cube
+};
+
+void GazePicker::Build(const std::vector<Cube>& cubes) {
+    const uint64_t startNs = MonotonicNs();
+    m_nodes.clear();
+    m_blocks.clear();
+    if (cubes.empty()) {
+        return;
+    }
+
+    BuildInput input{cubes, std::vector<float>(cubes.size() * 6), std::vector<float>(cubes.size() * 3)};
+    std::vector<uint32_t> order(cubes.size());
+    for (uint32_t i = 0; i < cubes.size(); i++) {
+        // The unit cube is rotated and scaled: its world box reaches |R| * half size from the center.
+        const PxrPosef& pose = cubes[i].Pose;
+        const float x = pose.orientation.x, y = pose.orientation.y, z = pose.orientation.z, w = pose.orientation.w;
+        const float r[3][3] = {{1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y)},
+                               {2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x)},
+                               {2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)}};
+        const float half[3] = {0.5f * cubes[i].Scale.x, 0.5f * cubes[i].Scale.y, 0.5f * cubes[i].Scale.z};
+        const float center[3] = {pose.position.x, pose.position.y, pose.position.z};
+        for (int axis = 0; axis < 3; axis++) {
+            const float extent = std::fabs(r[axis][0]) * half[0] + std::fabs(r[axis][1]) * half[1] +
+                                 std::fabs(r[axis][2]) * half[2];
+            input.bounds[i * 6 + axis] = center[axis] - extent;
+            input.bounds[i * 6 + 3 + axis] = center[axis] + extent;
+            input.centroids[i * 3 + axis] = center[axis];
+        }
+        order[i] = i;
+    }
+    m_nodes.reserve(cubes.size() / 3 + 1);
+    m_blocks.reserve(cubes.size() / 2 + 1);
+    BuildNode(order.data(), order.data() + order.size(), input);
+    Log::Write(Log::Level::Info, Fmt("GazePicker: %zu cubes, %zu nodes, %zu leaves in %.1f ms", cubes.size(),
+                                     m_nodes.size(), m_blocks.size(), (MonotonicNs() - startNs) / 1e6));
+}
+
+int32_t GazePicker::BuildNode(uint32_t* begin, uint32_t* end, const BuildInput& input) {
+    const int32_t index = (int32_t)m_nodes.size();
+    m_nodes.emplace_back();
+
+    // Split the range in up to four at centroid medians, the largest part first, along the
+    // axis it spreads most.
+    uint32_t* parts[5] = {begin, end};
+    int partCount = 1;
+    while (partCount < 4) {
+        int largest = 0;
+        for (int i = 1; i < partCount; i++) {
+            if (parts[i + 1] - parts[i] > parts[largest + 1] - parts[largest]) {
+                largest = i;
+            }
+        }
+        uint32_t* first = parts[largest];
+        uint32_t* last = parts[largest + 1];
+        if ((uint32_t)(last - first) <= LeafSize) {
+            break;
+        }
+        float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+        float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        for (const uint32_t* it = first; it != last; ++it) {
+            for (int axis = 0; axis < 3; axis++) {
+                lo[axis] = std::min(lo[axis], input.centroids[*it * 3 + axis]);
+                hi[axis] = std::max(hi[axis], input.centroids[*it * 3 + axis]);
+            }
+        }
+        int axis = 0;
+        for (int i = 1; i < 3; i++) {
+            if (hi[i] - lo[i] > hi[axis] - lo[axis]) {
+                axis = i;
+            }
+        }
+        uint32_t* middle = first + (last - first) / 2;
+        std::nth_element(first, middle, last, [&input, axis](uint32_t a, uint32_t b) {
+            return input.centroids[a * 3 + axis] < input.centroids[b * 3 + axis];
+        });
+        for (int i = partCount; i > largest; i--) {
+            parts[i + 1] = parts[i];
+        }
+        parts[largest + 1] = middle;
+        partCount++;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+        float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        int32_t child = -1;
+        uint32_t count = 0;
+        if (i < partCount) {
+            for (const uint32_t* it = parts[i]; it != parts[i + 1]; ++it) {
+                for (int axis = 0; axis < 3; axis++) {
+                    lo[axis] = std::min(lo[axis], input.bounds[*it * 6 + axis]);
+                    hi[axis] = std::max(hi[axis], input.bounds[*it * 6 + 3 + axis]);
+                }
+            }
+            count = (uint32_t)(parts[i + 1] - parts[i]);
+            if (count <= LeafSize) {
+                child = BuildLeaf(parts[i], parts[i + 1], input);
+            } else {
+                child = BuildNode(parts[i], parts[i + 1], input);
+                count = 0;
+            }
+        }
+        // Recursion may have moved the nodes.
+        Node& node = m_nodes[index];
+        node.minX[i] = lo[0];
+        node.minY[i] = lo[1];
+        node.minZ[i] = lo[2];
+        node.maxX[i] = hi[0];
+        node.maxY[i] = hi[1];
+        node.maxZ[i] = hi[2];
+        node.child[i] = child;
+        node.count[i] = count;
+    }
+    return index;
+}
+
+int32_t GazePicker::BuildLeaf(const uint32_t* begin, const uint32_t* end, const BuildInput& input) {
+    Block block;
+    for (uint32_t i = 0; i < LeafSize; i++) {
+        const bool used = begin + i < end;
+        const Cube& cube = input.cubes[used ? begin[i] : *begin];
+        block.centerX[i] = cube.Pose.position.x;
+        block.centerY[i] = cube.Pose.position.y;
+        block.centerZ[i] = cube.Pose.position.z;
+        block.inverseX[i] = -cube.Pose.orientation.x;
+        block.inverseY[i] = -cube.Pose.orientation.y;
+        block.inverseZ[i] = -cube.Pose.orientation.z;
+        block.inverseW[i] = cube.Pose.orientation.w;
+        block.halfX[i] = 0.5f * cube.Scale.x;
+        block.halfY[i] = 0.5f * cube.Scale.y;
+        block.halfZ[i] = 0.5f * cube.Scale.z;
+        block.object[i] = used ? (int32_t)begin[i] : -1;
+    }
+    m_blocks.push_back(block);
+    return (int32_t)m_blocks.size() - 1;
+}
+
+GazeHit GazePicker::Intersect(const PxrVector3f& origin, const PxrVector3f& direction, uint64_t* visits) const {
+    using namespace Simd;
+
+    if (m_nodes.empty()) {
+        return GazeHit{};
+    }
+    GazeHit hit;
+    hit.distance = FLT_MAX;
+    const Float4 ox = Splat(origin.x), oy = Splat(origin.y), oz = Splat(origin.z);
+    const Float4 dx = Splat(direction.x), dy = Splat(direction.y), dz = Splat(direction.z);
+    const Float4 ix = Splat(Inverse(direction.x)), iy = Splat(Inverse(direction.y)), iz = Splat(Inverse(direction.z));
+    const Float4 zero = Splat(0.0f);
+
+    struct Entry {
+        int32_t child;
+        uint32_t count;
+        float distance;
+    };
+    Entry stack[MaxStack];
+    int top = 0;
+    stack[top++] = {0, 0, 0.0f};
+    while (top > 0) {
+        const Entry entry = stack[--top];
+        if (entry.distance > hit.distance) {
+            continue;
+        }
+
+        if (entry.count != 0) {
+            // A leaf: the ray in each cube's frame, slab tested against its half size.
+            const Block& block = m_blocks[entry.child];
+            const Float4 qx = Load(block.inverseX), qy = Load(block.inverseY), qz = Load(block.inverseZ),
+                         qw = Load(block.inverseW);
+            Float4 px = ox - Load(block.centerX), py = oy - Load(block.centerY), pz = oz - Load(block.centerZ);
+            Float4 vx = dx, vy = dy, vz = dz;
+            Rotate(qx, qy, qz, qw, px, py, pz);
+            Rotate(qx, qy, qz, qw, vx, vy, vz);
+            const Float4 epsilon = Splat(MinDirection);
+            const Float4 tiny = Splat(MinDirection * MinDirection);
+            vx = Select(vx * vx < tiny, epsilon, vx);
+            vy = Select(vy * vy < tiny, epsilon, vy);
+            vz = Select(vz * vz < tiny, epsilon, vz);
+            const Float4 rx = Reciprocal(vx), ry = Reciprocal(vy), rz = Reciprocal(vz);
+            const Float4 hx = Load(block.halfX), hy = Load(block.halfY), hz = Load(block.halfZ);
+            const Float4 ax = (zero - hx - px) * rx, bx = (hx - px) * rx;
+            const Float4 ay = (zero - hy - py) * ry, by = (hy - py) * ry;
+            const Float4 az = (zero - hz - pz) * rz, bz = (hz - pz) * rz;
+            const Float4 tNear = Max(Max(Min(ax, bx), Min(ay, by)), Max(Min(az, bz), zero));
+            const Float4 tFar = Min(Min(Max(ax, bx), Max(ay, by)), Min(Max(az, bz), Splat(hit.distance)));
+            const int bits = Bits(tNear <= tFar);
+            if (bits != 0) {
+                alignas(16) float distances[4], localX[4], localY[4], localZ[4];
+                Store(distances, tNear);
+                Store(localX, (px + tNear * vx) * Reciprocal(hx));
+                Store(localY, (py + tNear * vy) * Reciprocal(hy));
+                Store(localZ, (pz + tNear * vz) * Reciprocal(hz));
+                for (int i = 0; i < 4; i++) {
+                    if ((bits & (1 << i)) && block.object[i] >= 0 && distances[i] < hit.distance) {
+                        hit.object = block.object[i];
+                        hit.distance = distances[i];
+                        hit.local[0] = localX[i];
+                        hit.local[1] = localY[i];
+                        hit.local[2] = localZ[i];
+                    }
+                }
+            }
+            continue;
+        }
+
+        (*visits)++;
+        const Node& node = m_nodes[entry.child];
+        const Float4 ax = (Load(node.minX) - ox) * ix, bx = (Load(node.maxX) - ox) * ix;
+        const Float4 ay = (Load(node.minY) - oy) * iy, by = (Load(node.maxY) - oy) * iy;
+        const Float4 az = (Load(node.minZ) - oz) * iz, bz = (Load(node.maxZ) - oz) * iz;
+        const Float4 tNear = Max(Max(Min(ax, bx), Min(ay, by)), Max(Min(az, bz), zero));
+        const Float4 tFar = Min(Min(Max(ax, bx), Max(ay, by)), Min(Max(az, bz), Splat(hit.distance)));
+        const int bits = Bits(tNear <= tFar);
+        if (bits == 0) {
+            continue;
+        }
+        alignas(16) float distances[4];
+        Store(distances, tNear);
+        // Push the farthest first, so the nearest child is visited next.
+        Entry children[4];
+        int childCount = 0;
+        for (int i = 0; i < 4; i++) {
+            if ((bits & (1 << i)) && node.child[i] >= 0) {
+                Entry child{node.child[i], node.count[i], distances[i]};
+                int j = childCount++;
+                for (; j > 0 && children[j - 1].distance < child.distance; j--) {
+                    children[j] = children[j - 1];
+                }
+                children[j] = child;
+            }
+        }
+        for (int i = 0; i < childCount && top < MaxStack; i++) {
+            stack[top++] = children[i];
+        }
+    }
+    if (hit.object < 0) {
+        hit.distance = 0.0f;
+    }
+    return hit;
+}
+
+GazeHit GazePicker::Pick(const PxrVector3f& origin, const PxrVector3f& direction) const {
+    GazeHit hit;
+    WorldGaze ray{origin, direction, true};
+    Pick(&ray, 1, &hit);
+    return hit;
+}
+
+void GazePicker::Pick(const WorldGaze* rays, size_t count, GazeHit* hits) const {
+    const uint64_t startNs = MonotonicNs();
+    uint64_t visits = 0;
+    uint64_t hitCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        hits[i] = rays[i].valid ? Intersect(rays[i].origin, rays[i].direction, &visits) : GazeHit{};
+        hitCount += hits[i].object >= 0 ? 1 : 0;
+    }
+    m_picks.fetch_add(count, std::memory_order_relaxed);
+    m_hits.fetch_add(hitCount, std::memory_order_relaxed);
+    m_nodeVisits.fetch_add(visits, std::memory_order_relaxed);
+    m_pickNs.fetch_add(MonotonicNs() - startNs, std::memory_order_relaxed);
+}
+
+GazeHit GazePicker::Track(const WorldGaze& ray, uint64_t timeNs) {
+    GazeHit hit;
+    Pick(&ray, 1, &hit);
+    if (hit.object >= 0 && hit.object == m_object) {
+        m_lastOnNs = timeNs;
+    } else if (m_object < 0 || timeNs - m_lastOnNs > DwellBreakNs) {
+        // A new target, or the old one was left for good.
+        m_object = hit.object;
+        m_dwellStartNs = m_lastOnNs = timeNs;
+        if (hit.object >= 0) {
+            m_targets.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    hit.dwellNs = hit.object >= 0 && hit.object == m_object ? timeNs - m_dwellStartNs : 0;
+
+    std::lock_guard<std::mutex> lock(m_latestLock);
+    m_latest = hit;
+    m_hasLatest = true;
+    return hit;
+}
+
+bool GazePicker::Latest(GazeHit* hit) const {
+    std::lock_guard<std::mutex> lock(m_latestLock);
+    *hit = m_latest;
+    return m_hasLatest;
+}
+
+void GazePicker::Report(std::ostringstream& out, double elapsedSeconds) {
+    const uint64_t picks = m_picks.load(std::memory_order_relaxed);
+    const uint64_t hits = m_hits.load(std::memory_order_relaxed);
+    const uint64_t nodeVisits = m_nodeVisits.load(std::memory_order_relaxed);
+    const uint64_t pickNs = m_pickNs.load(std::memory_order_relaxed);
+    const uint64_t targets = m_targets.load(std::memory_order_relaxed);
+    const uint64_t newPicks = picks - m_reportedPicks;
+    GazeHit latest;
+    Latest(&latest);
+
+    out << "picks/s=" << newPicks / elapsedSeconds
+        << " hit%=" << (newPicks != 0 ? 100.0 * (hits - m_reportedHits) / newPicks : 0.0)
+        << " nodes/pick=" << (newPicks != 0 ? (double)(nodeVisits - m_reportedNodeVisits) / newPicks : 0.0)
+        << " us/pick=" << (newPicks != 0 ? (pickNs - m_reportedPickNs) / 1000.0 / newPicks : 0.0)
+        << " newTargets=" << (targets - m_reportedTargets) << " object=" << latest.object
+        << " dwellMs=" << latest.dwellNs / 1e6;
+    m_reportedPicks = picks;
+    m_reportedHits = hits;
+    m_reportedNodeVisits = nodeVisits;
+    m_reportedPickNs = pickNs;
+    m_reportedTargets = targets;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "graphicsplugin.h"
+#include "headposehistory.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+// What a gaze ray landed on.
+struct GazeHit {
+    int32_t object = -1;    // index into the cubes given to Build(), -1 for nothing
+    float distance = 0.0f;  // along the ray, in meters
+    uint64_t dwellNs = 0;   // how long the gaze has stayed on the object, 0 from Pick()
+    float local[3] = {};    // where, in the cube's frame scaled to -1..1 on each axis
+};
+
+// Finds the cube a world space gaze ray hits first. Cubes go into a 4-wide BVH: each node
+// holds the boxes of its four children side by side, so one ray is slab tested against
+// all four at once, and each leaf holds up to four cubes, tested exactly (as rotated
+// boxes) the same way. Children are visited nearest first and skipped once they start
+// beyond the closest hit so far.
+//
+// Build() once the scene is set and before picking starts; the tree is read-only after
+// that, so Pick() may run on any thread. Track() keeps the dwell state and is meant for
+// one thread, the one handling gaze samples.
+class GazePicker {
+public:
+    static constexpr uint64_t DwellBreakNs = 100000000;  // glances away (or blinks) shorter than this keep the dwell
+
+    void Build(const std::vector<Cube>& cubes);
+
+    GazeHit Pick(const PxrVector3f& origin, const PxrVector3f& direction) const;
+    void Pick(const WorldGaze* rays, size_t count, GazeHit* hits) const;
+
+    // Picks with one gaze sample's ray and updates the dwell on the object hit.
+    GazeHit Track(const WorldGaze& ray, uint64_t timeNs);
+    // The result of the last Track(). Returns false until there is one.
+    bool Latest(GazeHit* hit) const;
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    // Four child boxes, one component array each. A child with count 0 is an inner node,
+    // otherwise a leaf whose cubes are block 'child'. Unused children have empty boxes.
+    struct Node {
+        float minX[4], minY[4], minZ[4];
+        float maxX[4], maxY[4], maxZ[4];
+        int32_t child[4];
+        uint32_t count[4];
+    };
+
+    // Up to four cubes as rotated boxes: center, inverse orientation and half size.
+    struct Block {
+        float centerX[4], centerY[4], centerZ[4];
+        float inverseX[4], inverseY[4], inverseZ[4], inverseW[4];
+        float halfX[4], halfY[4], halfZ[4];
+        int32_t object[4];
+    };
+
+    struct BuildInput;
+
+    int32_t BuildNode(uint32_t* begin, uint32_t* end, const BuildInput& input);
+    int32_t BuildLeaf(const uint32_t* begin, const uint32_t* end, const BuildInput& input);
+    // Closest hit along the ray; counts visited nodes into *visits.
+    GazeHit Intersect(const PxrVector3f& origin, const PxrVector3f& direction, uint64_t* visits) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<Block> m_blocks;
+
+    int32_t m_object{-1};
+    uint64_t m_dwellStartNs{0};
+    uint64_t m_lastOnNs{0};
+    mutable std::mutex m_latestLock;
+    GazeHit m_latest;
+    bool m_hasLatest{false};
+
+    mutable std::atomic<uint64_t> m_picks{0};
+    mutable std::atomic<uint64_t> m_hits{0};
+    mutable std::atomic<uint64_t> m_nodeVisits{0};
+    mutable std::atomic<uint64_t> m_pickNs{0};
+    std::atomic<uint64_t> m_targets{0};
+    uint64_t m_reportedPicks{0};
+    uint64_t m_reportedHits{0};
+    uint64_t m_reportedNodeVisits{0};
+    uint64_t m_reportedPickNs{0};
+    uint64_t m_reportedTargets{0};
+};
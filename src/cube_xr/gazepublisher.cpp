@@ -0,0 +1,146 @@
+#include "common.h"
+#include "gazepublisher.h"
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#if defined(__ANDROID__)
+#include <android/sharedmem.h>
+#endif
+
+namespace {
+int CreateSharedMemory(const char* name, size_t size) {
+#if defined(__ANDROID__)
+    return ASharedMemory_create(name, size);
+#else
+    int fd = (int)syscall(SYS_memfd_create, name, 0u);
+    if (fd >= 0 && ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+#endif
+}
+
+bool SendFd(int sock, int fd) {
+    char byte = 0;
+    struct iovec iov = {&byte, 1};
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    return sendmsg(sock, &msg, MSG_NOSIGNAL) == 1;
+}
+}  // namespace
+
+GazePublisher::~GazePublisher() { Stop(); }
+
+bool GazePublisher::Start(const char* socketName) {
+    m_fd = CreateSharedMemory("etvr-gaze", sizeof(GazeShmRing));
+    if (m_fd < 0) {
+        Log::Write(Log::Level::Error, Fmt("GazePublisher: shared memory creation failed (%d)", errno));
+        return false;
+    }
+    void* mem = mmap(nullptr, sizeof(GazeShmRing), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mem == MAP_FAILED) {
+        Log::Write(Log::Level::Error, Fmt("GazePublisher: mmap failed (%d)", errno));
+        Stop();
+        return false;
+    }
+    m_ring = static_cast<GazeShmRing*>(mem);
+    memset(m_ring, 0, sizeof(GazeShmRing));
+    m_ring->capacity = GAZE_SHM_CAPACITY;
+    m_ring->sampleSize = sizeof(GazeSample);
+    m_ring->version = GAZE_SHM_VERSION;
+    __atomic_store_n(&m_ring->magic, GAZE_SHM_MAGIC, __ATOMIC_RELEASE);
+    m_head = 0;
+#if defined(__ANDROID__)
+    // Mappings created from now on (i.e. by readers) can only be read-only.
+    ASharedMemory_setProt(m_fd, PROT_READ);
+#endif
+
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    size_t nameLen = strlen(socketName);
+    if (nameLen + 1 > sizeof(addr.sun_path)) {
+        Log::Write(Log::Level::Error, "GazePublisher: socket name too long");
+        Stop();
+        return false;
+    }
+    memcpy(addr.sun_path + 1, socketName, nameLen);
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0 ||
+        bind(m_listenFd, (struct sockaddr*)&addr, (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + nameLen)) < 0 ||
+        listen(m_listenFd, 8) < 0) {
+        Log::Write(Log::Level::Error, Fmt("GazePublisher: cannot listen on @%s (%d)", socketName, errno));
+        Stop();
+        return false;
+    }
+
+    m_running = true;
+    m_server = std::thread(&GazePublisher::ServeClients, this);
+    Log::Write(Log::Level::Info, Fmt("GazePublisher: serving %u-slot gaze ring on @%s", GAZE_SHM_CAPACITY, socketName));
+    return true;
+}
+
+void GazePublisher::Stop() {
+    m_running = false;
+    if (m_listenFd >= 0) {
+        shutdown(m_listenFd, SHUT_RDWR);
+    }
+    if (m_server.joinable()) {
+        m_server.join();
+    }
+    if (m_listenFd >= 0) {
+        close(m_listenFd);
+        m_listenFd = -1;
+    }
+    if (m_ring != nullptr) {
+        munmap(m_ring, sizeof(GazeShmRing));
+        m_ring = nullptr;
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void GazePublisher::Publish(const GazeSample& sample) {
+    if (m_ring == nullptr || m_paused.load(std::memory_order_relaxed)) {
+        return;
+    }
+    GazeShmSlot& slot = m_ring->slots[m_head & (GAZE_SHM_CAPACITY - 1)];
+    uint32_t seq = __atomic_load_n(&slot.seq, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot.seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot.sample = sample;
+    slot.sample.sequence = m_head;
+    __atomic_store_n(&slot.seq, seq + 2, __ATOMIC_RELEASE);
+
+    m_head++;
+    __atomic_store_n(&m_ring->head, m_head, __ATOMIC_RELEASE);
+}
+
+void GazePublisher::ServeClients() {
+    while (m_running) {
+        int client = accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (!SendFd(client, m_fd)) {
+            Log::Write(Log::Level::Warning, Fmt("GazePublisher: failed to hand out ring fd (%d)", errno));
+        }
+        close(client);
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "gazeshm.h"
+
+#include <atomic>
+#include <thread>
+
+// Writes gaze samples into a shared memory ring (see gazeshm.h) and hands the segment
+// fd to any local process that connects to the publisher socket.
+class GazePublisher {
+public:
+    GazePublisher() = default;
+    ~GazePublisher();
+
+    GazePublisher(const GazePublisher&) = delete;
+    GazePublisher& operator=(const GazePublisher&) = delete;
+
+    bool Start(const char* socketName = GAZE_SHM_SOCKET_NAME);
+    void Stop();
+
+    // Single writer only. Overwrites the oldest slot and stamps sample.sequence.
+    void Publish(const GazeSample& sample);
+
+    // While paused, Publish() drops samples; readers keep seeing the last ones written.
+    void SetPaused(bool paused) { m_paused.store(paused, std::memory_order_relaxed); }
+
+    int Fd() const { return m_fd; }
+
+private:
+    void ServeClients();
+
+    int m_fd{-1};
+    int m_listenFd{-1};
+    GazeShmRing* m_ring{nullptr};
+    uint32_t m_head{0};
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_paused{false};
+    std::thread m_server;
+};
@@ -0,0 +1,60 @@
+#include "common.h"
+#include "gazerecording.h"
+
+bool RecordingWriter::Open(const std::string& path, uint64_t startNs) {
+    Close();
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_file = fopen(path.c_str(), "wb");
+    if (m_file == nullptr) {
+        Log::Write(Log::Level::Warning, Fmt("Cannot create recording %s", path.c_str()));
+        return false;
+    }
+    setvbuf(m_file, nullptr, _IOFBF, BufferBytes);
+    RecordingHeader header = {};
+    header.magic = RecordingHeader::Magic;
+    header.version = RecordingHeader::Version;
+    header.recordSize = sizeof(RecordedSample);
+    header.startNs = startNs;
+    m_failed = fwrite(&header, sizeof(header), 1, m_file) != 1;
+    m_path = path;
+    m_index.Close();
+    m_records = 0;
+    return !m_failed;
+}
+
+void RecordingWriter::Append(const RecordedSample& sample) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_file == nullptr || m_failed) {
+        return;
+    }
+    if (fwrite(&sample, sizeof(sample), 1, m_file) != 1) {
+        Log::Write(Log::Level::Warning, Fmt("Recording %s stopped: write failed", m_path.c_str()));
+        m_failed = true;
+        return;
+    }
+    m_index.Add(&sample, 1);
+    m_records++;
+}
+
+void RecordingWriter::Flush() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_file != nullptr) {
+        fflush(m_file);
+    }
+}
+
+void RecordingWriter::Close() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_file == nullptr) {
+        return;
+    }
+    const bool closed = fclose(m_file) == 0;
+    m_file = nullptr;
+    // A recording that failed part way keeps what made it to disk; the index is then
+    // rebuilt from that when it is opened.
+    if (closed && !m_failed) {
+        m_index.Save(RecordingIndex::IndexPath(m_path), sizeof(RecordingHeader) + m_records * sizeof(RecordedSample));
+        Log::Write(Log::Level::Info, Fmt("Recorded %llu samples to %s", (unsigned long long)m_records, m_path.c_str()));
+    }
+    m_index.Close();
+}
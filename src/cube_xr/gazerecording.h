@@ -0,0 +1,64 @@
+#pragma once
+#include "gazesample.h"
+#include "recordingindex.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+// Head pose with the layout of PxrPosef, kept free of the runtime's headers so host
+// tools can read recordings.
+struct RecordedPose {
+    float orientation[4];  // x, y, z, w
+    float position[3];
+};
+
+// One recorded sample: the gaze and the head pose of the moment it was taken.
+struct RecordedSample {
+    GazeSample gaze;
+    RecordedPose head;
+    int32_t headValid;
+};
+
+// A recording is this header followed by RecordedSamples in timestamp order, nothing
+// else, so record i sits at sizeof(RecordingHeader) + i * recordSize. A trailing partial
+// record (the app was killed mid-write) is ignored.
+struct RecordingHeader {
+    static constexpr uint32_t Magic = 0x43525445;  // 'ETRC'
+    static constexpr uint32_t Version = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+    uint64_t startNs;
+    uint64_t reserved2[5];
+
+    bool Valid() const { return magic == Magic && version == Version && recordSize == sizeof(RecordedSample); }
+};
+static_assert(sizeof(RecordingHeader) == 64, "the recording header is part of the file format");
+
+// Appends samples to a recording through a large stdio buffer and builds its index as it
+// goes, saved beside it on Close(). Append() is for one thread; Flush() and Close() may
+// come from another.
+class RecordingWriter {
+public:
+    static constexpr size_t BufferBytes = 1 << 20;
+
+    ~RecordingWriter() { Close(); }
+
+    bool Open(const std::string& path, uint64_t startNs);
+    void Append(const RecordedSample& sample);
+    // Hands the buffered samples to the OS, e.g. when the app may be killed.
+    void Flush();
+    void Close();
+
+private:
+    std::mutex m_lock;
+    FILE* m_file{nullptr};
+    std::string m_path;
+    RecordingIndex m_index;
+    uint64_t m_records{0};
+    bool m_failed{false};
+};
@@ -0,0 +1,48 @@
+#pragma once
+/*
+ * Plain C layout of one eye tracking sample. This struct is shared with other
+ * processes through gazeshm.h, so keep it C compatible and only ever append fields.
+ */
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Bits of the *PoseStatus fields, as reported by Pxr_GetEyeTrackingData.
+enum GazePoseStatusBits {
+    GAZE_STATUS_GAZE_POINT_VALID     = 1 << 0,
+    GAZE_STATUS_GAZE_VECTOR_VALID    = 1 << 1,
+    GAZE_STATUS_OPENNESS_VALID       = 1 << 2,
+    GAZE_STATUS_PUPIL_DILATION_VALID = 1 << 3,
+    GAZE_STATUS_POSITION_GUIDE_VALID = 1 << 4,
+};
+
+typedef struct GazeSample {
+    uint64_t timestampNs;              // CLOCK_MONOTONIC time the sample was taken
+    uint32_t sequence;                 // monotonically increasing sample number
+
+    int32_t  leftEyePoseStatus;
+    int32_t  rightEyePoseStatus;
+    int32_t  combinedEyePoseStatus;
+
+    float    leftEyeGazePoint[3];
+    float    rightEyeGazePoint[3];
+    float    combinedEyeGazePoint[3];
+
+    float    leftEyeGazeVector[3];
+    float    rightEyeGazeVector[3];
+    float    combinedEyeGazeVector[3];
+
+    float    leftEyeOpenness;
+    float    rightEyeOpenness;
+    float    leftEyePupilDilation;
+    float    rightEyePupilDilation;
+
+    int32_t  foveatedGazeTrackingState;
+    float    foveatedGazeDirection[3];
+} GazeSample;
+
+#if defined(__cplusplus)
+}  // extern "C"
+#endif
@@ -0,0 +1,72 @@
+#include "gazesampler.h"
+
+#include <algorithm>
+#include <chrono>
+
+void GazeSampler::AddSink(Sink sink) {
+    std::lock_guard<std::mutex> lock(m_sinkLock);
+    m_sinks.push_back(std::move(sink));
+}
+
+void GazeSampler::Start(float rateHz) {
+    if (m_running) {
+        return;
+    }
+    SetRate(rateHz);
+    m_running = true;
+    m_thread = std::thread(&GazeSampler::Run, this);
+}
+
+void GazeSampler::Stop() {
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void GazeSampler::SetRate(float rateHz) {
+    m_rateHz.store(std::max(rateHz, 1.0f), std::memory_order_relaxed);
+}
+
+bool GazeSampler::Latest(GazeSample* sample) const {
+    std::lock_guard<std::mutex> lock(m_latestLock);
+    *sample = m_latest;
+    return m_latest.timestampNs != 0;
+}
+
+void GazeSampler::Run() {
+    using Clock = std::chrono::steady_clock;
+    uint32_t sequence = 0;
+    auto next = Clock::now();
+
+    while (m_running) {
+        GazeSample sample = {};
+        if (m_source(&sample)) {
+            sample.timestampNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     Clock::now().time_since_epoch()).count();
+            sample.sequence = sequence++;
+            if (m_correction) {
+                m_correction(&sample);
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_latestLock);
+                m_latest = sample;
+            }
+
+            std::lock_guard<std::mutex> lock(m_sinkLock);
+            for (const Sink& sink : m_sinks) {
+                sink(sample);
+            }
+        }
+
+        const auto period = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<float>(1.0f / m_rateHz.load(std::memory_order_relaxed)));
+        next += period;
+        const auto now = Clock::now();
+        if (next < now) {
+            // We fell behind (e.g. the process was descheduled); don't try to catch up with a burst.
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "gazesample.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Polls the eye tracker on its own thread at a fixed rate and fans every sample out to
+// the registered sinks, so gaze consumers never run on the render thread.
+class GazeSampler {
+public:
+    // Fills the sample (except timestampNs/sequence). Returns false if no data was available.
+    using Source = std::function<bool(GazeSample* sample)>;
+    using Sink = std::function<void(const GazeSample& sample)>;
+    // Rewrites each timestamped sample in place before anyone sees it (e.g. calibration).
+    using Correction = std::function<void(GazeSample* sample)>;
+
+    explicit GazeSampler(Source source) : m_source(std::move(source)) {}
+    ~GazeSampler() { Stop(); }
+
+    GazeSampler(const GazeSampler&) = delete;
+    GazeSampler& operator=(const GazeSampler&) = delete;
+
+    // Sinks are called on the sampler thread, in registration order.
+    void AddSink(Sink sink);
+    // Set before Start().
+    void SetCorrection(Correction correction) { m_correction = std::move(correction); }
+
+    void Start(float rateHz);
+    void Stop();
+
+    void SetRate(float rateHz);
+    float Rate() const { return m_rateHz.load(std::memory_order_relaxed); }
+
+    // Copies the most recent sample, for consumers that poll once per frame instead of
+    // handling every sample. Returns false until the first sample arrives.
+    bool Latest(GazeSample* sample) const;
+
+private:
+    void Run();
+
+    Source m_source;
+    Correction m_correction;
+    std::mutex m_sinkLock;
+    std::vector<Sink> m_sinks;
+    mutable std::mutex m_latestLock;
+    GazeSample m_latest{};
+    std::atomic<float> m_rateHz{0.0f};
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+};
@@ -0,0 +1,207 @@
+#pragma once
+/*
+ * Shared memory gaze ring. The app publishes every eye tracking sample into an
+ * ashmem/memfd segment; other processes on the device read it without any syscall
+ * on the read path.
+ *
+ * Reader usage (C or C++):
+ *
+ *     const GazeShmRing* ring = gaze_shm_connect(GAZE_SHM_SOCKET_NAME);
+ *     uint32_t cursor = 0;
+ *     GazeSample samples[16];
+ *     for (;;) {
+ *         uint32_t n = gaze_shm_read(ring, &cursor, samples, 16, NULL);
+ *         ...
+ *     }
+ *     gaze_shm_disconnect(ring);
+ *
+ * gaze_shm_connect() fetches the segment fd once over an abstract unix socket and maps
+ * it read-only. Each slot is protected by its own seqlock, so a reader never blocks the
+ * writer and simply retries if it raced with an overwrite. A writer that died inside a
+ * slot leaves it odd for good; readers give up on it after GAZE_SHM_MAX_SPINS tries and
+ * report it instead of spinning forever.
+ */
+#include "gazesample.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define GAZE_SHM_MAGIC       0x52565445u  // "ETVR"
+#define GAZE_SHM_VERSION     1u
+#define GAZE_SHM_CAPACITY    256u         // must be a power of two
+#define GAZE_SHM_SOCKET_NAME "etvr.gaze"
+#define GAZE_SHM_MAX_SPINS   4096u        // tries at a slot being written; a write takes well under 1 us
+
+// Results of gaze_shm_read_slot().
+#define GAZE_SHM_OVERWRITTEN 0
+#define GAZE_SHM_OK          1
+#define GAZE_SHM_BUSY        (-1)          // the writer stayed inside the slot; it may have died
+
+typedef struct GazeShmSlot {
+    uint32_t   seq;                       // odd while the writer is inside the slot
+    uint32_t   reserved;
+    GazeSample sample;
+} __attribute__((aligned(64))) GazeShmSlot;
+
+typedef struct GazeShmRing {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    capacity;
+    uint32_t    sampleSize;
+    uint32_t    head;                     // number of samples published so far (wraps)
+    uint32_t    reserved[11];
+    GazeShmSlot slots[GAZE_SHM_CAPACITY];
+} GazeShmRing;
+
+static inline void gaze_shm_cpu_relax(void) {
+#if defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Copies slot 'index' if it still holds sample number 'index'. Returns GAZE_SHM_OK,
+// GAZE_SHM_OVERWRITTEN, or GAZE_SHM_BUSY if the writer did not leave the slot within
+// GAZE_SHM_MAX_SPINS tries.
+static inline int gaze_shm_read_slot(const GazeShmRing* ring, uint32_t index, GazeSample* out) {
+    const GazeShmSlot* slot = &ring->slots[index & (GAZE_SHM_CAPACITY - 1)];
+    for (uint32_t spin = 0; spin < GAZE_SHM_MAX_SPINS; spin++) {
+        uint32_t seq0 = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq0 & 1u) {
+            gaze_shm_cpu_relax();
+            continue;
+        }
+        memcpy(out, &slot->sample, sizeof(GazeSample));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint32_t seq1 = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+        if (seq0 == seq1) {
+            return out->sequence == index ? GAZE_SHM_OK : GAZE_SHM_OVERWRITTEN;
+        }
+    }
+    return GAZE_SHM_BUSY;
+}
+
+// Reads the most recent sample. Returns 0 if nothing has been published yet, or if the
+// writer is stuck inside the latest slot (the data is stale).
+static inline int gaze_shm_read_latest(const GazeShmRing* ring, GazeSample* out) {
+    for (uint32_t attempt = 0; attempt < GAZE_SHM_MAX_SPINS; attempt++) {
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (head == 0) {
+            return 0;
+        }
+        int result = gaze_shm_read_slot(ring, head - 1, out);
+        if (result == GAZE_SHM_OK) {
+            return 1;
+        }
+        if (result == GAZE_SHM_BUSY) {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+// Reads up to 'max' samples published after '*cursor' and advances the cursor. If the
+// reader fell more than a ring behind, the oldest samples are skipped and counted in '*lost'.
+// Reading stops at a slot the writer is stuck in; the cursor stays there, so a later call
+// retries it, and '*stalled' (if given) is set.
+static inline uint32_t gaze_shm_read_ex(const GazeShmRing* ring, uint32_t* cursor, GazeSample* out, uint32_t max,
+                                        uint32_t* lost, int* stalled) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t count = 0;
+    if (stalled) *stalled = 0;
+    if (head - *cursor > GAZE_SHM_CAPACITY) {
+        if (lost) *lost += head - *cursor - GAZE_SHM_CAPACITY;
+        *cursor = head - GAZE_SHM_CAPACITY;
+    }
+    while (*cursor != head && count < max) {
+        int result = gaze_shm_read_slot(ring, *cursor, &out[count]);
+        if (result == GAZE_SHM_BUSY) {
+            if (stalled) *stalled = 1;
+            break;
+        }
+        if (result == GAZE_SHM_OK) {
+            count++;
+        } else if (lost) {
+            (*lost)++;
+        }
+        (*cursor)++;
+    }
+    return count;
+}
+
+static inline uint32_t gaze_shm_read(const GazeShmRing* ring, uint32_t* cursor, GazeSample* out, uint32_t max,
+                                     uint32_t* lost) {
+    return gaze_shm_read_ex(ring, cursor, out, max, lost, NULL);
+}
+
+// Connects to the publisher and maps the ring read-only. Returns NULL on failure.
+static inline const GazeShmRing* gaze_shm_connect(const char* socketName) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    size_t nameLen = strlen(socketName);
+    if (nameLen + 1 > sizeof(addr.sun_path)) {
+        return NULL;
+    }
+    memcpy(addr.sun_path + 1, socketName, nameLen);  // abstract namespace
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        return NULL;
+    }
+    if (connect(sock, (struct sockaddr*)&addr, (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + nameLen)) < 0) {
+        close(sock);
+        return NULL;
+    }
+
+    char byte;
+    struct iovec iov = {&byte, 1};
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t received = recvmsg(sock, &msg, 0);
+    close(sock);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (received <= 0 || cmsg == NULL || cmsg->cmsg_type != SCM_RIGHTS) {
+        return NULL;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+
+    void* mem = mmap(NULL, sizeof(GazeShmRing), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return NULL;
+    }
+    const GazeShmRing* ring = (const GazeShmRing*)mem;
+    if (ring->magic != GAZE_SHM_MAGIC || ring->version != GAZE_SHM_VERSION ||
+        ring->sampleSize != sizeof(GazeSample)) {
+        munmap(mem, sizeof(GazeShmRing));
+        return NULL;
+    }
+    return ring;
+}
+
+static inline void gaze_shm_disconnect(const GazeShmRing* ring) {
+    if (ring) {
+        munmap((void*)ring, sizeof(GazeShmRing));
+    }
+}
+
+#if defined(__cplusplus)
+}  // extern "C"
+#endif
@@ -1,11 +1,32 @@
 #pragma once
 #include "pxr/PxrApi.h"
+
+#include <cstdint>
+
 namespace Geometry {
 
+// Packed vertex: snorm16 position (object space within [-1, 1], w is padding) and RGBA8
+// color, 12 bytes instead of 24 for float3 + float3.
 struct Vertex {
-    PxrVector3f Position;
-    PxrVector3f Color;
+    int16_t Position[4];
+    uint8_t Color[4];
 };
+static_assert(sizeof(Vertex) == 12, "Vertex must stay tightly packed");
+
+constexpr int16_t PackSnorm16(float value) {
+    return (int16_t)((value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value) * 32767.0f + (value < 0.0f ? -0.5f : 0.5f));
+}
+
+constexpr float UnpackSnorm16(int16_t value) { return value < -32767 ? -1.0f : value / 32767.0f; }
+
+constexpr uint8_t PackUnorm8(float value) {
+    return (uint8_t)((value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value) * 255.0f + 0.5f);
+}
+
+constexpr Vertex PackVertex(PxrVector3f position, PxrVector3f color) {
+    return Vertex{{PackSnorm16(position.x), PackSnorm16(position.y), PackSnorm16(position.z), 0},
+                  {PackUnorm8(color.x), PackUnorm8(color.y), PackUnorm8(color.z), 255}};
+}
 
 constexpr PxrVector3f Red{1, 0, 0};
 constexpr PxrVector3f DarkRed{0.25f, 0, 0};
@@ -24,25 +45,33 @@ constexpr PxrVector3f RBF{0.5f, -0.5f, 0.5f};
 constexpr PxrVector3f RTB{0.5f, 0.5f, -0.5f};
 constexpr PxrVector3f RTF{0.5f, 0.5f, 0.5f};
 
-#define CUBE_SIDE(V1, V2, V3, V4, V5, V6, COLOR) {V1, COLOR}, {V2, COLOR}, {V3, COLOR}, {V4, COLOR}, {V5, COLOR}, {V6, COLOR},
+// Each side has its own color, so corners are shared within a side only: 4 vertices per side.
+#define CUBE_SIDE(V1, V2, V3, V4, COLOR) \
+    PackVertex(V1, COLOR), PackVertex(V2, COLOR), PackVertex(V3, COLOR), PackVertex(V4, COLOR),
 
 constexpr Vertex c_cubeVertices[] = {
-    CUBE_SIDE(LTB, LBF, LBB, LTB, LTF, LBF, DarkRed)    // -X
-    CUBE_SIDE(RTB, RBB, RBF, RTB, RBF, RTF, Red)        // +X
-    CUBE_SIDE(LBB, LBF, RBF, LBB, RBF, RBB, DarkGreen)  // -Y
-    CUBE_SIDE(LTB, RTB, RTF, LTB, RTF, LTF, Green)      // +Y
-    CUBE_SIDE(LBB, RBB, RTB, LBB, RTB, LTB, DarkBlue)   // -Z
-    CUBE_SIDE(LBF, LTF, RTF, LBF, RTF, RBF, Blue)       // +Z
+    CUBE_SIDE(LTB, LTF, LBF, LBB, DarkRed)    // -X
+    CUBE_SIDE(RTB, RBB, RBF, RTF, Red)        // +X
+    CUBE_SIDE(LBB, LBF, RBF, RBB, DarkGreen)  // -Y
+    CUBE_SIDE(LTB, RTB, RTF, LTF, Green)      // +Y
+    CUBE_SIDE(LBB, RBB, RTB, LTB, DarkBlue)   // -Z
+    CUBE_SIDE(LBF, LTF, RTF, RBF, Blue)       // +Z
 };
 
-// Winding order is clockwise. Each side uses a different color.
+#undef CUBE_SIDE
+
+// Winding order is clockwise. Two triangles per side, fanned from its first vertex.
+#define CUBE_SIDE(BASE) BASE, BASE + 1, BASE + 2, BASE, BASE + 2, BASE + 3,
+
 constexpr unsigned short c_cubeIndices[] = {
-    0,  1,  2,  3,  4,  5,   // -X
-    6,  7,  8,  9,  10, 11,  // +X
-    12, 13, 14, 15, 16, 17,  // -Y
-    18, 19, 20, 21, 22, 23,  // +Y
-    24, 25, 26, 27, 28, 29,  // -Z
-    30, 31, 32, 33, 34, 35,  // +Z
+    CUBE_SIDE(0)   // -X
+    CUBE_SIDE(4)   // +X
+    CUBE_SIDE(8)   // -Y
+    CUBE_SIDE(12)  // +Y
+    CUBE_SIDE(16)  // -Z
+    CUBE_SIDE(20)  // +Z
 };
 
-}  // namespace Geometry
\ No newline at end of file
+#undef CUBE_SIDE
+
+}  // namespace Geometry
@@ -0,0 +1,23 @@
+#include "common.h"
+#include "glcalls.h"
+
+namespace GlCalls {
+std::atomic<uint64_t> g_counts[IdCount];
+
+uint64_t Total() {
+    uint64_t total = 0;
+    for (const std::atomic<uint64_t>& count : g_counts) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+const char* Name(Id id) {
+    static const char* const names[IdCount] = {
+#define GL_COUNTED_CALL_NAME(name) #name,
+        GL_COUNTED_CALLS(GL_COUNTED_CALL_NAME)
+#undef GL_COUNTED_CALL_NAME
+    };
+    return id < IdCount ? names[id] : "?";
+}
+}  // namespace GlCalls
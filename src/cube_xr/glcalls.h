@@ -0,0 +1,757 @@
+#pragma once
+// Single wrapper layer over the GL API for the renderer's translation units: every GLES 3.2
+// entry point (and the extension functions the plugin loads) becomes a macro that counts
+// the call, then makes it. Include this after any other GL header; it pulls in the ones
+// the renderer uses itself, so later includes of those are no-ops. A call made from a
+// file that includes it cannot go uncounted.
+//
+// The list is the function set of the Khronos GLES3/gl32.h. Extension entry points called
+// through loaded pointers are appended by hand at the end.
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
+#include <GLES3/gl32.h>
+
+#include <atomic>
+#include <cstdint>
+
+#define GL_COUNTED_CALLS(X) \
+    X(glActiveShaderProgram) \
+    X(glActiveTexture) \
+    X(glAttachShader) \
+    X(glBeginQuery) \
+    X(glBeginTransformFeedback) \
+    X(glBindAttribLocation) \
+    X(glBindBuffer) \
+    X(glBindBufferBase) \
+    X(glBindBufferRange) \
+    X(glBindFramebuffer) \
+    X(glBindImageTexture) \
+    X(glBindProgramPipeline) \
+    X(glBindRenderbuffer) \
+    X(glBindSampler) \
+    X(glBindTexture) \
+    X(glBindTransformFeedback) \
+    X(glBindVertexArray) \
+    X(glBindVertexBuffer) \
+    X(glBlendBarrier) \
+    X(glBlendColor) \
+    X(glBlendEquation) \
+    X(glBlendEquationSeparate) \
+    X(glBlendEquationSeparatei) \
+    X(glBlendEquationi) \
+    X(glBlendFunc) \
+    X(glBlendFuncSeparate) \
+    X(glBlendFuncSeparatei) \
+    X(glBlendFunci) \
+    X(glBlitFramebuffer) \
+    X(glBufferData) \
+    X(glBufferSubData) \
+    X(glCheckFramebufferStatus) \
+    X(glClear) \
+    X(glClearBufferfi) \
+    X(glClearBufferfv) \
+    X(glClearBufferiv) \
+    X(glClearBufferuiv) \
+    X(glClearColor) \
+    X(glClearDepthf) \
+    X(glClearStencil) \
+    X(glClientWaitSync) \
+    X(glColorMask) \
+    X(glColorMaski) \
+    X(glCompileShader) \
+    X(glCompressedTexImage2D) \
+    X(glCompressedTexImage3D) \
+    X(glCompressedTexSubImage2D) \
+    X(glCompressedTexSubImage3D) \
+    X(glCopyBufferSubData) \
+    X(glCopyImageSubData) \
+    X(glCopyTexImage2D) \
+    X(glCopyTexSubImage2D) \
+    X(glCopyTexSubImage3D) \
+    X(glCreateProgram) \
+    X(glCreateShader) \
+    X(glCreateShaderProgramv) \
+    X(glCullFace) \
+    X(glDebugMessageCallback) \
+    X(glDebugMessageControl) \
+    X(glDebugMessageInsert) \
+    X(glDeleteBuffers) \
+    X(glDeleteFramebuffers) \
+    X(glDeleteProgram) \
+    X(glDeleteProgramPipelines) \
+    X(glDeleteQueries) \
+    X(glDeleteRenderbuffers) \
+    X(glDeleteSamplers) \
+    X(glDeleteShader) \
+    X(glDeleteSync) \
+    X(glDeleteTextures) \
+    X(glDeleteTransformFeedbacks) \
+    X(glDeleteVertexArrays) \
+    X(glDepthFunc) \
+    X(glDepthMask) \
+    X(glDepthRangef) \
+    X(glDetachShader) \
+    X(glDisable) \
+    X(glDisableVertexAttribArray) \
+    X(glDisablei) \
+    X(glDispatchCompute) \
+    X(glDispatchComputeIndirect) \
+    X(glDrawArrays) \
+    X(glDrawArraysIndirect) \
+    X(glDrawArraysInstanced) \
+    X(glDrawBuffers) \
+    X(glDrawElements) \
+    X(glDrawElementsBaseVertex) \
+    X(glDrawElementsIndirect) \
+    X(glDrawElementsInstanced) \
+    X(glDrawElementsInstancedBaseVertex) \
+    X(glDrawRangeElements) \
+    X(glDrawRangeElementsBaseVertex) \
+    X(glEnable) \
+    X(glEnableVertexAttribArray) \
+    X(glEnablei) \
+    X(glEndQuery) \
+    X(glEndTransformFeedback) \
+    X(glFenceSync) \
+    X(glFinish) \
+    X(glFlush) \
+    X(glFlushMappedBufferRange) \
+    X(glFramebufferParameteri) \
+    X(glFramebufferRenderbuffer) \
+    X(glFramebufferTexture) \
+    X(glFramebufferTexture2D) \
+    X(glFramebufferTextureLayer) \
+    X(glFrontFace) \
+    X(glGenBuffers) \
+    X(glGenFramebuffers) \
+    X(glGenProgramPipelines) \
+    X(glGenQueries) \
+    X(glGenRenderbuffers) \
+    X(glGenSamplers) \
+    X(glGenTextures) \
+    X(glGenTransformFeedbacks) \
+    X(glGenVertexArrays) \
+    X(glGenerateMipmap) \
+    X(glGetActiveAttrib) \
+    X(glGetActiveUniform) \
+    X(glGetActiveUniformBlockName) \
+    X(glGetActiveUniformBlockiv) \
+    X(glGetActiveUniformsiv) \
+    X(glGetAttachedShaders) \
+    X(glGetAttribLocation) \
+    X(glGetBooleani_v) \
+    X(glGetBooleanv) \
+    X(glGetBufferParameteri64v) \
+    X(glGetBufferParameteriv) \
+    X(glGetBufferPointerv) \
+    X(glGetDebugMessageLog) \
+    X(glGetError) \
+    X(glGetFloatv) \
+    X(glGetFragDataLocation) \
+    X(glGetFramebufferAttachmentParameteriv) \
+    X(glGetFramebufferParameteriv) \
+    X(glGetGraphicsResetStatus) \
+    X(glGetInteger64i_v) \
+    X(glGetInteger64v) \
+    X(glGetIntegeri_v) \
+    X(glGetIntegerv) \
+    X(glGetInternalformativ) \
+    X(glGetMultisamplefv) \
+    X(glGetObjectLabel) \
+    X(glGetObjectPtrLabel) \
+    X(glGetPointerv) \
+    X(glGetProgramBinary) \
+    X(glGetProgramInfoLog) \
+    X(glGetProgramInterfaceiv) \
+    X(glGetProgramPipelineInfoLog) \
+    X(glGetProgramPipelineiv) \
+    X(glGetProgramResourceIndex) \
+    X(glGetProgramResourceLocation) \
+    X(glGetProgramResourceName) \
+    X(glGetProgramResourceiv) \
+    X(glGetProgramiv) \
+    X(glGetQueryObjectuiv) \
+    X(glGetQueryiv) \
+    X(glGetRenderbufferParameteriv) \
+    X(glGetSamplerParameterIiv) \
+    X(glGetSamplerParameterIuiv) \
+    X(glGetSamplerParameterfv) \
+    X(glGetSamplerParameteriv) \
+    X(glGetShaderInfoLog) \
+    X(glGetShaderPrecisionFormat) \
+    X(glGetShaderSource) \
+    X(glGetShaderiv) \
+    X(glGetString) \
+    X(glGetStringi) \
+    X(glGetSynciv) \
+    X(glGetTexLevelParameterfv) \
+    X(glGetTexLevelParameteriv) \
+    X(glGetTexParameterIiv) \
+    X(glGetTexParameterIuiv) \
+    X(glGetTexParameterfv) \
+    X(glGetTexParameteriv) \
+    X(glGetTransformFeedbackVarying) \
+    X(glGetUniformBlockIndex) \
+    X(glGetUniformIndices) \
+    X(glGetUniformLocation) \
+    X(glGetUniformfv) \
+    X(glGetUniformiv) \
+    X(glGetUniformuiv) \
+    X(glGetVertexAttribIiv) \
+    X(glGetVertexAttribIuiv) \
+    X(glGetVertexAttribPointerv) \
+    X(glGetVertexAttribfv) \
+    X(glGetVertexAttribiv) \
+    X(glGetnUniformfv) \
+    X(glGetnUniformiv) \
+    X(glGetnUniformuiv) \
+    X(glHint) \
+    X(glInvalidateFramebuffer) \
+    X(glInvalidateSubFramebuffer) \
+    X(glIsBuffer) \
+    X(glIsEnabled) \
+    X(glIsEnabledi) \
+    X(glIsFramebuffer) \
+    X(glIsProgram) \
+    X(glIsProgramPipeline) \
+    X(glIsQuery) \
+    X(glIsRenderbuffer) \
+    X(glIsSampler) \
+    X(glIsShader) \
+    X(glIsSync) \
+    X(glIsTexture) \
+    X(glIsTransformFeedback) \
+    X(glIsVertexArray) \
+    X(glLineWidth) \
+    X(glLinkProgram) \
+    X(glMapBufferRange) \
+    X(glMemoryBarrier) \
+    X(glMemoryBarrierByRegion) \
+    X(glMinSampleShading) \
+    X(glObjectLabel) \
+    X(glObjectPtrLabel) \
+    X(glPatchParameteri) \
+    X(glPauseTransformFeedback) \
+    X(glPixelStorei) \
+    X(glPolygonOffset) \
+    X(glPopDebugGroup) \
+    X(glPrimitiveBoundingBox) \
+    X(glProgramBinary) \
+    X(glProgramParameteri) \
+    X(glProgramUniform1f) \
+    X(glProgramUniform1fv) \
+    X(glProgramUniform1i) \
+    X(glProgramUniform1iv) \
+    X(glProgramUniform1ui) \
+    X(glProgramUniform1uiv) \
+    X(glProgramUniform2f) \
+    X(glProgramUniform2fv) \
+    X(glProgramUniform2i) \
+    X(glProgramUniform2iv) \
+    X(glProgramUniform2ui) \
+    X(glProgramUniform2uiv) \
+    X(glProgramUniform3f) \
+    X(glProgramUniform3fv) \
+    X(glProgramUniform3i) \
+    X(glProgramUniform3iv) \
+    X(glProgramUniform3ui) \
+    X(glProgramUniform3uiv) \
+    X(glProgramUniform4f) \
+    X(glProgramUniform4fv) \
+    X(glProgramUniform4i) \
+    X(glProgramUniform4iv) \
+    X(glProgramUniform4ui) \
+    X(glProgramUniform4uiv) \
+    X(glProgramUniformMatrix2fv) \
+    X(glProgramUniformMatrix2x3fv) \
+    X(glProgramUniformMatrix2x4fv) \
+    X(glProgramUniformMatrix3fv) \
+    X(glProgramUniformMatrix3x2fv) \
+    X(glProgramUniformMatrix3x4fv) \
+    X(glProgramUniformMatrix4fv) \
+    X(glProgramUniformMatrix4x2fv) \
+    X(glProgramUniformMatrix4x3fv) \
+    X(glPushDebugGroup) \
+    X(glReadBuffer) \
+    X(glReadPixels) \
+    X(glReadnPixels) \
+    X(glReleaseShaderCompiler) \
+    X(glRenderbufferStorage) \
+    X(glRenderbufferStorageMultisample) \
+    X(glResumeTransformFeedback) \
+    X(glSampleCoverage) \
+    X(glSampleMaski) \
+    X(glSamplerParameterIiv) \
+    X(glSamplerParameterIuiv) \
+    X(glSamplerParameterf) \
+    X(glSamplerParameterfv) \
+    X(glSamplerParameteri) \
+    X(glSamplerParameteriv) \
+    X(glScissor) \
+    X(glShaderBinary) \
+    X(glShaderSource) \
+    X(glStencilFunc) \
+    X(glStencilFuncSeparate) \
+    X(glStencilMask) \
+    X(glStencilMaskSeparate) \
+    X(glStencilOp) \
+    X(glStencilOpSeparate) \
+    X(glTexBuffer) \
+    X(glTexBufferRange) \
+    X(glTexImage2D) \
+    X(glTexImage3D) \
+    X(glTexParameterIiv) \
+    X(glTexParameterIuiv) \
+    X(glTexParameterf) \
+    X(glTexParameterfv) \
+    X(glTexParameteri) \
+    X(glTexParameteriv) \
+    X(glTexStorage2D) \
+    X(glTexStorage2DMultisample) \
+    X(glTexStorage3D) \
+    X(glTexStorage3DMultisample) \
+    X(glTexSubImage2D) \
+    X(glTexSubImage3D) \
+    X(glTransformFeedbackVaryings) \
+    X(glUniform1f) \
+    X(glUniform1fv) \
+    X(glUniform1i) \
+    X(glUniform1iv) \
+    X(glUniform1ui) \
+    X(glUniform1uiv) \
+    X(glUniform2f) \
+    X(glUniform2fv) \
+    X(glUniform2i) \
+    X(glUniform2iv) \
+    X(glUniform2ui) \
+    X(glUniform2uiv) \
+    X(glUniform3f) \
+    X(glUniform3fv) \
+    X(glUniform3i) \
+    X(glUniform3iv) \
+    X(glUniform3ui) \
+    X(glUniform3uiv) \
+    X(glUniform4f) \
+    X(glUniform4fv) \
+    X(glUniform4i) \
+    X(glUniform4iv) \
+    X(glUniform4ui) \
+    X(glUniform4uiv) \
+    X(glUniformBlockBinding) \
+    X(glUniformMatrix2fv) \
+    X(glUniformMatrix2x3fv) \
+    X(glUniformMatrix2x4fv) \
+    X(glUniformMatrix3fv) \
+    X(glUniformMatrix3x2fv) \
+    X(glUniformMatrix3x4fv) \
+    X(glUniformMatrix4fv) \
+    X(glUniformMatrix4x2fv) \
+    X(glUniformMatrix4x3fv) \
+    X(glUnmapBuffer) \
+    X(glUseProgram) \
+    X(glUseProgramStages) \
+    X(glValidateProgram) \
+    X(glValidateProgramPipeline) \
+    X(glVertexAttrib1f) \
+    X(glVertexAttrib1fv) \
+    X(glVertexAttrib2f) \
+    X(glVertexAttrib2fv) \
+    X(glVertexAttrib3f) \
+    X(glVertexAttrib3fv) \
+    X(glVertexAttrib4f) \
+    X(glVertexAttrib4fv) \
+    X(glVertexAttribBinding) \
+    X(glVertexAttribDivisor) \
+    X(glVertexAttribFormat) \
+    X(glVertexAttribI4i) \
+    X(glVertexAttribI4iv) \
+    X(glVertexAttribI4ui) \
+    X(glVertexAttribI4uiv) \
+    X(glVertexAttribIFormat) \
+    X(glVertexAttribIPointer) \
+    X(glVertexAttribPointer) \
+    X(glVertexBindingDivisor) \
+    X(glViewport) \
+    X(glWaitSync) \
+    X(glFramebufferTexture2DMultisampleEXT) \
+    X(glGetQueryObjectui64vEXT)
+
+namespace GlCalls {
+enum Id : uint16_t {
+#define GL_COUNTED_CALL_ID(name) name,
+    GL_COUNTED_CALLS(GL_COUNTED_CALL_ID)
+#undef GL_COUNTED_CALL_ID
+    IdCount
+};
+
+extern std::atomic<uint64_t> g_counts[IdCount];
+
+inline void Count(Id id) { g_counts[id].fetch_add(1, std::memory_order_relaxed); }
+
+// Calls made so far, of one function or of all; may be read from any thread.
+inline uint64_t Calls(Id id) { return g_counts[id].load(std::memory_order_relaxed); }
+uint64_t Total();
+const char* Name(Id id);
+}  // namespace GlCalls
+
+#define glActiveShaderProgram(...) (GlCalls::Count(GlCalls::glActiveShaderProgram), glActiveShaderProgram(__VA_ARGS__))
+#define glActiveTexture(...) (GlCalls::Count(GlCalls::glActiveTexture), glActiveTexture(__VA_ARGS__))
+#define glAttachShader(...) (GlCalls::Count(GlCalls::glAttachShader), glAttachShader(__VA_ARGS__))
+#define glBeginQuery(...) (GlCalls::Count(GlCalls::glBeginQuery), glBeginQuery(__VA_ARGS__))
+#define glBeginTransformFeedback(...) (GlCalls::Count(GlCalls::glBeginTransformFeedback), glBeginTransformFeedback(__VA_ARGS__))
+#define glBindAttribLocation(...) (GlCalls::Count(GlCalls::glBindAttribLocation), glBindAttribLocation(__VA_ARGS__))
+#define glBindBuffer(...) (GlCalls::Count(GlCalls::glBindBuffer), glBindBuffer(__VA_ARGS__))
+#define glBindBufferBase(...) (GlCalls::Count(GlCalls::glBindBufferBase), glBindBufferBase(__VA_ARGS__))
+#define glBindBufferRange(...) (GlCalls::Count(GlCalls::glBindBufferRange), glBindBufferRange(__VA_ARGS__))
+#define glBindFramebuffer(...) (GlCalls::Count(GlCalls::glBindFramebuffer), glBindFramebuffer(__VA_ARGS__))
+#define glBindImageTexture(...) (GlCalls::Count(GlCalls::glBindImageTexture), glBindImageTexture(__VA_ARGS__))
+#define glBindProgramPipeline(...) (GlCalls::Count(GlCalls::glBindProgramPipeline), glBindProgramPipeline(__VA_ARGS__))
+#define glBindRenderbuffer(...) (GlCalls::Count(GlCalls::glBindRenderbuffer), glBindRenderbuffer(__VA_ARGS__))
+#define glBindSampler(...) (GlCalls::Count(GlCalls::glBindSampler), glBindSampler(__VA_ARGS__))
+#define glBindTexture(...) (GlCalls::Count(GlCalls::glBindTexture), glBindTexture(__VA_ARGS__))
+#define glBindTransformFeedback(...) (GlCalls::Count(GlCalls::glBindTransformFeedback), glBindTransformFeedback(__VA_ARGS__))
+#define glBindVertexArray(...) (GlCalls::Count(GlCalls::glBindVertexArray), glBindVertexArray(__VA_ARGS__))
+#define glBindVertexBuffer(...) (GlCalls::Count(GlCalls::glBindVertexBuffer), glBindVertexBuffer(__VA_ARGS__))
+#define glBlendBarrier(...) (GlCalls::Count(GlCalls::glBlendBarrier), glBlendBarrier(__VA_ARGS__))
+#define glBlendColor(...) (GlCalls::Count(GlCalls::glBlendColor), glBlendColor(__VA_ARGS__))
+#define glBlendEquation(...) (GlCalls::Count(GlCalls::glBlendEquation), glBlendEquation(__VA_ARGS__))
+#define glBlendEquationSeparate(...) (GlCalls::Count(GlCalls::glBlendEquationSeparate), glBlendEquationSeparate(__VA_ARGS__))
+#define glBlendEquationSeparatei(...) (GlCalls::Count(GlCalls::glBlendEquationSeparatei), glBlendEquationSeparatei(__VA_ARGS__))
+#define glBlendEquationi(...) (GlCalls::Count(GlCalls::glBlendEquationi), glBlendEquationi(__VA_ARGS__))
+#define glBlendFunc(...) (GlCalls::Count(GlCalls::glBlendFunc), glBlendFunc(__VA_ARGS__))
+#define glBlendFuncSeparate(...) (GlCalls::Count(GlCalls::glBlendFuncSeparate), glBlendFuncSeparate(__VA_ARGS__))
+#define glBlendFuncSeparatei(...) (GlCalls::Count(GlCalls::glBlendFuncSeparatei), glBlendFuncSeparatei(__VA_ARGS__))
+#define glBlendFunci(...) (GlCalls::Count(GlCalls::glBlendFunci), glBlendFunci(__VA_ARGS__))
+#define glBlitFramebuffer(...) (GlCalls::Count(GlCalls::glBlitFramebuffer), glBlitFramebuffer(__VA_ARGS__))
+#define glBufferData(...) (GlCalls::Count(GlCalls::glBufferData), glBufferData(__VA_ARGS__))
+#define glBufferSubData(...) (GlCalls::Count(GlCalls::glBufferSubData), glBufferSubData(__VA_ARGS__))
+#define glCheckFramebufferStatus(...) (GlCalls::Count(GlCalls::glCheckFramebufferStatus), glCheckFramebufferStatus(__VA_ARGS__))
+#define glClear(...) (GlCalls::Count(GlCalls::glClear), glClear(__VA_ARGS__))
+#define glClearBufferfi(...) (GlCalls::Count(GlCalls::glClearBufferfi), glClearBufferfi(__VA_ARGS__))
+#define glClearBufferfv(...) (GlCalls::Count(GlCalls::glClearBufferfv), glClearBufferfv(__VA_ARGS__))
+#define glClearBufferiv(...) (GlCalls::Count(GlCalls::glClearBufferiv), glClearBufferiv(__VA_ARGS__))
+#define glClearBufferuiv(...) (GlCalls::Count(GlCalls::glClearBufferuiv), glClearBufferuiv(__VA_ARGS__))
+#define glClearColor(...) (GlCalls::Count(GlCalls::glClearColor), glClearColor(__VA_ARGS__))
+#define glClearDepthf(...) (GlCalls::Count(GlCalls::glClearDepthf), glClearDepthf(__VA_ARGS__))
+#define glClearStencil(...) (GlCalls::Count(GlCalls::glClearStencil), glClearStencil(__VA_ARGS__))
+#define glClientWaitSync(...) (GlCalls::Count(GlCalls::glClientWaitSync), glClientWaitSync(__VA_ARGS__))
+#define glColorMask(...) (GlCalls::Count(GlCalls::glColorMask), glColorMask(__VA_ARGS__))
+#define glColorMaski(...) (GlCalls::Count(GlCalls::glColorMaski), glColorMaski(__VA_ARGS__))
+#define glCompileShader(...) (GlCalls::Count(GlCalls::glCompileShader), glCompileShader(__VA_ARGS__))
+#define glCompressedTexImage2D(...) (GlCalls::Count(GlCalls::glCompressedTexImage2D), glCompressedTexImage2D(__VA_ARGS__))
+#define glCompressedTexImage3D(...) (GlCalls::Count(GlCalls::glCompressedTexImage3D), glCompressedTexImage3D(__VA_ARGS__))
+#define glCompressedTexSubImage2D(...) (GlCalls::Count(GlCalls::glCompressedTexSubImage2D), glCompressedTexSubImage2D(__VA_ARGS__))
+#define glCompressedTexSubImage3D(...) (GlCalls::Count(GlCalls::glCompressedTexSubImage3D), glCompressedTexSubImage3D(__VA_ARGS__))
+#define glCopyBufferSubData(...) (GlCalls::Count(GlCalls::glCopyBufferSubData), glCopyBufferSubData(__VA_ARGS__))
+#define glCopyImageSubData(...) (GlCalls::Count(GlCalls::glCopyImageSubData), glCopyImageSubData(__VA_ARGS__))
+#define glCopyTexImage2D(...) (GlCalls::Count(GlCalls::glCopyTexImage2D), glCopyTexImage2D(__VA_ARGS__))
+#define glCopyTexSubImage2D(...) (GlCalls::Count(GlCalls::glCopyTexSubImage2D), glCopyTexSubImage2D(__VA_ARGS__))
+#define glCopyTexSubImage3D(...) (GlCalls::Count(GlCalls::glCopyTexSubImage3D), glCopyTexSubImage3D(__VA_ARGS__))
+#define glCreateProgram(...) (GlCalls::Count(GlCalls::glCreateProgram), glCreateProgram(__VA_ARGS__))
+#define glCreateShader(...) (GlCalls::Count(GlCalls::glCreateShader), glCreateShader(__VA_ARGS__))
+#define glCreateShaderProgramv(...) (GlCalls::Count(GlCalls::glCreateShaderProgramv), glCreateShaderProgramv(__VA_ARGS__))
+#define glCullFace(...) (GlCalls::Count(GlCalls::glCullFace), glCullFace(__VA_ARGS__))
+#define glDebugMessageCallback(...) (GlCalls::Count(GlCalls::glDebugMessageCallback), glDebugMessageCallback(__VA_ARGS__))
+#define glDebugMessageControl(...) (GlCalls::Count(GlCalls::glDebugMessageControl), glDebugMessageControl(__VA_ARGS__))
+#define glDebugMessageInsert(...) (GlCalls::Count(GlCalls::glDebugMessageInsert), glDebugMessageInsert(__VA_ARGS__))
+#define glDeleteBuffers(...) (GlCalls::Count(GlCalls::glDeleteBuffers), glDeleteBuffers(__VA_ARGS__))
+#define glDeleteFramebuffers(...) (GlCalls::Count(GlCalls::glDeleteFramebuffers), glDeleteFramebuffers(__VA_ARGS__))
+#define glDeleteProgram(...) (GlCalls::Count(GlCalls::glDeleteProgram), glDeleteProgram(__VA_ARGS__))
+#define glDeleteProgramPipelines(...) (GlCalls::Count(GlCalls::glDeleteProgramPipelines), glDeleteProgramPipelines(__VA_ARGS__))
+#define glDeleteQueries(...) (GlCalls::Count(GlCalls::glDeleteQueries), glDeleteQueries(__VA_ARGS__))
+#define glDeleteRenderbuffers(...) (GlCalls::Count(GlCalls::glDeleteRenderbuffers), glDeleteRenderbuffers(__VA_ARGS__))
+#define glDeleteSamplers(...) (GlCalls::Count(GlCalls::glDeleteSamplers), glDeleteSamplers(__VA_ARGS__))
+#define glDeleteShader(...) (GlCalls::Count(GlCalls::glDeleteShader), glDeleteShader(__VA_ARGS__))
+#define glDeleteSync(...) (GlCalls::Count(GlCalls::glDeleteSync), glDeleteSync(__VA_ARGS__))
+#define glDeleteTextures(...) (GlCalls::Count(GlCalls::glDeleteTextures), glDeleteTextures(__VA_ARGS__))
+#define glDeleteTransformFeedbacks(...) (GlCalls::Count(GlCalls::glDeleteTransformFeedbacks), glDeleteTransformFeedbacks(__VA_ARGS__))
+#define glDeleteVertexArrays(...) (GlCalls::Count(GlCalls::glDeleteVertexArrays), glDeleteVertexArrays(__VA_ARGS__))
+#define glDepthFunc(...) (GlCalls::Count(GlCalls::glDepthFunc), glDepthFunc(__VA_ARGS__))
+#define glDepthMask(...) (GlCalls::Count(GlCalls::glDepthMask), glDepthMask(__VA_ARGS__))
+#define glDepthRangef(...) (GlCalls::Count(GlCalls::glDepthRangef), glDepthRangef(__VA_ARGS__))
+#define glDetachShader(...) (GlCalls::Count(GlCalls::glDetachShader), glDetachShader(__VA_ARGS__))
+#define glDisable(...) (GlCalls::Count(GlCalls::glDisable), glDisable(__VA_ARGS__))
+#define glDisableVertexAttribArray(...) (GlCalls::Count(GlCalls::glDisableVertexAttribArray), glDisableVertexAttribArray(__VA_ARGS__))
+#define glDisablei(...) (GlCalls::Count(GlCalls::glDisablei), glDisablei(__VA_ARGS__))
+#define glDispatchCompute(...) (GlCalls::Count(GlCalls::glDispatchCompute), glDispatchCompute(__VA_ARGS__))
+#define glDispatchComputeIndirect(...) (GlCalls::Count(GlCalls::glDispatchComputeIndirect), glDispatchComputeIndirect(__VA_ARGS__))
+#define glDrawArrays(...) (GlCalls::Count(GlCalls::glDrawArrays), glDrawArrays(__VA_ARGS__))
+#define glDrawArraysIndirect(...) (GlCalls::Count(GlCalls::glDrawArraysIndirect), glDrawArraysIndirect(__VA_ARGS__))
+#define glDrawArraysInstanced(...) (GlCalls::Count(GlCalls::glDrawArraysInstanced), glDrawArraysInstanced(__VA_ARGS__))
+#define glDrawBuffers(...) (GlCalls::Count(GlCalls::glDrawBuffers), glDrawBuffers(__VA_ARGS__))
+#define glDrawElements(...) (GlCalls::Count(GlCalls::glDrawElements), glDrawElements(__VA_ARGS__))
+#define glDrawElementsBaseVertex(...) (GlCalls::Count(GlCalls::glDrawElementsBaseVertex), glDrawElementsBaseVertex(__VA_ARGS__))
+#define glDrawElementsIndirect(...) (GlCalls::Count(GlCalls::glDrawElementsIndirect), glDrawElementsIndirect(__VA_ARGS__))
+#define glDrawElementsInstanced(...) (GlCalls::Count(GlCalls::glDrawElementsInstanced), glDrawElementsInstanced(__VA_ARGS__))
+#define glDrawElementsInstancedBaseVertex(...) (GlCalls::Count(GlCalls::glDrawElementsInstancedBaseVertex), glDrawElementsInstancedBaseVertex(__VA_ARGS__))
+#define glDrawRangeElements(...) (GlCalls::Count(GlCalls::glDrawRangeElements), glDrawRangeElements(__VA_ARGS__))
+#define glDrawRangeElementsBaseVertex(...) (GlCalls::Count(GlCalls::glDrawRangeElementsBaseVertex), glDrawRangeElementsBaseVertex(__VA_ARGS__))
+#define glEnable(...) (GlCalls::Count(GlCalls::glEnable), glEnable(__VA_ARGS__))
+#define glEnableVertexAttribArray(...) (GlCalls::Count(GlCalls::glEnableVertexAttribArray), glEnableVertexAttribArray(__VA_ARGS__))
+#define glEnablei(...) (GlCalls::Count(GlCalls::glEnablei), glEnablei(__VA_ARGS__))
+#define glEndQuery(...) (GlCalls::Count(GlCalls::glEndQuery), glEndQuery(__VA_ARGS__))
+#define glEndTransformFeedback(...) (GlCalls::Count(GlCalls::glEndTransformFeedback), glEndTransformFeedback(__VA_ARGS__))
+#define glFenceSync(...) (GlCalls::Count(GlCalls::glFenceSync), glFenceSync(__VA_ARGS__))
+#define glFinish(...) (GlCalls::Count(GlCalls::glFinish), glFinish(__VA_ARGS__))
+#define glFlush(...) (GlCalls::Count(GlCalls::glFlush), glFlush(__VA_ARGS__))
+#define glFlushMappedBufferRange(...) (GlCalls::Count(GlCalls::glFlushMappedBufferRange), glFlushMappedBufferRange(__VA_ARGS__))
+#define glFramebufferParameteri(...) (GlCalls::Count(GlCalls::glFramebufferParameteri), glFramebufferParameteri(__VA_ARGS__))
+#define glFramebufferRenderbuffer(...) (GlCalls::Count(GlCalls::glFramebufferRenderbuffer), glFramebufferRenderbuffer(__VA_ARGS__))
+#define glFramebufferTexture(...) (GlCalls::Count(GlCalls::glFramebufferTexture), glFramebufferTexture(__VA_ARGS__))
+#define glFramebufferTexture2D(...) (GlCalls::Count(GlCalls::glFramebufferTexture2D), glFramebufferTexture2D(__VA_ARGS__))
+#define glFramebufferTextureLayer(...) (GlCalls::Count(GlCalls::glFramebufferTextureLayer), glFramebufferTextureLayer(__VA_ARGS__))
+#define glFrontFace(...) (GlCalls::Count(GlCalls::glFrontFace), glFrontFace(__VA_ARGS__))
+#define glGenBuffers(...) (GlCalls::Count(GlCalls::glGenBuffers), glGenBuffers(__VA_ARGS__))
+#define glGenFramebuffers(...) (GlCalls::Count(GlCalls::glGenFramebuffers), glGenFramebuffers(__VA_ARGS__))
+#define glGenProgramPipelines(...) (GlCalls::Count(GlCalls::glGenProgramPipelines), glGenProgramPipelines(__VA_ARGS__))
+#define glGenQueries(...) (GlCalls::Count(GlCalls::glGenQueries), glGenQueries(__VA_ARGS__))
+#define glGenRenderbuffers(...) (GlCalls::Count(GlCalls::glGenRenderbuffers), glGenRenderbuffers(__VA_ARGS__))
+#define glGenSamplers(...) (GlCalls::Count(GlCalls::glGenSamplers), glGenSamplers(__VA_ARGS__))
+#define glGenTextures(...) (GlCalls::Count(GlCalls::glGenTextures), glGenTextures(__VA_ARGS__))
+#define glGenTransformFeedbacks(...) (GlCalls::Count(GlCalls::glGenTransformFeedbacks), glGenTransformFeedbacks(__VA_ARGS__))
+#define glGenVertexArrays(...) (GlCalls::Count(GlCalls::glGenVertexArrays), glGenVertexArrays(__VA_ARGS__))
+#define glGenerateMipmap(...) (GlCalls::Count(GlCalls::glGenerateMipmap), glGenerateMipmap(__VA_ARGS__))
+#define glGetActiveAttrib(...) (GlCalls::Count(GlCalls::glGetActiveAttrib), glGetActiveAttrib(__VA_ARGS__))
+#define glGetActiveUniform(...) (GlCalls::Count(GlCalls::glGetActiveUniform), glGetActiveUniform(__VA_ARGS__))
+#define glGetActiveUniformBlockName(...) (GlCalls::Count(GlCalls::glGetActiveUniformBlockName), glGetActiveUniformBlockName(__VA_ARGS__))
+#define glGetActiveUniformBlockiv(...) (GlCalls::Count(GlCalls::glGetActiveUniformBlockiv), glGetActiveUniformBlockiv(__VA_ARGS__))
+#define glGetActiveUniformsiv(...) (GlCalls::Count(GlCalls::glGetActiveUniformsiv), glGetActiveUniformsiv(__VA_ARGS__))
+#define glGetAttachedShaders(...) (GlCalls::Count(GlCalls::glGetAttachedShaders), glGetAttachedShaders(__VA_ARGS__))
+#define glGetAttribLocation(...) (GlCalls::Count(GlCalls::glGetAttribLocation), glGetAttribLocation(__VA_ARGS__))
+#define glGetBooleani_v(...) (GlCalls::Count(GlCalls::glGetBooleani_v), glGetBooleani_v(__VA_ARGS__))
+#define glGetBooleanv(...) (GlCalls::Count(GlCalls::glGetBooleanv), glGetBooleanv(__VA_ARGS__))
+#define glGetBufferParameteri64v(...) (GlCalls::Count(GlCalls::glGetBufferParameteri64v), glGetBufferParameteri64v(__VA_ARGS__))
+#define glGetBufferParameteriv(...) (GlCalls::Count(GlCalls::glGetBufferParameteriv), glGetBufferParameteriv(__VA_ARGS__))
+#define glGetBufferPointerv(...) (GlCalls::Count(GlCalls::glGetBufferPointerv), glGetBufferPointerv(__VA_ARGS__))
+#define glGetDebugMessageLog(...) (GlCalls::Count(GlCalls::glGetDebugMessageLog), glGetDebugMessageLog(__VA_ARGS__))
+#define glGetError(...) (GlCalls::Count(GlCalls::glGetError), glGetError(__VA_ARGS__))
+#define glGetFloatv(...) (GlCalls::Count(GlCalls::glGetFloatv), glGetFloatv(__VA_ARGS__))
+#define glGetFragDataLocation(...) (GlCalls::Count(GlCalls::glGetFragDataLocation), glGetFragDataLocation(__VA_ARGS__))
+#define glGetFramebufferAttachmentParameteriv(...) (GlCalls::Count(GlCalls::glGetFramebufferAttachmentParameteriv), glGetFramebufferAttachmentParameteriv(__VA_ARGS__))
+#define glGetFramebufferParameteriv(...) (GlCalls::Count(GlCalls::glGetFramebufferParameteriv), glGetFramebufferParameteriv(__VA_ARGS__))
+#define glGetGraphicsResetStatus(...) (GlCalls::Count(GlCalls::glGetGraphicsResetStatus), glGetGraphicsResetStatus(__VA_ARGS__))
+#define glGetInteger64i_v(...) (GlCalls::Count(GlCalls::glGetInteger64i_v), glGetInteger64i_v(__VA_ARGS__))
+#define glGetInteger64v(...) (GlCalls::Count(GlCalls::glGetInteger64v), glGetInteger64v(__VA_ARGS__))
+#define glGetIntegeri_v(...) (GlCalls::Count(GlCalls::glGetIntegeri_v), glGetIntegeri_v(__VA_ARGS__))
+#define glGetIntegerv(...) (GlCalls::Count(GlCalls::glGetIntegerv), glGetIntegerv(__VA_ARGS__))
+#define glGetInternalformativ(...) (GlCalls::Count(GlCalls::glGetInternalformativ), glGetInternalformativ(__VA_ARGS__))
+#define glGetMultisamplefv(...) (GlCalls::Count(GlCalls::glGetMultisamplefv), glGetMultisamplefv(__VA_ARGS__))
+#define glGetObjectLabel(...) (GlCalls::Count(GlCalls::glGetObjectLabel), glGetObjectLabel(__VA_ARGS__))
+#define glGetObjectPtrLabel(...) (GlCalls::Count(GlCalls::glGetObjectPtrLabel), glGetObjectPtrLabel(__VA_ARGS__))
+#define glGetPointerv(...) (GlCalls::Count(GlCalls::glGetPointerv), glGetPointerv(__VA_ARGS__))
+#define glGetProgramBinary(...) (GlCalls::Count(GlCalls::glGetProgramBinary), glGetProgramBinary(__VA_ARGS__))
+#define glGetProgramInfoLog(...) (GlCalls::Count(GlCalls::glGetProgramInfoLog), glGetProgramInfoLog(__VA_ARGS__))
+#define glGetProgramInterfaceiv(...) (GlCalls::Count(GlCalls::glGetProgramInterfaceiv), glGetProgramInterfaceiv(__VA_ARGS__))
+#define glGetProgramPipelineInfoLog(...) (GlCalls::Count(GlCalls::glGetProgramPipelineInfoLog), glGetProgramPipelineInfoLog(__VA_ARGS__))
+#define glGetProgramPipelineiv(...) (GlCalls::Count(GlCalls::glGetProgramPipelineiv), glGetProgramPipelineiv(__VA_ARGS__))
+#define glGetProgramResourceIndex(...) (GlCalls::Count(GlCalls::glGetProgramResourceIndex), glGetProgramResourceIndex(__VA_ARGS__))
+#define glGetProgramResourceLocation(...) (GlCalls::Count(GlCalls::glGetProgramResourceLocation), glGetProgramResourceLocation(__VA_ARGS__))
+#define glGetProgramResourceName(...) (GlCalls::Count(GlCalls::glGetProgramResourceName), glGetProgramResourceName(__VA_ARGS__))
+#define glGetProgramResourceiv(...) (GlCalls::Count(GlCalls::glGetProgramResourceiv), glGetProgramResourceiv(__VA_ARGS__))
+#define glGetProgramiv(...) (GlCalls::Count(GlCalls::glGetProgramiv), glGetProgramiv(__VA_ARGS__))
+#define glGetQueryObjectuiv(...) (GlCalls::Count(GlCalls::glGetQueryObjectuiv), glGetQueryObjectuiv(__VA_ARGS__))
+#define glGetQueryiv(...) (GlCalls::Count(GlCalls::glGetQueryiv), glGetQueryiv(__VA_ARGS__))
+#define glGetRenderbufferParameteriv(...) (GlCalls::Count(GlCalls::glGetRenderbufferParameteriv), glGetRenderbufferParameteriv(__VA_ARGS__))
+#define glGetSamplerParameterIiv(...) (GlCalls::Count(GlCalls::glGetSamplerParameterIiv), glGetSamplerParameterIiv(__VA_ARGS__))
+#define glGetSamplerParameterIuiv(...) (GlCalls::Count(GlCalls::glGetSamplerParameterIuiv), glGetSamplerParameterIuiv(__VA_ARGS__))
+#define glGetSamplerParameterfv(...) (GlCalls::Count(GlCalls::glGetSamplerParameterfv), glGetSamplerParameterfv(__VA_ARGS__))
+#define glGetSamplerParameteriv(...) (GlCalls::Count(GlCalls::glGetSamplerParameteriv), glGetSamplerParameteriv(__VA_ARGS__))
+#define glGetShaderInfoLog(...) (GlCalls::Count(GlCalls::glGetShaderInfoLog), glGetShaderInfoLog(__VA_ARGS__))
+#define glGetShaderPrecisionFormat(...) (GlCalls::Count(GlCalls::glGetShaderPrecisionFormat), glGetShaderPrecisionFormat(__VA_ARGS__))
+#define glGetShaderSource(...) (GlCalls::Count(GlCalls::glGetShaderSource), glGetShaderSource(__VA_ARGS__))
+#define glGetShaderiv(...) (GlCalls::Count(GlCalls::glGetShaderiv), glGetShaderiv(__VA_ARGS__))
+#define glGetString(...) (GlCalls::Count(GlCalls::glGetString), glGetString(__VA_ARGS__))
+#define glGetStringi(...) (GlCalls::Count(GlCalls::glGetStringi), glGetStringi(__VA_ARGS__))
+#define glGetSynciv(...) (GlCalls::Count(GlCalls::glGetSynciv), glGetSynciv(__VA_ARGS__))
+#define glGetTexLevelParameterfv(...) (GlCalls::Count(GlCalls::glGetTexLevelParameterfv), glGetTexLevelParameterfv(__VA_ARGS__))
+#define glGetTexLevelParameteriv(...) (GlCalls::Count(GlCalls::glGetTexLevelParameteriv), glGetTexLevelParameteriv(__VA_ARGS__))
+#define glGetTexParameterIiv(...) (GlCalls::Count(GlCalls::glGetTexParameterIiv), glGetTexParameterIiv(__VA_ARGS__))
+#define glGetTexParameterIuiv(...) (GlCalls::Count(GlCalls::glGetTexParameterIuiv), glGetTexParameterIuiv(__VA_ARGS__))
+#define glGetTexParameterfv(...) (GlCalls::Count(GlCalls::glGetTexParameterfv), glGetTexParameterfv(__VA_ARGS__))
+#define glGetTexParameteriv(...) (GlCalls::Count(GlCalls::glGetTexParameteriv), glGetTexParameteriv(__VA_ARGS__))
+#define glGetTransformFeedbackVarying(...) (GlCalls::Count(GlCalls::glGetTransformFeedbackVarying), glGetTransformFeedbackVarying(__VA_ARGS__))
+#define glGetUniformBlockIndex(...) (GlCalls::Count(GlCalls::glGetUniformBlockIndex), glGetUniformBlockIndex(__VA_ARGS__))
+#define glGetUniformIndices(...) (GlCalls::Count(GlCalls::glGetUniformIndices), glGetUniformIndices(__VA_ARGS__))
+#define glGetUniformLocation(...) (GlCalls::Count(GlCalls::glGetUniformLocation), glGetUniformLocation(__VA_ARGS__))
+#define glGetUniformfv(...) (GlCalls::Count(GlCalls::glGetUniformfv), glGetUniformfv(__VA_ARGS__))
+#define glGetUniformiv(...) (GlCalls::Count(GlCalls::glGetUniformiv), glGetUniformiv(__VA_ARGS__))
+#define glGetUniformuiv(...) (GlCalls::Count(GlCalls::glGetUniformuiv), glGetUniformuiv(__VA_ARGS__))
+#define glGetVertexAttribIiv(...) (GlCalls::Count(GlCalls::glGetVertexAttribIiv), glGetVertexAttribIiv(__VA_ARGS__))
+#define glGetVertexAttribIuiv(...) (GlCalls::Count(GlCalls::glGetVertexAttribIuiv), glGetVertexAttribIuiv(__VA_ARGS__))
+#define glGetVertexAttribPointerv(...) (GlCalls::Count(GlCalls::glGetVertexAttribPointerv), glGetVertexAttribPointerv(__VA_ARGS__))
+#define glGetVertexAttribfv(...) (GlCalls::Count(GlCalls::glGetVertexAttribfv), glGetVertexAttribfv(__VA_ARGS__))
+#define glGetVertexAttribiv(...) (GlCalls::Count(GlCalls::glGetVertexAttribiv), glGetVertexAttribiv(__VA_ARGS__))
+#define glGetnUniformfv(...) (GlCalls::Count(GlCalls::glGetnUniformfv), glGetnUniformfv(__VA_ARGS__))
+#define glGetnUniformiv(...) (GlCalls::Count(GlCalls::glGetnUniformiv), glGetnUniformiv(__VA_ARGS__))
+#define glGetnUniformuiv(...) (GlCalls::Count(GlCalls::glGetnUniformuiv), glGetnUniformuiv(__VA_ARGS__))
+#define glHint(...) (GlCalls::Count(GlCalls::glHint), glHint(__VA_ARGS__))
+#define glInvalidateFramebuffer(...) (GlCalls::Count(GlCalls::glInvalidateFramebuffer), glInvalidateFramebuffer(__VA_ARGS__))
+#define glInvalidateSubFramebuffer(...) (GlCalls::Count(GlCalls::glInvalidateSubFramebuffer), glInvalidateSubFramebuffer(__VA_ARGS__))
+#define glIsBuffer(...) (GlCalls::Count(GlCalls::glIsBuffer), glIsBuffer(__VA_ARGS__))
+#define glIsEnabled(...) (GlCalls::Count(GlCalls::glIsEnabled), glIsEnabled(__VA_ARGS__))
+#define glIsEnabledi(...) (GlCalls::Count(GlCalls::glIsEnabledi), glIsEnabledi(__VA_ARGS__))
+#define glIsFramebuffer(...) (GlCalls::Count(GlCalls::glIsFramebuffer), glIsFramebuffer(__VA_ARGS__))
+#define glIsProgram(...) (GlCalls::Count(GlCalls::glIsProgram), glIsProgram(__VA_ARGS__))
+#define glIsProgramPipeline(...) (GlCalls::Count(GlCalls::glIsProgramPipeline), glIsProgramPipeline(__VA_ARGS__))
+#define glIsQuery(...) (GlCalls::Count(GlCalls::glIsQuery), glIsQuery(__VA_ARGS__))
+#define glIsRenderbuffer(...) (GlCalls::Count(GlCalls::glIsRenderbuffer), glIsRenderbuffer(__VA_ARGS__))
+#define glIsSampler(...) (GlCalls::Count(GlCalls::glIsSampler), glIsSampler(__VA_ARGS__))
+#define glIsShader(...) (GlCalls::Count(GlCalls::glIsShader), glIsShader(__VA_ARGS__))
+#define glIsSync(...) (GlCalls::Count(GlCalls::glIsSync), glIsSync(__VA_ARGS__))
+#define glIsTexture(...) (GlCalls::Count(GlCalls::glIsTexture), glIsTexture(__VA_ARGS__))
+#define glIsTransformFeedback(...) (GlCalls::Count(GlCalls::glIsTransformFeedback), glIsTransformFeedback(__VA_ARGS__))
+#define glIsVertexArray(...) (GlCalls::Count(GlCalls::glIsVertexArray), glIsVertexArray(__VA_ARGS__))
+#define glLineWidth(...) (GlCalls::Count(GlCalls::glLineWidth), glLineWidth(__VA_ARGS__))
+#define glLinkProgram(...) (GlCalls::Count(GlCalls::glLinkProgram), glLinkProgram(__VA_ARGS__))
+#define glMapBufferRange(...) (GlCalls::Count(GlCalls::glMapBufferRange), glMapBufferRange(__VA_ARGS__))
+#define glMemoryBarrier(...) (GlCalls::Count(GlCalls::glMemoryBarrier), glMemoryBarrier(__VA_ARGS__))
+#define glMemoryBarrierByRegion(...) (GlCalls::Count(GlCalls::glMemoryBarrierByRegion), glMemoryBarrierByRegion(__VA_ARGS__))
+#define glMinSampleShading(...) (GlCalls::Count(GlCalls::glMinSampleShading), glMinSampleShading(__VA_ARGS__))
+#define glObjectLabel(...) (GlCalls::Count(GlCalls::glObjectLabel), glObjectLabel(__VA_ARGS__))
+#define glObjectPtrLabel(...) (GlCalls::Count(GlCalls::glObjectPtrLabel), glObjectPtrLabel(__VA_ARGS__))
+#define glPatchParameteri(...) (GlCalls::Count(GlCalls::glPatchParameteri), glPatchParameteri(__VA_ARGS__))
+#define glPauseTransformFeedback(...) (GlCalls::Count(GlCalls::glPauseTransformFeedback), glPauseTransformFeedback(__VA_ARGS__))
+#define glPixelStorei(...) (GlCalls::Count(GlCalls::glPixelStorei), glPixelStorei(__VA_ARGS__))
+#define glPolygonOffset(...) (GlCalls::Count(GlCalls::glPolygonOffset), glPolygonOffset(__VA_ARGS__))
+#define glPopDebugGroup(...) (GlCalls::Count(GlCalls::glPopDebugGroup), glPopDebugGroup(__VA_ARGS__))
+#define glPrimitiveBoundingBox(...) (GlCalls::Count(GlCalls::glPrimitiveBoundingBox), glPrimitiveBoundingBox(__VA_ARGS__))
+#define glProgramBinary(...) (GlCalls::Count(GlCalls::glProgramBinary), glProgramBinary(__VA_ARGS__))
+#define glProgramParameteri(...) (GlCalls::Count(GlCalls::glProgramParameteri), glProgramParameteri(__VA_ARGS__))
+#define glProgramUniform1f(...) (GlCalls::Count(GlCalls::glProgramUniform1f), glProgramUniform1f(__VA_ARGS__))
+#define glProgramUniform1fv(...) (GlCalls::Count(GlCalls::glProgramUniform1fv), glProgramUniform1fv(__VA_ARGS__))
+#define glProgramUniform1i(...) (GlCalls::Count(GlCalls::glProgramUniform1i), glProgramUniform1i(__VA_ARGS__))
+#define glProgramUniform1iv(...) (GlCalls::Count(GlCalls::glProgramUniform1iv), glProgramUniform1iv(__VA_ARGS__))
+#define glProgramUniform1ui(...) (GlCalls::Count(GlCalls::glProgramUniform1ui), glProgramUniform1ui(__VA_ARGS__))
+#define glProgramUniform1uiv(...) (GlCalls::Count(GlCalls::glProgramUniform1uiv), glProgramUniform1uiv(__VA_ARGS__))
+#define glProgramUniform2f(...) (GlCalls::Count(GlCalls::glProgramUniform2f), glProgramUniform2f(__VA_ARGS__))
+#define glProgramUniform2fv(...) (GlCalls::Count(GlCalls::glProgramUniform2fv), glProgramUniform2fv(__VA_ARGS__))
+#define glProgramUniform2i(...) (GlCalls::Count(GlCalls::glProgramUniform2i), glProgramUniform2i(__VA_ARGS__))
+#define glProgramUniform2iv(...) (GlCalls::Count(GlCalls::glProgramUniform2iv), glProgramUniform2iv(__VA_ARGS__))
+#define glProgramUniform2ui(...) (GlCalls::Count(GlCalls::glProgramUniform2ui), glProgramUniform2ui(__VA_ARGS__))
+#define glProgramUniform2uiv(...) (GlCalls::Count(GlCalls::glProgramUniform2uiv), glProgramUniform2uiv(__VA_ARGS__))
+#define glProgramUniform3f(...) (GlCalls::Count(GlCalls::glProgramUniform3f), glProgramUniform3f(__VA_ARGS__))
+#define glProgramUniform3fv(...) (GlCalls::Count(GlCalls::glProgramUniform3fv), glProgramUniform3fv(__VA_ARGS__))
+#define glProgramUniform3i(...) (GlCalls::Count(GlCalls::glProgramUniform3i), glProgramUniform3i(__VA_ARGS__))
+#define glProgramUniform3iv(...) (GlCalls::Count(GlCalls::glProgramUniform3iv), glProgramUniform3iv(__VA_ARGS__))
+#define glProgramUniform3ui(...) (GlCalls::Count(GlCalls::glProgramUniform3ui), glProgramUniform3ui(__VA_ARGS__))
+#define glProgramUniform3uiv(...) (GlCalls::Count(GlCalls::glProgramUniform3uiv), glProgramUniform3uiv(__VA_ARGS__))
+#define glProgramUniform4f(...) (GlCalls::Count(GlCalls::glProgramUniform4f), glProgramUniform4f(__VA_ARGS__))
+#define glProgramUniform4fv(...) (GlCalls::Count(GlCalls::glProgramUniform4fv), glProgramUniform4fv(__VA_ARGS__))
+#define glProgramUniform4i(...) (GlCalls::Count(GlCalls::glProgramUniform4i), glProgramUniform4i(__VA_ARGS__))
+#define glProgramUniform4iv(...) (GlCalls::Count(GlCalls::glProgramUniform4iv), glProgramUniform4iv(__VA_ARGS__))
+#define glProgramUniform4ui(...) (GlCalls::Count(GlCalls::glProgramUniform4ui), glProgramUniform4ui(__VA_ARGS__))
+#define glProgramUniform4uiv(...) (GlCalls::Count(GlCalls::glProgramUniform4uiv), glProgramUniform4uiv(__VA_ARGS__))
+#define glProgramUniformMatrix2fv(...) (GlCalls::Count(GlCalls::glProgramUniformMatrix2fv), glProgramUniformMatrix2fv(__VA_ARGS__))
+#define glProgramUniformMatrix2x3fv(...) (GlCalls::Count(GlCalls::glProgramUniformMatrix2x3fv), glProgramUniformMatrix2x3fv(__VA_ARGS__))
+#define glProgramUniformMatrix2x4fv(...) (GlCalls::Count(GlCalls::glProgramUniformMatrix2x4fv), glProgramUniformMatrix2x4fv(__VA_ARGS__))
+#define glProgramUniformMatrix3fv(...) (GlCalls::Count(GlCalls::glProgramUniformMatrix3fv), glProgramUniformMatrix3fv(__VA_ARGS__))
+#define glProgramUniformMatrix3x2fv(...) (GlCalls::Count(GlCalls::glProgramUniformMatrix3x2fv), glProgramUniformMatrix3x2fv(__VA_ARGS__))
+#define glProgramUniformMatrix3x4fv(...) (GlCalls::Count(GlCalls::glProgramUniformMatrix3x4fv), glProgramUniformMatrix3x4fv(__VA_ARGS__))
+#define glProgramUniformMatrix4fv(...) (GlCalls::Count(GlCalls::glProgramUniformMatrix4fv), glProgramUniformMatrix4fv(__VA_ARGS__))
+#define glProgramUniformMatrix4x2fv(...) (GlCalls::Count(GlCalls::glProgramUniformMatrix4x2fv), glProgramUniformMatrix4x2fv(__VA_ARGS__))
+#define glProgramUniformMatrix4x3fv(...) (GlCalls::Count(GlCalls::glProgramUniformMatrix4x3fv), glProgramUniformMatrix4x3fv(__VA_ARGS__))
+#define glPushDebugGroup(...) (GlCalls::Count(GlCalls::glPushDebugGroup), glPushDebugGroup(__VA_ARGS__))
+#define glReadBuffer(...) (GlCalls::Count(GlCalls::glReadBuffer), glReadBuffer(__VA_ARGS__))
+#define glReadPixels(...) (GlCalls::Count(GlCalls::glReadPixels), glReadPixels(__VA_ARGS__))
+#define glReadnPixels(...) (GlCalls::Count(GlCalls::glReadnPixels), glReadnPixels(__VA_ARGS__))
+#define glReleaseShaderCompiler(...) (GlCalls::Count(GlCalls::glReleaseShaderCompiler), glReleaseShaderCompiler(__VA_ARGS__))
+#define glRenderbufferStorage(...) (GlCalls::Count(GlCalls::glRenderbufferStorage), glRenderbufferStorage(__VA_ARGS__))
+#define glRenderbufferStorageMultisample(...) (GlCalls::Count(GlCalls::glRenderbufferStorageMultisample), glRenderbufferStorageMultisample(__VA_ARGS__))
+#define glResumeTransformFeedback(...) (GlCalls::Count(GlCalls::glResumeTransformFeedback), glResumeTransformFeedback(__VA_ARGS__))
+#define glSampleCoverage(...) (GlCalls::Count(GlCalls::glSampleCoverage), glSampleCoverage(__VA_ARGS__))
+#define glSampleMaski(...) (GlCalls::Count(GlCalls::glSampleMaski), glSampleMaski(__VA_ARGS__))
+#define glSamplerParameterIiv(...) (GlCalls::Count(GlCalls::glSamplerParameterIiv), glSamplerParameterIiv(__VA_ARGS__))
+#define glSamplerParameterIuiv(...) (GlCalls::Count(GlCalls::glSamplerParameterIuiv), glSamplerParameterIuiv(__VA_ARGS__))
+#define glSamplerParameterf(...) (GlCalls::Count(GlCalls::glSamplerParameterf), glSamplerParameterf(__VA_ARGS__))
+#define glSamplerParameterfv(...) (GlCalls::Count(GlCalls::glSamplerParameterfv), glSamplerParameterfv(__VA_ARGS__))
+#define glSamplerParameteri(...) (GlCalls::Count(GlCalls::glSamplerParameteri), glSamplerParameteri(__VA_ARGS__))
+#define glSamplerParameteriv(...) (GlCalls::Count(GlCalls::glSamplerParameteriv), glSamplerParameteriv(__VA_ARGS__))
+#define glScissor(...) (GlCalls::Count(GlCalls::glScissor), glScissor(__VA_ARGS__))
+#define glShaderBinary(...) (GlCalls::Count(GlCalls::glShaderBinary), glShaderBinary(__VA_ARGS__))
+#define glShaderSource(...) (GlCalls::Count(GlCalls::glShaderSource), glShaderSource(__VA_ARGS__))
+#define glStencilFunc(...) (GlCalls::Count(GlCalls::glStencilFunc), glStencilFunc(__VA_ARGS__))
+#define glStencilFuncSeparate(...) (GlCalls::Count(GlCalls::glStencilFuncSeparate), glStencilFuncSeparate(__VA_ARGS__))
+#define glStencilMask(...) (GlCalls::Count(GlCalls::glStencilMask), glStencilMask(__VA_ARGS__))
+#define glStencilMaskSeparate(...) (GlCalls::Count(GlCalls::glStencilMaskSeparate), glStencilMaskSeparate(__VA_ARGS__))
+#define glStencilOp(...) (GlCalls::Count(GlCalls::glStencilOp), glStencilOp(__VA_ARGS__))
+#define glStencilOpSeparate(...) (GlCalls::Count(GlCalls::glStencilOpSeparate), glStencilOpSeparate(__VA_ARGS__))
+#define glTexBuffer(...) (GlCalls::Count(GlCalls::glTexBuffer), glTexBuffer(__VA_ARGS__))
+#define glTexBufferRange(...) (GlCalls::Count(GlCalls::glTexBufferRange), glTexBufferRange(__VA_ARGS__))
+#define glTexImage2D(...) (GlCalls::Count(GlCalls::glTexImage2D), glTexImage2D(__VA_ARGS__))
+#define glTexImage3D(...) (GlCalls::Count(GlCalls::glTexImage3D), glTexImage3D(__VA_ARGS__))
+#define glTexParameterIiv(...) (GlCalls::Count(GlCalls::glTexParameterIiv), glTexParameterIiv(__VA_ARGS__))
+#define glTexParameterIuiv(...) (GlCalls::Count(GlCalls::glTexParameterIuiv), glTexParameterIuiv(__VA_ARGS__))
+#define glTexParameterf(...) (GlCalls::Count(GlCalls::glTexParameterf), glTexParameterf(__VA_ARGS__))
+#define glTexParameterfv(...) (GlCalls::Count(GlCalls::glTexParameterfv), glTexParameterfv(__VA_ARGS__))
+#define glTexParameteri(...) (GlCalls::Count(GlCalls::glTexParameteri), glTexParameteri(__VA_ARGS__))
+#define glTexParameteriv(...) (GlCalls::Count(GlCalls::glTexParameteriv), glTexParameteriv(__VA_ARGS__))
+#define glTexStorage2D(...) (GlCalls::Count(GlCalls::glTexStorage2D), glTexStorage2D(__VA_ARGS__))
+#define glTexStorage2DMultisample(...) (GlCalls::Count(GlCalls::glTexStorage2DMultisample), glTexStorage2DMultisample(__VA_ARGS__))
+#define glTexStorage3D(...) (GlCalls::Count(GlCalls::glTexStorage3D), glTexStorage3D(__VA_ARGS__))
+#define glTexStorage3DMultisample(...) (GlCalls::Count(GlCalls::glTexStorage3DMultisample), glTexStorage3DMultisample(__VA_ARGS__))
+#define glTexSubImage2D(...) (GlCalls::Count(GlCalls::glTexSubImage2D), glTexSubImage2D(__VA_ARGS__))
+#define glTexSubImage3D(...) (GlCalls::Count(GlCalls::glTexSubImage3D), glTexSubImage3D(__VA_ARGS__))
+#define glTransformFeedbackVaryings(...) (GlCalls::Count(GlCalls::glTransformFeedbackVaryings), glTransformFeedbackVaryings(__VA_ARGS__))
+#define glUniform1f(...) (GlCalls::Count(GlCalls::glUniform1f), glUniform1f(__VA_ARGS__))
+#define glUniform1fv(...) (GlCalls::Count(GlCalls::glUniform1fv), glUniform1fv(__VA_ARGS__))
+#define glUniform1i(...) (GlCalls::Count(GlCalls::glUniform1i), glUniform1i(__VA_ARGS__))
+#define glUniform1iv(...) (GlCalls::Count(GlCalls::glUniform1iv), glUniform1iv(__VA_ARGS__))
+#define glUniform1ui(...) (GlCalls::Count(GlCalls::glUniform1ui), glUniform1ui(__VA_ARGS__))
+#define glUniform1uiv(...) (GlCalls::Count(GlCalls::glUniform1uiv), glUniform1uiv(__VA_ARGS__))
+#define glUniform2f(...) (GlCalls::Count(GlCalls::glUniform2f), glUniform2f(__VA_ARGS__))
+#define glUniform2fv(...) (GlCalls::Count(GlCalls::glUniform2fv), glUniform2fv(__VA_ARGS__))
+#define glUniform2i(...) (GlCalls::Count(GlCalls::glUniform2i), glUniform2i(__VA_ARGS__))
+#define glUniform2iv(...) (GlCalls::Count(GlCalls::glUniform2iv), glUniform2iv(__VA_ARGS__))
+#define glUniform2ui(...) (GlCalls::Count(GlCalls::glUniform2ui), glUniform2ui(__VA_ARGS__))
+#define glUniform2uiv(...) (GlCalls::Count(GlCalls::glUniform2uiv), glUniform2uiv(__VA_ARGS__))
+#define glUniform3f(...) (GlCalls::Count(GlCalls::glUniform3f), glUniform3f(__VA_ARGS__))
+#define glUniform3fv(...) (GlCalls::Count(GlCalls::glUniform3fv), glUniform3fv(__VA_ARGS__))
+#define glUniform3i(...) (GlCalls::Count(GlCalls::glUniform3i), glUniform3i(__VA_ARGS__))
+#define glUniform3iv(...) (GlCalls::Count(GlCalls::glUniform3iv), glUniform3iv(__VA_ARGS__))
+#define glUniform3ui(...) (GlCalls::Count(GlCalls::glUniform3ui), glUniform3ui(__VA_ARGS__))
+#define glUniform3uiv(...) (GlCalls::Count(GlCalls::glUniform3uiv), glUniform3uiv(__VA_ARGS__))
+#define glUniform4f(...) (GlCalls::Count(GlCalls::glUniform4f), glUniform4f(__VA_ARGS__))
+#define glUniform4fv(...) (GlCalls::Count(GlCalls::glUniform4fv), glUniform4fv(__VA_ARGS__))
+#define glUniform4i(...) (GlCalls::Count(GlCalls::glUniform4i), glUniform4i(__VA_ARGS__))
+#define glUniform4iv(...) (GlCalls::Count(GlCalls::glUniform4iv), glUniform4iv(__VA_ARGS__))
+#define glUniform4ui(...) (GlCalls::Count(GlCalls::glUniform4ui), glUniform4ui(__VA_ARGS__))
+#define glUniform4uiv(...) (GlCalls::Count(GlCalls::glUniform4uiv), glUniform4uiv(__VA_ARGS__))
+#define glUniformBlockBinding(...) (GlCalls::Count(GlCalls::glUniformBlockBinding), glUniformBlockBinding(__VA_ARGS__))
+#define glUniformMatrix2fv(...) (GlCalls::Count(GlCalls::glUniformMatrix2fv), glUniformMatrix2fv(__VA_ARGS__))
+#define glUniformMatrix2x3fv(...) (GlCalls::Count(GlCalls::glUniformMatrix2x3fv), glUniformMatrix2x3fv(__VA_ARGS__))
+#define glUniformMatrix2x4fv(...) (GlCalls::Count(GlCalls::glUniformMatrix2x4fv), glUniformMatrix2x4fv(__VA_ARGS__))
+#define glUniformMatrix3fv(...) (GlCalls::Count(GlCalls::glUniformMatrix3fv), glUniformMatrix3fv(__VA_ARGS__))
+#define glUniformMatrix3x2fv(...) (GlCalls::Count(GlCalls::glUniformMatrix3x2fv), glUniformMatrix3x2fv(__VA_ARGS__))
+#define glUniformMatrix3x4fv(...) (GlCalls::Count(GlCalls::glUniformMatrix3x4fv), glUniformMatrix3x4fv(__VA_ARGS__))
+#define glUniformMatrix4fv(...) (GlCalls::Count(GlCalls::glUniformMatrix4fv), glUniformMatrix4fv(__VA_ARGS__))
+#define glUniformMatrix4x2fv(...) (GlCalls::Count(GlCalls::glUniformMatrix4x2fv), glUniformMatrix4x2fv(__VA_ARGS__))
+#define glUniformMatrix4x3fv(...) (GlCalls::Count(GlCalls::glUniformMatrix4x3fv), glUniformMatrix4x3fv(__VA_ARGS__))
+#define glUnmapBuffer(...) (GlCalls::Count(GlCalls::glUnmapBuffer), glUnmapBuffer(__VA_ARGS__))
+#define glUseProgram(...) (GlCalls::Count(GlCalls::glUseProgram), glUseProgram(__VA_ARGS__))
+#define glUseProgramStages(...) (GlCalls::Count(GlCalls::glUseProgramStages), glUseProgramStages(__VA_ARGS__))
+#define glValidateProgram(...) (GlCalls::Count(GlCalls::glValidateProgram), glValidateProgram(__VA_ARGS__))
+#define glValidateProgramPipeline(...) (GlCalls::Count(GlCalls::glValidateProgramPipeline), glValidateProgramPipeline(__VA_ARGS__))
+#define glVertexAttrib1f(...) (GlCalls::Count(GlCalls::glVertexAttrib1f), glVertexAttrib1f(__VA_ARGS__))
+#define glVertexAttrib1fv(...) (GlCalls::Count(GlCalls::glVertexAttrib1fv), glVertexAttrib1fv(__VA_ARGS__))
+#define glVertexAttrib2f(...) (GlCalls::Count(GlCalls::glVertexAttrib2f), glVertexAttrib2f(__VA_ARGS__))
+#define glVertexAttrib2fv(...) (GlCalls::Count(GlCalls::glVertexAttrib2fv), glVertexAttrib2fv(__VA_ARGS__))
+#define glVertexAttrib3f(...) (GlCalls::Count(GlCalls::glVertexAttrib3f), glVertexAttrib3f(__VA_ARGS__))
+#define glVertexAttrib3fv(...) (GlCalls::Count(GlCalls::glVertexAttrib3fv), glVertexAttrib3fv(__VA_ARGS__))
+#define glVertexAttrib4f(...) (GlCalls::Count(GlCalls::glVertexAttrib4f), glVertexAttrib4f(__VA_ARGS__))
+#define glVertexAttrib4fv(...) (GlCalls::Count(GlCalls::glVertexAttrib4fv), glVertexAttrib4fv(__VA_ARGS__))
+#define glVertexAttribBinding(...) (GlCalls::Count(GlCalls::glVertexAttribBinding), glVertexAttribBinding(__VA_ARGS__))
+#define glVertexAttribDivisor(...) (GlCalls::Count(GlCalls::glVertexAttribDivisor), glVertexAttribDivisor(__VA_ARGS__))
+#define glVertexAttribFormat(...) (GlCalls::Count(GlCalls::glVertexAttribFormat), glVertexAttribFormat(__VA_ARGS__))
+#define glVertexAttribI4i(...) (GlCalls::Count(GlCalls::glVertexAttribI4i), glVertexAttribI4i(__VA_ARGS__))
+#define glVertexAttribI4iv(...) (GlCalls::Count(GlCalls::glVertexAttribI4iv), glVertexAttribI4iv(__VA_ARGS__))
+#define glVertexAttribI4ui(...) (GlCalls::Count(GlCalls::glVertexAttribI4ui), glVertexAttribI4ui(__VA_ARGS__))
+#define glVertexAttribI4uiv(...) (GlCalls::Count(GlCalls::glVertexAttribI4uiv), glVertexAttribI4uiv(__VA_ARGS__))
+#define glVertexAttribIFormat(...) (GlCalls::Count(GlCalls::glVertexAttribIFormat), glVertexAttribIFormat(__VA_ARGS__))
+#define glVertexAttribIPointer(...) (GlCalls::Count(GlCalls::glVertexAttribIPointer), glVertexAttribIPointer(__VA_ARGS__))
+#define glVertexAttribPointer(...) (GlCalls::Count(GlCalls::glVertexAttribPointer), glVertexAttribPointer(__VA_ARGS__))
+#define glVertexBindingDivisor(...) (GlCalls::Count(GlCalls::glVertexBindingDivisor), glVertexBindingDivisor(__VA_ARGS__))
+#define glViewport(...) (GlCalls::Count(GlCalls::glViewport), glViewport(__VA_ARGS__))
+#define glWaitSync(...) (GlCalls::Count(GlCalls::glWaitSync), glWaitSync(__VA_ARGS__))
+#define glFramebufferTexture2DMultisampleEXT(...) (GlCalls::Count(GlCalls::glFramebufferTexture2DMultisampleEXT), glFramebufferTexture2DMultisampleEXT(__VA_ARGS__))
+#define glGetQueryObjectui64vEXT(...) (GlCalls::Count(GlCalls::glGetQueryObjectui64vEXT), glGetQueryObjectui64vEXT(__VA_ARGS__))
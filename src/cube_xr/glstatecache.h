@@ -0,0 +1,151 @@
+#pragma once
+
+#include "glcalls.h"
+
+#include <atomic>
+#include <cstdint>
+
+// Shadows the bits of GL context state the renderer touches every eye and drops calls
+// that would not change anything. All state changes of the plugin must go through here
+// (or be followed by Invalidate()), otherwise the shadow copy goes stale.
+// Counts the calls it drops; the calls made are counted by glcalls.h.
+class GlStateCache {
+public:
+    struct Stats {
+        std::atomic<uint64_t> skipped{0};
+    };
+
+    void Invalidate() {
+        m_capabilities = 0;
+        m_capabilitiesKnown = 0;
+        m_frontFace = m_cullFace = InvalidEnum;
+        m_program = m_vertexArray = m_framebuffer = InvalidName;
+        m_viewport[0] = m_viewport[1] = m_viewport[2] = m_viewport[3] = -1;
+        m_clearColorKnown = m_clearDepthKnown = false;
+    }
+
+    void Enable(GLenum capability) { SetCapability(capability, true); }
+    void Disable(GLenum capability) { SetCapability(capability, false); }
+
+    void FrontFace(GLenum mode) {
+        if (Changed(m_frontFace, mode)) glFrontFace(mode);
+    }
+
+    void CullFace(GLenum mode) {
+        if (Changed(m_cullFace, mode)) glCullFace(mode);
+    }
+
+    void UseProgram(GLuint program) {
+        if (Changed(m_program, program)) glUseProgram(program);
+    }
+
+    void BindVertexArray(GLuint vertexArray) {
+        if (Changed(m_vertexArray, vertexArray)) glBindVertexArray(vertexArray);
+    }
+
+    void BindFramebuffer(GLuint framebuffer) {
+        if (Changed(m_framebuffer, framebuffer)) glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+
+    // Separate read and draw bindings, for blits. The GL_FRAMEBUFFER binding is only known
+    // again once both point at the same framebuffer.
+    void BindFramebuffers(GLuint read, GLuint draw) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, read);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw);
+        m_framebuffer = read == draw ? read : InvalidName;
+    }
+
+    void Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (m_viewport[0] == x && m_viewport[1] == y && m_viewport[2] == width && m_viewport[3] == height) {
+            Skip();
+            return;
+        }
+        m_viewport[0] = x;
+        m_viewport[1] = y;
+        m_viewport[2] = width;
+        m_viewport[3] = height;
+        glViewport(x, y, width, height);
+    }
+
+    void ClearColor(const float color[4]) {
+        if (m_clearColorKnown && m_clearColor[0] == color[0] && m_clearColor[1] == color[1] &&
+            m_clearColor[2] == color[2] && m_clearColor[3] == color[3]) {
+            Skip();
+            return;
+        }
+        for (int i = 0; i < 4; i++) m_clearColor[i] = color[i];
+        m_clearColorKnown = true;
+        glClearColor(color[0], color[1], color[2], color[3]);
+    }
+
+    void ClearDepth(float depth) {
+        if (m_clearDepthKnown && m_clearDepth == depth) {
+            Skip();
+            return;
+        }
+        m_clearDepth = depth;
+        m_clearDepthKnown = true;
+        glClearDepthf(depth);
+    }
+
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    static const GLenum InvalidEnum = 0xFFFFFFFFu;
+    static const GLuint InvalidName = 0xFFFFFFFFu;
+
+    static int CapabilityBit(GLenum capability) {
+        switch (capability) {
+            case GL_CULL_FACE: return 0;
+            case GL_DEPTH_TEST: return 1;
+            case GL_BLEND: return 2;
+            case GL_SCISSOR_TEST: return 3;
+            case GL_STENCIL_TEST: return 4;
+            default: return -1;
+        }
+    }
+
+    void SetCapability(GLenum capability, bool enable) {
+        const int bit = CapabilityBit(capability);
+        if (bit >= 0) {
+            const uint32_t mask = 1u << bit;
+            if ((m_capabilitiesKnown & mask) && ((m_capabilities & mask) != 0) == enable) {
+                Skip();
+                return;
+            }
+            m_capabilitiesKnown |= mask;
+            m_capabilities = enable ? (m_capabilities | mask) : (m_capabilities & ~mask);
+        }
+        if (enable) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    }
+
+    template <typename T>
+    bool Changed(T& current, T value) {
+        if (current == value) {
+            Skip();
+            return false;
+        }
+        current = value;
+        return true;
+    }
+
+    void Skip() { m_stats.skipped.fetch_add(1, std::memory_order_relaxed); }
+
+    uint32_t m_capabilities{0};
+    uint32_t m_capabilitiesKnown{0};
+    GLenum m_frontFace{InvalidEnum};
+    GLenum m_cullFace{InvalidEnum};
+    GLuint m_program{InvalidName};
+    GLuint m_vertexArray{InvalidName};
+    GLuint m_framebuffer{InvalidName};
+    GLint m_viewport[4] = {-1, -1, -1, -1};
+    float m_clearColor[4] = {};
+    bool m_clearColorKnown{false};
+    float m_clearDepth{1.0f};
+    bool m_clearDepthKnown{false};
+    Stats m_stats;
+};
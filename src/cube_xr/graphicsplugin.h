@@ -1,9 +1,25 @@
 #pragma once
 #include "pxr/PxrApi.h"
+#include "geometry.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+const uint32_t MaxMeshLods = 4;
 
 struct Cube {
     PxrPosef    Pose;
     PxrVector3f Scale;
+    uint32_t    Lod = 0;  // mesh level of detail, 0 is the most detailed
+};
+
+// One level of detail of the mesh drawn for cubes.
+struct MeshLod {
+    const Geometry::Vertex* vertices;
+    uint32_t vertexCount;
+    const uint16_t* indices;
+    uint32_t indexCount;
 };
 
 typedef struct PxrFovf {
@@ -19,12 +35,55 @@ typedef struct PxrProjectionView_ {
     PxrRecti                    imageRect;
 } PxrProjectionView;
 
+const uint32_t MaxSwapchainImages = 3;
+
+// What happens to an attachment's previous contents at the start of a view, and to the
+// rendered contents at its end. On tiled GPUs, Load and Store cost a full read or write
+// of the attachment through memory; Clear and DontCare stay on-chip.
+enum class LoadAction { Load, Clear, DontCare };
+enum class StoreAction { Store, DontCare };
+enum class DepthFormat { D16, D24, D32F };
+
+struct RenderPassActions {
+    LoadAction  colorLoad   = LoadAction::Clear;
+    StoreAction colorStore  = StoreAction::Store;
+    LoadAction  depthLoad   = LoadAction::Clear;
+    StoreAction depthStore  = StoreAction::DontCare;
+    DepthFormat depthFormat = DepthFormat::D24;
+};
+
 struct IGraphicsPlugin {
     virtual ~IGraphicsPlugin() = default;
 
+    // Where compiled program binaries are kept between launches. Call before InitializeDevice().
+    virtual void SetCacheDirectory(const std::string& directory) = 0;
+
     virtual void InitializeDevice() = 0;
 
-    virtual void RenderView_N(PxrEyeType eye,const PxrProjectionView*  layerViews, uint64_t colorTexture,
+    // Bracket the RenderView_N calls of one frame.
+    virtual void BeginFrame() = 0;
+    virtual void EndFrame() = 0;
+
+    // GPU time of the latest frame whose timer query has completed (a few frames back),
+    // or 0 without EXT_disjoint_timer_query.
+    virtual uint64_t GpuFrameTimeNs() const = 0;
+    // The part of that frame spent stretching views rendered below the swapchain size over
+    // their images; 0 when every view was rendered at full size.
+    virtual uint64_t GpuUpscaleTimeNs() const = 0;
+
+    // Takes effect for framebuffers built afterwards (depth format) and the next view (actions).
+    virtual void SetRenderPassActions(const RenderPassActions& actions) = 0;
+
+    // Replaces the meshes drawn for cubes, most detailed first (by default the unit cube as
+    // the only LOD); Cube::Lod picks one, past the last means the last. All LODs share one
+    // buffer, so together they may have at most 65536 vertices. With optimize, the triangles
+    // are first reordered for the post-transform cache and for overdraw.
+    virtual void SetMesh(const MeshLod* lods, uint32_t lodCount, bool optimize) = 0;
+
+    // Builds one framebuffer per swapchain image of the eye, so rendering only has to bind it.
+    virtual void SetSwapchainImages(PxrEyeType eye, const uint64_t* images, uint32_t imageCount, int samples) = 0;
+
+    virtual void RenderView_N(PxrEyeType eye,const PxrProjectionView*  layerViews, uint32_t imageIndex,
                              const std::vector<Cube>& cubes,int samples) = 0;
 };
 
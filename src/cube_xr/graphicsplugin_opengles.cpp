@@ -1,13 +1,15 @@
 #include "common.h"
 #include "geometry.h"
+#include "glcalls.h"
+#include "glstatecache.h"
 #include "graphicsplugin.h"
+#include "instrumentation.h"
+#include "meshoptimizer.h"
+#include "programcache.h"
+#include "streamingbuffer.h"
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
-#include <GLES2/gl2.h>
-#include <GLES2/gl2ext.h>
-#include <GLES3/gl3.h>
-#include <GLES3/gl32.h>
 
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -15,19 +17,22 @@
 
 namespace {
 constexpr float DarkSlateGray[] = {0.184313729f, 0.309803933f, 0.309803933f, 1.0f};
+constexpr int FramesInFlight = 3;
+constexpr size_t InstanceBytesPerFrame = 256 * 1024;
 
 static const char* VertexShaderGlsl = R"_(
     #version 320 es
 
     in vec3 VertexPos;
     in vec3 VertexColor;
+    in mat4 InstanceModel;
 
     out vec3 PSVertexColor;
 
-    uniform mat4 ModelViewProjection;
+    uniform mat4 ViewProjection;
 
     void main() {
-       gl_Position = ModelViewProjection * vec4(VertexPos, 1.0);
+       gl_Position = ViewProjection * InstanceModel * vec4(VertexPos, 1.0);
        PSVertexColor = VertexColor;
     }
     )_";
@@ -44,6 +49,37 @@ static const char* FragmentShaderGlsl = R"_(
     )_";
 
 struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
+    struct SwapchainFramebuffer {
+        GLuint framebuffer = 0;
+        GLuint colorTexture = 0;
+        GLuint depthTexture = 0;
+        GLuint blitFramebuffer = 0;  // color only and single-sampled, for blits
+        GLint width = 0;
+        GLint height = 0;
+        int samples = 0;
+        DepthFormat depthFormat = DepthFormat::D24;
+    };
+
+    // Where one LOD lives in the shared index buffer.
+    struct MeshRange {
+        uint32_t firstIndex = 0;
+        GLsizei indexCount = 0;
+        float acmr = 0.0f;
+    };
+
+    // The instances of one LOD in this frame's upload.
+    struct InstanceRange {
+        GLsizei first = 0;
+        GLsizei count = 0;
+    };
+
+    // A view rendered into the scaled target, to be stretched over its swapchain image.
+    struct Upscale {
+        const SwapchainFramebuffer* source;
+        const SwapchainFramebuffer* destination;
+        PxrRecti rect;
+    };
+
     OpenGLESGraphicsPlugin(){};
 
     OpenGLESGraphicsPlugin(const OpenGLESGraphicsPlugin&) = delete;
@@ -52,8 +88,16 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
     OpenGLESGraphicsPlugin& operator=(OpenGLESGraphicsPlugin&&) = delete;
 
     ~OpenGLESGraphicsPlugin() override {
-        if (m_swapchainFramebuffer != 0) {
-            glDeleteFramebuffers(1, &m_swapchainFramebuffer);
+        for (auto& eyeFramebuffers : m_swapchainFramebuffers) {
+            for (SwapchainFramebuffer& framebuffer : eyeFramebuffers) {
+                DestroyFramebuffer(framebuffer);
+            }
+        }
+        for (SwapchainFramebuffer& framebuffer : m_scaledFramebuffers) {
+            if (framebuffer.colorTexture != 0) {
+                glDeleteTextures(1, &framebuffer.colorTexture);
+            }
+            DestroyFramebuffer(framebuffer);
         }
         if (m_program != 0) {
             glDeleteProgram(m_program);
@@ -61,21 +105,24 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         if (m_vao != 0) {
             glDeleteVertexArrays(1, &m_vao);
         }
-        if (m_cubeVertexBuffer != 0) {
-            glDeleteBuffers(1, &m_cubeVertexBuffer);
+        if (m_meshVertexBuffer != 0) {
+            glDeleteBuffers(1, &m_meshVertexBuffer);
         }
-        if (m_cubeIndexBuffer != 0) {
-            glDeleteBuffers(1, &m_cubeIndexBuffer);
+        if (m_meshIndexBuffer != 0) {
+            glDeleteBuffers(1, &m_meshIndexBuffer);
         }
-
-        for (auto& colorToDepth : m_colorToDepthMap) {
-            if (colorToDepth.second != 0) {
-                glDeleteTextures(1, &colorToDepth.second);
-            }
+        m_instanceBuffer.Destroy();
+        if (glGetQueryObjectui64vEXT) {
+            glDeleteQueries(FramesInFlight, m_timerQueries);
+            glDeleteQueries(FramesInFlight, m_upscaleQueries);
         }
     }
 
     bool InitContext(){
+        // A context made current by the embedder (e.g. a headless test) is used as is.
+        if (eglGetCurrentContext() != EGL_NO_CONTEXT) {
+            return true;
+        }
 
         EGLint numConfigs;
         EGLConfig config = nullptr;
@@ -144,90 +191,303 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         return true;
     }
 
+    void SetCacheDirectory(const std::string& directory) override { m_programCache.SetDirectory(directory); }
+
     void InitializeDevice() override {
         InitContext();
         InitializeResources();
     }
 
     PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEIMGPROC glFramebufferTexture2DMultisampleEXT = NULL;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vEXT = NULL;
     void InitializeResources() {
-        glFramebufferTexture2DMultisampleEXT = (PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEIMGPROC) eglGetProcAddress(
-                    "glFramebufferTexture2DMultisampleEXT");
+        const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+        if (extensions != nullptr && strstr(extensions, "GL_EXT_multisampled_render_to_texture") != nullptr) {
+            glFramebufferTexture2DMultisampleEXT = (PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEIMGPROC) eglGetProcAddress(
+                        "glFramebufferTexture2DMultisampleEXT");
+        }
         if (!glFramebufferTexture2DMultisampleEXT) {
-            Log::Write(Log::Level::Error, "Couldn't get function pointer to glFramebufferTexture2DMultisampleEXT()!");
+            Log::Write(Log::Level::Warning, "No glFramebufferTexture2DMultisampleEXT(), rendering without multisampling");
+        }
+
+        if (extensions != nullptr && strstr(extensions, "GL_EXT_disjoint_timer_query") != nullptr) {
+            glGetQueryObjectui64vEXT = (PFNGLGETQUERYOBJECTUI64VEXTPROC) eglGetProcAddress("glGetQueryObjectui64vEXT");
+        }
+        if (glGetQueryObjectui64vEXT) {
+            glGenQueries(FramesInFlight, m_timerQueries);
+            glGenQueries(FramesInFlight, m_upscaleQueries);
+        }
+
+        m_program = m_programCache.Build("cube", VertexShaderGlsl, FragmentShaderGlsl);
+        if (m_program == 0) {
             return;
         }
-        glGenFramebuffers(1, &m_swapchainFramebuffer);
-
-        GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShader, 1, &VertexShaderGlsl, nullptr);
-        glCompileShader(vertexShader);
-        CheckShader(vertexShader);
-        GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShader, 1, &FragmentShaderGlsl, nullptr);
-        glCompileShader(fragmentShader);
-        CheckShader(fragmentShader);
-        m_program = glCreateProgram();
-        glAttachShader(m_program, vertexShader);
-        glAttachShader(m_program, fragmentShader);
-        glLinkProgram(m_program);
-        CheckProgram(m_program);
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
-
-        m_modelViewProjectionUniformLocation = glGetUniformLocation(m_program,
-                                                                    "ModelViewProjection");
+
+        m_viewProjectionUniformLocation = glGetUniformLocation(m_program, "ViewProjection");
 
         m_vertexAttribCoords = glGetAttribLocation(m_program, "VertexPos");
         m_vertexAttribColor = glGetAttribLocation(m_program, "VertexColor");
-        glGenBuffers(1, &m_cubeVertexBuffer);
-        glBindBuffer(GL_ARRAY_BUFFER, m_cubeVertexBuffer);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(Geometry::c_cubeVertices), Geometry::c_cubeVertices, GL_STATIC_DRAW);
-
-        glGenBuffers(1, &m_cubeIndexBuffer);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cubeIndexBuffer);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Geometry::c_cubeIndices), Geometry::c_cubeIndices, GL_STATIC_DRAW);
+        m_instanceAttribModel = glGetAttribLocation(m_program, "InstanceModel");
+        glGenBuffers(1, &m_meshVertexBuffer);
+        glGenBuffers(1, &m_meshIndexBuffer);
         glGenVertexArrays(1, &m_vao);
         glBindVertexArray(m_vao);
         glEnableVertexAttribArray(m_vertexAttribCoords);
         glEnableVertexAttribArray(m_vertexAttribColor);
-        glBindBuffer(GL_ARRAY_BUFFER, m_cubeVertexBuffer);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cubeIndexBuffer);
-        glVertexAttribPointer(m_vertexAttribCoords, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex), nullptr);
-        glVertexAttribPointer(m_vertexAttribColor, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex),
-                              reinterpret_cast<const void*>(sizeof(PxrVector3f)));
+        glBindBuffer(GL_ARRAY_BUFFER, m_meshVertexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_meshIndexBuffer);
+        // snorm16 positions and unorm8 colors are expanded to floats by the vertex fetch.
+        glVertexAttribPointer(m_vertexAttribCoords, 3, GL_SHORT, GL_TRUE, sizeof(Geometry::Vertex),
+                              reinterpret_cast<const void*>(offsetof(Geometry::Vertex, Position)));
+        glVertexAttribPointer(m_vertexAttribColor, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Geometry::Vertex),
+                              reinterpret_cast<const void*>(offsetof(Geometry::Vertex, Color)));
+        // A mat4 attribute takes four consecutive locations, one per column.
+        for (int column = 0; column < 4; column++) {
+            glEnableVertexAttribArray(m_instanceAttribModel + column);
+            glVertexAttribDivisor(m_instanceAttribModel + column, 1);
+        }
+        glBindVertexArray(0);
+        m_state.Invalidate();
+        const MeshLod cube = {Geometry::c_cubeVertices, (uint32_t)ArraySize(Geometry::c_cubeVertices),
+                              Geometry::c_cubeIndices, (uint32_t)ArraySize(Geometry::c_cubeIndices)};
+        SetMesh(&cube, 1, false);
+
+        // Per-object model matrices are rewritten every frame.
+        m_instanceBuffer.Initialize(GL_ARRAY_BUFFER, InstanceBytesPerFrame, FramesInFlight);
+        Instrumentation::AddReporter("gles", [this](std::ostringstream& out, double seconds) { Report(out, seconds); });
+    }
+
+    void SetMesh(const MeshLod* lods, uint32_t lodCount, bool optimize) override {
+        lodCount = std::min(lodCount, MaxMeshLods);
+        uint32_t totalVertices = 0;
+        for (uint32_t lod = 0; lod < lodCount; lod++) {
+            totalVertices += lods[lod].vertexCount;
+        }
+        if (lodCount == 0 || totalVertices > 65536) {
+            Log::Write(Log::Level::Error, Fmt("Unsupported mesh: %u LODs with %u vertices", lodCount, totalVertices));
+            return;
+        }
+
+        // LODs are concatenated; indices are rebased so every LOD draws from vertex 0.
+        std::vector<Geometry::Vertex> vertices;
+        std::vector<uint16_t> indices;
+        vertices.reserve(totalVertices);
+        for (uint32_t lod = 0; lod < lodCount; lod++) {
+            const MeshLod& mesh = lods[lod];
+            std::vector<uint16_t> ordered(mesh.indices, mesh.indices + mesh.indexCount);
+            const float acmr = MeshOptimizer::AverageCacheMissRatio(ordered.data(), ordered.size(), mesh.vertexCount);
+            if (optimize) {
+                MeshOptimizer::OptimizeVertexCache(ordered.data(), ordered.size(), mesh.vertexCount);
+                MeshOptimizer::OptimizeOverdraw(ordered.data(), ordered.size(), mesh.vertices, mesh.vertexCount);
+            }
+            MeshRange& range = m_meshLods[lod];
+            range.firstIndex = (uint32_t)indices.size();
+            range.indexCount = (GLsizei)mesh.indexCount;
+            range.acmr = MeshOptimizer::AverageCacheMissRatio(ordered.data(), ordered.size(), mesh.vertexCount);
+            const uint16_t baseVertex = (uint16_t)vertices.size();
+            for (uint16_t index : ordered) {
+                indices.push_back((uint16_t)(index + baseVertex));
+            }
+            vertices.insert(vertices.end(), mesh.vertices, mesh.vertices + mesh.vertexCount);
+
+            Log::Write(Log::Level::Info, Fmt("Mesh LOD %u: %u vertices x %zu bytes, %u indices, ACMR %.2f -> %.2f", lod,
+                                             mesh.vertexCount, sizeof(Geometry::Vertex), mesh.indexCount, acmr,
+                                             range.acmr));
+        }
+        m_meshLodCount = lodCount;
+
+        // The element buffer binding is VAO state, so bind the VAO before touching it.
+        m_state.BindVertexArray(m_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_meshVertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Geometry::Vertex), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_meshIndexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    }
+
+    void Report(std::ostringstream& out, double /*seconds*/) {
+        const StreamingBuffer::Stats& stats = m_instanceBuffer.GetStats();
+        const uint64_t frames = stats.frames.load();
+        const uint64_t uploadBytes = stats.uploadBytes.load();
+        const uint64_t fenceWaitNs = stats.fenceWaitNs.load();
+        const uint64_t newFrames = frames - m_reportedFrames;
+        if (newFrames > 0) {
+            out << "uploadKB/frame=" << (uploadBytes - m_reportedUploadBytes) / 1024.0 / newFrames
+                << " fenceWaitUs/frame=" << (fenceWaitNs - m_reportedFenceWaitNs) / 1000.0 / newFrames;
+        }
+        out << " orphans=" << stats.orphans.load();
+
+        const uint64_t glFrames = m_frames.load();
+        const uint64_t glCalls = GlCalls::Total();
+        const uint64_t glSkipped = m_state.GetStats().skipped.load();
+        if (glFrames > m_reportedGlFrames) {
+            const double newGlFrames = (double)(glFrames - m_reportedGlFrames);
+            out << " glCalls/frame=" << (glCalls - m_reportedGlCalls) / newGlFrames
+                << " redundantSkipped/frame=" << (glSkipped - m_reportedGlSkipped) / newGlFrames;
+        }
+        const uint64_t attachmentBytes = m_attachmentBytes.load();
+        if (glFrames > m_reportedGlFrames) {
+            out << " estAttachmentMB/frame="
+                << (attachmentBytes - m_reportedAttachmentBytes) / (1024.0 * 1024.0) / (glFrames - m_reportedGlFrames);
+        }
+        const uint64_t drawnIndices = m_drawnIndices.load();
+        const uint64_t vertexFetchBytes = m_vertexFetchBytes.load();
+        if (glFrames > m_reportedGlFrames) {
+            const double newGlFrames = (double)(glFrames - m_reportedGlFrames);
+            out << " indices/frame=" << (drawnIndices - m_reportedDrawnIndices) / newGlFrames
+                << " estVertexFetchKB/frame=" << (vertexFetchBytes - m_reportedVertexFetchBytes) / 1024.0 / newGlFrames;
+        }
+        m_reportedDrawnIndices = drawnIndices;
+        m_reportedVertexFetchBytes = vertexFetchBytes;
+        m_reportedAttachmentBytes = attachmentBytes;
+        m_reportedGlFrames = glFrames;
+        m_reportedGlCalls = glCalls;
+        m_reportedGlSkipped = glSkipped;
+        m_reportedFrames = frames;
+        m_reportedUploadBytes = uploadBytes;
+        m_reportedFenceWaitNs = fenceWaitNs;
+    }
+
+    void BeginFrame() override {
+        m_instanceBuffer.BeginFrame();
+        m_instanceCount = -1;
+        BeginTimerQuery();
+    }
+
+    void EndFrame() override {
+        const bool timed = m_timerActive;
+        if (m_timerActive) {
+            glEndQuery(GL_TIME_ELAPSED_EXT);
+            m_timerActive = false;
+        }
+        // The upscales run after both eyes under a query of their own (elapsed-time
+        // queries cannot nest), so their cost can be told apart from rendering.
+        if (m_upscaleCount > 0) {
+            if (timed) {
+                glBeginQuery(GL_TIME_ELAPSED_EXT, m_upscaleQueries[m_timerSlot]);
+            }
+            for (uint32_t i = 0; i < m_upscaleCount; i++) {
+                RunUpscale(m_upscales[i]);
+            }
+            if (timed) {
+                glEndQuery(GL_TIME_ELAPSED_EXT);
+                m_upscalePending[m_timerSlot] = true;
+            }
+            m_upscaleCount = 0;
+        }
+        m_instanceBuffer.EndFrame();
+        glFlush();
+        m_frames++;
     }
 
-    void CheckShader(GLuint shader) {
-        GLint r = 0;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &r);
-        if (r == GL_FALSE) {
-            GLchar msg[4096] = {};
-            GLsizei length;
-            glGetShaderInfoLog(shader, sizeof(msg), &length, msg);
-            Log::Write(Log::Level::Error, Fmt("Compile shader failed: %s", msg));
+    uint64_t GpuFrameTimeNs() const override { return m_gpuFrameTimeNs.load(std::memory_order_relaxed); }
+
+    uint64_t GpuUpscaleTimeNs() const override { return m_gpuUpscaleTimeNs.load(std::memory_order_relaxed); }
+
+    // Collects the results of the queries issued FramesInFlight frames ago, then reuses them
+    // to time this frame. Queries that are still not available just skip this frame.
+    void BeginTimerQuery() {
+        if (!glGetQueryObjectui64vEXT) {
+            return;
+        }
+        const int slot = (int)(m_timerFrame++ % FramesInFlight);
+        if (m_timerPending[slot]) {
+            GLuint available = 0;
+            glGetQueryObjectuiv(m_timerQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available && m_upscalePending[slot]) {
+                glGetQueryObjectuiv(m_upscaleQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            }
+            if (!available) {
+                return;
+            }
+            GLuint64 renderNs = 0;
+            GLuint64 upscaleNs = 0;
+            GLint disjoint = 0;
+            glGetQueryObjectui64vEXT(m_timerQueries[slot], GL_QUERY_RESULT, &renderNs);
+            if (m_upscalePending[slot]) {
+                glGetQueryObjectui64vEXT(m_upscaleQueries[slot], GL_QUERY_RESULT, &upscaleNs);
+            }
+            glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+            // A disjoint event (frequency change, context loss) invalidates running timers.
+            if (!disjoint) {
+                m_gpuFrameTimeNs.store(renderNs + upscaleNs, std::memory_order_relaxed);
+                m_gpuUpscaleTimeNs.store(upscaleNs, std::memory_order_relaxed);
+            }
+            m_timerPending[slot] = false;
+            m_upscalePending[slot] = false;
         }
+        glBeginQuery(GL_TIME_ELAPSED_EXT, m_timerQueries[slot]);
+        m_timerPending[slot] = true;
+        m_timerSlot = slot;
+        m_timerActive = true;
     }
 
-    void CheckProgram(GLuint prog) {
-        GLint r = 0;
-        glGetProgramiv(prog, GL_LINK_STATUS, &r);
-        if (r == GL_FALSE) {
-            GLchar msg[4096] = {};
-            GLsizei length;
-            glGetProgramInfoLog(prog, sizeof(msg), &length, msg);
-            Log::Write(Log::Level::Error, Fmt("Link program failed: %s", msg));
+    // Stretches the rendered rect over the whole image, which overwrites all of it.
+    void RunUpscale(const Upscale& upscale) {
+        const GLenum color = GL_COLOR_ATTACHMENT0;
+        const PxrRecti& rect = upscale.rect;
+        m_state.BindFramebuffers(upscale.source->blitFramebuffer, upscale.destination->blitFramebuffer);
+        glInvalidateFramebuffer(GL_DRAW_FRAMEBUFFER, 1, &color);
+        glBlitFramebuffer(rect.x, rect.y, rect.x + rect.width, rect.y + rect.height, 0, 0, upscale.destination->width,
+                          upscale.destination->height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+
+    // Writes one model matrix per cube into the streaming buffer, grouped by LOD so each
+    // LOD is one instanced draw. Both eyes draw from the same upload.
+    void UploadInstances(const std::vector<Cube>& cubes) {
+        for (InstanceRange& range : m_lodInstances) {
+            range = InstanceRange();
+        }
+        if (cubes.empty() || m_meshLodCount == 0) {
+            m_instanceCount = 0;
+            return;
+        }
+        // Counting sort by LOD: count, turn counts into first slots, then scatter.
+        const uint32_t lastLod = m_meshLodCount - 1;
+        for (const Cube& cube : cubes) {
+            m_lodInstances[std::min(cube.Lod, lastLod)].count++;
+        }
+        GLsizei first = 0;
+        GLsizei next[MaxMeshLods];
+        for (uint32_t lod = 0; lod < m_meshLodCount; lod++) {
+            m_lodInstances[lod].first = next[lod] = first;
+            first += m_lodInstances[lod].count;
+        }
+
+        const StreamingBuffer::Allocation allocation = m_instanceBuffer.Map(cubes.size() * sizeof(glm::mat4));
+        auto* models = static_cast<glm::mat4*>(allocation.data);
+        for (const Cube& cube : cubes) {
+            models[next[std::min(cube.Lod, lastLod)]++] =
+                glm::translate(glm::mat4(1.0f), glm::vec3(cube.Pose.position.x, cube.Pose.position.y, cube.Pose.position.z))
+                * glm::toMat4(glm::quat(cube.Pose.orientation.w, cube.Pose.orientation.x, cube.Pose.orientation.y, cube.Pose.orientation.z))
+                * glm::scale(glm::mat4(1.0f), glm::vec3(cube.Scale.x, cube.Scale.y, cube.Scale.z));
         }
+        m_instanceBuffer.Unmap();
+        m_instanceOffset = allocation.offset;
+        m_instanceCount = static_cast<GLsizei>(cubes.size());
     }
 
+    // Points the instance attribute at the model matrices starting at instance first.
+    void BindInstances(GLsizei first) {
+        for (int column = 0; column < 4; column++) {
+            glVertexAttribPointer(m_instanceAttribModel + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                  reinterpret_cast<const void*>(m_instanceOffset + first * sizeof(glm::mat4) +
+                                                                column * sizeof(glm::vec4)));
+        }
+    }
 
-    uint32_t GetDepthTexture(uint32_t colorTexture) {
-        // If a depth-stencil view has already been created for this back-buffer, use it.
-        auto depthBufferIt = m_colorToDepthMap.find(colorTexture);
-        if (depthBufferIt != m_colorToDepthMap.end()) {
-            return depthBufferIt->second;
+    static GLenum DepthInternalFormat(DepthFormat format) {
+        switch (format) {
+            case DepthFormat::D16: return GL_DEPTH_COMPONENT16;
+            case DepthFormat::D32F: return GL_DEPTH_COMPONENT32F;
+            default: return GL_DEPTH_COMPONENT24;
         }
+    }
+
+    static int DepthBytes(DepthFormat format) { return format == DepthFormat::D16 ? 2 : 4; }
 
+    void SetRenderPassActions(const RenderPassActions& actions) override { m_actions = actions; }
+
+    uint32_t CreateDepthTexture(uint32_t colorTexture) {
         GLint width;
         GLint height;
         glBindTexture(GL_TEXTURE_2D, colorTexture);
@@ -241,50 +501,179 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-
-        m_colorToDepthMap.insert(std::make_pair(colorTexture, depthTexture));
+        glTexStorage2D(GL_TEXTURE_2D, 1, DepthInternalFormat(m_actions.depthFormat), width, height);
+        glBindTexture(GL_TEXTURE_2D, 0);
 
         return depthTexture;
     }
 
-    void RenderView_N(PxrEyeType eye,const PxrProjectionView* layerViews, uint64_t colorTexture,
-                    const std::vector<Cube>& cubes, int samples) override {
-        glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer);
-        if(eye == PXR_EYE_BOTH)
-            eye = PXR_EYE_LEFT;
-
-        glViewport(static_cast<GLint>(layerViews[eye].imageRect.x),
-                   static_cast<GLint>(layerViews[eye].imageRect.y),
-                   static_cast<GLsizei>(layerViews[eye].imageRect.width),
-                   static_cast<GLsizei>(layerViews[eye].imageRect.height));
-
-        glFrontFace(GL_CW);
-        glCullFace(GL_BACK);
-        glEnable(GL_CULL_FACE);
-        glEnable(GL_DEPTH_TEST);
+    // (Re)builds the framebuffer of one swapchain image with its own depth texture. With
+    // samples > 1 both attachments are multisampled-render-to-texture, so the tiler
+    // resolves color into the swapchain image on the way out.
+    void BuildFramebuffer(SwapchainFramebuffer& framebuffer, uint32_t colorTexture, int samples) {
+        if (framebuffer.framebuffer == 0) {
+            glGenFramebuffers(1, &framebuffer.framebuffer);
+        }
+        if (framebuffer.depthTexture == 0 || framebuffer.colorTexture != colorTexture ||
+            framebuffer.depthFormat != m_actions.depthFormat) {
+            if (framebuffer.depthTexture != 0) {
+                glDeleteTextures(1, &framebuffer.depthTexture);
+            }
+            framebuffer.depthTexture = CreateDepthTexture(colorTexture);
+        }
+        framebuffer.colorTexture = colorTexture;
+        framebuffer.samples = samples;
+        framebuffer.depthFormat = m_actions.depthFormat;
+        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &framebuffer.width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &framebuffer.height);
+        glBindTexture(GL_TEXTURE_2D, 0);
 
-        const uint32_t depthTexture  = GetDepthTexture((uint32_t)colorTexture);
+        if (framebuffer.blitFramebuffer == 0) {
+            glGenFramebuffers(1, &framebuffer.blitFramebuffer);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.blitFramebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
 
-        if (samples > 1) {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.framebuffer);
+        if (samples > 1 && glFramebufferTexture2DMultisampleEXT) {
             glFramebufferTexture2DMultisampleEXT(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                                                 GL_TEXTURE_2D, (uint32_t)colorTexture, 0, samples);
+                                                 GL_TEXTURE_2D, colorTexture, 0, samples);
             glFramebufferTexture2DMultisampleEXT(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-                                                 GL_TEXTURE_2D, depthTexture, 0, samples);
+                                                 GL_TEXTURE_2D, framebuffer.depthTexture, 0, samples);
         } else {
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-                                   (uint32_t)colorTexture, 0);
+                                   colorTexture, 0);
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
-                                   depthTexture, 0);
+                                   framebuffer.depthTexture, 0);
+        }
+        const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            Log::Write(Log::Level::Error, Fmt("Incomplete framebuffer for swapchain image %u: 0x%x", colorTexture, status));
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        m_state.Invalidate();
+    }
+
+    void DestroyFramebuffer(SwapchainFramebuffer& framebuffer) {
+        if (framebuffer.framebuffer != 0) {
+            glDeleteFramebuffers(1, &framebuffer.framebuffer);
+        }
+        if (framebuffer.depthTexture != 0) {
+            glDeleteTextures(1, &framebuffer.depthTexture);
+        }
+        if (framebuffer.blitFramebuffer != 0) {
+            glDeleteFramebuffers(1, &framebuffer.blitFramebuffer);
+        }
+        framebuffer = SwapchainFramebuffer();
+    }
+
+    void SetSwapchainImages(PxrEyeType eye, const uint64_t* images, uint32_t imageCount, int samples) override {
+        if (eye >= PXR_EYE_MAX || imageCount > MaxSwapchainImages) {
+            Log::Write(Log::Level::Error, Fmt("Unsupported swapchain: eye %d with %u images", eye, imageCount));
+            return;
+        }
+        for (uint32_t i = 0; i < MaxSwapchainImages; i++) {
+            if (i < imageCount) {
+                BuildFramebuffer(m_swapchainFramebuffers[eye][i], (uint32_t)images[i], samples);
+            } else {
+                DestroyFramebuffer(m_swapchainFramebuffers[eye][i]);
+            }
+        }
+        if (imageCount > 0) {
+            BuildScaledFramebuffer(eye, m_swapchainFramebuffers[eye][0].width, m_swapchainFramebuffers[eye][0].height,
+                                   samples);
+        }
+    }
+
+    // Views whose imageRect is smaller than the swapchain image render into this target of
+    // the same size and are then stretched over the whole image. Rebuilt only when the
+    // swapchain size or sample count changes, never when the imageRect does.
+    void BuildScaledFramebuffer(PxrEyeType eye, GLint width, GLint height, int samples) {
+        SwapchainFramebuffer& scaled = m_scaledFramebuffers[eye];
+        if (scaled.colorTexture != 0 && (scaled.width != width || scaled.height != height)) {
+            glDeleteTextures(1, &scaled.colorTexture);
+            DestroyFramebuffer(scaled);
+        }
+        GLuint colorTexture = scaled.colorTexture;
+        if (colorTexture == 0) {
+            glGenTextures(1, &colorTexture);
+            glBindTexture(GL_TEXTURE_2D, colorTexture);
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        BuildFramebuffer(scaled, colorTexture, samples);
+    }
+
+    void RenderView_N(PxrEyeType eye,const PxrProjectionView* layerViews, uint32_t imageIndex,
+                    const std::vector<Cube>& cubes, int samples) override {
+        if(eye == PXR_EYE_BOTH)
+            eye = PXR_EYE_LEFT;
+
+        SwapchainFramebuffer& framebuffer = m_swapchainFramebuffers[eye][imageIndex];
+        if (framebuffer.colorTexture == 0) {
+            return;
+        }
+        if (framebuffer.samples != samples) {
+            BuildFramebuffer(framebuffer, framebuffer.colorTexture, samples);
         }
 
-        // Clear color and depth buffer.
-        glClearColor(DarkSlateGray[0], DarkSlateGray[1], DarkSlateGray[2], DarkSlateGray[3]);
-        glClearDepthf(1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        // A partial imageRect renders into the scaled target, which must keep its color for
+        // the upscale; a full one renders straight into the swapchain image.
+        const PxrRecti& rect = layerViews[eye].imageRect;
+        const bool direct = rect.x == 0 && rect.y == 0 && rect.width == framebuffer.width &&
+                            rect.height == framebuffer.height;
+        SwapchainFramebuffer& target = direct ? framebuffer : m_scaledFramebuffers[eye];
+        if (target.colorTexture == 0) {
+            return;
+        }
+        if (target.samples != samples) {
+            BuildFramebuffer(target, target.colorTexture, samples);
+        }
+        RenderPassActions actions = m_actions;
+        if (!direct) {
+            actions.colorStore = StoreAction::Store;
+        }
+        m_state.BindFramebuffer(target.framebuffer);
+
+        m_state.Viewport(static_cast<GLint>(layerViews[eye].imageRect.x),
+                         static_cast<GLint>(layerViews[eye].imageRect.y),
+                         static_cast<GLsizei>(layerViews[eye].imageRect.width),
+                         static_cast<GLsizei>(layerViews[eye].imageRect.height));
+
+        m_state.FrontFace(GL_CW);
+        m_state.CullFace(GL_BACK);
+        m_state.Enable(GL_CULL_FACE);
+        m_state.Enable(GL_DEPTH_TEST);
+
+        // Start the pass: clear what is cleared, discard what is don't-care, leave loads alone.
+        // There is no stencil attachment, so stencil is never touched.
+        GLbitfield clearMask = 0;
+        GLenum discard[2];
+        GLsizei discardCount = 0;
+        if (actions.colorLoad == LoadAction::Clear) {
+            m_state.ClearColor(DarkSlateGray);
+            clearMask |= GL_COLOR_BUFFER_BIT;
+        } else if (actions.colorLoad == LoadAction::DontCare) {
+            discard[discardCount++] = GL_COLOR_ATTACHMENT0;
+        }
+        if (actions.depthLoad == LoadAction::Clear) {
+            m_state.ClearDepth(1.0f);
+            clearMask |= GL_DEPTH_BUFFER_BIT;
+        } else if (actions.depthLoad == LoadAction::DontCare) {
+            discard[discardCount++] = GL_DEPTH_ATTACHMENT;
+        }
+        if (discardCount > 0) {
+            glInvalidateFramebuffer(GL_FRAMEBUFFER, discardCount, discard);
+        }
+        if (clearMask != 0) {
+            glClear(clearMask);
+        }
 
         // Set shaders and uniform variables.
-        glUseProgram(m_program);
+        m_state.UseProgram(m_program);
 
 
         const auto &pose = layerViews[eye].pose;
@@ -314,47 +703,107 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         mViewMatrix        = glm::inverse(mToViewMatrix);
         mViewProjMatrix    = mProjectionMatrix * mViewMatrix;
 
-        // Set cube primitive data.
-        glBindVertexArray(m_vao);
-
-        // Render each cube
-        glm::mat4    modelMatrix      = glm::mat4(1.0f);
-        glm::mat4    mvpMatrix        = glm::mat4(1.0f);
-        for (const Cube& cube : cubes) {
-            // Compute the model-view-projection transform and set it..
-
-            modelMatrix =  glm::translate(glm::mat4(1.0f), glm::vec3(cube.Pose.position.x, cube.Pose.position.y, cube.Pose.position.z))        \
-                           * glm::toMat4(glm::quat(cube.Pose.orientation.w, cube.Pose.orientation.x,cube.Pose.orientation.y,cube.Pose.orientation.z)) \
-                           * glm::scale(glm::mat4(1.0f), glm::vec3(cube.Scale.x, cube.Scale.y, cube.Scale.z));
-            mvpMatrix   = mViewProjMatrix * modelMatrix;
-
-            glUniformMatrix4fv(m_modelViewProjectionUniformLocation, 1, GL_FALSE,
-                               reinterpret_cast<const GLfloat *>(&mvpMatrix ));
+        // Set cube primitive data and per-cube model matrices.
+        if (m_instanceCount < 0) {
+            UploadInstances(cubes);
+        }
+        m_state.BindVertexArray(m_vao);
+        glUniformMatrix4fv(m_viewProjectionUniformLocation, 1, GL_FALSE,
+                           reinterpret_cast<const GLfloat *>(&mViewProjMatrix));
+        glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer.Buffer());
+
+        // One instanced call per LOD in use.
+        for (uint32_t lod = 0; lod < m_meshLodCount; lod++) {
+            const InstanceRange& instances = m_lodInstances[lod];
+            if (instances.count == 0) {
+                continue;
+            }
+            const MeshRange& mesh = m_meshLods[lod];
+            BindInstances(instances.first);
+            glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_SHORT,
+                                    reinterpret_cast<const void*>(mesh.firstIndex * sizeof(uint16_t)), instances.count);
+            // Vertices actually fetched: one per post-transform cache miss.
+            m_drawnIndices += (uint64_t)mesh.indexCount * instances.count;
+            m_vertexFetchBytes +=
+                (uint64_t)(mesh.acmr * (mesh.indexCount / 3) * sizeof(Geometry::Vertex)) * instances.count;
+        }
 
-            // Draw the cube.
-            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(ArraySize(Geometry::c_cubeIndices)), GL_UNSIGNED_SHORT, nullptr);
+        // End the pass: tell the driver which attachments need not be written back to memory.
+        discardCount = 0;
+        if (actions.colorStore == StoreAction::DontCare) {
+            discard[discardCount++] = GL_COLOR_ATTACHMENT0;
+        }
+        if (actions.depthStore == StoreAction::DontCare) {
+            discard[discardCount++] = GL_DEPTH_ATTACHMENT;
+        }
+        if (discardCount > 0) {
+            glInvalidateFramebuffer(GL_FRAMEBUFFER, discardCount, discard);
+        }
 
+        // Estimated attachment traffic between tile memory and DRAM for this view.
+        const uint64_t pixels = (uint64_t)layerViews[eye].imageRect.width * layerViews[eye].imageRect.height;
+        const uint64_t depthBytes = DepthBytes(target.depthFormat);
+        uint64_t bytes = 0;
+        bytes += actions.colorLoad == LoadAction::Load ? pixels * 4 : 0;
+        bytes += actions.colorStore == StoreAction::Store ? pixels * 4 : 0;
+        bytes += actions.depthLoad == LoadAction::Load ? pixels * depthBytes : 0;
+        bytes += actions.depthStore == StoreAction::Store ? pixels * depthBytes : 0;
+
+        if (!direct && m_upscaleCount < ArraySize(m_upscales)) {
+            m_upscales[m_upscaleCount++] = {&target, &framebuffer, rect};
+            bytes += pixels * 4 + (uint64_t)framebuffer.width * framebuffer.height * 4;
         }
+        m_attachmentBytes += bytes;
 
-        glBindVertexArray(0);
-        glUseProgram(0);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glFlush();
+        // Bindings are left in place for the next eye; EndFrame() upscales and flushes once per frame.
     }
 
 private:
-    GLuint m_swapchainFramebuffer{0};
+    SwapchainFramebuffer m_swapchainFramebuffers[PXR_EYE_MAX][MaxSwapchainImages];
+    SwapchainFramebuffer m_scaledFramebuffers[PXR_EYE_MAX];
+    ProgramCache m_programCache;
     GLuint m_program{0};
-    GLint m_modelViewProjectionUniformLocation{0};
+    GLint m_viewProjectionUniformLocation{0};
     GLint m_mvpMtx{0};
     GLint m_vertexAttribCoords{0};
     GLint m_vertexAttribColor{0};
+    GLint m_instanceAttribModel{0};
     GLuint m_vao{0};
-    GLuint m_cubeVertexBuffer{0};
-    GLuint m_cubeIndexBuffer{0};
+    GLuint m_meshVertexBuffer{0};
+    GLuint m_meshIndexBuffer{0};
+    MeshRange m_meshLods[MaxMeshLods];
+    uint32_t m_meshLodCount{0};
+    StreamingBuffer m_instanceBuffer;
+    GLintptr m_instanceOffset{0};
+    GLsizei m_instanceCount{-1};
+    InstanceRange m_lodInstances[MaxMeshLods];
+    GlStateCache m_state;
+    GLuint m_timerQueries[FramesInFlight] = {};
+    bool m_timerPending[FramesInFlight] = {};
+    GLuint m_upscaleQueries[FramesInFlight] = {};
+    bool m_upscalePending[FramesInFlight] = {};
+    bool m_timerActive{false};
+    int m_timerSlot{0};
+    Upscale m_upscales[PXR_EYE_MAX] = {};
+    uint32_t m_upscaleCount{0};
+    uint64_t m_timerFrame{0};
+    std::atomic<uint64_t> m_gpuFrameTimeNs{0};
+    std::atomic<uint64_t> m_gpuUpscaleTimeNs{0};
+    std::atomic<uint64_t> m_frames{0};
+    uint64_t m_reportedFrames{0};
+    uint64_t m_reportedGlFrames{0};
+    uint64_t m_reportedGlCalls{0};
+    uint64_t m_reportedGlSkipped{0};
+    RenderPassActions m_actions;
+    std::atomic<uint64_t> m_attachmentBytes{0};
+    uint64_t m_reportedAttachmentBytes{0};
+    std::atomic<uint64_t> m_drawnIndices{0};
+    std::atomic<uint64_t> m_vertexFetchBytes{0};
+    uint64_t m_reportedDrawnIndices{0};
+    uint64_t m_reportedVertexFetchBytes{0};
+    uint64_t m_reportedUploadBytes{0};
+    uint64_t m_reportedFenceWaitNs{0};
     GLenum err = -1;
-    // Map color buffer to associated depth buffer. This map is populated on demand.
-    std::map<uint32_t, uint32_t> m_colorToDepthMap;
 };
 }  // namespace
 
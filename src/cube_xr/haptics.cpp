@@ -0,0 +1,127 @@
+#include "common.h"
+#include "haptics.h"
+
+namespace {
+const float AmplitudeStep = 0.05f;          // changes smaller than this are not worth a runtime call
+const uint64_t CoalesceGapNs = 50000000;    // requests this close to an effect's end still extend it
+const int LeaseMs = 100;                    // minimum duration handed to the runtime per call
+const uint64_t RenewMarginNs = 30000000;    // re-issue when the issued vibration is this close to ending
+
+float Quantize(float amplitude) {
+    return std::min(1.0f, std::round(amplitude / AmplitudeStep) * AmplitudeStep);
+}
+}  // namespace
+
+void HapticsScheduler::Request(uint32_t hand, float amplitude, int durationMs, uint64_t nowNs,
+                               const HapticEnvelope& envelope) {
+    if (hand >= PXR_CONTROLLER_COUNT || durationMs <= 0) {
+        return;
+    }
+    amplitude = Quantize(amplitude);
+    if (amplitude <= 0.0f) {
+        return;
+    }
+    // Only requests that would have reached the runtime count towards the calls saved.
+    m_requests.fetch_add(1, std::memory_order_relaxed);
+
+    Channel& channel = m_channels[hand];
+    const uint64_t endNs = nowNs + (uint64_t)durationMs * 1000000;
+    Effect* slot = nullptr;
+    for (Effect& effect : channel.effects) {
+        if (effect.active && effect.amplitude == amplitude && effect.envelope == envelope &&
+            effect.endNs + CoalesceGapNs >= nowNs) {
+            effect.endNs = std::max(effect.endNs, endNs);
+            return;
+        }
+        if (!effect.active) {
+            slot = &effect;
+        } else if (slot == nullptr || (slot->active && effect.endNs < slot->endNs)) {
+            slot = &effect;
+        }
+    }
+
+    slot->active = true;
+    slot->amplitude = amplitude;
+    slot->envelope = envelope;
+    slot->startNs = nowNs;
+    slot->endNs = endNs;
+}
+
+void HapticsScheduler::Cancel(uint32_t hand) {
+    if (hand >= PXR_CONTROLLER_COUNT) {
+        return;
+    }
+    for (Effect& effect : m_channels[hand].effects) {
+        effect.active = false;
+    }
+}
+
+float HapticsScheduler::Evaluate(const Effect& effect, uint64_t nowNs) {
+    const float elapsedMs = (float)(nowNs - effect.startNs) * 1e-6f;
+    const float remainingMs = (float)(effect.endNs - nowNs) * 1e-6f;
+    float gain = 1.0f;
+    if (effect.envelope.attackMs > 0.0f && elapsedMs < effect.envelope.attackMs) {
+        gain = elapsedMs / effect.envelope.attackMs;
+    }
+    if (effect.envelope.releaseMs > 0.0f && remainingMs < effect.envelope.releaseMs) {
+        gain = std::min(gain, remainingMs / effect.envelope.releaseMs);
+    }
+    return effect.amplitude * gain;
+}
+
+void HapticsScheduler::Update(uint64_t nowNs) {
+    for (uint32_t hand = 0; hand < PXR_CONTROLLER_COUNT; hand++) {
+        Channel& channel = m_channels[hand];
+
+        float amplitude = 0.0f;
+        uint64_t endNs = nowNs;
+        for (Effect& effect : channel.effects) {
+            if (!effect.active) {
+                continue;
+            }
+            if (effect.endNs <= nowNs) {
+                effect.active = false;
+                continue;
+            }
+            amplitude = std::max(amplitude, Evaluate(effect, nowNs));
+            endNs = std::max(endNs, effect.endNs);
+        }
+        amplitude = Quantize(amplitude);
+
+        if (amplitude <= 0.0f) {
+            if (channel.issuedAmplitude > 0.0f && channel.issuedEndNs > nowNs) {
+                Issue(hand, 0.0f, 0);
+            }
+            channel.issuedAmplitude = 0.0f;
+            channel.issuedEndNs = nowNs;
+            continue;
+        }
+
+        const bool changed = amplitude != channel.issuedAmplitude;
+        const bool expiring = channel.issuedEndNs < endNs && channel.issuedEndNs < nowNs + RenewMarginNs;
+        if (changed || expiring) {
+            const int durationMs = std::max(LeaseMs, (int)((endNs - nowNs + 999999) / 1000000));
+            Issue(hand, amplitude, durationMs);
+            channel.issuedAmplitude = amplitude;
+            channel.issuedEndNs = nowNs + (uint64_t)durationMs * 1000000;
+        }
+    }
+}
+
+void HapticsScheduler::Issue(uint32_t hand, float amplitude, int durationMs) {
+    m_device->SetVibration(hand, amplitude, durationMs);
+    m_calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HapticsScheduler::Report(std::ostringstream& out, double elapsedSeconds) {
+    const uint64_t requests = m_requests.load(std::memory_order_relaxed);
+    const uint64_t calls = m_calls.load(std::memory_order_relaxed);
+    const uint64_t newRequests = requests - m_reportedRequests;
+    const uint64_t newCalls = calls - m_reportedCalls;
+    const uint64_t saved = newRequests > newCalls ? newRequests - newCalls : 0;
+    m_reportedRequests = requests;
+    m_reportedCalls = calls;
+
+    out << "requests=" << newRequests << " runtimeCalls=" << newCalls << " savedCalls/s="
+        << (elapsedSeconds > 0.0 ? saved / elapsedSeconds : 0.0);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "inputdevice.h"
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+
+// Linear ramps at the start and end of an effect.
+struct HapticEnvelope {
+    float attackMs = 0.0f;
+    float releaseMs = 0.0f;
+
+    bool operator==(const HapticEnvelope& other) const {
+        return attackMs == other.attackMs && releaseMs == other.releaseMs;
+    }
+};
+
+// Collects vibration requests per controller and only talks to the runtime when the
+// effective (max over active effects, quantized) amplitude changes, when the issued
+// vibration is about to run out, or when it has to be stopped early. Repeating the same
+// request every frame therefore costs a runtime call every few frames instead of one each.
+class HapticsScheduler {
+public:
+    static const int MaxEffectsPerController = 8;
+
+    explicit HapticsScheduler(std::shared_ptr<IInputDevice> device) : m_device(std::move(device)) {}
+
+    // Identical requests that overlap an active effect extend it instead of adding a new one.
+    void Request(uint32_t hand, float amplitude, int durationMs, uint64_t nowNs,
+                 const HapticEnvelope& envelope = HapticEnvelope());
+    void Cancel(uint32_t hand);
+
+    // Call once per frame.
+    void Update(uint64_t nowNs);
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    struct Effect {
+        bool           active = false;
+        float          amplitude = 0.0f;
+        HapticEnvelope envelope;
+        uint64_t       startNs = 0;
+        uint64_t       endNs = 0;
+    };
+
+    struct Channel {
+        Effect   effects[MaxEffectsPerController];
+        float    issuedAmplitude = 0.0f;
+        uint64_t issuedEndNs = 0;
+    };
+
+    static float Evaluate(const Effect& effect, uint64_t nowNs);
+    void Issue(uint32_t hand, float amplitude, int durationMs);
+
+    std::shared_ptr<IInputDevice> m_device;
+    Channel m_channels[PXR_CONTROLLER_COUNT];
+
+    std::atomic<uint64_t> m_requests{0};
+    std::atomic<uint64_t> m_calls{0};
+    uint64_t m_reportedRequests{0};
+    uint64_t m_reportedCalls{0};
+};
@@ -0,0 +1,260 @@
+#include "common.h"
+#include "headposehistory.h"
+#include "simd4.h"
+
+#include "glm/gtx/quaternion.hpp"
+
+namespace {
+// Entries the writer may be about to overwrite; lookups stay clear of them.
+const uint64_t ReadGuard = 16;
+// Samples transformed per block, sized for the stack.
+const size_t BlockSize = 64;
+
+glm::quat ToQuat(const float* q) { return glm::quat(q[3], q[0], q[1], q[2]); }
+glm::vec3 ToVec3(const float* v) { return glm::vec3(v[0], v[1], v[2]); }
+}  // namespace
+
+void HeadPoseHistory::Push(const PxrSensorState& state, uint64_t timeNs) {
+    if (timeNs <= m_lastTimeNs) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_lastTimeNs = timeNs;
+
+    const uint64_t index = m_head.load(std::memory_order_relaxed);
+    Slot& slot = m_slots[index & (Capacity - 1)];
+    const uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Entry& entry = slot.entry;
+    entry.index = index;
+    entry.timeNs = timeNs;
+    entry.orientation[0] = state.pose.orientation.x;
+    entry.orientation[1] = state.pose.orientation.y;
+    entry.orientation[2] = state.pose.orientation.z;
+    entry.orientation[3] = state.pose.orientation.w;
+    entry.position[0] = state.pose.position.x;
+    entry.position[1] = state.pose.position.y;
+    entry.position[2] = state.pose.position.z;
+    const PxrVector3f* vectors[] = {&state.angularVelocity, &state.linearVelocity, &state.angularAcceleration,
+                                    &state.linearAcceleration};
+    float* fields[] = {entry.angularVelocity, entry.linearVelocity, entry.angularAcceleration, entry.linearAcceleration};
+    for (size_t i = 0; i < ArraySize(fields); i++) {
+        fields[i][0] = vectors[i]->x;
+        fields[i][1] = vectors[i]->y;
+        fields[i][2] = vectors[i]->z;
+    }
+
+    slot.seq.store(seq + 2, std::memory_order_release);
+    m_head.store(index + 1, std::memory_order_release);
+}
+
+bool HeadPoseHistory::Read(uint64_t index, Entry* entry) const {
+    const Slot& slot = m_slots[index & (Capacity - 1)];
+    for (;;) {
+        const uint32_t seq0 = slot.seq.load(std::memory_order_acquire);
+        if (seq0 & 1u) {
+            continue;
+        }
+        memcpy(entry, &slot.entry, sizeof(Entry));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == seq0) {
+            return entry->index == index;
+        }
+    }
+}
+
+uint64_t HeadPoseHistory::Oldest(uint64_t head) const {
+    return head > Capacity - ReadGuard ? head - (Capacity - ReadGuard) : 0;
+}
+
+bool HeadPoseHistory::Find(uint64_t timeNs, uint64_t head, Bracket* bracket) const {
+    m_searches.fetch_add(1, std::memory_order_relaxed);
+    // First entry newer than timeNs. An entry written over is older than anything still
+    // in the ring, so it counts as before timeNs.
+    uint64_t lo = Oldest(head);
+    uint64_t hi = head;
+    while (lo < hi) {
+        const uint64_t mid = lo + (hi - lo) / 2;
+        Entry entry;
+        if (!Read(mid, &entry) || entry.timeNs <= timeNs) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    // The search may end on the entry just before the readable ones, which need not be
+    // old enough.
+    if (lo == 0 || !Read(lo - 1, &bracket->before) || bracket->before.timeNs > timeNs) {
+        return false;
+    }
+    bracket->hasAfter = lo < head && Read(lo, &bracket->after);
+    return true;
+}
+
+bool HeadPoseHistory::Evaluate(const Bracket& bracket, uint64_t timeNs, float* orientation, float* position) const {
+    const Entry& before = bracket.before;
+    glm::quat q;
+    glm::vec3 p;
+    if (bracket.hasAfter && bracket.after.timeNs - before.timeNs <= MaxGapNs) {
+        const Entry& after = bracket.after;
+        const float t = (float)(timeNs - before.timeNs) / (float)(after.timeNs - before.timeNs);
+        q = glm::slerp(ToQuat(before.orientation), ToQuat(after.orientation), t);
+        p = glm::mix(ToVec3(before.position), ToVec3(after.position), t);
+    } else {
+        // Past the newest entry, or across a tracking gap: extrapolate, if not too far.
+        const uint64_t aheadNs = timeNs - before.timeNs;
+        if (aheadNs > MaxExtrapolationNs) {
+            return false;
+        }
+        const float dt = aheadNs * 1e-9f;
+        p = ToVec3(before.position) + ToVec3(before.linearVelocity) * dt +
+            ToVec3(before.linearAcceleration) * (0.5f * dt * dt);
+        // Angular velocity is in world space, so the increment applies on the left.
+        const glm::vec3 omega = ToVec3(before.angularVelocity) + ToVec3(before.angularAcceleration) * (0.5f * dt);
+        const float speed = glm::length(omega);
+        q = ToQuat(before.orientation);
+        if (speed * dt > 1e-6f) {
+            q = glm::angleAxis(speed * dt, omega / speed) * q;
+        }
+        if (aheadNs != 0) {
+            m_extrapolated.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    q = glm::normalize(q);
+    orientation[0] = q.x;
+    orientation[1] = q.y;
+    orientation[2] = q.z;
+    orientation[3] = q.w;
+    position[0] = p.x;
+    position[1] = p.y;
+    position[2] = p.z;
+    return true;
+}
+
+bool HeadPoseHistory::PoseAt(uint64_t timeNs, PxrPosef* pose) const {
+    m_lookups.fetch_add(1, std::memory_order_relaxed);
+    Bracket bracket;
+    float orientation[4];
+    float position[3];
+    if (!Find(timeNs, m_head.load(std::memory_order_acquire), &bracket) ||
+        !Evaluate(bracket, timeNs, orientation, position)) {
+        m_missed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    pose->orientation = {orientation[0], orientation[1], orientation[2], orientation[3]};
+    pose->position = {position[0], position[1], position[2]};
+    return true;
+}
+
+size_t HeadPoseHistory::TransformGaze(const GazeSample* samples, size_t count, WorldGaze* out) const {
+    using namespace Simd;
+
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    Bracket bracket;
+    bool bracketed = false;
+    size_t valid = 0;
+
+    // Head orientation and position, eye space gaze direction and origin, per sample.
+    alignas(16) float qx[BlockSize], qy[BlockSize], qz[BlockSize], qw[BlockSize];
+    alignas(16) float px[BlockSize], py[BlockSize], pz[BlockSize];
+    alignas(16) float dx[BlockSize], dy[BlockSize], dz[BlockSize];
+    alignas(16) float ox[BlockSize], oy[BlockSize], oz[BlockSize];
+    bool ok[BlockSize];
+
+    for (size_t base = 0; base < count; base += BlockSize) {
+        const size_t n = std::min(BlockSize, count - base);
+        const size_t padded = (n + 3) & ~(size_t)3;
+        for (size_t i = 0; i < padded; i++) {
+            float orientation[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+            float position[3] = {0.0f, 0.0f, 0.0f};
+            float direction[3] = {0.0f, 0.0f, -1.0f};
+            float origin[3] = {0.0f, 0.0f, 0.0f};
+            ok[i] = false;
+            if (i < n) {
+                const GazeSample& sample = samples[base + i];
+                const float* vector = sample.combinedEyeGazeVector;
+                if ((sample.combinedEyePoseStatus & GAZE_STATUS_GAZE_VECTOR_VALID) &&
+                    vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2] > 0.25f) {
+                    m_lookups.fetch_add(1, std::memory_order_relaxed);
+                    const uint64_t timeNs = sample.timestampNs;
+                    if (!bracketed || timeNs < bracket.before.timeNs || !bracket.hasAfter ||
+                        timeNs >= bracket.after.timeNs) {
+                        bracketed = Find(timeNs, head, &bracket);
+                    }
+                    ok[i] = bracketed && Evaluate(bracket, timeNs, orientation, position);
+                    if (!ok[i]) {
+                        m_missed.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                if (ok[i]) {
+                    memcpy(direction, vector, sizeof(direction));
+                    if (sample.combinedEyePoseStatus & GAZE_STATUS_GAZE_POINT_VALID) {
+                        memcpy(origin, sample.combinedEyeGazePoint, sizeof(origin));
+                    }
+                }
+            }
+            qx[i] = orientation[0];
+            qy[i] = orientation[1];
+            qz[i] = orientation[2];
+            qw[i] = orientation[3];
+            px[i] = position[0];
+            py[i] = position[1];
+            pz[i] = position[2];
+            dx[i] = direction[0];
+            dy[i] = direction[1];
+            dz[i] = direction[2];
+            ox[i] = origin[0];
+            oy[i] = origin[1];
+            oz[i] = origin[2];
+        }
+
+        for (size_t i = 0; i < padded; i += 4) {
+            const Float4 rx = Load(qx + i), ry = Load(qy + i), rz = Load(qz + i), rw = Load(qw + i);
+            Float4 vx = Load(dx + i), vy = Load(dy + i), vz = Load(dz + i);
+            const Float4 inverseLength = RSqrt(vx * vx + vy * vy + vz * vz);
+            vx = vx * inverseLength;
+            vy = vy * inverseLength;
+            vz = vz * inverseLength;
+            Rotate(rx, ry, rz, rw, vx, vy, vz);
+            Store(dx + i, vx);
+            Store(dy + i, vy);
+            Store(dz + i, vz);
+
+            Float4 sx = Load(ox + i), sy = Load(oy + i), sz = Load(oz + i);
+            Rotate(rx, ry, rz, rw, sx, sy, sz);
+            Store(ox + i, sx + Load(px + i));
+            Store(oy + i, sy + Load(py + i));
+            Store(oz + i, sz + Load(pz + i));
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            WorldGaze& gaze = out[base + i];
+            gaze.origin = {ox[i], oy[i], oz[i]};
+            gaze.direction = {dx[i], dy[i], dz[i]};
+            gaze.valid = ok[i];
+            valid += ok[i] ? 1 : 0;
+        }
+    }
+    return valid;
+}
+
+void HeadPoseHistory::Report(std::ostringstream& out, double elapsedSeconds) {
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    const uint64_t lookups = m_lookups.load(std::memory_order_relaxed);
+    const uint64_t searches = m_searches.load(std::memory_order_relaxed);
+    const uint64_t extrapolated = m_extrapolated.load(std::memory_order_relaxed);
+    const uint64_t missed = m_missed.load(std::memory_order_relaxed);
+    const uint64_t newLookups = lookups - m_reportedLookups;
+
+    out << "poses/s=" << (head - m_reportedHead) / elapsedSeconds << " lookups/s=" << newLookups / elapsedSeconds
+        << " searches/lookup=" << (newLookups != 0 ? (double)(searches - m_reportedSearches) / newLookups : 0.0)
+        << " extrapolated=" << (extrapolated - m_reportedExtrapolated) << " missed=" << (missed - m_reportedMissed)
+        << " dropped=" << m_dropped.load(std::memory_order_relaxed);
+    m_reportedHead = head;
+    m_reportedLookups = lookups;
+    m_reportedSearches = searches;
+    m_reportedExtrapolated = extrapolated;
+    m_reportedMissed = missed;
+}
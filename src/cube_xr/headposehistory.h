@@ -0,0 +1,94 @@
+#pragma once
+#include "gazesample.h"
+#include "pxr/PxrApi.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+
+// A gaze ray in world space, at the time its sample was taken.
+struct WorldGaze {
+    PxrVector3f origin;
+    PxrVector3f direction;
+    bool valid;  // the sample had a gaze vector and the head pose at its time is known
+};
+
+// Recent head poses by time, so eye-in-head gaze can be carried into world space with the
+// head pose of the moment it was sampled rather than the one predicted for display. One
+// thread pushes the runtime's sensor states; any thread looks poses up without locking.
+// Each slot has its own seqlock, like the shared gaze ring: a reader retries if it raced
+// with the writer and treats a slot that moved on as history that fell out of the ring.
+//
+// A lookup binary searches the entries around the time, then slerps orientation and lerps
+// position between them. Past the newest entry the pose is extrapolated from its velocities
+// and accelerations, for at most MaxExtrapolationNs.
+class HeadPoseHistory {
+public:
+    static constexpr uint32_t Capacity = 256;                 // a power of two; ~3.5 s of frames at 72 Hz
+    static constexpr uint64_t MaxExtrapolationNs = 30000000;  // ~2 frames
+    static constexpr uint64_t MaxGapNs = 100000000;           // entries further apart are not interpolated
+
+    HeadPoseHistory() = default;
+    HeadPoseHistory(const HeadPoseHistory&) = delete;
+    HeadPoseHistory& operator=(const HeadPoseHistory&) = delete;
+
+    // Writer side, one thread. timeNs is on CLOCK_MONOTONIC, like gaze samples; an entry
+    // not newer than the previous one is dropped.
+    void Push(const PxrSensorState& state, uint64_t timeNs);
+
+    // The head pose at timeNs. False when it is older than the history or too far ahead.
+    bool PoseAt(uint64_t timeNs, PxrPosef* pose) const;
+
+    // World space combined gaze ray of each sample. Lookups walk forward from the previous
+    // sample's entries, so time ordered samples cost a binary search per block, not per
+    // sample; the rotations run four samples at a time. Returns the number of valid rays.
+    size_t TransformGaze(const GazeSample* samples, size_t count, WorldGaze* out) const;
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    struct Entry {
+        uint64_t index;  // push number, to tell a slot that was written over
+        uint64_t timeNs;
+        float orientation[4];  // x, y, z, w
+        float position[3];
+        float angularVelocity[3];
+        float linearVelocity[3];
+        float angularAcceleration[3];
+        float linearAcceleration[3];
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> seq{0};  // odd while the writer is inside the slot
+        Entry entry;
+    };
+
+    // Two neighbouring entries and the time span they cover.
+    struct Bracket {
+        Entry before;
+        Entry after;
+        bool hasAfter;
+    };
+
+    bool Read(uint64_t index, Entry* entry) const;
+    uint64_t Oldest(uint64_t head) const;
+    bool Find(uint64_t timeNs, uint64_t head, Bracket* bracket) const;
+    bool Evaluate(const Bracket& bracket, uint64_t timeNs, float* orientation, float* position) const;
+
+    Slot m_slots[Capacity];
+    std::atomic<uint64_t> m_head{0};  // number of entries pushed so far
+    uint64_t m_lastTimeNs{0};
+
+    mutable std::atomic<uint64_t> m_lookups{0};
+    mutable std::atomic<uint64_t> m_searches{0};
+    mutable std::atomic<uint64_t> m_extrapolated{0};
+    mutable std::atomic<uint64_t> m_missed{0};
+    std::atomic<uint64_t> m_dropped{0};
+    uint64_t m_reportedHead{0};
+    uint64_t m_reportedLookups{0};
+    uint64_t m_reportedSearches{0};
+    uint64_t m_reportedExtrapolated{0};
+    uint64_t m_reportedMissed{0};
+};
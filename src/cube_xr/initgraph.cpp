@@ -0,0 +1,165 @@
+#include "common.h"
+#include "initgraph.h"
+
+#include <cstring>
+
+InitGraph::InitGraph() : m_createdNs(MonotonicNs()) {}
+
+InitGraph::~InitGraph() { Wait(); }
+
+void InitGraph::Add(const char* name, std::vector<const char*> dependencies, Affinity affinity,
+                    std::function<void()> task) {
+    std::unique_ptr<Task> entry(new Task());
+    entry->name = name;
+    entry->affinity = affinity;
+    entry->function = std::move(task);
+    for (const char* dependency : dependencies) {
+        size_t index = 0;
+        while (index < m_tasks.size() && strcmp(m_tasks[index]->name, dependency) != 0) {
+            index++;
+        }
+        if (index == m_tasks.size()) {
+            Log::Write(Log::Level::Error, Fmt("Init: task '%s' depends on unknown task '%s'", name, dependency));
+            continue;
+        }
+        entry->dependencies.push_back(index);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks.push_back(std::move(entry));
+}
+
+bool InitGraph::Run(const std::vector<const char*>& targets) {
+    std::vector<bool> needed(m_tasks.size(), false);
+    for (const char* target : targets) {
+        for (size_t i = 0; i < m_tasks.size(); i++) {
+            if (strcmp(m_tasks[i]->name, target) == 0) {
+                MarkNeeded(i, needed);
+            }
+        }
+    }
+    RunUntil(needed);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_tasks.size(); i++) {
+        if (needed[i] && m_tasks[i]->state == State::Failed) {
+            Log::Write(Log::Level::Error, Fmt("Init: failed after %.1f ms", (MonotonicNs() - m_createdNs) / 1e6));
+            return false;
+        }
+    }
+    Log::Write(Log::Level::Info, Fmt("Init: ready to render after %.1f ms", (MonotonicNs() - m_createdNs) / 1e6));
+    return true;
+}
+
+void InitGraph::Wait() {
+    RunUntil(std::vector<bool>(m_tasks.size(), true));
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+}
+
+bool InitGraph::IsReady(const Task& task) const {
+    for (size_t dependency : task.dependencies) {
+        if (m_tasks[dependency]->state != State::Done) {
+            return false;
+        }
+    }
+    return task.state == State::Pending;
+}
+
+void InitGraph::MarkNeeded(size_t index, std::vector<bool>& needed) const {
+    if (needed[index]) {
+        return;
+    }
+    needed[index] = true;
+    for (size_t dependency : m_tasks[index]->dependencies) {
+        MarkNeeded(dependency, needed);
+    }
+}
+
+// Called with m_mutex held. Dependencies always come earlier, so one pass down the list
+// reaches everything downstream of the failed task.
+void InitGraph::SkipDependents(size_t index) {
+    for (size_t i = index + 1; i < m_tasks.size(); i++) {
+        Task& task = *m_tasks[i];
+        if (task.state != State::Pending) {
+            continue;
+        }
+        for (size_t dependency : task.dependencies) {
+            if (m_tasks[dependency]->state == State::Failed) {
+                Log::Write(Log::Level::Error, Fmt("Init: skipping '%s', '%s' failed", task.name,
+                                                  m_tasks[dependency]->name));
+                task.state = State::Failed;
+                break;
+            }
+        }
+    }
+}
+
+// Called with m_mutex held.
+void InitGraph::LaunchReadyWorkers() {
+    for (size_t i = 0; i < m_tasks.size(); i++) {
+        Task& task = *m_tasks[i];
+        if (task.affinity == Affinity::Worker && IsReady(task)) {
+            task.state = State::Running;
+            m_workers.emplace_back([this, i]() { Execute(i); });
+        }
+    }
+}
+
+void InitGraph::Execute(size_t index) {
+    Task& task = *m_tasks[index];
+    task.startNs = MonotonicNs();
+    bool failed = true;
+    try {
+        task.function();
+        failed = false;
+    } catch (const std::exception& ex) {
+        Log::Write(Log::Level::Error, Fmt("Init: task '%s' failed: %s", task.name, ex.what()));
+    } catch (...) {
+        Log::Write(Log::Level::Error, Fmt("Init: task '%s' failed", task.name));
+    }
+    task.endNs = MonotonicNs();
+    Log::Write(Log::Level::Info, Fmt("Init: %-12s started at %7.1f ms, took %7.1f ms on the %s thread", task.name,
+                                     (task.startNs - m_createdNs) / 1e6, (task.endNs - task.startNs) / 1e6,
+                                     task.affinity == Affinity::Main ? "main" : "worker"));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    task.state = failed ? State::Failed : State::Done;
+    if (failed) {
+        SkipDependents(index);
+    }
+    LaunchReadyWorkers();
+    m_changed.notify_all();
+}
+
+void InitGraph::RunUntil(const std::vector<bool>& needed) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        LaunchReadyWorkers();
+
+        bool done = true;
+        size_t runnable = m_tasks.size();
+        for (size_t i = 0; i < m_tasks.size(); i++) {
+            if (!needed[i] || m_tasks[i]->state == State::Done || m_tasks[i]->state == State::Failed) {
+                continue;
+            }
+            done = false;
+            if (m_tasks[i]->affinity == Affinity::Main && IsReady(*m_tasks[i]) && runnable == m_tasks.size()) {
+                runnable = i;
+            }
+        }
+        if (done) {
+            return;
+        }
+        if (runnable < m_tasks.size()) {
+            m_tasks[runnable]->state = State::Running;
+            lock.unlock();
+            Execute(runnable);
+            lock.lock();
+        } else {
+            m_changed.wait(lock);
+        }
+    }
+}
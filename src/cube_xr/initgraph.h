@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Startup as a dependency graph. Worker tasks get a thread each as soon as their
+// dependencies are done; main tasks (anything that needs the GL context or must stay on
+// the app thread) run on the thread calling Run() or Wait(). Every task logs when it
+// started and how long it took, relative to the graph's creation. A task fails by
+// throwing; everything that depends on it is then skipped.
+class InitGraph {
+public:
+    enum class Affinity { Worker, Main };
+
+    InitGraph();
+    ~InitGraph();
+
+    InitGraph(const InitGraph&) = delete;
+    InitGraph& operator=(const InitGraph&) = delete;
+
+    // Dependencies are names of tasks added earlier, so the graph is acyclic by construction.
+    void Add(const char* name, std::vector<const char*> dependencies, Affinity affinity, std::function<void()> task);
+
+    // Returns once the named tasks and everything they depend on are done or skipped, true
+    // if none of them failed. Other worker tasks keep running in the background.
+    bool Run(const std::vector<const char*>& targets);
+
+    // Runs whatever is left and joins all workers.
+    void Wait();
+
+private:
+    enum class State { Pending, Running, Done, Failed };
+
+    struct Task {
+        const char* name;
+        std::vector<size_t> dependencies;
+        Affinity affinity;
+        std::function<void()> function;
+        State state = State::Pending;
+        uint64_t startNs = 0;
+        uint64_t endNs = 0;
+    };
+
+    bool IsReady(const Task& task) const;
+    void MarkNeeded(size_t index, std::vector<bool>& needed) const;
+    void SkipDependents(size_t index);
+    void LaunchReadyWorkers();
+    void Execute(size_t index);
+    void RunUntil(const std::vector<bool>& needed);
+
+    uint64_t m_createdNs;
+    std::vector<std::unique_ptr<Task>> m_tasks;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+};
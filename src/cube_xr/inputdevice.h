@@ -0,0 +1,21 @@
+#pragma once
+#include "pxr/PxrApi.h"
+#include "pxr/PxrInput.h"
+
+#include <memory>
+
+// The slice of the PXR controller API used by the app. Kept behind an interface so the
+// input code can run against a stand-in implementation off-device.
+struct IInputDevice {
+    virtual ~IInputDevice() = default;
+
+    virtual int GetCapabilities(uint32_t hand, PxrControllerCapability* capability) = 0;
+    virtual int GetConnectStatus(uint32_t hand) = 0;
+    virtual int GetInputState(uint32_t hand, PxrControllerInputState* state) = 0;
+    virtual int GetInputEvent(uint32_t hand, PxrControllerInputEvent* event) = 0;
+    virtual int SetInputEventCallback(bool enable) = 0;
+    virtual int SetVibration(uint32_t hand, float strength, int durationMs) = 0;
+};
+
+// Create an input device backed by the PXR runtime.
+std::shared_ptr<IInputDevice> CreateInputDevice_Pxr();
@@ -0,0 +1,30 @@
+#include "common.h"
+#include "inputdevice.h"
+
+namespace {
+struct PxrInputDevice : public IInputDevice {
+    int GetCapabilities(uint32_t hand, PxrControllerCapability* capability) override {
+        return Pxr_GetControllerCapabilities(hand, capability);
+    }
+
+    int GetConnectStatus(uint32_t hand) override { return Pxr_GetControllerConnectStatus(hand); }
+
+    int GetInputState(uint32_t hand, PxrControllerInputState* state) override {
+        return Pxr_GetControllerInputState(hand, state);
+    }
+
+    int GetInputEvent(uint32_t hand, PxrControllerInputEvent* event) override {
+        return Pxr_GetControllerInputEvent(hand, event);
+    }
+
+    int SetInputEventCallback(bool enable) override { return Pxr_SetInputEventCallback(enable); }
+
+    int SetVibration(uint32_t hand, float strength, int durationMs) override {
+        return Pxr_SetControllerVibration(hand, strength, durationMs);
+    }
+};
+}  // namespace
+
+std::shared_ptr<IInputDevice> CreateInputDevice_Pxr() {
+    return std::make_shared<PxrInputDevice>();
+}
@@ -0,0 +1,172 @@
+#include "common.h"
+#include "inputsystem.h"
+
+namespace {
+struct ButtonBinding {
+    InputButton button;
+    int PxrControllerInputState::*state;
+    PxrInputEvent PxrControllerInputEvent::*event;
+};
+
+constexpr ButtonBinding c_buttonBindings[] = {
+    {InputButton::Home,       &PxrControllerInputState::homeValue,     &PxrControllerInputEvent::home},
+    {InputButton::Back,       &PxrControllerInputState::backValue,     &PxrControllerInputEvent::back},
+    {InputButton::Touchpad,   &PxrControllerInputState::touchpadValue, &PxrControllerInputEvent::touchpad},
+    {InputButton::VolumeUp,   &PxrControllerInputState::volumeUp,      &PxrControllerInputEvent::volumeUp},
+    {InputButton::VolumeDown, &PxrControllerInputState::volumeDown,    &PxrControllerInputEvent::volumeDown},
+    {InputButton::AX,         &PxrControllerInputState::AXValue,       &PxrControllerInputEvent::AX},
+    {InputButton::BY,         &PxrControllerInputState::BYValue,       &PxrControllerInputEvent::BY},
+    {InputButton::Side,       &PxrControllerInputState::sideValue,     &PxrControllerInputEvent::side},
+};
+
+uint32_t ButtonMask(const PxrControllerInputState& state) {
+    uint32_t mask = 0;
+    for (const ButtonBinding& binding : c_buttonBindings) {
+        if (state.*binding.state) {
+            mask |= 1u << (uint32_t)binding.button;
+        }
+    }
+    return mask;
+}
+}  // namespace
+
+InputSystem::InputSystem(std::shared_ptr<IInputDevice> device) : m_device(std::move(device)) { Invalidate(); }
+
+void InputSystem::SetUseInputEventCallback(bool enable) {
+    if (m_useEventCallback == enable) {
+        return;
+    }
+    m_useEventCallback = enable;
+    if (m_resumed) {
+        m_device->SetInputEventCallback(enable);
+    }
+}
+
+void InputSystem::OnResume() {
+    m_resumed = true;
+    if (m_useEventCallback) {
+        m_device->SetInputEventCallback(true);
+    }
+}
+
+void InputSystem::OnPause() {
+    m_resumed = false;
+    if (m_useEventCallback) {
+        m_device->SetInputEventCallback(false);
+    }
+}
+
+void InputSystem::OnControllerChanged(const PxrEventDataControllerChanged& event) {
+    if (event.controller < PXR_CONTROLLER_COUNT) {
+        m_dirty[event.controller] = true;
+        m_controllers[event.controller].capabilityValid = false;
+    } else {
+        Invalidate();
+    }
+}
+
+void InputSystem::Invalidate() {
+    for (uint32_t hand = 0; hand < PXR_CONTROLLER_COUNT; hand++) {
+        m_dirty[hand] = true;
+        m_controllers[hand].capabilityValid = false;
+    }
+}
+
+void InputSystem::Update() {
+    m_eventCount = 0;
+    m_stats.updates++;
+
+    for (uint32_t hand = 0; hand < PXR_CONTROLLER_COUNT; hand++) {
+        if (m_dirty[hand]) {
+            RefreshConnection(hand);
+        }
+        if (!m_controllers[hand].connected) {
+            continue;
+        }
+
+        PxrControllerInputState state = {};
+        m_device->GetInputState(hand, &state);
+        m_stats.runtimeCalls++;
+        if (memcmp(&state, &m_controllers[hand].input, sizeof(state)) == 0) {
+            m_stats.unchangedSnapshots++;
+        } else {
+            DiffSnapshot(hand, state);
+        }
+        if (m_useEventCallback) {
+            ReadRuntimeEdges(hand);
+        }
+    }
+}
+
+void InputSystem::RefreshConnection(uint32_t hand) {
+    ControllerState& controller = m_controllers[hand];
+    const bool connected = m_device->GetConnectStatus(hand) == 1;
+    m_stats.runtimeCalls++;
+
+    if (connected && !controller.capabilityValid) {
+        controller.capabilityValid = m_device->GetCapabilities(hand, &controller.capability) == PXR_RET_SUCCESS;
+        m_stats.runtimeCalls++;
+    }
+    if (connected != controller.connected) {
+        controller.connected = connected;
+        controller.input = {};
+        controller.buttons = 0;
+        Emit(hand, connected ? InputEventType::Connected : InputEventType::Disconnected);
+    }
+    m_dirty[hand] = false;
+}
+
+void InputSystem::DiffSnapshot(uint32_t hand, const PxrControllerInputState& state) {
+    ControllerState& controller = m_controllers[hand];
+
+    const uint32_t buttons = ButtonMask(state);
+    if (!m_useEventCallback) {
+        uint32_t changed = buttons ^ controller.buttons;
+        for (uint32_t bit = 0; changed != 0; bit++, changed >>= 1) {
+            if (changed & 1u) {
+                Emit(hand, (buttons & (1u << bit)) ? InputEventType::ButtonDown : InputEventType::ButtonUp, (InputButton)bit);
+            }
+        }
+    }
+    if (state.triggerValue != controller.input.triggerValue) {
+        Emit(hand, InputEventType::TriggerChanged, InputButton::Count, state.triggerValue);
+    }
+    if (state.gripValue != controller.input.gripValue) {
+        Emit(hand, InputEventType::GripChanged, InputButton::Count, state.gripValue);
+    }
+    if (state.Joystick.x != controller.input.Joystick.x || state.Joystick.y != controller.input.Joystick.y) {
+        Emit(hand, InputEventType::JoystickChanged);
+    }
+
+    controller.input = state;
+    controller.buttons = buttons;
+}
+
+void InputSystem::ReadRuntimeEdges(uint32_t hand) {
+    PxrControllerInputEvent event = {};
+    const int result = m_device->GetInputEvent(hand, &event);
+    m_stats.runtimeCalls++;
+    if (result != PXR_RET_SUCCESS) {
+        return;
+    }
+    for (const ButtonBinding& binding : c_buttonBindings) {
+        const PxrInputEvent& key = event.*binding.event;
+        if (key.down) {
+            Emit(hand, InputEventType::ButtonDown, binding.button);
+        }
+        if (key.longpress) {
+            Emit(hand, InputEventType::LongPress, binding.button);
+        }
+        if (key.up) {
+            Emit(hand, InputEventType::ButtonUp, binding.button);
+        }
+    }
+}
+
+void InputSystem::Emit(uint32_t hand, InputEventType type, InputButton button, float value) {
+    if (m_eventCount == MaxEventsPerFrame) {
+        return;
+    }
+    m_events[m_eventCount++] = InputEvent{hand, type, button, value};
+    m_stats.events++;
+}
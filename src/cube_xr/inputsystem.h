@@ -0,0 +1,82 @@
+#pragma once
+#include "inputdevice.h"
+
+#include <memory>
+
+enum class InputButton : uint8_t { Home, Back, Touchpad, VolumeUp, VolumeDown, AX, BY, Side, Count };
+
+enum class InputEventType : uint8_t {
+    Connected,
+    Disconnected,
+    ButtonDown,
+    ButtonUp,
+    LongPress,  // only reported on the runtime input event path
+    TriggerChanged,
+    GripChanged,
+    JoystickChanged,
+};
+
+struct InputEvent {
+    uint32_t       hand;
+    InputEventType type;
+    InputButton    button;
+    float          value;
+};
+
+struct ControllerState {
+    bool                    connected = false;
+    bool                    capabilityValid = false;
+    PxrControllerCapability capability = {};
+    PxrControllerInputState input = {};
+    uint32_t                buttons = 0;  // bit per InputButton currently held
+
+    bool IsDown(InputButton button) const { return (buttons & (1u << (uint32_t)button)) != 0; }
+};
+
+// Caches controller capabilities and connection state until the runtime reports a
+// controller change, and turns per-frame input snapshots into edge events. When nothing
+// changes, a frame costs one input-state query per connected controller and no events.
+class InputSystem {
+public:
+    static const int MaxEventsPerFrame = 64;
+
+    struct Stats {
+        uint64_t updates = 0;
+        uint64_t runtimeCalls = 0;
+        uint64_t unchangedSnapshots = 0;
+        uint64_t events = 0;
+    };
+
+    explicit InputSystem(std::shared_ptr<IInputDevice> device);
+
+    // Take button edges from Pxr_GetControllerInputEvent instead of diffing snapshots.
+    void SetUseInputEventCallback(bool enable);
+    void OnResume();
+    void OnPause();
+
+    // Invalidate cached capability and connection state.
+    void OnControllerChanged(const PxrEventDataControllerChanged& event);
+    void Invalidate();
+
+    void Update();
+
+    const ControllerState& Controller(uint32_t hand) const { return m_controllers[hand]; }
+    const InputEvent* begin() const { return m_events; }
+    const InputEvent* end() const { return m_events + m_eventCount; }
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    void RefreshConnection(uint32_t hand);
+    void DiffSnapshot(uint32_t hand, const PxrControllerInputState& state);
+    void ReadRuntimeEdges(uint32_t hand);
+    void Emit(uint32_t hand, InputEventType type, InputButton button = InputButton::Count, float value = 0.0f);
+
+    std::shared_ptr<IInputDevice> m_device;
+    bool m_useEventCallback{false};
+    bool m_resumed{false};
+    bool m_dirty[PXR_CONTROLLER_COUNT];
+    ControllerState m_controllers[PXR_CONTROLLER_COUNT];
+    InputEvent m_events[MaxEventsPerFrame];
+    int m_eventCount{0};
+    Stats m_stats;
+};
@@ -0,0 +1,65 @@
+#include "common.h"
+#include "instrumentation.h"
+
+#include <condition_variable>
+
+namespace {
+struct NamedReporter {
+    std::string name;
+    Instrumentation::Reporter reporter;
+};
+
+std::mutex g_lock;
+std::condition_variable g_wake;
+std::vector<NamedReporter> g_reporters;
+std::thread g_thread;
+bool g_running = false;
+
+void Run(double periodSeconds) {
+    using Clock = std::chrono::steady_clock;
+    auto last = Clock::now();
+    std::unique_lock<std::mutex> lock(g_lock);
+    while (g_running) {
+        if (g_wake.wait_for(lock, std::chrono::duration<double>(periodSeconds), [] { return !g_running; })) {
+            break;
+        }
+        const auto now = Clock::now();
+        const double elapsed = std::chrono::duration<double>(now - last).count();
+        last = now;
+        for (const NamedReporter& entry : g_reporters) {
+            std::ostringstream out;
+            out.setf(std::ios::fixed);
+            out.precision(1);
+            entry.reporter(out, elapsed);
+            Log::Write(Log::Level::Info, Fmt("[perf] %s: %s", entry.name.c_str(), out.str().c_str()));
+        }
+    }
+}
+}  // namespace
+
+namespace Instrumentation {
+void AddReporter(const char* name, Reporter reporter) {
+    std::lock_guard<std::mutex> lock(g_lock);
+    g_reporters.push_back(NamedReporter{name, std::move(reporter)});
+}
+
+void Start(double periodSeconds) {
+    std::lock_guard<std::mutex> lock(g_lock);
+    if (g_running) {
+        return;
+    }
+    g_running = true;
+    g_thread = std::thread(Run, periodSeconds);
+}
+
+void Stop() {
+    {
+        std::lock_guard<std::mutex> lock(g_lock);
+        g_running = false;
+    }
+    g_wake.notify_all();
+    if (g_thread.joinable()) {
+        g_thread.join();
+    }
+}
+}  // namespace Instrumentation
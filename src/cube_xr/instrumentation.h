@@ -0,0 +1,16 @@
+#pragma once
+
+#include <functional>
+#include <sstream>
+
+// Periodic performance report. Subsystems register a reporter that appends their
+// counters to a line; a background thread writes one log line per reporter every
+// period. Reporters run on that thread, so they must only read atomics or otherwise
+// thread-safe state.
+namespace Instrumentation {
+using Reporter = std::function<void(std::ostringstream& out, double elapsedSeconds)>;
+
+void AddReporter(const char* name, Reporter reporter);
+void Start(double periodSeconds = 1.0);
+void Stop();
+}  // namespace Instrumentation
@@ -0,0 +1,129 @@
+#include "common.h"
+#include "lodselector.h"
+#include "simd4.h"
+
+namespace {
+const float BoundingRadius = 0.8660254f;  // half the diagonal of the unit cube
+}  // namespace
+
+void LodSelector::SetLods(const uint32_t* triangleCounts, uint32_t lodCount, uint32_t baselineTriangles) {
+    m_lodCount = std::max(1u, std::min(lodCount, MaxMeshLods));
+    for (uint32_t lod = 0; lod < m_lodCount; lod++) {
+        m_triangles[lod] = triangleCounts[lod];
+    }
+    m_baselineTriangles = baselineTriangles;
+}
+
+// Updates m_lod, padded to a multiple of 4, from the cubes' demand.
+void LodSelector::Classify(const std::vector<Cube>& cubes, const PxrVector3f& origin, const PxrVector3f& direction) {
+    using namespace Simd;
+
+    const size_t count = cubes.size();
+    const size_t padded = (count + 3) & ~(size_t)3;
+    const uint32_t lastLod = m_lodCount - 1;
+    // Cubes appended since the last frame start at the coarsest LOD.
+    m_lod.resize(padded, (float)lastLod);
+    m_x.resize(padded);
+    m_y.resize(padded);
+    m_z.resize(padded);
+    m_radius.resize(padded);
+    for (size_t i = 0; i < count; i++) {
+        const Cube& cube = cubes[i];
+        m_x[i] = cube.Pose.position.x;
+        m_y[i] = cube.Pose.position.y;
+        m_z[i] = cube.Pose.position.z;
+        m_radius[i] = BoundingRadius * std::max(cube.Scale.x, std::max(cube.Scale.y, cube.Scale.z));
+    }
+
+    const Float4 ox = Splat(origin.x), oy = Splat(origin.y), oz = Splat(origin.z);
+    const Float4 gx = Splat(direction.x), gy = Splat(direction.y), gz = Splat(direction.z);
+    const Float4 zero = Splat(0.0f), one = Splat(1.0f), two = Splat(2.0f);
+    const Float4 minDistance2 = Splat(1e-6f);
+    const Float4 inverseFovea = Splat(1.0f / FoveaRadians);
+    Float4 raised[MaxMeshLods - 1];
+    Float4 lowered[MaxMeshLods - 1];
+    for (uint32_t k = 0; k < lastLod; k++) {
+        raised[k] = Splat(Thresholds[k] * (1.0f + Hysteresis));
+        lowered[k] = Splat(Thresholds[k] * (1.0f - Hysteresis));
+    }
+
+    for (size_t i = 0; i < padded; i += 4) {
+        const Float4 dx = Load(&m_x[i]) - ox;
+        const Float4 dy = Load(&m_y[i]) - oy;
+        const Float4 dz = Load(&m_z[i]) - oz;
+        const Float4 inverseDistance = RSqrt(Max(dx * dx + dy * dy + dz * dz, minDistance2));
+        const Float4 cosine = (dx * gx + dy * gy + dz * gz) * inverseDistance;
+        // The chord between the unit vectors stands in for the angle: equal at 0, 10% short
+        // at 90 degrees, and monotonic, which is all the thresholds need.
+        const Float4 angle = Sqrt(Max(zero, two * (one - cosine)));
+        const Float4 size = Load(&m_radius[i]) * inverseDistance;
+        // Eccentricity of the object's nearest edge; 0 when the gaze ray passes through it.
+        const Float4 eccentricity = Max(zero, angle - size);
+        const Float4 demand = size * Reciprocal(one + eccentricity * inverseFovea);
+
+        // A LOD is the number of thresholds demand is below. Counted against the lowered
+        // thresholds that is the finest LOD the cube may keep, against the raised ones the
+        // coarsest; the previous LOD only moves when it falls outside that range.
+        Float4 finest = zero;
+        Float4 coarsest = zero;
+        for (uint32_t k = 0; k < lastLod; k++) {
+            finest = finest + Simd::Select(demand < lowered[k], one, zero);
+            coarsest = coarsest + Simd::Select(demand < raised[k], one, zero);
+        }
+        Store(&m_lod[i], Clamp(Load(&m_lod[i]), finest, coarsest));
+    }
+}
+
+void LodSelector::Select(std::vector<Cube>& cubes, const PxrVector3f& origin, const PxrVector3f& direction) {
+    const size_t count = cubes.size();
+    if (m_lodCount > 1) {
+        Classify(cubes, origin, direction);
+    } else {
+        m_lod.assign(count, 0.0f);
+    }
+
+    uint64_t drawn = 0;
+    uint64_t switches = 0;
+    uint64_t lodObjects[MaxMeshLods] = {};
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t lod = (uint32_t)m_lod[i];
+        switches += cubes[i].Lod != lod ? 1 : 0;
+        cubes[i].Lod = lod;
+        drawn += m_triangles[lod];
+        lodObjects[lod]++;
+    }
+
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    m_drawnTriangles.fetch_add(drawn, std::memory_order_relaxed);
+    m_baselineTotal.fetch_add((uint64_t)m_baselineTriangles * count, std::memory_order_relaxed);
+    m_switches.fetch_add(switches, std::memory_order_relaxed);
+    for (uint32_t lod = 0; lod < m_lodCount; lod++) {
+        m_lodObjects[lod].fetch_add(lodObjects[lod], std::memory_order_relaxed);
+    }
+}
+
+void LodSelector::Report(std::ostringstream& out, double /*elapsedSeconds*/) {
+    const uint64_t frames = m_frames.load(std::memory_order_relaxed);
+    const uint64_t drawn = m_drawnTriangles.load(std::memory_order_relaxed);
+    const uint64_t baseline = m_baselineTotal.load(std::memory_order_relaxed);
+    const uint64_t switches = m_switches.load(std::memory_order_relaxed);
+    const uint64_t newFrames = frames - m_reportedFrames;
+    if (newFrames > 0) {
+        // Per view; both eyes draw the same selection. Negative when the LODs cost more than
+        // the baseline mesh did.
+        out << "trisSaved/frame="
+            << ((int64_t)(baseline - m_reportedBaselineTotal) - (int64_t)(drawn - m_reportedDrawnTriangles)) /
+                   (int64_t)newFrames
+            << " trisDrawn/frame=" << (drawn - m_reportedDrawnTriangles) / newFrames
+            << " switches/frame=" << (double)(switches - m_reportedSwitches) / newFrames << " objects/lod=";
+        for (uint32_t lod = 0; lod < m_lodCount; lod++) {
+            const uint64_t objects = m_lodObjects[lod].load(std::memory_order_relaxed);
+            out << (lod > 0 ? "/" : "") << (objects - m_reportedLodObjects[lod]) / newFrames;
+            m_reportedLodObjects[lod] = objects;
+        }
+    }
+    m_reportedFrames = frames;
+    m_reportedDrawnTriangles = drawn;
+    m_reportedBaselineTotal = baseline;
+    m_reportedSwitches = switches;
+}
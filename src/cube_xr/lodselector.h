@@ -0,0 +1,63 @@
+#pragma once
+#include "graphicsplugin.h"
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+// Picks a mesh LOD per cube from where the user looks. Detail goes with the object's
+// angular size weighted by visual acuity at its eccentricity from the gaze ray:
+//   demand = size / (1 + eccentricity / FoveaRadians)
+// so a cube gets the same LOD when it is half as big on screen or when it sits at the
+// eccentricity where acuity has halved. LOD i is used while demand is below threshold i-1
+// but not below threshold i; the thresholds have a hysteresis band around them, so a
+// cube whose demand hovers near one does not pop back and forth.
+//
+// Objects are processed four at a time from per-component arrays.
+class LodSelector {
+public:
+    static constexpr float FoveaRadians = 0.04f;  // ~2.3 degrees, eccentricity of half acuity
+    static constexpr float Hysteresis = 0.2f;     // relative half-width of the band around a threshold
+    // Demand at which each LOD gives way to the next coarser one, for LODs about 4x apart in
+    // triangle count. Demand is in radians: the angular radius of the bounding sphere at the
+    // fovea.
+    static constexpr float Thresholds[MaxMeshLods - 1] = {0.10f, 0.04f, 0.015f};
+
+    // Triangles of each LOD, most detailed first; also sets the number of LODs (at most
+    // MaxMeshLods). baselineTriangles is what an object cost before it had LODs, which the
+    // reported savings are measured against. With a single LOD, Select() only resets Lod.
+    void SetLods(const uint32_t* triangleCounts, uint32_t lodCount, uint32_t baselineTriangles);
+
+    // Sets Cube::Lod of every cube for a gaze ray in world space (direction normalized).
+    // Call once per frame with the same cube order, so hysteresis state follows the cubes.
+    void Select(std::vector<Cube>& cubes, const PxrVector3f& origin, const PxrVector3f& direction);
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    void Classify(const std::vector<Cube>& cubes, const PxrVector3f& origin, const PxrVector3f& direction);
+
+    uint32_t m_lodCount{1};
+    uint32_t m_triangles[MaxMeshLods] = {};
+    uint32_t m_baselineTriangles{0};
+
+    // One entry per cube, padded to a multiple of 4.
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    std::vector<float> m_radius;
+    std::vector<float> m_lod;
+
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_drawnTriangles{0};
+    std::atomic<uint64_t> m_baselineTotal{0};
+    std::atomic<uint64_t> m_switches{0};
+    std::atomic<uint64_t> m_lodObjects[MaxMeshLods] = {};
+    uint64_t m_reportedFrames{0};
+    uint64_t m_reportedDrawnTriangles{0};
+    uint64_t m_reportedBaselineTotal{0};
+    uint64_t m_reportedSwitches{0};
+    uint64_t m_reportedLodObjects[MaxMeshLods] = {};
+};
@@ -1,29 +1,131 @@
 #include "common.h"
+#include "dynamicresolution.h"
+#include "eventqueue.h"
+#include "framearena.h"
+#include "framescheduler.h"
 #include "graphicsplugin.h"
+#include "gazecalibration.h"
+#include "gazeheatmap.h"
+#include "gazemetrics.h"
+#include "gazepicker.h"
+#include "gazepublisher.h"
+#include "gazerecording.h"
+#include "gazesampler.h"
+#include "haptics.h"
+#include "headposehistory.h"
+#include "initgraph.h"
+#include "inputsystem.h"
+#include "instrumentation.h"
+#include "lodselector.h"
+#include "perfgovernor.h"
+#include "presencemonitor.h"
 #include "pxr/PxrApi.h"
 #include "pxr/PxrInput.h"
+#include "vergence.h"
 #include <GLES3/gl3.h>
 
+#include "glm/gtx/quaternion.hpp"
+
 const int SAMPLE_COUNT = 4;
 const int UNIT_CUBE_COUNT = 5;
-const int MaxEventCount = 20;
+const int FRAMES_IN_FLIGHT = 3;
+const float GAZE_SAMPLE_RATE_HZ = 120.0f;
+const uint64_t GAZE_MAX_AGE_NS = 50000000;
+// Whose gaze calibration profile to load; there is a single user per device for now.
+const char* const GAZE_CALIBRATION_USER = "default";
+// Debug calibration, started with the touchpad: a 3x3 grid of head-locked targets 12 degrees
+// apart, one meter ahead, each shown for CALIBRATION_TARGET_NS. Long enough to get past
+// GazeCalibration::SettleNs and collect a few hundred samples.
+const float CALIBRATION_TARGET_SPREAD = 0.21f;  // tan(12 degrees)
+const float CALIBRATION_TARGET_SCALE = 0.03f;
+const uint64_t CALIBRATION_TARGET_NS = 1500000000;
+const int CALIBRATION_TARGET_COUNT = 9;
+// While nobody looks: render every IDLE_FRAME_INTERVAL-th vsync and sample just fast
+// enough to notice the eyes coming back.
+const int IDLE_FRAME_INTERVAL = 4;
+const float IDLE_GAZE_SAMPLE_RATE_HZ = 20.0f;
+// A first predicted display time further than this from MonotonicNs() is not on
+// CLOCK_MONOTONIC, so it cannot key the head pose history the gaze samples are looked up in.
+const uint64_t MAX_DISPLAY_TIME_OFFSET_NS = 1000000000;
+const int LOOPER_ID_FRAME_TIMER = LOOPER_ID_USER;
+const int LOOPER_ID_FRAME_SIGNAL = LOOPER_ID_USER + 1;
 struct AndroidAppState {
     ANativeWindow* nativeWindow = nullptr;
     bool resumed = false;
 
     int recommendW;
     int recommendH;
+    int layerW;
+    int layerH;
+    int samples = SAMPLE_COUNT;
+    uint64_t frameStartNs = 0;
     int eyeLayerId = 0;
-    uint64_t layerImages[PXR_EYE_MAX][3] = {0};
+    uint64_t layerImages[PXR_EYE_MAX][MaxSwapchainImages] = {0};
+    uint32_t imageCount[PXR_EYE_MAX] = {0};
 
     int handCount  = 0;
     bool handState[PXR_CONTROLLER_COUNT];
     float handScale[PXR_CONTROLLER_COUNT] = {1.0};
     PxrVector2f joystick[PXR_CONTROLLER_COUNT];
     uint32_t mainController;
-    PxrEventDataBuffer* eventDataPointer[MaxEventCount];
+    uint64_t frameIndex = 0;
+    bool displayTimeChecked = false;
+    bool displayTimeMonotonic = false;  // predicted display times can key the head pose history
+
+    int calibrationTarget = -1;  // target being shown, -1 when not calibrating
+    uint64_t calibrationTargetStartNs = 0;
+    bool calibrationCube = false;
 };
 
+std::shared_ptr<IInputDevice> inputDevice = CreateInputDevice_Pxr();
+InputSystem inputSystem(inputDevice);
+HapticsScheduler haptics(inputDevice);
+PerfGovernor perfGovernor(CreatePerfDevice_Pxr(), PerfLimits{1, SAMPLE_COUNT, 0.7f, 0.1f});
+DynamicResolution dynamicResolution;
+LodSelector lodSelector;
+EventQueue eventQueue;
+FrameScheduler frameScheduler;
+PresenceMonitor presenceMonitor;
+HeadPoseHistory headPoses;
+GazePicker gazePicker;
+VergenceEstimator vergence;
+GazeMetrics gazeMetrics;
+GazeCalibration gazeCalibration;
+GazeHeatmap gazeHeatmap;
+#if defined(ETVR_RECORD_GAZE)
+RecordingWriter gazeRecorder;
+#endif
+
+std::vector<Cube> cubes;
+std::shared_ptr<IGraphicsPlugin> graphicsPlugin;
+FrameArenaRing<FRAMES_IN_FLIGHT> frameArenas;
+std::atomic<uint64_t> renderedFrames{0};
+std::atomic<uint64_t> frameHeapAllocations{0};
+uint64_t launchTimeNs = 0;
+InitGraph initGraph;
+std::thread heatmapExport;
+std::atomic<bool> heatmapExporting{false};
+
+// Writes the gaze heatmap as it is now into the app's data directory, off this thread.
+// Skipped while the previous export is still writing; pxrapi_deinit() waits for it.
+static void export_heatmap(struct android_app* app)
+{
+    if (app->activity->internalDataPath == nullptr || heatmapExporting.load()) {
+        return;
+    }
+    if (heatmapExport.joinable()) {
+        heatmapExport.join();
+    }
+    const std::string path = std::string(app->activity->internalDataPath) + "/gaze_heatmap.png";
+    heatmapExporting = true;
+    heatmapExport = std::thread([path]() {
+        if (gazeHeatmap.Export(path, MonotonicNs())) {
+            Log::Write(Log::Level::Info, Fmt("Gaze heatmap written to %s", path.c_str()));
+        }
+        heatmapExporting = false;
+    });
+}
+
 /**
  * Process the next main command.
  */
@@ -42,14 +144,18 @@ static void app_handle_cmd(struct android_app* app, int32_t cmd) {
         case APP_CMD_RESUME: {
             Log::Write(Log::Level::Info, "onResume()");
             Log::Write(Log::Level::Info, "    APP_CMD_RESUME");
-            //Pxr_SetInputEventCallback(true);
+            inputSystem.OnResume();
             appState->resumed = true;
             break;
         }
         case APP_CMD_PAUSE: {
             Log::Write(Log::Level::Info, "onPause()");
             Log::Write(Log::Level::Info, "    APP_CMD_PAUSE");
-            //Pxr_SetInputEventCallback(false);
+            inputSystem.OnPause();
+            export_heatmap(app);
+#if defined(ETVR_RECORD_GAZE)
+            gazeRecorder.Flush();
+#endif
             appState->resumed = false;
             break;
         }
@@ -101,13 +207,17 @@ static void pxrapi_init_layers(struct android_app* app)
 
     s->recommendW = recommendW;
     s->recommendH = recommendH;
+    // Allocated once at the recommended size, which full-scale frames render straight into;
+    // dynamic resolution only shrinks the imageRect below that.
+    s->layerW = recommendW;
+    s->layerH = recommendH;
 
     PxrLayerParam layerParam = {};
     layerParam.layerId = layerId;
     layerParam.layerShape = PXR_LAYER_PROJECTION;
     layerParam.layerLayout = PXR_LAYER_LAYOUT_STEREO;
-    layerParam.width = recommendW;
-    layerParam.height = recommendH;
+    layerParam.width = s->layerW;
+    layerParam.height = s->layerH;
     layerParam.faceCount = 1;
     layerParam.mipmapCount = 1;
     layerParam.sampleCount = 1;
@@ -120,10 +230,13 @@ static void pxrapi_init_layers(struct android_app* app)
     {
         uint32_t imageCounts = 0;
         Pxr_GetLayerImageCount(layerId, (PxrEyeType)i, &imageCounts);
-        for(int j = 0; j < imageCounts; j++)
+        imageCounts = std::min(imageCounts, MaxSwapchainImages);
+        for(uint32_t j = 0; j < imageCounts; j++)
         {
             Pxr_GetLayerImage(layerId, (PxrEyeType)i, j, &s->layerImages[i][j]);
         }
+        s->imageCount[i] = imageCounts;
+        graphicsPlugin->SetSwapchainImages((PxrEyeType)i, s->layerImages[i], imageCounts, s->samples);
     }
 }
 
@@ -135,91 +248,267 @@ static void pxrapi_init_controller(struct android_app* app)
 
 static void pxrapi_init_events(struct android_app* app)
 {
-    auto* s = (AndroidAppState*)app->userData;
-    for(auto & i : s->eventDataPointer){
-        i = new PxrEventDataBuffer;
+    eventQueue.Subscribe<PxrEventDataSessionReady>([](const PxrEventDataSessionReady&) { Pxr_BeginXr(); });
+    eventQueue.Subscribe<PxrEventDataSessionStopping>([](const PxrEventDataSessionStopping&) { Pxr_EndXr(); });
+    eventQueue.Subscribe<PxrEventDataControllerChanged>([](const PxrEventDataControllerChanged& event) {
+        inputSystem.OnControllerChanged(event);
+    });
+    eventQueue.Subscribe<PxrEventDataPerfSettings>([](const PxrEventDataPerfSettings& event) {
+        perfGovernor.OnPerfSettings(event);
+    });
+    eventQueue.Subscribe<PxrEventDataRefreshRateChanged>([](const PxrEventDataRefreshRateChanged& event) {
+        perfGovernor.OnRefreshRateChanged(event.refrashRate);
+    });
+    // Whatever was lost may have included controller changes.
+    eventQueue.Subscribe<PxrEventDataEventsLost>([](const PxrEventDataEventsLost& event) {
+        Log::Write(Log::Level::Warning, Fmt("Lost %u runtime events", event.lostEventCount));
+        inputSystem.Invalidate();
+    });
+    eventQueue.Subscribe<PxrEventDataTargetFrameRateChanged>([](const PxrEventDataTargetFrameRateChanged& event) {
+        Log::Write(Log::Level::Info, Fmt("Target frame rate changed to %d", event.frameRate));
+    });
+    eventQueue.Subscribe<PxrEventDataFoveationLevelChanged>([](const PxrEventDataFoveationLevelChanged& event) {
+        Log::Write(Log::Level::Info, Fmt("Foveation level changed to %d", event.level));
+    });
+    eventQueue.Subscribe<PxrEventDataFrustumChanged>([](const PxrEventDataFrustumChanged&) {
+        Log::Write(Log::Level::Info, "View frustum changed");
+    });
+    eventQueue.Subscribe<PxrEventDataRenderTextureChanged>([](const PxrEventDataRenderTextureChanged& event) {
+        Log::Write(Log::Level::Info, Fmt("Recommended render texture changed to %dx%d", event.width, event.height));
+    });
+}
+
+static bool read_eye_tracking(GazeSample* sample)
+{
+    PxrEyeTrackingData data = {};
+    if (Pxr_GetEyeTrackingData(&data) != PXR_RET_SUCCESS) {
+        return false;
+    }
+    sample->leftEyePoseStatus     = data.leftEyePoseStatus;
+    sample->rightEyePoseStatus    = data.rightEyePoseStatus;
+    sample->combinedEyePoseStatus = data.combinedEyePoseStatus;
+    memcpy(sample->leftEyeGazePoint,      data.leftEyeGazePoint,      sizeof(data.leftEyeGazePoint));
+    memcpy(sample->rightEyeGazePoint,     data.rightEyeGazePoint,     sizeof(data.rightEyeGazePoint));
+    memcpy(sample->combinedEyeGazePoint,  data.combinedEyeGazePoint,  sizeof(data.combinedEyeGazePoint));
+    memcpy(sample->leftEyeGazeVector,     data.leftEyeGazeVector,     sizeof(data.leftEyeGazeVector));
+    memcpy(sample->rightEyeGazeVector,    data.rightEyeGazeVector,    sizeof(data.rightEyeGazeVector));
+    memcpy(sample->combinedEyeGazeVector, data.combinedEyeGazeVector, sizeof(data.combinedEyeGazeVector));
+    sample->leftEyeOpenness       = data.leftEyeOpenness;
+    sample->rightEyeOpenness      = data.rightEyeOpenness;
+    sample->leftEyePupilDilation  = data.leftEyePupilDilation;
+    sample->rightEyePupilDilation = data.rightEyePupilDilation;
+    sample->foveatedGazeTrackingState = data.foveatedGazeTrackingState;
+    memcpy(sample->foveatedGazeDirection, data.foveatedGazeDirection, sizeof(data.foveatedGazeDirection));
+    return true;
+}
+
+GazePublisher gazePublisher;
+GazeSampler gazeSampler(read_eye_tracking);
+static void pxrapi_init_eyetracking(struct android_app* app)
+{
+    if (!Pxr_GetFeatureSupported(PXR_FEATURE_EYETRACKING)) {
+        Log::Write(Log::Level::Warning, "Eye tracking is not supported on this device");
+        return;
+    }
+    PxrTrackingModeFlags trackingMode = 0;
+    Pxr_GetTrackingMode(&trackingMode);
+    Pxr_SetTrackingMode(trackingMode | PXR_TRACKING_MODE_EYE_BIT);
+
+    if (app->activity->internalDataPath != nullptr) {
+        gazeCalibration.SetDirectory(app->activity->internalDataPath);
+        gazeCalibration.Load(GAZE_CALIBRATION_USER);
+    }
+    // Calibration targets collect the tracker's own directions; everything else sees them corrected.
+    gazeSampler.SetCorrection([](GazeSample* sample) {
+        gazeCalibration.AddSample(*sample);
+        gazeCalibration.Apply(sample, 1);
+    });
+    if (gazePublisher.Start()) {
+        gazeSampler.AddSink([](const GazeSample& sample) { gazePublisher.Publish(sample); });
+    }
+    gazeSampler.AddSink([](const GazeSample& sample) { gazeMetrics.OnSample(sample); });
+    gazeSampler.AddSink([](const GazeSample& sample) {
+        if (presenceMonitor.OnSample(sample, MonotonicNs())) {
+            frameScheduler.Signal();
+        }
+    });
+    gazeSampler.AddSink([](const GazeSample& sample) {
+        WorldGaze gaze;
+        headPoses.TransformGaze(&sample, 1, &gaze);
+        const GazeHit hit = gazePicker.Track(gaze, sample.timestampNs);
+        gazeHeatmap.Add(gaze, sample.timestampNs);
+        if (hit.object >= 0) {
+            gazeHeatmap.AddObject(hit.object, hit.local, sample.timestampNs);
+        }
+        const float pickedDistance = hit.object >= 0 ? hit.distance : 0.0f;
+        VergenceDepth depth;
+        vergence.Process(&sample, 1, &pickedDistance, &depth);
+    });
+#if defined(ETVR_RECORD_GAZE)
+    if (app->activity->internalDataPath != nullptr &&
+        gazeRecorder.Open(Fmt("%s/gaze_%lld.etrec", app->activity->internalDataPath, (long long)time(nullptr)),
+                          MonotonicNs())) {
+        gazeSampler.AddSink([](const GazeSample& sample) {
+            PxrPosef head;
+            RecordedSample record = {};
+            record.gaze = sample;
+            if (headPoses.PoseAt(sample.timestampNs, &head)) {
+                static_assert(sizeof(head) == sizeof(record.head), "RecordedPose mirrors PxrPosef");
+                memcpy(&record.head, &head, sizeof(record.head));
+                record.headValid = 1;
+            }
+            gazeRecorder.Append(record);
+        });
+    }
+#endif
+    gazeSampler.Start(GAZE_SAMPLE_RATE_HZ);
+}
+
+// World space gaze ray for the frame. The latest gaze sample is carried into world space
+// with the head pose of the moment it was taken: while the eyes fixate, they counter-rotate
+// any head motion, so that ray stays put however the head moves until display. The gaze
+// itself is not extrapolated, the eyes move far faster than it could be predicted. Before
+// the pose history covers the sample, the head pose predicted for display carries it.
+// Without a fresh valid sample, the head's forward axis.
+static void predicted_gaze_ray(const PxrPosef& head, PxrVector3f* origin, PxrVector3f* direction)
+{
+    const glm::quat orientation(head.orientation.w, head.orientation.x, head.orientation.y, head.orientation.z);
+    const glm::vec3 position(head.position.x, head.position.y, head.position.z);
+    glm::vec3 gazeOrigin(0.0f);
+    glm::vec3 gazeDirection(0.0f, 0.0f, -1.0f);
+
+    GazeSample sample;
+    if (gazeSampler.Latest(&sample) && MonotonicNs() - sample.timestampNs < GAZE_MAX_AGE_NS &&
+        (sample.combinedEyePoseStatus & GAZE_STATUS_GAZE_VECTOR_VALID)) {
+        WorldGaze gaze;
+        if (headPoses.TransformGaze(&sample, 1, &gaze) == 1) {
+            *origin = gaze.origin;
+            *direction = gaze.direction;
+            return;
+        }
+        const glm::vec3 vector(sample.combinedEyeGazeVector[0], sample.combinedEyeGazeVector[1],
+                               sample.combinedEyeGazeVector[2]);
+        if (glm::length(vector) > 0.5f) {
+            gazeDirection = glm::normalize(vector);
+            if (sample.combinedEyePoseStatus & GAZE_STATUS_GAZE_POINT_VALID) {
+                gazeOrigin = glm::vec3(sample.combinedEyeGazePoint[0], sample.combinedEyeGazePoint[1],
+                                       sample.combinedEyeGazePoint[2]);
+            }
+        }
     }
+    const glm::vec3 worldOrigin = position + orientation * gazeOrigin;
+    const glm::vec3 worldDirection = orientation * gazeDirection;
+    *origin = {worldOrigin.x, worldOrigin.y, worldOrigin.z};
+    *direction = {worldDirection.x, worldDirection.y, worldDirection.z};
 }
 
-static void pxrapi_init(struct android_app* app){
-    // init pxr
-    pxrapi_init_common(app);
-    // create eye layer
-    pxrapi_init_layers(app);
-    // controller
-    pxrapi_init_controller(app);
-    pxrapi_init_events(app);
+static void pxrapi_init_perf(struct android_app* app)
+{
+    perfGovernor.Start();
 }
 
 static void pxrapi_deinit(struct android_app* app) {
     auto* s = (AndroidAppState*)app->userData;
+    initGraph.Wait();
+    if (heatmapExport.joinable()) {
+        heatmapExport.join();
+    }
+    gazeSampler.Stop();
+    gazePublisher.Stop();
+#if defined(ETVR_RECORD_GAZE)
+    gazeRecorder.Close();
+#endif
     //destroy eye layer
     Pxr_DestroyLayer(s->eyeLayerId);
-    for(auto & i : s->eventDataPointer){
-        delete i;
-    }
     Pxr_Shutdown();
 }
 
-static void dispatch_events(struct android_app* app)
+// Head space direction of a debug calibration target, row by row from the top left.
+static void calibration_target_direction(int target, float direction[3])
 {
-    int eventCount = 0;
-    auto* s = (AndroidAppState*)app->userData;
+    const glm::vec3 d = glm::normalize(glm::vec3((target % 3 - 1) * CALIBRATION_TARGET_SPREAD,
+                                                 (1 - target / 3) * CALIBRATION_TARGET_SPREAD, -1.0f));
+    direction[0] = d.x;
+    direction[1] = d.y;
+    direction[2] = d.z;
+}
 
-    if( Pxr_PollEvent(MaxEventCount, &eventCount, s->eventDataPointer) ){
-        for(int i=0; i<eventCount; i++){
-            if(s->eventDataPointer[i]->type == PXR_TYPE_EVENT_DATA_SESSION_STATE_READY){
-                Pxr_BeginXr();
-            }else if(s->eventDataPointer[i]->type == PXR_TYPE_EVENT_DATA_SESSION_STATE_STOPPING){
-                Pxr_EndXr();
-            }
-        }
+static void begin_calibration_target(AndroidAppState* s, int target, uint64_t nowNs)
+{
+    float direction[3];
+    calibration_target_direction(target, direction);
+    gazeCalibration.BeginTarget(direction, nowNs);
+    s->calibrationTarget = target;
+    s->calibrationTargetStartNs = nowNs;
+}
+
+// Moves through the targets and, after the last one, solves and saves the profile.
+static void update_calibration(AndroidAppState* s, uint64_t nowNs)
+{
+    if (s->calibrationTarget < 0 || nowNs - s->calibrationTargetStartNs < CALIBRATION_TARGET_NS) {
+        return;
+    }
+    if (!gazeCalibration.EndTarget()) {
+        Log::Write(Log::Level::Warning, Fmt("Gaze calibration: no usable samples for target %d", s->calibrationTarget));
+    }
+    if (s->calibrationTarget + 1 < CALIBRATION_TARGET_COUNT) {
+        begin_calibration_target(s, s->calibrationTarget + 1, nowNs);
+        return;
+    }
+    s->calibrationTarget = -1;
+    if (!gazeCalibration.Solve()) {
+        Log::Write(Log::Level::Warning, "Gaze calibration failed, keeping the previous profile");
+    } else if (!gazeCalibration.Save(GAZE_CALIBRATION_USER)) {
+        Log::Write(Log::Level::Warning, "Gaze calibration could not be saved");
     }
+}
+
+static void dispatch_events(struct android_app* app)
+{
+    auto* s = (AndroidAppState*)app->userData;
+    eventQueue.Dispatch();
 
     if(Pxr_IsRunning())
     {
-        uint8_t connectStatus = -1;
-        PxrControllerCapability cap;
+        const uint64_t nowNs = MonotonicNs();
+        inputSystem.Update();
+        for (const InputEvent& event : inputSystem) {
+            if(event.type == InputEventType::ButtonDown && event.button == InputButton::Back){
+                ANativeActivity_finish(app->activity);
+            }
+            if (event.type == InputEventType::ButtonDown && event.button == InputButton::Touchpad &&
+                s->calibrationTarget < 0) {
+                Log::Write(Log::Level::Info, "Gaze calibration started");
+                gazeCalibration.ClearTargets();
+                begin_calibration_target(s, 0, nowNs);
+            }
+        }
+        update_calibration(s, nowNs);
 
         int handCount = 0;
         for (auto hand : {PXR_CONTROLLER_LEFT, PXR_CONTROLLER_RIGHT}) {
-            Pxr_GetControllerCapabilities(hand, &cap);
-            if (Pxr_GetControllerConnectStatus(hand) == 1) {
-                int triggerValue;
-                int AXValue;
-                int BYValue;
-                int sideValue;
+            const ControllerState& controller = inputSystem.Controller(hand);
+            if (controller.connected) {
                 float scale = 0.1f;
-                PxrControllerInputState state;
 
-                Pxr_GetControllerInputState(hand, &state);
-                triggerValue = state.triggerValue;
-                AXValue      = state.AXValue;
-                BYValue      = state.BYValue;
-                sideValue    = state.sideValue;
-
-                auto trigger = (float)triggerValue;    // trigger value
+                float trigger = controller.input.triggerValue;    // trigger value
                 if(trigger > 0.01f ){
-                    Pxr_SetControllerVibration(hand, trigger, 20);
+                    haptics.Request(hand, trigger, 20, nowNs);
                 }
 
-                if(AXValue) {  // AX button
+                if(controller.IsDown(InputButton::AX)) {  // AX button
                     scale = 0.05f;
                 }
 
-                if(BYValue) {    // BY button
+                if(controller.IsDown(InputButton::BY)) {    // BY button
                     scale = 0.15f;
                 }
 
-                if(sideValue) {   // Side button
+                if(controller.IsDown(InputButton::Side)) {   // Side button
                     scale = 0.25f;
                 }
 
-                if(state.backValue){
-                    ANativeActivity_finish(app->activity);
-                }
-
-                s->joystick[hand]  = state.Joystick;
+                s->joystick[hand]  = controller.input.Joystick;
                 s->handScale[hand] = scale;
                 s->handState[hand] = true;
                 handCount++;
@@ -228,20 +517,92 @@ static void dispatch_events(struct android_app* app)
             }
         }
         s->handCount = handCount;
+        haptics.Update(nowNs);
     }
 }
 
-std::vector<Cube> cubes;
-std::shared_ptr<IGraphicsPlugin> graphicsPlugin;
-static void init_scene(struct android_app* app)
+static void init_graphics(struct android_app* app)
 {
     graphicsPlugin = CreateGraphicsPlugin_OpenGLES();
+    if (app->activity->internalDataPath != nullptr) {
+        graphicsPlugin->SetCacheDirectory(app->activity->internalDataPath);
+    }
     graphicsPlugin->InitializeDevice();
 
+    // The plain cube the plugin starts with is the only LOD: at 12 triangles there is
+    // nothing a coarser mesh could save. Savings are reported against it.
+    const uint32_t cubeTriangles = (uint32_t)ArraySize(Geometry::c_cubeIndices) / 3;
+    lodSelector.SetLods(&cubeTriangles, 1, cubeTriangles);
+}
+
+static void init_scene(struct android_app* app)
+{
     for(int z=-UNIT_CUBE_COUNT;z<UNIT_CUBE_COUNT;z++)
         for(int y=-UNIT_CUBE_COUNT;y<UNIT_CUBE_COUNT;y++)
             for(int x=-UNIT_CUBE_COUNT;x<UNIT_CUBE_COUNT;x++)
                 cubes.push_back(Cube{ {{0.0f,0.0f,0.0f,1.0f},{0.0f+x+0.3f,0.0f+y+0.3f,0.0f+z+0.3f}}, {0.3f, 0.3f, 0.3f}});
+    // Only the static scene is pickable; the hand cubes come and go every frame.
+    gazePicker.Build(cubes);
+}
+
+// Worker tasks that call into the runtime get their own JNI attachment.
+static void run_attached(struct android_app* app, void (*init)(struct android_app*))
+{
+    JNIEnv* env;
+    app->activity->vm->AttachCurrentThread(&env, nullptr);
+    init(app);
+    app->activity->vm->DetachCurrentThread();
+}
+
+// Applies the governor's quality knobs: render scale caps dynamic resolution, MSAA needs
+// the framebuffers rebuilt.
+static void apply_perf_state(struct android_app* app)
+{
+    auto* s = (AndroidAppState*)app->userData;
+    const PerfState& state = perfGovernor.State();
+    dynamicResolution.SetCeiling(state.renderScale);
+    if (state.samples != s->samples) {
+        s->samples = state.samples;
+        for (int i = 0; i < 2; i++) {
+            graphicsPlugin->SetSwapchainImages((PxrEyeType)i, s->layerImages[i], s->imageCount[i], s->samples);
+        }
+    }
+}
+
+// Returns false if something the first frame needs failed to initialize.
+static bool init_app(struct android_app* app)
+{
+    using Affinity = InitGraph::Affinity;
+    // The GL context lives on the main thread, so everything touching GL runs there.
+    initGraph.Add("graphics", {}, Affinity::Main, [app]() { init_graphics(app); });
+    initGraph.Add("scene", {}, Affinity::Worker, [app]() { init_scene(app); });
+    initGraph.Add("events", {}, Affinity::Worker, [app]() { pxrapi_init_events(app); });
+    initGraph.Add("pxr", {}, Affinity::Worker, [app]() { run_attached(app, pxrapi_init_common); });
+    initGraph.Add("layers", {"graphics", "pxr"}, Affinity::Main, [app]() { pxrapi_init_layers(app); });
+    initGraph.Add("controller", {"pxr"}, Affinity::Worker, [app]() { run_attached(app, pxrapi_init_controller); });
+    initGraph.Add("perf", {"pxr"}, Affinity::Worker, [app]() { run_attached(app, pxrapi_init_perf); });
+    initGraph.Add("eyetracking", {"pxr", "scene"}, Affinity::Worker, [app]() { run_attached(app, pxrapi_init_eyetracking); });
+
+    // Eye tracking is not needed to draw, so the first frame does not wait for it.
+    if (!initGraph.Run({"scene", "events", "layers", "controller", "perf"})) {
+        return false;
+    }
+    // The governor's state is only safe to read once "perf" is done, which "layers" does
+    // not wait for.
+    apply_perf_state(app);
+    return true;
+}
+
+// Nobody is looking: slow the frame rate, drop to power savings clocks and stop
+// streaming gaze. Everything comes back as soon as the eyes do.
+static void apply_presence(struct android_app* app)
+{
+    const bool idle = presenceMonitor.GetState() == PresenceMonitor::State::Idle;
+    frameScheduler.SetFrameInterval(idle ? IDLE_FRAME_INTERVAL : 1);
+    perfGovernor.SetIdle(idle);
+    apply_perf_state(app);
+    gazePublisher.SetPaused(idle);
+    gazeSampler.SetRate(idle ? IDLE_GAZE_SAMPLE_RATE_HZ : GAZE_SAMPLE_RATE_HZ);
 }
 
 static void render_frame(struct android_app* app)
@@ -249,16 +610,44 @@ static void render_frame(struct android_app* app)
     if(!Pxr_IsRunning()) return;
 
     auto* s = (AndroidAppState*)app->userData;
+    const uint64_t heapAllocationsBefore = ThreadHeapAllocationCount();
+    FrameArena& arena = frameArenas.BeginFrame(s->frameIndex++);
     int sensorFrameIndex;
     int eyeCount = 2;
-    PxrPosef pose[eyeCount];
+    PxrPosef* pose = arena.AllocateArray<PxrPosef>(eyeCount);
     PxrSensorState  sensorState = {};
     double predictedDisplayTimeMs = 0.0f;
 
     Pxr_BeginFrame();
+    FrameTiming timing;
+    const uint64_t frameStartNs = MonotonicNs();
+    timing.intervalNs = s->frameStartNs != 0 ? frameStartNs - s->frameStartNs : 0;
+    s->frameStartNs = frameStartNs;
 
     Pxr_GetPredictedDisplayTime(&predictedDisplayTimeMs);
+    frameScheduler.OnFrameStarted(frameStartNs, predictedDisplayTimeMs, perfGovernor.TargetFrameNs());
     Pxr_GetPredictedMainSensorStateWithEyePose(predictedDisplayTimeMs, &sensorState, &sensorFrameIndex, eyeCount, pose);
+    // The pose is predicted for display, so that is its time in the history. poseTimeStampNs
+    // is when the tracking sample it was predicted from was taken, not when the pose holds.
+    // Gaze sampled between two frames lands between their display-time poses. The SDK does
+    // not document the display time's clock and gaze samples carry MonotonicNs(), so the
+    // first display time is checked against it; on another clock every lookup would miss, and
+    // the history stays empty instead.
+    const uint64_t predictedDisplayTimeNs = (uint64_t)(predictedDisplayTimeMs * 1e6);
+    if (predictedDisplayTimeMs > 0.0 && !s->displayTimeChecked) {
+        const uint64_t offsetNs = predictedDisplayTimeNs > frameStartNs ? predictedDisplayTimeNs - frameStartNs
+                                                                        : frameStartNs - predictedDisplayTimeNs;
+        s->displayTimeChecked = true;
+        s->displayTimeMonotonic = offsetNs < MAX_DISPLAY_TIME_OFFSET_NS;
+        if (!s->displayTimeMonotonic) {
+            Log::Write(Log::Level::Error,
+                       Fmt("Predicted display time %.3f ms is %.1f s off CLOCK_MONOTONIC; gaze is not mapped to "
+                           "world space at sample time", predictedDisplayTimeMs, offsetNs / 1e9));
+        }
+    }
+    if (predictedDisplayTimeMs > 0.0 && s->displayTimeMonotonic) {
+        headPoses.Push(sensorState, predictedDisplayTimeNs);
+    }
 
     // Render two 10cm cube scaled by grabAction for each hand.
     for(int i = 0; i<PXR_CONTROLLER_COUNT; i++){
@@ -280,7 +669,31 @@ static void render_frame(struct android_app* app)
         }
     }
 
-    PxrProjectionView layerView[eyeCount];
+    // The current calibration target, fixed in head space.
+    s->calibrationCube = s->calibrationTarget >= 0;
+    if (s->calibrationCube) {
+        float direction[3];
+        calibration_target_direction(s->calibrationTarget, direction);
+        const glm::quat orientation(sensorState.pose.orientation.w, sensorState.pose.orientation.x,
+                                    sensorState.pose.orientation.y, sensorState.pose.orientation.z);
+        const glm::vec3 position = glm::vec3(sensorState.pose.position.x, sensorState.pose.position.y,
+                                             sensorState.pose.position.z) +
+                                   orientation * glm::vec3(direction[0], direction[1], direction[2]);
+        cubes.push_back(Cube{{sensorState.pose.orientation, {position.x, position.y, position.z}},
+                             {CALIBRATION_TARGET_SCALE, CALIBRATION_TARGET_SCALE, CALIBRATION_TARGET_SCALE}});
+    }
+
+    PxrVector3f gazeOrigin, gazeDirection;
+    predicted_gaze_ray(sensorState.pose, &gazeOrigin, &gazeDirection);
+    lodSelector.Select(cubes, gazeOrigin, gazeDirection);
+
+    // Viewport size for this frame, in multiples of 8 pixels.
+    const uint64_t gpuNs = graphicsPlugin->GpuFrameTimeNs();
+    const float scale = dynamicResolution.Update(gpuNs, graphicsPlugin->GpuUpscaleTimeNs(), perfGovernor.TargetFrameNs());
+    const int viewW = std::min(s->layerW, ((int)(s->recommendW * scale) + 7) & ~7);
+    const int viewH = std::min(s->layerH, ((int)(s->recommendH * scale) + 7) & ~7);
+
+    PxrProjectionView* layerView = arena.AllocateArray<PxrProjectionView>(eyeCount);
     for(int i = 0; i < eyeCount; i++) {
         float fovL,fovR,fovU,fovD;
 
@@ -299,14 +712,16 @@ static void render_frame(struct android_app* app)
         layerView[i].fov.angleUp        = fovU;
         layerView[i].imageRect.x        = 0;
         layerView[i].imageRect.y        = 0;
-        layerView[i].imageRect.width    = s->recommendW;
-        layerView[i].imageRect.height   = s->recommendH;
+        layerView[i].imageRect.width    = viewW;
+        layerView[i].imageRect.height   = viewH;
     }
 
     int imageIndex = 0;
     Pxr_GetLayerNextImageIndex(0, &imageIndex);
-    graphicsPlugin->RenderView_N(PXR_EYE_LEFT,  layerView, s->layerImages[PXR_EYE_LEFT][imageIndex],  cubes, SAMPLE_COUNT);
-    graphicsPlugin->RenderView_N(PXR_EYE_RIGHT, layerView, s->layerImages[PXR_EYE_RIGHT][imageIndex], cubes, SAMPLE_COUNT);
+    graphicsPlugin->BeginFrame();
+    graphicsPlugin->RenderView_N(PXR_EYE_LEFT,  layerView, imageIndex, cubes, s->samples);
+    graphicsPlugin->RenderView_N(PXR_EYE_RIGHT, layerView, imageIndex, cubes, s->samples);
+    graphicsPlugin->EndFrame();
 
     PxrLayerProjection layerProjection = {};
     layerProjection.header.layerId          = s->eyeLayerId;
@@ -317,13 +732,51 @@ static void render_frame(struct android_app* app)
     layerProjection.header.colorScale[3]    = 1.0f;
     layerProjection.header.sensorFrameIndex = sensorFrameIndex;
     Pxr_SubmitLayer((PxrLayerHeader*)&layerProjection);
+    timing.cpuNs = MonotonicNs() - frameStartNs;
     Pxr_EndFrame();
+    if (renderedFrames == 0) {
+        Log::Write(Log::Level::Info, Fmt("Startup: first frame submitted %.1f ms after launch",
+                                         (MonotonicNs() - launchTimeNs) / 1e6));
+    }
 
     while(s->handCount)
     {
         cubes.pop_back();
         s->handCount--;
     }
+    if (s->calibrationCube) {
+        cubes.pop_back();
+    }
+
+    timing.gpuNs = gpuNs;
+    if (perfGovernor.AddFrame(timing)) {
+        apply_perf_state(app);
+    }
+
+    frameHeapAllocations += ThreadHeapAllocationCount() - heapAllocationsBefore;
+    renderedFrames++;
+}
+
+static void report_frames(std::ostringstream& out, double seconds)
+{
+    static uint64_t reportedFrames = 0;
+    static uint64_t reportedAllocations = 0;
+    const uint64_t frames = renderedFrames.load();
+    const uint64_t allocations = frameHeapAllocations.load();
+    const uint64_t newFrames = frames - reportedFrames;
+
+    size_t arenaHighWater = 0;
+    uint64_t arenaOverflows = 0;
+    for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
+        arenaHighWater = std::max(arenaHighWater, frameArenas.At(i).HighWater());
+        arenaOverflows += frameArenas.At(i).Overflows();
+    }
+
+    out << "fps=" << newFrames / seconds
+        << " heapAllocs/frame=" << (newFrames ? (double)(allocations - reportedAllocations) / newFrames : 0.0)
+        << " arenaHighWater=" << arenaHighWater << "B arenaOverflows=" << arenaOverflows;
+    reportedFrames = frames;
+    reportedAllocations = allocations;
 }
 
 
@@ -336,34 +789,107 @@ void android_main(struct android_app* app) {
     try {
         JNIEnv* Env;
         AndroidAppState appState = {};
+        launchTimeNs = MonotonicNs();
 
         app->activity->vm->AttachCurrentThread(&Env, nullptr);
         app->userData = &appState;
         app->onAppCmd = app_handle_cmd;
 
-        init_scene(app);
-        pxrapi_init(app);
+        if (frameScheduler.Initialize()) {
+            ALooper_addFd(app->looper, frameScheduler.TimerFd(), LOOPER_ID_FRAME_TIMER, ALOOPER_EVENT_INPUT, nullptr, nullptr);
+            ALooper_addFd(app->looper, frameScheduler.SignalFd(), LOOPER_ID_FRAME_SIGNAL, ALOOPER_EVENT_INPUT, nullptr,
+                          nullptr);
+        }
+        if (!init_app(app)) {
+            // Let whatever is still running finish before the process goes away.
+            initGraph.Wait();
+            throw std::runtime_error("Initialization failed");
+        }
+
+        Instrumentation::AddReporter("frame", report_frames);
+        Instrumentation::AddReporter("perf", [](std::ostringstream& out, double seconds) {
+            perfGovernor.Report(out, seconds);
+        });
+        Instrumentation::AddReporter("dynres", [](std::ostringstream& out, double seconds) {
+            dynamicResolution.Report(out, seconds);
+        });
+        Instrumentation::AddReporter("lod", [](std::ostringstream& out, double seconds) {
+            lodSelector.Report(out, seconds);
+        });
+        Instrumentation::AddReporter("sched", [](std::ostringstream& out, double seconds) {
+            frameScheduler.Report(out, seconds);
+        });
+        Instrumentation::AddReporter("events", [](std::ostringstream& out, double seconds) {
+            eventQueue.Report(out, seconds);
+        });
+        Instrumentation::AddReporter("headposes", [](std::ostringstream& out, double seconds) {
+            headPoses.Report(out, seconds);
+        });
+        Instrumentation::AddReporter("pick", [](std::ostringstream& out, double seconds) {
+            gazePicker.Report(out, seconds);
+        });
+        Instrumentation::AddReporter("gaze", [](std::ostringstream& out, double seconds) {
+            gazeMetrics.Report(out, seconds);
+        });
+        Instrumentation::AddReporter("vergence", [](std::ostringstream& out, double seconds) {
+            vergence.Report(out, seconds);
+        });
+        Instrumentation::AddReporter("heatmap", [](std::ostringstream& out, double seconds) {
+            gazeHeatmap.Report(out, seconds);
+        });
+        Instrumentation::AddReporter("presence", [](std::ostringstream& out, double seconds) {
+            presenceMonitor.Report(out, seconds);
+        });
+        Instrumentation::AddReporter("haptics", [](std::ostringstream& out, double seconds) {
+            haptics.Report(out, seconds);
+        });
+        Instrumentation::Start();
 
         while (app->destroyRequested == 0) {
-            // Read all pending events.
+            const FrameScheduler::Mode mode = Pxr_IsRunning() ? FrameScheduler::Mode::Running
+                                              : appState.resumed ? FrameScheduler::Mode::Idle
+                                                                 : FrameScheduler::Mode::Stopped;
+            frameScheduler.Arm(mode);
+
+            // Sleep until the next frame (or idle tick) is due, or a looper source or the
+            // scheduler's signal wakes us; then handle everything else pending without blocking.
+            int timeoutMilliseconds = frameScheduler.Due(MonotonicNs()) ? 0 : -1;
             for (;;) {
                 int events;
                 struct android_poll_source* source;
-                // If the timeout is zero, returns immediately without blocking.
-                // If the timeout is negative, waits indefinitely until an event appears.
-                const int timeoutMilliseconds =
-                    (!appState.resumed  && !Pxr_IsRunning() && app->destroyRequested == 0) ? -1 : 0;
-                if (ALooper_pollAll(timeoutMilliseconds, nullptr, &events, (void**)&source) < 0) {
+                const uint64_t waitStartNs = MonotonicNs();
+                const int ident = ALooper_pollAll(timeoutMilliseconds, nullptr, &events, (void**)&source);
+                if (timeoutMilliseconds != 0) {
+                    frameScheduler.Waited(MonotonicNs() - waitStartNs);
+                }
+                if (ident < 0) {
                     break;
                 }
-                // Process this event.
-                if (source != nullptr) {
-                    source->process(app, source);
+                if (ident == LOOPER_ID_FRAME_TIMER) {
+                    frameScheduler.OnTimer();
+                } else if (ident == LOOPER_ID_FRAME_SIGNAL) {
+                    frameScheduler.OnSignal();
+                } else {
+                    frameScheduler.OnLooperEvent();
+                    if (source != nullptr) {
+                        source->process(app, source);
+                    }
                 }
+                timeoutMilliseconds = 0;
+            }
+            if (presenceMonitor.Update(MonotonicNs())) {
+                apply_presence(app);
+            }
+            if (app->destroyRequested != 0 || !frameScheduler.Due(MonotonicNs())) {
+                frameScheduler.AccountCpu();
+                continue;
             }
             dispatch_events(app);
             render_frame(app);
+            frameScheduler.WorkDone(MonotonicNs());
+            frameScheduler.AccountCpu();
         }
+        Instrumentation::Stop();
         pxrapi_deinit(app);
     } catch (const std::exception& ex) {
         Log::Write(Log::Level::Error, ex.what());
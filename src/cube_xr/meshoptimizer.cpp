@@ -0,0 +1,258 @@
+#include "meshoptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+const float CacheDecayPower = 1.5f;
+const float LastTriangleScore = 0.75f;
+const float ValenceBoostScale = 2.0f;
+const float ValenceBoostPower = 0.5f;
+
+// Forsyth's vertex score: favours vertices recently used (but not the ones of the last
+// triangle as much) and vertices with few remaining triangles, so islands get finished.
+float VertexScore(int cachePosition, uint32_t remainingTriangles) {
+    if (remainingTriangles == 0) {
+        return -1.0f;
+    }
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            score = LastTriangleScore;
+        } else {
+            const float scaler = 1.0f / (MeshOptimizer::CacheSize - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, CacheDecayPower);
+        }
+    }
+    return score + ValenceBoostScale * std::pow((float)remainingTriangles, -ValenceBoostPower);
+}
+
+struct Float3 {
+    float x, y, z;
+};
+
+Float3 Position(const Geometry::Vertex& vertex) {
+    return {Geometry::UnpackSnorm16(vertex.Position[0]), Geometry::UnpackSnorm16(vertex.Position[1]),
+            Geometry::UnpackSnorm16(vertex.Position[2])};
+}
+}  // namespace
+
+namespace MeshOptimizer {
+
+void OptimizeVertexCache(uint16_t* indices, size_t indexCount, size_t vertexCount) {
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Vertex -> triangle adjacency.
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        remaining[indices[i]]++;
+    }
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) {
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) {
+            adjacency[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        vertexScore[v] = VertexScore(-1, remaining[v]);
+    }
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint16_t> output;
+    output.reserve(triangleCount * 3);
+    uint32_t cache[CacheSize + 3];
+    size_t cacheCount = 0;
+    size_t scanStart = 0;
+
+    int best = -1;
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        if (best < 0) {
+            // No candidate from the cache: take the best-scoring triangle left anywhere.
+            float bestScore = -1.0f;
+            for (size_t t = scanStart; t < triangleCount; t++) {
+                if (!emitted[t] && triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = (int)t;
+                }
+            }
+            while (scanStart < triangleCount && emitted[scanStart]) {
+                scanStart++;
+            }
+        }
+
+        const uint16_t* triangle = &indices[best * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[best] = true;
+
+        // Move the triangle's vertices to the front of the cache and drop it from adjacency.
+        uint32_t newCache[CacheSize + 3];
+        size_t newCount = 0;
+        for (int k = 0; k < 3; k++) {
+            const uint16_t v = triangle[k];
+            newCache[newCount++] = v;
+            uint32_t* begin = &adjacency[adjacencyOffset[v]];
+            uint32_t* end = begin + remaining[v];
+            std::remove(begin, end, (uint32_t)best);
+            remaining[v]--;
+        }
+        for (size_t i = 0; i < cacheCount; i++) {
+            const uint32_t v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                newCache[newCount++] = v;
+            }
+        }
+
+        // Rescore everything that was or is in the cache, then pick the best neighbour.
+        for (size_t i = 0; i < newCount; i++) {
+            cachePosition[newCache[i]] = i < CacheSize ? (int)i : -1;
+        }
+        best = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < newCount; i++) {
+            const uint32_t v = newCache[i];
+            const float score = VertexScore(cachePosition[v], remaining[v]);
+            const float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            for (uint32_t a = 0; a < remaining[v]; a++) {
+                const uint32_t t = adjacency[adjacencyOffset[v] + a];
+                triangleScore[t] += delta;
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = (int)t;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCount, (size_t)CacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeOverdraw(uint16_t* indices, size_t indexCount, const Geometry::Vertex* vertices, size_t vertexCount,
+                      float threshold) {
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // Split into clusters where the cache naturally restarts (a triangle with three misses),
+    // so reordering clusters costs little cache efficiency.
+    std::vector<size_t> clusterStart;
+    std::vector<uint32_t> fifo(vertexCount, 0);
+    uint32_t timestamp = CacheSize + 1;
+    for (size_t t = 0; t < triangleCount; t++) {
+        int misses = 0;
+        for (int k = 0; k < 3; k++) {
+            const uint16_t v = indices[t * 3 + k];
+            if (timestamp - fifo[v] > CacheSize) {
+                fifo[v] = timestamp++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) {
+            clusterStart.push_back(t);
+        }
+    }
+    const size_t clusterCount = clusterStart.size();
+    if (clusterCount < 2) {
+        return;
+    }
+    clusterStart.push_back(triangleCount);
+
+    Float3 meshCentroid{0, 0, 0};
+    for (size_t v = 0; v < vertexCount; v++) {
+        const Float3 p = Position(vertices[v]);
+        meshCentroid.x += p.x;
+        meshCentroid.y += p.y;
+        meshCentroid.z += p.z;
+    }
+    meshCentroid.x /= vertexCount;
+    meshCentroid.y /= vertexCount;
+    meshCentroid.z /= vertexCount;
+
+    // Sort key: how far the cluster's area-weighted normal points away from the mesh centre.
+    std::vector<float> sortKey(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        Float3 centroid{0, 0, 0};
+        Float3 normal{0, 0, 0};
+        float area = 0.0f;
+        for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++) {
+            const Float3 a = Position(vertices[indices[t * 3]]);
+            const Float3 b = Position(vertices[indices[t * 3 + 1]]);
+            const Float3 d = Position(vertices[indices[t * 3 + 2]]);
+            const Float3 e1{b.x - a.x, b.y - a.y, b.z - a.z};
+            const Float3 e2{d.x - a.x, d.y - a.y, d.z - a.z};
+            const Float3 n{e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x};
+            const float triangleArea = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+            centroid.x += (a.x + b.x + d.x) * triangleArea;
+            centroid.y += (a.y + b.y + d.y) * triangleArea;
+            centroid.z += (a.z + b.z + d.z) * triangleArea;
+            normal.x += n.x;
+            normal.y += n.y;
+            normal.z += n.z;
+            area += triangleArea;
+        }
+        const float inverse = area > 0.0f ? 1.0f / (3.0f * area) : 0.0f;
+        centroid = {centroid.x * inverse - meshCentroid.x, centroid.y * inverse - meshCentroid.y,
+                    centroid.z * inverse - meshCentroid.z};
+        const float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        // The winding is clockwise, so the geometric normal points inward: negate.
+        sortKey[c] = length > 0.0f ? -(centroid.x * normal.x + centroid.y * normal.y + centroid.z * normal.z) / length : 0.0f;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<uint16_t> output;
+    output.reserve(triangleCount * 3);
+    for (size_t c : order) {
+        output.insert(output.end(), indices + clusterStart[c] * 3, indices + clusterStart[c + 1] * 3);
+    }
+
+    const float before = AverageCacheMissRatio(indices, triangleCount * 3, vertexCount);
+    const float after = AverageCacheMissRatio(output.data(), output.size(), vertexCount);
+    if (after <= before * threshold) {
+        std::copy(output.begin(), output.end(), indices);
+    }
+}
+
+float AverageCacheMissRatio(const uint16_t* indices, size_t indexCount, size_t vertexCount) {
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+    std::vector<uint32_t> fifo(vertexCount, 0);
+    uint32_t timestamp = CacheSize + 1;
+    size_t misses = 0;
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        const uint16_t v = indices[i];
+        if (timestamp - fifo[v] > CacheSize) {
+            fifo[v] = timestamp++;
+            misses++;
+        }
+    }
+    return (float)misses / triangleCount;
+}
+
+}  // namespace MeshOptimizer
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "geometry.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Index reordering for meshes loaded into the renderer. Both passes only permute
+// triangles (vertex order and winding are untouched), so they can run on any indexed
+// triangle list at load time.
+namespace MeshOptimizer {
+
+// Post-transform vertex cache size assumed by the optimizer and the statistics below.
+constexpr uint32_t CacheSize = 16;
+
+// Reorders triangles so consecutive ones reuse recently transformed vertices
+// (Forsyth's linear-speed vertex cache optimization).
+void OptimizeVertexCache(uint16_t* indices, size_t indexCount, size_t vertexCount);
+
+// Reorders clusters of the cache-optimized list so outward-facing clusters come first,
+// which lets early depth reject more of what is behind them. The result is kept only if
+// its cache miss ratio stays within threshold times the input's.
+void OptimizeOverdraw(uint16_t* indices, size_t indexCount, const Geometry::Vertex* vertices, size_t vertexCount,
+                      float threshold = 1.05f);
+
+// Average cache misses per triangle (ACMR) of a FIFO cache of CacheSize entries:
+// 3.0 means no reuse, 0.5 is the ideal for a large regular grid.
+float AverageCacheMissRatio(const uint16_t* indices, size_t indexCount, size_t vertexCount);
+
+}  // namespace MeshOptimizer
@@ -0,0 +1,17 @@
+#pragma once
+#include "pxr/PxrApi.h"
+
+#include <memory>
+
+// The slice of the PXR performance API used by the governor, behind an interface so the
+// governor can be driven by a simulated device and timing source off-device.
+struct IPerfDevice {
+    virtual ~IPerfDevice() = default;
+
+    virtual int SetPerformanceLevel(PxrPerfSettings which, int level) = 0;
+    virtual int GetPerformanceLevel(PxrPerfSettings which, int* level) = 0;
+    virtual int GetDisplayRefreshRate(float* refreshRate) = 0;
+};
+
+// Create a performance device backed by the PXR runtime.
+std::shared_ptr<IPerfDevice> CreatePerfDevice_Pxr();
@@ -0,0 +1,16 @@
+#include "common.h"
+#include "perfdevice.h"
+
+namespace {
+struct PxrPerfDevice : public IPerfDevice {
+    int SetPerformanceLevel(PxrPerfSettings which, int level) override { return Pxr_SetPerformanceLevels(which, level); }
+
+    int GetPerformanceLevel(PxrPerfSettings which, int* level) override { return Pxr_GetPerformanceLevels(which, level); }
+
+    int GetDisplayRefreshRate(float* refreshRate) override { return Pxr_GetDisplayRefreshRate(refreshRate); }
+};
+}  // namespace
+
+std::shared_ptr<IPerfDevice> CreatePerfDevice_Pxr() {
+    return std::make_shared<PxrPerfDevice>();
+}
@@ -0,0 +1,258 @@
+#include "common.h"
+#include "perfgovernor.h"
+
+namespace {
+const int Levels[] = {PXR_PERF_SETTINGS_LEVEL_POWER_SAVINGS, PXR_PERF_SETTINGS_LEVEL_SUSTAINED_LOW,
+                      PXR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH, PXR_PERF_SETTINGS_LEVEL_BOOST};
+const double BinMs = 0.5;
+const double MissFactor = 1.5;        // an interval this far over target skipped a vsync
+const double MissRateLimit = 0.02;    // more misses than this per window means over budget
+const double OverPercentile = 0.9;
+const double HeadroomFactor = 0.7;    // p90 work under this fraction of the budget is headroom
+const float DefaultRefreshRate = 72.0f;
+
+// Keeps repeated scale steps from drifting off the grid (0.7 + 3 * 0.1 != 1.0 in floats).
+float RoundScale(float scale) { return std::round(scale * 100.0f) / 100.0f; }
+}  // namespace
+
+void PerfGovernor::Histogram::Clear() {
+    memset(bins, 0, sizeof(bins));
+    count = 0;
+}
+
+void PerfGovernor::Histogram::Add(uint64_t ns) {
+    const int bin = (int)(ns / 1e6 / BinMs);
+    bins[std::min(bin, HistogramBins - 1)]++;
+    count++;
+}
+
+double PerfGovernor::Histogram::PercentileMs(double fraction) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    const uint32_t rank = (uint32_t)std::ceil(fraction * count);
+    uint32_t seen = 0;
+    for (int bin = 0; bin < HistogramBins; bin++) {
+        seen += bins[bin];
+        if (seen >= rank) {
+            return (bin + 1) * BinMs;
+        }
+    }
+    return HistogramBins * BinMs;
+}
+
+PerfGovernor::PerfGovernor(std::shared_ptr<IPerfDevice> device, const PerfLimits& limits)
+    : m_device(std::move(device)), m_limits(limits) {
+    m_state.samples = m_limits.maxSamples;
+    m_interval.Clear();
+    m_cpu.Clear();
+    m_gpu.Clear();
+    for (auto& value : m_reportedState) {
+        value = 0;
+    }
+}
+
+void PerfGovernor::Start() {
+    float refreshRate = 0.0f;
+    if (m_device->GetDisplayRefreshRate(&refreshRate) != PXR_RET_SUCCESS || refreshRate <= 0.0f) {
+        refreshRate = DefaultRefreshRate;
+    }
+    m_targetNs = (uint64_t)(1e9 / refreshRate);
+    Log::Write(Log::Level::Info, Fmt("PerfGovernor: target %.1f Hz", refreshRate));
+    Apply(m_state);
+}
+
+int PerfGovernor::LevelIndex(int level) {
+    int index = 0;
+    while (index + 1 < (int)ArraySize(Levels) && Levels[index + 1] <= level) {
+        index++;
+    }
+    return index;
+}
+
+// Highest clock level allowed by the latest thermal notification of the domain.
+int PerfGovernor::Cap(PxrPerfSettingsDomain domain) const {
+    switch (m_thermalLevel[domain]) {
+        case PXR_PERF_SETTINGS_NOTIF_LEVEL_HIGH: return PXR_PERF_SETTINGS_LEVEL_SUSTAINED_LOW;
+        case PXR_PERF_SETTINGS_NOTIF_LEVEL_MID: return PXR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH;
+        default: return PXR_PERF_SETTINGS_LEVEL_BOOST;
+    }
+}
+
+void PerfGovernor::OnPerfSettings(const PxrEventDataPerfSettings& event) {
+    if (event.domain != PXR_PERF_SETTINGS_DOMAIN_CPU && event.domain != PXR_PERF_SETTINGS_DOMAIN_GPU) {
+        return;
+    }
+    Log::Write(Log::Level::Info, Fmt("PerfGovernor: %s %s level %d -> %d",
+                                     event.domain == PXR_PERF_SETTINGS_DOMAIN_CPU ? "cpu" : "gpu",
+                                     event.subDomain == PXR_PERF_SETTINGS_SUB_DOMAIN_THERMAL ? "thermal" : "load",
+                                     event.fromLevel, event.toLevel));
+    if (event.subDomain == PXR_PERF_SETTINGS_SUB_DOMAIN_THERMAL) {
+        m_thermalLevel[event.domain] = event.toLevel;
+        // Respect a lower cap right away rather than at the end of the window.
+        PerfState state = m_state;
+        state.cpuLevel = std::min(state.cpuLevel, Cap(PXR_PERF_SETTINGS_DOMAIN_CPU));
+        state.gpuLevel = std::min(state.gpuLevel, Cap(PXR_PERF_SETTINGS_DOMAIN_GPU));
+        Apply(state);
+    } else {
+        // The runtime itself reports it is struggling to composite or render in time.
+        m_compositorPressure = event.toLevel >= PXR_PERF_SETTINGS_NOTIF_LEVEL_HIGH;
+    }
+}
+
+void PerfGovernor::OnRefreshRateChanged(float refreshRate) {
+    if (refreshRate <= 0.0f) {
+        return;
+    }
+    m_targetNs = (uint64_t)(1e9 / refreshRate);
+    Log::Write(Log::Level::Info, Fmt("PerfGovernor: target %.1f Hz", refreshRate));
+    // The current window mixes both rates; judge the next full one instead.
+    ResetWindow();
+}
+
+void PerfGovernor::ResetWindow() {
+    m_interval.Clear();
+    m_cpu.Clear();
+    m_gpu.Clear();
+    m_windowFrames = 0;
+    m_windowMisses = 0;
+    m_relaxedWindows = 0;
+}
+
+bool PerfGovernor::AddFrame(const FrameTiming& timing) {
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    if (m_idle) {
+        // Idle frames are paced down on purpose; they say nothing about the budget.
+        const bool changed = m_changed;
+        m_changed = false;
+        return changed;
+    }
+    if (timing.intervalNs > m_targetNs * MissFactor) {
+        m_windowMisses++;
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_interval.Add(timing.intervalNs);
+    m_cpu.Add(timing.cpuNs);
+    if (timing.gpuNs != 0) {
+        m_gpu.Add(timing.gpuNs);
+    }
+    if (++m_windowFrames >= WindowFrames) {
+        Decide();
+        m_interval.Clear();
+        m_cpu.Clear();
+        m_gpu.Clear();
+        m_windowFrames = 0;
+        m_windowMisses = 0;
+    }
+    const bool changed = m_changed;
+    m_changed = false;
+    return changed;
+}
+
+void PerfGovernor::SetIdle(bool idle) {
+    if (idle == m_idle) {
+        return;
+    }
+    m_idle = idle;
+    PerfState state;
+    if (idle) {
+        m_activeState = m_state;
+        state = m_state;
+        state.cpuLevel = PXR_PERF_SETTINGS_LEVEL_POWER_SAVINGS;
+        state.gpuLevel = PXR_PERF_SETTINGS_LEVEL_POWER_SAVINGS;
+    } else {
+        state = m_activeState;
+        state.cpuLevel = std::min(state.cpuLevel, Cap(PXR_PERF_SETTINGS_DOMAIN_CPU));
+        state.gpuLevel = std::min(state.gpuLevel, Cap(PXR_PERF_SETTINGS_DOMAIN_GPU));
+    }
+    Apply(state);
+    ResetWindow();
+}
+
+void PerfGovernor::Decide() {
+    if (m_settling) {
+        m_settling = false;
+        return;
+    }
+
+    const double budgetMs = m_targetNs / 1e6;
+    const double cpuMs = m_cpu.PercentileMs(OverPercentile);
+    const double gpuMs = m_gpu.PercentileMs(OverPercentile);
+    const bool gpuKnown = m_gpu.count > 0;
+    const bool over = m_windowMisses > MissRateLimit * m_windowFrames || m_compositorPressure;
+    const bool cpuHeadroom = cpuMs < budgetMs * HeadroomFactor;
+    // Without GPU timings the GPU is never clocked down blindly, but quality may come back.
+    const bool gpuHeadroom = gpuKnown && gpuMs < budgetMs * HeadroomFactor;
+    const bool qualityHeadroom = cpuHeadroom && (gpuHeadroom || !gpuKnown);
+    const bool relaxed = m_windowMisses == 0 && (cpuHeadroom || gpuHeadroom);
+
+    PerfState state = m_state;
+    if (over) {
+        m_relaxedWindows = 0;
+        // Without GPU timings, a slow frame with a fast CPU is the GPU's.
+        const bool gpuBound = gpuKnown ? gpuMs >= cpuMs : cpuHeadroom;
+        int& level = gpuBound ? state.gpuLevel : state.cpuLevel;
+        const int cap = Cap(gpuBound ? PXR_PERF_SETTINGS_DOMAIN_GPU : PXR_PERF_SETTINGS_DOMAIN_CPU);
+        const int next = Levels[std::min(LevelIndex(level) + 1, (int)ArraySize(Levels) - 1)];
+        if (next > level && next <= cap) {
+            level = next;
+        } else if (state.renderScale > m_limits.minRenderScale) {
+            state.renderScale = std::max(m_limits.minRenderScale, RoundScale(state.renderScale - m_limits.renderScaleStep));
+        } else if (state.samples > m_limits.minSamples) {
+            state.samples = std::max(m_limits.minSamples, state.samples / 2);
+        }
+    } else if (relaxed && ++m_relaxedWindows >= RelaxWindows) {
+        m_relaxedWindows = 0;
+        if (qualityHeadroom && state.samples < m_limits.maxSamples) {
+            state.samples = std::min(m_limits.maxSamples, state.samples * 2);
+        } else if (qualityHeadroom && state.renderScale < 1.0f) {
+            state.renderScale = std::min(1.0f, RoundScale(state.renderScale + m_limits.renderScaleStep));
+        } else {
+            // One domain per decision, GPU first as it draws more power.
+            const int gpuLower = Levels[std::max(LevelIndex(state.gpuLevel) - 1, 0)];
+            const int cpuLower = Levels[std::max(LevelIndex(state.cpuLevel) - 1, 0)];
+            if (gpuHeadroom && gpuLower < state.gpuLevel) {
+                state.gpuLevel = gpuLower;
+            } else if (cpuHeadroom) {
+                state.cpuLevel = cpuLower;
+            }
+        }
+    } else if (!relaxed) {
+        m_relaxedWindows = 0;
+    }
+    Apply(state);
+}
+
+void PerfGovernor::Apply(const PerfState& state) {
+    const bool first = m_changes.load(std::memory_order_relaxed) == 0;
+    if (state == m_state && !first) {
+        return;
+    }
+    if (state.cpuLevel != m_state.cpuLevel || first) {
+        m_device->SetPerformanceLevel(PXR_PERF_SETTINGS_CPU, state.cpuLevel);
+    }
+    if (state.gpuLevel != m_state.gpuLevel || first) {
+        m_device->SetPerformanceLevel(PXR_PERF_SETTINGS_GPU, state.gpuLevel);
+    }
+    Log::Write(Log::Level::Info, Fmt("PerfGovernor: cpu %d gpu %d samples %d scale %.2f", state.cpuLevel,
+                                     state.gpuLevel, state.samples, state.renderScale));
+    m_changed = m_changed || state != m_state;
+    m_state = state;
+    m_settling = true;
+    m_changes.fetch_add(1, std::memory_order_relaxed);
+    m_reportedState[0] = state.cpuLevel;
+    m_reportedState[1] = state.gpuLevel;
+    m_reportedState[2] = state.samples;
+    m_reportedState[3] = (int)std::lround(state.renderScale * 100.0f);
+}
+
+void PerfGovernor::Report(std::ostringstream& out, double /*elapsedSeconds*/) {
+    const uint64_t frames = m_frames.load(std::memory_order_relaxed);
+    const uint64_t misses = m_misses.load(std::memory_order_relaxed);
+    out << "cpu=" << m_reportedState[0].load() << " gpu=" << m_reportedState[1].load()
+        << " msaa=" << m_reportedState[2].load() << " scale=" << m_reportedState[3].load() / 100.0
+        << " missed=" << (misses - m_reportedMisses) << "/" << (frames - m_reportedFrames)
+        << " changes=" << m_changes.load(std::memory_order_relaxed);
+    m_reportedFrames = frames;
+    m_reportedMisses = misses;
+}
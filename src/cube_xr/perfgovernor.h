@@ -0,0 +1,115 @@
+#pragma once
+#include "perfdevice.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+
+// Everything the governor trades against frame time. Levels are PxrPerfSettingsLevel values.
+struct PerfState {
+    int   cpuLevel = PXR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH;
+    int   gpuLevel = PXR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH;
+    int   samples = 4;
+    float renderScale = 1.0f;
+
+    bool operator==(const PerfState& other) const {
+        return cpuLevel == other.cpuLevel && gpuLevel == other.gpuLevel && samples == other.samples &&
+               renderScale == other.renderScale;
+    }
+    bool operator!=(const PerfState& other) const { return !(*this == other); }
+};
+
+// Per-frame measurements. gpuNs is 0 when the GPU time is not known (yet).
+struct FrameTiming {
+    uint64_t intervalNs = 0;  // start of the previous frame to start of this one
+    uint64_t cpuNs = 0;       // app thread work, excluding waits on the runtime
+    uint64_t gpuNs = 0;
+};
+
+// Range the quality knobs may be moved in.
+struct PerfLimits {
+    int   minSamples = 1;
+    int   maxSamples = 4;
+    float minRenderScale = 0.7f;
+    float renderScaleStep = 0.1f;
+};
+
+// Holds the display's frame rate at the lowest power cost. Frame times are collected into
+// histograms over windows of WindowFrames; at the end of each window:
+//  - if frames were missed, clock up whichever of CPU and GPU is the bottleneck, and once
+//    that one is at its (thermal) cap, lower render scale, then MSAA;
+//  - if both CPU and GPU had headroom for RelaxWindows windows in a row, first restore
+//    render scale and MSAA, then clock down.
+// The window after any change is skipped so it is judged on settled numbers.
+class PerfGovernor {
+public:
+    static const int WindowFrames = 90;
+    static const int RelaxWindows = 3;
+    static const int HistogramBins = 64;  // 0.5 ms each, the last one is open-ended
+
+    explicit PerfGovernor(std::shared_ptr<IPerfDevice> device, const PerfLimits& limits = PerfLimits());
+
+    // Reads the refresh rate and applies the initial state.
+    void Start();
+
+    // Thermal and compositor notifications (PXR_TYPE_EVENT_DATA_PERF_SETTINGS_EXT).
+    void OnPerfSettings(const PxrEventDataPerfSettings& event);
+    // The display changed its refresh rate (PXR_TYPE_EVENT_DATA_REFRESH_RATE_CHANGED).
+    void OnRefreshRateChanged(float refreshRate);
+
+    // While idle (nobody wearing the headset) both clocks sit at power savings and no
+    // decisions are made; leaving idle restores the state from before, within thermal caps.
+    void SetIdle(bool idle);
+
+    // Returns true when State() changed; samples and render scale are up to the caller.
+    bool AddFrame(const FrameTiming& timing);
+
+    const PerfState& State() const { return m_state; }
+    uint64_t TargetFrameNs() const { return m_targetNs; }
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    struct Histogram {
+        uint32_t bins[HistogramBins];
+        uint32_t count;
+
+        void Clear();
+        void Add(uint64_t ns);
+        double PercentileMs(double fraction) const;
+    };
+
+    static int LevelIndex(int level);
+    void Decide();
+    void ResetWindow();
+    void Apply(const PerfState& state);
+    int Cap(PxrPerfSettingsDomain domain) const;
+
+    std::shared_ptr<IPerfDevice> m_device;
+    PerfLimits m_limits;
+    PerfState m_state;
+    uint64_t m_targetNs{0};
+
+    Histogram m_interval{};
+    Histogram m_cpu{};
+    Histogram m_gpu{};
+    uint32_t m_windowFrames{0};
+    uint32_t m_windowMisses{0};
+    int m_relaxedWindows{0};
+    bool m_settling{false};
+    bool m_idle{false};
+    PerfState m_activeState;
+    bool m_changed{false};
+
+    int m_thermalLevel[3] = {};  // PxrPerfSettingsNotificationLevel, indexed by domain
+    bool m_compositorPressure{false};
+
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_changes{0};
+    std::atomic<int> m_reportedState[4];
+    uint64_t m_reportedFrames{0};
+    uint64_t m_reportedMisses{0};
+};
@@ -0,0 +1,57 @@
+#include "common.h"
+#include "presencemonitor.h"
+
+bool PresenceMonitor::IsPresent(const GazeSample& sample) {
+    const bool tracked = (sample.combinedEyePoseStatus & GAZE_STATUS_GAZE_VECTOR_VALID) != 0 ||
+                         sample.foveatedGazeTrackingState != 0;
+    if (!tracked) {
+        return false;
+    }
+    const bool opennessKnown = (sample.leftEyePoseStatus & GAZE_STATUS_OPENNESS_VALID) != 0 ||
+                               (sample.rightEyePoseStatus & GAZE_STATUS_OPENNESS_VALID) != 0;
+    return !opennessKnown || std::max(sample.leftEyeOpenness, sample.rightEyeOpenness) >= MinOpenness;
+}
+
+bool PresenceMonitor::OnSample(const GazeSample& sample, uint64_t nowNs) {
+    if (!m_sampled.load(std::memory_order_relaxed)) {
+        // The first sample starts the clock, present or not.
+        m_lastPresentNs.store(nowNs, std::memory_order_relaxed);
+        m_sampled.store(true, std::memory_order_release);
+    }
+    if (!IsPresent(sample)) {
+        return false;
+    }
+    m_lastPresentNs.store(nowNs, std::memory_order_release);
+    return m_idle.load(std::memory_order_acquire);
+}
+
+bool PresenceMonitor::Update(uint64_t nowNs) {
+    if (!m_sampled.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const uint64_t lastPresentNs = m_lastPresentNs.load(std::memory_order_acquire);
+    if (m_state == State::Active && nowNs > lastPresentNs && nowNs - lastPresentNs >= EnterIdleNs) {
+        m_state = State::Idle;
+        m_idleSinceNs = nowNs;
+        m_idle.store(true, std::memory_order_release);
+        m_idleEntries.fetch_add(1, std::memory_order_relaxed);
+        Log::Write(Log::Level::Info, "Presence: no eyes for a while, going idle");
+        return true;
+    }
+    if (m_state == State::Idle && lastPresentNs > m_idleSinceNs) {
+        m_state = State::Active;
+        m_idle.store(false, std::memory_order_release);
+        m_idleNs.fetch_add(nowNs - m_idleSinceNs, std::memory_order_relaxed);
+        Log::Write(Log::Level::Info, Fmt("Presence: eyes back after %.1f s idle", (nowNs - m_idleSinceNs) / 1e9));
+        return true;
+    }
+    return false;
+}
+
+void PresenceMonitor::Report(std::ostringstream& out, double /*elapsedSeconds*/) {
+    const uint64_t idleNs = m_idleNs.load(std::memory_order_relaxed);
+    out << "state=" << (m_idle.load(std::memory_order_relaxed) ? "idle" : "active")
+        << " idleEntries=" << m_idleEntries.load(std::memory_order_relaxed)
+        << " completedIdleS=" << (idleNs - m_reportedIdleNs) / 1e9;
+    m_reportedIdleNs = idleNs;
+}
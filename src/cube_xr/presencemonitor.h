@@ -0,0 +1,49 @@
+#pragma once
+#include "gazesample.h"
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+
+// Tells whether someone is wearing the headset, from the eye tracker alone. A sample
+// counts as present when the gaze is tracked (combined gaze vector valid, or the
+// foveated gaze still tracking) and, when openness is reported, at least one eye is open.
+//
+// Going idle needs no present sample for EnterIdleNs, long enough to ride out blinks and
+// brief tracking loss; coming back needs a single present sample, so the app can restore
+// within a frame of the eyes reappearing. Until the first sample arrives nothing is
+// known, so a device without eye tracking never goes idle.
+//
+// OnSample() runs on the sampler thread, Update() on the main thread; the state only
+// changes in Update(). Time is passed in, so the machine can be driven with synthetic data.
+class PresenceMonitor {
+public:
+    enum class State { Active, Idle };
+
+    static constexpr uint64_t EnterIdleNs = 3000000000;
+    static constexpr float MinOpenness = 0.1f;
+
+    static bool IsPresent(const GazeSample& sample);
+
+    // Returns true when the sample ends an idle period, so the caller can wake the main loop.
+    bool OnSample(const GazeSample& sample, uint64_t nowNs);
+
+    // Re-evaluates the state at nowNs. Returns true when it changed.
+    bool Update(uint64_t nowNs);
+
+    State GetState() const { return m_state; }
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    State m_state{State::Active};
+    uint64_t m_idleSinceNs{0};
+
+    std::atomic<bool> m_sampled{false};
+    std::atomic<bool> m_idle{false};
+    std::atomic<uint64_t> m_lastPresentNs{0};
+    std::atomic<uint64_t> m_idleEntries{0};
+    std::atomic<uint64_t> m_idleNs{0};  // completed idle periods
+    uint64_t m_reportedIdleNs{0};
+};
@@ -0,0 +1,165 @@
+#include "common.h"
+#include "glcalls.h"
+#include "programcache.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+const uint32_t ProgramCacheMagic = 0x50475843;  // 'CXGP'
+const uint32_t ProgramCacheVersion = 1;
+
+struct ProgramCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+};
+
+// FNV-1a, chained over several strings.
+uint64_t Hash(uint64_t hash, const char* text) {
+    for (const char* c = text ? text : ""; *c != 0; c++) {
+        hash ^= (uint8_t)*c;
+        hash *= 0x100000001b3ull;
+    }
+    // Separator, so ("ab", "c") and ("a", "bc") differ.
+    hash ^= 0xff;
+    hash *= 0x100000001b3ull;
+    return hash;
+}
+
+const char* GlString(GLenum name) {
+    const char* value = reinterpret_cast<const char*>(glGetString(name));
+    return value ? value : "";
+}
+
+bool CompileShader(GLuint shader, const char* source) {
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    GLint r = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &r);
+    if (r == GL_FALSE) {
+        GLchar msg[4096] = {};
+        GLsizei length;
+        glGetShaderInfoLog(shader, sizeof(msg), &length, msg);
+        Log::Write(Log::Level::Error, Fmt("Compile shader failed: %s", msg));
+        return false;
+    }
+    return true;
+}
+
+bool IsLinked(GLuint program) {
+    GLint r = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &r);
+    return r != GL_FALSE;
+}
+}  // namespace
+
+GLuint ProgramCache::Build(const char* name, const char* vertexSource, const char* fragmentSource) {
+    const uint64_t start = MonotonicNs();
+
+    GLint binaryFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+    const bool cacheable = !m_directory.empty() && binaryFormats > 0;
+
+    uint64_t key = 0xcbf29ce484222325ull;
+    key = Hash(key, vertexSource);
+    key = Hash(key, fragmentSource);
+    key = Hash(key, GlString(GL_VENDOR));
+    key = Hash(key, GlString(GL_RENDERER));
+    key = Hash(key, GlString(GL_VERSION));
+    const std::string path = m_directory + "/" + name + ".glprogram";
+
+    GLuint program = cacheable ? Load(path, key) : 0;
+    const bool hit = program != 0;
+    if (!hit) {
+        program = Compile(vertexSource, fragmentSource);
+        if (program != 0 && cacheable) {
+            Store(path, key, program);
+        }
+    }
+
+    const uint64_t elapsed = MonotonicNs() - start;
+    m_stats.buildNs += elapsed;
+    (hit ? m_stats.hits : m_stats.misses)++;
+    Log::Write(Log::Level::Info, Fmt("Program '%s': %s in %.2f ms", name,
+                                     hit ? "loaded from cache" : "compiled from source", elapsed / 1e6));
+    return program;
+}
+
+GLuint ProgramCache::Load(const std::string& path, uint64_t key) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return 0;
+    }
+    ProgramCacheHeader header = {};
+    std::vector<uint8_t> binary;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && header.magic == ProgramCacheMagic &&
+                 header.version == ProgramCacheVersion && header.key == key && header.binaryLength > 0;
+    if (valid) {
+        binary.resize(header.binaryLength);
+        valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+    if (!valid) {
+        return 0;
+    }
+
+    // The driver may still reject a blob it wrote (e.g. after an update that kept the
+    // version string); that shows up as a failed link.
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+    if (!IsLinked(program)) {
+        Log::Write(Log::Level::Warning, Fmt("Program cache entry %s rejected by the driver", path.c_str()));
+        glDeleteProgram(program);
+        remove(path.c_str());
+        return 0;
+    }
+    return program;
+}
+
+void ProgramCache::Store(const std::string& path, uint64_t key, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<uint8_t> binary(length);
+    ProgramCacheHeader header = {ProgramCacheMagic, ProgramCacheVersion, key, 0, 0};
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+    header.binaryFormat = binaryFormat;
+    header.binaryLength = (uint32_t)length;
+
+    if (!WriteFileAtomically(path, [&](FILE* file) {
+            return fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(binary.data(), 1, header.binaryLength, file) == header.binaryLength;
+        })) {
+        Log::Write(Log::Level::Warning, Fmt("Cannot write program cache entry %s", path.c_str()));
+    }
+}
+
+GLuint ProgramCache::Compile(const char* vertexSource, const char* fragmentSource) {
+    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    GLuint program = 0;
+    if (CompileShader(vertexShader, vertexSource) && CompileShader(fragmentShader, fragmentSource)) {
+        program = glCreateProgram();
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glLinkProgram(program);
+        if (!IsLinked(program)) {
+            GLchar msg[4096] = {};
+            GLsizei length;
+            glGetProgramInfoLog(program, sizeof(msg), &length, msg);
+            Log::Write(Log::Level::Error, Fmt("Link program failed: %s", msg));
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
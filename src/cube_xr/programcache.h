@@ -0,0 +1,36 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Builds GL programs through an on-disk cache of glGetProgramBinary() blobs. Entries are
+// keyed by a hash of the shader sources and the driver (vendor, renderer, version), so a
+// shader edit or a driver update simply misses. Anything that fails to load falls back
+// to compiling from source, which then rewrites the entry.
+class ProgramCache {
+public:
+    struct Stats {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> buildNs{0};
+    };
+
+    // Without a directory (or on drivers without binary formats) every Build() compiles.
+    void SetDirectory(const std::string& directory) { m_directory = directory; }
+
+    // Needs a current context. Returns 0 if the program could not be built.
+    GLuint Build(const char* name, const char* vertexSource, const char* fragmentSource);
+
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    GLuint Load(const std::string& path, uint64_t key);
+    void Store(const std::string& path, uint64_t key, GLuint program);
+    GLuint Compile(const char* vertexSource, const char* fragmentSource);
+
+    std::string m_directory;
+    Stats m_stats;
+};
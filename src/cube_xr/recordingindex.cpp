@@ -0,0 +1,442 @@
+#include "common.h"
+#include "recordingindex.h"
+#include "gazerecording.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace {
+const uint32_t IndexMagic = 0x58495445;  // 'ETIX'
+const uint32_t IndexVersion = 1;
+
+struct IndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t blockRecords;
+    uint32_t summarySize;
+    uint64_t records;
+    uint64_t recordingBytes;  // the recording it was built from, to notice a stale index
+    uint64_t blocks;
+};
+
+bool Has(int32_t status, int bits) { return (status & bits) == bits; }
+}  // namespace
+
+// Where a blink scan stands between blocks.
+struct RecordingIndex::BlinkState {
+    float closedOpenness;
+    uint64_t minNs;
+    uint64_t maxNs;
+    bool closed;
+    bool started;  // the closed run began inside the range
+    uint64_t sinceNs;
+};
+
+void RecordingIndex::Stats::Add(float value) {
+    if (count == 0) {
+        min = max = value;
+    } else {
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    sum += value;
+    count++;
+}
+
+void RecordingIndex::Stats::Add(const Stats& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    sum += other.sum;
+    count += other.count;
+}
+
+void RecordingIndex::Summary::Add(const Summary& other) {
+    if (other.records == 0) {
+        return;
+    }
+    if (records == 0) {
+        firstNs = other.firstNs;
+    }
+    lastNs = other.lastNs;
+    records += other.records;
+    for (int i = 0; i < FieldCount; i++) {
+        fields[i].Add(other.fields[i]);
+    }
+}
+
+void RecordingIndex::Summarize(const RecordedSample& sample, Summary* summary) {
+    const GazeSample& gaze = sample.gaze;
+    if (summary->records == 0) {
+        summary->firstNs = gaze.timestampNs;
+    }
+    summary->lastNs = gaze.timestampNs;
+    summary->records++;
+    if (Has(gaze.leftEyePoseStatus, GAZE_STATUS_PUPIL_DILATION_VALID)) {
+        summary->fields[LeftPupil].Add(gaze.leftEyePupilDilation);
+    }
+    if (Has(gaze.rightEyePoseStatus, GAZE_STATUS_PUPIL_DILATION_VALID)) {
+        summary->fields[RightPupil].Add(gaze.rightEyePupilDilation);
+    }
+    const bool leftOpenness = Has(gaze.leftEyePoseStatus, GAZE_STATUS_OPENNESS_VALID);
+    const bool rightOpenness = Has(gaze.rightEyePoseStatus, GAZE_STATUS_OPENNESS_VALID);
+    if (leftOpenness) {
+        summary->fields[LeftOpenness].Add(gaze.leftEyeOpenness);
+    }
+    if (rightOpenness) {
+        summary->fields[RightOpenness].Add(gaze.rightEyeOpenness);
+    }
+    if (leftOpenness && rightOpenness) {
+        summary->fields[EyesOpenness].Add(std::max(gaze.leftEyeOpenness, gaze.rightEyeOpenness));
+    }
+    summary->fields[CombinedValid].Add(Has(gaze.combinedEyePoseStatus, GAZE_STATUS_GAZE_VECTOR_VALID) ? 1.0f : 0.0f);
+}
+
+void RecordingIndex::Add(const RecordedSample* samples, size_t count) {
+    if (m_levels.empty()) {
+        m_levels.resize(1);
+    }
+    std::vector<Summary>& blocks = m_levels[0];
+    for (size_t i = 0; i < count; i++) {
+        if (blocks.empty() || blocks.back().records == BlockRecords) {
+            blocks.emplace_back();
+        }
+        Summarize(samples[i], &blocks.back());
+    }
+    m_records += count;
+}
+
+void RecordingIndex::BuildLevels() {
+    m_levels.resize(1);
+    while (m_levels.back().size() > 1) {
+        const std::vector<Summary>& below = m_levels.back();
+        std::vector<Summary> level((below.size() + Fanout - 1) / Fanout);
+        for (size_t i = 0; i < below.size(); i++) {
+            level[i / Fanout].Add(below[i]);
+        }
+        m_levels.push_back(std::move(level));
+    }
+}
+
+bool RecordingIndex::Save(const std::string& path, uint64_t recordingBytes) {
+    const std::vector<Summary> none;
+    const std::vector<Summary>& blocks = m_levels.empty() ? none : m_levels[0];
+    const IndexHeader header = {IndexMagic, IndexVersion, BlockRecords, sizeof(Summary),
+                                m_records,  recordingBytes, blocks.size()};
+
+    if (!WriteFileAtomically(path, [&](FILE* file) {
+            return fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   (blocks.empty() || fwrite(blocks.data(), sizeof(Summary), blocks.size(), file) == blocks.size());
+        })) {
+        Log::Write(Log::Level::Warning, Fmt("Cannot write recording index %s", path.c_str()));
+        return false;
+    }
+    return true;
+}
+
+bool RecordingIndex::Load(const std::string& path, uint64_t recordingBytes) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    IndexHeader header = {};
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && header.magic == IndexMagic &&
+                 header.version == IndexVersion && header.blockRecords == BlockRecords &&
+                 header.summarySize == sizeof(Summary) && header.recordingBytes == recordingBytes &&
+                 header.blocks == (header.records + BlockRecords - 1) / BlockRecords;
+    if (valid) {
+        m_levels.assign(1, std::vector<Summary>(header.blocks));
+        valid = header.blocks == 0 || fread(m_levels[0].data(), sizeof(Summary), header.blocks, file) == header.blocks;
+    }
+    fclose(file);
+    if (!valid) {
+        m_levels.clear();
+        return false;
+    }
+    m_records = header.records;
+    BuildLevels();
+    return true;
+}
+
+bool RecordingIndex::Build(const std::string& recordingPath) {
+    FILE* file = fopen(recordingPath.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    RecordingHeader header = {};
+    if (fread(&header, sizeof(header), 1, file) != 1 || !header.Valid()) {
+        fclose(file);
+        return false;
+    }
+    m_levels.clear();
+    m_records = 0;
+    std::vector<RecordedSample> samples(BlockRecords);
+    size_t count;
+    while ((count = fread(samples.data(), sizeof(RecordedSample), samples.size(), file)) > 0) {
+        Add(samples.data(), count);
+    }
+    fclose(file);
+    if (m_levels.empty()) {
+        m_levels.resize(1);
+    }
+    BuildLevels();
+    return true;
+}
+
+bool RecordingIndex::Open(const std::string& recordingPath) {
+    Close();
+    const uint64_t startNs = MonotonicNs();
+    m_fd = open(recordingPath.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    RecordingHeader header = {};
+    if (m_fd < 0 || fstat(m_fd, &status) != 0 ||
+        pread(m_fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || !header.Valid()) {
+        Log::Write(Log::Level::Error, Fmt("Cannot open recording %s", recordingPath.c_str()));
+        Close();
+        return false;
+    }
+    const uint64_t recordingBytes =
+        sizeof(header) + (status.st_size - sizeof(header)) / sizeof(RecordedSample) * sizeof(RecordedSample);
+
+    const std::string indexPath = IndexPath(recordingPath);
+    if (Load(indexPath, recordingBytes)) {
+        Log::Write(Log::Level::Info, Fmt("Recording index %s loaded in %.2f ms", indexPath.c_str(),
+                                         (MonotonicNs() - startNs) / 1e6));
+        return true;
+    }
+    if (!Build(recordingPath)) {
+        Log::Write(Log::Level::Error, Fmt("Cannot index recording %s", recordingPath.c_str()));
+        Close();
+        return false;
+    }
+    Save(indexPath, recordingBytes);
+    Log::Write(Log::Level::Info, Fmt("Recording %s indexed in %.2f ms, %llu samples", recordingPath.c_str(),
+                                     (MonotonicNs() - startNs) / 1e6, (unsigned long long)m_records));
+    return true;
+}
+
+void RecordingIndex::Close() {
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_levels.clear();
+    m_records = 0;
+}
+
+bool RecordingIndex::Read(uint64_t first, uint64_t count, std::vector<RecordedSample>* samples) const {
+    samples->resize(count);
+    uint8_t* data = reinterpret_cast<uint8_t*>(samples->data());
+    const size_t size = count * sizeof(RecordedSample);
+    const off_t offset = sizeof(RecordingHeader) + first * sizeof(RecordedSample);
+    for (size_t done = 0; done < size;) {
+        const ssize_t n = pread(m_fd, data + done, size - done, offset + done);
+        if (n <= 0) {
+            return false;
+        }
+        done += n;
+    }
+    m_blocksRead.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+uint64_t RecordingIndex::TimeAt(uint64_t record) const {
+    uint64_t timeNs = 0;
+    const off_t offset = sizeof(RecordingHeader) + record * sizeof(RecordedSample) + offsetof(GazeSample, timestampNs);
+    return pread(m_fd, &timeNs, sizeof(timeNs), offset) == (ssize_t)sizeof(timeNs) ? timeNs : UINT64_MAX;
+}
+
+uint64_t RecordingIndex::FindRecord(uint64_t timeNs) const {
+    if (m_records == 0) {
+        return 0;
+    }
+    // The block is found in the index, the record in the file.
+    const std::vector<Summary>& blocks = m_levels[0];
+    const auto block = std::lower_bound(blocks.begin(), blocks.end(), timeNs,
+                                        [](const Summary& summary, uint64_t t) { return summary.lastNs < t; });
+    if (block == blocks.end()) {
+        return m_records;
+    }
+    uint64_t low = (uint64_t)(block - blocks.begin()) * BlockRecords;
+    if (block->firstNs >= timeNs) {
+        return low;
+    }
+    // Earlier than timeNs at low, not at high.
+    uint64_t high = low + block->records - 1;
+    while (high - low > 1) {
+        const uint64_t middle = low + (high - low) / 2;
+        if (TimeAt(middle) >= timeNs) {
+            high = middle;
+        } else {
+            low = middle;
+        }
+    }
+    return high;
+}
+
+bool RecordingIndex::Query(Field field, uint64_t fromNs, uint64_t toNs, Stats* stats) const {
+    const uint64_t startNs = MonotonicNs();
+    *stats = Stats();
+    if (m_fd < 0) {
+        return false;
+    }
+    const uint64_t first = FindRecord(fromNs);
+    const uint64_t end = std::max(first, FindRecord(toNs));
+    if (first == end) {
+        return true;
+    }
+
+    std::vector<RecordedSample> samples;
+    auto addRecords = [&](uint64_t from, uint64_t to) {
+        if (!Read(from, to - from, &samples)) {
+            return false;
+        }
+        Summary summary;
+        for (const RecordedSample& sample : samples) {
+            Summarize(sample, &summary);
+        }
+        stats->Add(summary.fields[field]);
+        return true;
+    };
+
+    bool read = true;
+    size_t low = first / BlockRecords;
+    size_t high = (end - 1) / BlockRecords + 1;
+    if (high - low == 1) {
+        read = addRecords(first, end);
+        low = high;
+    } else {
+        // Partial blocks at the two ends come from the file...
+        if (first % BlockRecords != 0) {
+            read = addRecords(first, (uint64_t)(low + 1) * BlockRecords);
+            low++;
+        }
+        const uint64_t lastStart = (uint64_t)(high - 1) * BlockRecords;
+        if (end != lastStart + m_levels[0][high - 1].records) {
+            read = addRecords(lastStart, end) && read;
+            high--;
+        }
+    }
+    // ... whole ones from the highest level that covers them.
+    for (size_t level = 0; low < high; level++) {
+        const std::vector<Summary>& nodes = m_levels[level];
+        if (level + 1 == m_levels.size()) {
+            for (size_t i = low; i < high; i++) {
+                stats->Add(nodes[i].fields[field]);
+            }
+            break;
+        }
+        for (; low < high && low % Fanout != 0; low++) {
+            stats->Add(nodes[low].fields[field]);
+        }
+        // A parent ending with the level covers the rest, even when it is not full.
+        for (; low < high && high % Fanout != 0 && high != nodes.size(); high--) {
+            stats->Add(nodes[high - 1].fields[field]);
+        }
+        if (low == high) {
+            break;
+        }
+        low /= Fanout;
+        high = (high + Fanout - 1) / Fanout;
+    }
+    m_queries.fetch_add(1, std::memory_order_relaxed);
+    m_queryNs.fetch_add(MonotonicNs() - startNs, std::memory_order_relaxed);
+    return read;
+}
+
+bool RecordingIndex::Blinks(uint64_t fromNs, uint64_t toNs, std::vector<Blink>* blinks,
+                            const GazeMetricsParameters& parameters) const {
+    const uint64_t startNs = MonotonicNs();
+    blinks->clear();
+    if (m_fd < 0) {
+        return false;
+    }
+    const uint64_t first = FindRecord(fromNs);
+    const uint64_t end = std::max(first, FindRecord(toNs));
+    // Eyes already closed at fromNs closed before it: not a blink within the range.
+    BlinkState state = {parameters.closedOpenness, parameters.blinkMinNs, parameters.blinkMaxNs, true, false, 0};
+    bool read = true;
+    if (first < end) {
+        read = ScanBlinks(m_levels.size() - 1, 0, first, end, &state, blinks);
+    }
+    m_queries.fetch_add(1, std::memory_order_relaxed);
+    m_queryNs.fetch_add(MonotonicNs() - startNs, std::memory_order_relaxed);
+    return read;
+}
+
+bool RecordingIndex::ScanBlinks(size_t level, size_t node, uint64_t first, uint64_t end, BlinkState* state,
+                                std::vector<Blink>* blinks) const {
+    uint64_t span = BlockRecords;
+    for (size_t i = 0; i < level; i++) {
+        span *= Fanout;
+    }
+    const uint64_t nodeFirst = node * span;
+    const uint64_t nodeEnd = std::min(nodeFirst + span, m_records);
+    if (nodeEnd <= first || nodeFirst >= end) {
+        return true;
+    }
+    // Samples without openness leave the state as it is, and eyes open throughout keep
+    // it open: either way there is nothing in here.
+    const Stats& openness = m_levels[level][node].fields[EyesOpenness];
+    if (openness.count == 0 || (!state->closed && openness.min >= state->closedOpenness)) {
+        return true;
+    }
+    // Nor when they open somewhere in here after closing before the range.
+    if (state->closed && !state->started && openness.min >= state->closedOpenness && nodeFirst >= first &&
+        nodeEnd <= end) {
+        state->closed = false;
+        return true;
+    }
+
+    if (level > 0) {
+        const size_t children = m_levels[level - 1].size();
+        for (size_t child = node * Fanout; child < std::min((node + 1) * Fanout, children); child++) {
+            if (!ScanBlinks(level - 1, child, first, end, state, blinks)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<RecordedSample> samples;
+    const uint64_t from = std::max(first, nodeFirst);
+    if (!Read(from, std::min(end, nodeEnd) - from, &samples)) {
+        return false;
+    }
+    for (const RecordedSample& sample : samples) {
+        const GazeSample& gaze = sample.gaze;
+        if (!Has(gaze.leftEyePoseStatus, GAZE_STATUS_OPENNESS_VALID) ||
+            !Has(gaze.rightEyePoseStatus, GAZE_STATUS_OPENNESS_VALID)) {
+            continue;
+        }
+        const bool closed = std::max(gaze.leftEyeOpenness, gaze.rightEyeOpenness) < state->closedOpenness;
+        if (closed && !state->closed) {
+            state->sinceNs = gaze.timestampNs;
+            state->started = true;
+        } else if (!closed && state->closed && state->started) {
+            const uint64_t closedNs = gaze.timestampNs - state->sinceNs;
+            if (closedNs >= state->minNs && closedNs <= state->maxNs) {
+                blinks->push_back({state->sinceNs, gaze.timestampNs});
+            }
+        }
+        state->closed = closed;
+    }
+    return true;
+}
+
+void RecordingIndex::Report(std::ostringstream& out, double elapsedSeconds) {
+    const uint64_t queries = m_queries.load(std::memory_order_relaxed);
+    const uint64_t queryNs = m_queryNs.load(std::memory_order_relaxed);
+    const uint64_t newQueries = queries - m_reportedQueries;
+    out << "queries/s=" << newQueries / elapsedSeconds
+        << " queryMs=" << (newQueries != 0 ? (queryNs - m_reportedQueryNs) / 1e6 / newQueries : 0.0)
+        << " blocksRead=" << BlocksRead() << " samples=" << m_records;
+    m_reportedQueries = queries;
+    m_reportedQueryNs = queryNs;
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include "gazemetrics.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct RecordedSample;
+
+// Time index of a gaze recording (gazerecording.h), kept beside it as <recording>.idx.
+//
+// Level 0 summarizes every block of BlockRecords samples: its first and last timestamp,
+// and min / max / sum / count of a few fields. It doubles as the sparse index, since a
+// timestamp's block is a binary search away and records have a fixed size. Each further
+// level summarizes Fanout nodes of the one below, up to a single root, so a timeline can
+// be drawn at any zoom from the summaries alone.
+//
+// A range query finds its first and last record, reads only the partial blocks at the
+// two ends, and adds the whole blocks in between from the highest levels that fit. Blink
+// queries walk the levels and skip every node whose eyes were open throughout. Either way
+// the file is touched a few blocks at a time, whatever its size.
+//
+// Only level 0 is stored; the levels above are rebuilt on load. A missing or stale index
+// is rebuilt from the recording with one sequential scan. Queries are const and may run
+// on several threads at once.
+class RecordingIndex {
+public:
+    static constexpr uint32_t BlockRecords = 1024;
+    static constexpr uint32_t Fanout = 16;
+
+    enum Field {
+        LeftPupil,      // mm
+        RightPupil,     // mm
+        LeftOpenness,   // 0 to 1
+        RightOpenness,  // 0 to 1
+        EyesOpenness,   // the more open eye, when both are tracked; what blinks go by
+        CombinedValid,  // 1 with a combined gaze vector, 0 without
+        FieldCount
+    };
+
+    struct Stats {
+        float min = 0.0f;
+        float max = 0.0f;
+        double sum = 0.0;
+        uint64_t count = 0;
+        void Add(float value);
+        void Add(const Stats& other);
+        double Mean() const { return count != 0 ? sum / count : 0.0; }
+    };
+
+    struct Summary {
+        uint64_t firstNs = 0;
+        uint64_t lastNs = 0;
+        uint64_t records = 0;
+        Stats fields[FieldCount];
+        void Add(const Summary& other);
+    };
+
+    struct Blink {
+        uint64_t startNs;  // first closed sample
+        uint64_t endNs;    // first open sample after it
+    };
+
+    RecordingIndex() = default;
+    ~RecordingIndex() { Close(); }
+    RecordingIndex(const RecordingIndex&) = delete;
+    RecordingIndex& operator=(const RecordingIndex&) = delete;
+
+    static std::string IndexPath(const std::string& recordingPath) { return recordingPath + ".idx"; }
+
+    // Building, as the recording is written; samples must come in timestamp order.
+    void Add(const RecordedSample* samples, size_t count);
+    bool Save(const std::string& path, uint64_t recordingBytes);
+
+    // Opens a recording for queries, loading its index or building (and saving) it.
+    bool Open(const std::string& recordingPath);
+    void Close();
+
+    uint64_t Records() const { return m_records; }
+    uint64_t FirstNs() const { return m_records != 0 ? m_levels.back()[0].firstNs : 0; }
+    uint64_t LastNs() const { return m_records != 0 ? m_levels.back()[0].lastNs : 0; }
+    // Level 0 holds the blocks, the last level the root.
+    size_t Levels() const { return m_levels.size(); }
+    const std::vector<Summary>& Level(size_t level) const { return m_levels[level]; }
+
+    // The first record at or after timeNs; Records() if there is none.
+    uint64_t FindRecord(uint64_t timeNs) const;
+    // One field over the samples in [fromNs, toNs).
+    bool Query(Field field, uint64_t fromNs, uint64_t toNs, Stats* stats) const;
+    // Blinks lying entirely within [fromNs, toNs), classified as GazeMetrics does with
+    // these parameters.
+    bool Blinks(uint64_t fromNs, uint64_t toNs, std::vector<Blink>* blinks,
+                const GazeMetricsParameters& parameters = GazeMetricsParameters()) const;
+
+    // Blocks read from the recording by queries so far.
+    uint64_t BlocksRead() const { return m_blocksRead.load(std::memory_order_relaxed); }
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    struct BlinkState;
+
+    static void Summarize(const RecordedSample& sample, Summary* summary);
+    void BuildLevels();
+    bool Load(const std::string& path, uint64_t recordingBytes);
+    bool Build(const std::string& recordingPath);
+    bool Read(uint64_t first, uint64_t count, std::vector<RecordedSample>* samples) const;
+    uint64_t TimeAt(uint64_t record) const;
+    bool ScanBlinks(size_t level, size_t node, uint64_t first, uint64_t end, BlinkState* state,
+                    std::vector<Blink>* blinks) const;
+
+    std::vector<std::vector<Summary>> m_levels;
+    uint64_t m_records{0};
+    int m_fd{-1};
+
+    mutable std::atomic<uint64_t> m_queries{0};
+    mutable std::atomic<uint64_t> m_blocksRead{0};
+    mutable std::atomic<uint64_t> m_queryNs{0};
+    uint64_t m_reportedQueries{0};
+    uint64_t m_reportedQueryNs{0};
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(SIMD4_SCALAR)
+// The plain loops on any target, to check the vector paths against.
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SIMD4_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIMD4_SSE 1
+#endif
+
+// Four floats processed at once, for the batch loops over per-object data (laid out as
+// one array per component). Maps to NEON on both Android ABIs, to SSE on x86 builds and
+// to plain loops elsewhere, or wherever SIMD4_SCALAR is defined. Only what works on armeabi-v7a is used: no native divide or
+// square root there, so those are estimates refined by Newton-Raphson steps (~1e-6
+// relative error), which is plenty for culling and selection decisions.
+namespace Simd {
+
+#if defined(SIMD4_NEON)
+struct Float4 { float32x4_t v; };
+struct Mask4 { uint32x4_t v; };
+
+inline Float4 Load(const float* p) { return {vld1q_f32(p)}; }
+inline void Store(float* p, Float4 a) { vst1q_f32(p, a.v); }
+inline Float4 Splat(float s) { return {vdupq_n_f32(s)}; }
+
+inline Float4 operator+(Float4 a, Float4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline Float4 operator-(Float4 a, Float4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline Float4 operator*(Float4 a, Float4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline Float4 Min(Float4 a, Float4 b) { return {vminq_f32(a.v, b.v)}; }
+inline Float4 Max(Float4 a, Float4 b) { return {vmaxq_f32(a.v, b.v)}; }
+
+inline Float4 RSqrt(Float4 a) {
+    float32x4_t e = vrsqrteq_f32(a.v);
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a.v, e), e));
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a.v, e), e));
+    return {e};
+}
+inline Float4 Reciprocal(Float4 a) {
+    float32x4_t e = vrecpeq_f32(a.v);
+    e = vmulq_f32(e, vrecpsq_f32(a.v, e));
+    e = vmulq_f32(e, vrecpsq_f32(a.v, e));
+    return {e};
+}
+
+inline Mask4 operator<(Float4 a, Float4 b) { return {vcltq_f32(a.v, b.v)}; }
+inline Mask4 operator<=(Float4 a, Float4 b) { return {vcleq_f32(a.v, b.v)}; }
+inline Mask4 operator>(Float4 a, Float4 b) { return {vcgtq_f32(a.v, b.v)}; }
+inline Mask4 operator&(Mask4 a, Mask4 b) { return {vandq_u32(a.v, b.v)}; }
+inline Mask4 operator|(Mask4 a, Mask4 b) { return {vorrq_u32(a.v, b.v)}; }
+inline Float4 Select(Mask4 m, Float4 a, Float4 b) { return {vbslq_f32(m.v, a.v, b.v)}; }
+
+// Bit i is set when lane i of the mask is.
+inline int Bits(Mask4 m) {
+    return (int)((vgetq_lane_u32(m.v, 0) & 1) | (vgetq_lane_u32(m.v, 1) & 2) | (vgetq_lane_u32(m.v, 2) & 4) |
+                 (vgetq_lane_u32(m.v, 3) & 8));
+}
+
+#elif defined(SIMD4_SSE)
+struct Float4 { __m128 v; };
+struct Mask4 { __m128 v; };
+
+inline Float4 Load(const float* p) { return {_mm_loadu_ps(p)}; }
+inline void Store(float* p, Float4 a) { _mm_storeu_ps(p, a.v); }
+inline Float4 Splat(float s) { return {_mm_set1_ps(s)}; }
+
+inline Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Float4 operator*(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Float4 Min(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline Float4 Max(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+
+inline Float4 RSqrt(Float4 a) {
+    // One Newton-Raphson step on the 12-bit estimate: e * (1.5 - 0.5 * a * e * e).
+    const __m128 e = _mm_rsqrt_ps(a.v);
+    const __m128 halfAEE = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), a.v), _mm_mul_ps(e, e));
+    return {_mm_mul_ps(e, _mm_sub_ps(_mm_set1_ps(1.5f), halfAEE))};
+}
+inline Float4 Reciprocal(Float4 a) { return {_mm_div_ps(_mm_set1_ps(1.0f), a.v)}; }
+
+inline Mask4 operator<(Float4 a, Float4 b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline Mask4 operator<=(Float4 a, Float4 b) { return {_mm_cmple_ps(a.v, b.v)}; }
+inline Mask4 operator>(Float4 a, Float4 b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+inline Mask4 operator&(Mask4 a, Mask4 b) { return {_mm_and_ps(a.v, b.v)}; }
+inline Mask4 operator|(Mask4 a, Mask4 b) { return {_mm_or_ps(a.v, b.v)}; }
+inline Float4 Select(Mask4 m, Float4 a, Float4 b) { return {_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))}; }
+
+inline int Bits(Mask4 m) { return _mm_movemask_ps(m.v); }
+
+#else
+struct Float4 { float v[4]; };
+struct Mask4 { bool v[4]; };
+
+inline Float4 Load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void Store(float* p, Float4 a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+inline Float4 Splat(float s) { return {{s, s, s, s}}; }
+
+#define SIMD4_BINARY(NAME, EXPR)                                                  \
+    inline Float4 NAME(Float4 a, Float4 b) {                                      \
+        Float4 r;                                                                 \
+        for (int i = 0; i < 4; i++) r.v[i] = EXPR;                                \
+        return r;                                                                 \
+    }
+SIMD4_BINARY(operator+, a.v[i] + b.v[i])
+SIMD4_BINARY(operator-, a.v[i] - b.v[i])
+SIMD4_BINARY(operator*, a.v[i] * b.v[i])
+SIMD4_BINARY(Min, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+SIMD4_BINARY(Max, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+#undef SIMD4_BINARY
+
+inline Float4 RSqrt(Float4 a) {
+    Float4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = 1.0f / __builtin_sqrtf(a.v[i]);
+    return r;
+}
+inline Float4 Reciprocal(Float4 a) {
+    Float4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = 1.0f / a.v[i];
+    return r;
+}
+
+#define SIMD4_COMPARE(NAME, EXPR)                                                 \
+    inline Mask4 NAME(Float4 a, Float4 b) {                                       \
+        Mask4 r;                                                                  \
+        for (int i = 0; i < 4; i++) r.v[i] = EXPR;                                \
+        return r;                                                                 \
+    }
+SIMD4_COMPARE(operator<, a.v[i] < b.v[i])
+SIMD4_COMPARE(operator<=, a.v[i] <= b.v[i])
+SIMD4_COMPARE(operator>, a.v[i] > b.v[i])
+#undef SIMD4_COMPARE
+
+inline Mask4 operator&(Mask4 a, Mask4 b) { return {{a.v[0] && b.v[0], a.v[1] && b.v[1], a.v[2] && b.v[2], a.v[3] && b.v[3]}}; }
+inline Mask4 operator|(Mask4 a, Mask4 b) { return {{a.v[0] || b.v[0], a.v[1] || b.v[1], a.v[2] || b.v[2], a.v[3] || b.v[3]}}; }
+inline Float4 Select(Mask4 m, Float4 a, Float4 b) {
+    Float4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = m.v[i] ? a.v[i] : b.v[i];
+    return r;
+}
+
+inline int Bits(Mask4 m) { return (m.v[0] ? 1 : 0) | (m.v[1] ? 2 : 0) | (m.v[2] ? 4 : 0) | (m.v[3] ? 8 : 0); }
+#endif
+
+inline Float4 Sqrt(Float4 a) {
+    // a * 1/sqrt(a), with a = 0 kept finite.
+    return a * RSqrt(Max(a, Splat(1e-30f)));
+}
+
+inline Float4 Clamp(Float4 a, Float4 lo, Float4 hi) { return Min(Max(a, lo), hi); }
+
+// Multiply-add written out; compilers fuse it where the target has FMA.
+inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return a * b + c; }
+
+// Rotates four vectors by four unit quaternions (x, y, z, w):
+// v' = v + w t + q.xyz x t, with t = 2 q.xyz x v.
+inline void Rotate(Float4 qx, Float4 qy, Float4 qz, Float4 qw, Float4& vx, Float4& vy, Float4& vz) {
+    const Float4 two = Splat(2.0f);
+    const Float4 tx = two * (qy * vz - qz * vy);
+    const Float4 ty = two * (qz * vx - qx * vz);
+    const Float4 tz = two * (qx * vy - qy * vx);
+    vx = vx + qw * tx + (qy * tz - qz * ty);
+    vy = vy + qw * ty + (qz * tx - qx * tz);
+    vz = vz + qw * tz + (qx * ty - qy * tx);
+}
+
+}  // namespace Simd
@@ -0,0 +1,87 @@
+#include "common.h"
+#include "glcalls.h"
+#include "streamingbuffer.h"
+
+void StreamingBuffer::Initialize(GLenum target, size_t bytesPerFrame, int framesInFlight) {
+    m_target = target;
+    m_regionSize = bytesPerFrame;
+    m_regionCount = std::min(std::max(framesInFlight, 1), MaxFramesInFlight);
+    m_region = 0;
+    m_offset = 0;
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(m_target, m_buffer);
+    glBufferData(m_target, (GLsizeiptr)(m_regionSize * m_regionCount), nullptr, GL_STREAM_DRAW);
+}
+
+void StreamingBuffer::Destroy() {
+    for (GLsync& fence : m_fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (m_buffer != 0) {
+        glDeleteBuffers(1, &m_buffer);
+        m_buffer = 0;
+    }
+}
+
+void StreamingBuffer::BeginFrame() {
+    m_region = (m_region + 1) % m_regionCount;
+    m_offset = 0;
+
+    GLsync& fence = m_fences[m_region];
+    if (fence != nullptr) {
+        const uint64_t start = MonotonicNs();
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        while (result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        m_stats.fenceWaitNs += MonotonicNs() - start;
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+void StreamingBuffer::EndFrame() {
+    if (m_offset > 0) {
+        m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    m_stats.uploadBytes += m_offset;
+    m_stats.frames++;
+}
+
+StreamingBuffer::Allocation StreamingBuffer::Map(size_t size, size_t alignment) {
+    Allocation allocation;
+    size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+
+    glBindBuffer(m_target, m_buffer);
+    if (offset + size > m_regionSize) {
+        // This frame outgrew its region: orphan the storage and start the ring over. The
+        // driver keeps the old storage alive until pending draws are done with it.
+        m_regionSize = std::max(m_regionSize * 2, size);
+        glBufferData(m_target, (GLsizeiptr)(m_regionSize * m_regionCount), nullptr, GL_STREAM_DRAW);
+        for (GLsync& fence : m_fences) {
+            if (fence != nullptr) {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+        m_stats.orphans++;
+        offset = 0;
+    }
+
+    const GLintptr absolute = (GLintptr)(m_region * m_regionSize + offset);
+    allocation.data = glMapBufferRange(m_target, absolute, (GLsizeiptr)size,
+                                       GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    allocation.offset = absolute;
+    allocation.size = size;
+    m_offset = offset + size;
+    return allocation;
+}
+
+void StreamingBuffer::Unmap() {
+    glBindBuffer(m_target, m_buffer);
+    glUnmapBuffer(m_target);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Ring of per-frame regions in one large GL buffer for data rewritten every frame.
+// Sub-allocations are mapped with GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT,
+// so the driver never has to reallocate or synchronize; instead each frame's region is
+// fenced and only waited on when the ring comes back around to it. A frame that outgrows
+// its region orphans the whole buffer rather than stalling.
+class StreamingBuffer {
+public:
+    struct Allocation {
+        void*    data = nullptr;  // write-only, valid until Unmap()
+        GLintptr offset = 0;
+        size_t   size = 0;
+    };
+
+    struct Stats {
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> uploadBytes{0};
+        std::atomic<uint64_t> fenceWaitNs{0};
+        std::atomic<uint64_t> orphans{0};
+    };
+
+    StreamingBuffer() = default;
+    ~StreamingBuffer() { Destroy(); }
+
+    StreamingBuffer(const StreamingBuffer&) = delete;
+    StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+    void Initialize(GLenum target, size_t bytesPerFrame, int framesInFlight);
+    void Destroy();
+
+    // Waits (if needed) until the GPU is done with the region this frame reuses.
+    void BeginFrame();
+    // Fences everything allocated since BeginFrame().
+    void EndFrame();
+
+    // Leaves the buffer bound to its target and mapped; call Unmap() before drawing from it.
+    // If this allocation orphans the buffer, earlier allocations of the same frame must
+    // already have been drawn.
+    Allocation Map(size_t size, size_t alignment = 16);
+    void Unmap();
+
+    GLuint Buffer() const { return m_buffer; }
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    static const int MaxFramesInFlight = 4;
+
+    GLenum m_target{GL_ARRAY_BUFFER};
+    GLuint m_buffer{0};
+    size_t m_regionSize{0};
+    int m_regionCount{0};
+    int m_region{0};
+    size_t m_offset{0};
+    GLsync m_fences[MaxFramesInFlight] = {};
+    Stats m_stats;
+};
@@ -0,0 +1,210 @@
+#include "common.h"
+#include "vergence.h"
+#include "simd4.h"
+
+namespace {
+const size_t BlockSize = 64;
+const int RayBits = GAZE_STATUS_GAZE_POINT_VALID | GAZE_STATUS_GAZE_VECTOR_VALID;
+const float MinParallel = 1e-6f;       // sin^2 of the angle between rays below which they count as parallel
+const float MissScale = 0.02f;         // radians; rays missing each other by this much halve the confidence
+const float ClosedOpenness = 0.1f;     // openness at which an eye is taken as closed ...
+const float OpenOpenness = 0.5f;       // ... and fully open
+const float PickGateDiopters = 0.25f;  // slack around the filter's uncertainty for accepting a pick
+// What unusable samples get: two parallel rays, with no weight.
+const float NoLeftEye[3] = {-0.032f, 0.0f, 0.0f};
+const float NoRightEye[3] = {0.032f, 0.0f, 0.0f};
+const float NoGaze[3] = {0.0f, 0.0f, -1.0f};
+
+// An eye open enough to be trusted, 0 to 1; 1 when openness is not reported.
+float OpennessWeight(const GazeSample& sample) {
+    if (!(sample.leftEyePoseStatus & GAZE_STATUS_OPENNESS_VALID) ||
+        !(sample.rightEyePoseStatus & GAZE_STATUS_OPENNESS_VALID)) {
+        return 1.0f;
+    }
+    const float openness = std::min(sample.leftEyeOpenness, sample.rightEyeOpenness);
+    return std::min(1.0f, std::max(0.0f, (openness - ClosedOpenness) / (OpenOpenness - ClosedOpenness)));
+}
+}  // namespace
+
+size_t VergenceEstimator::Process(const GazeSample* samples, size_t count, const float* pickedDistances,
+                                  VergenceDepth* out) {
+    using namespace Simd;
+
+    // Eye ray origins and directions, and the weight each sample starts from.
+    alignas(16) float lx[BlockSize], ly[BlockSize], lz[BlockSize], ldx[BlockSize], ldy[BlockSize], ldz[BlockSize];
+    alignas(16) float rx[BlockSize], ry[BlockSize], rz[BlockSize], rdx[BlockSize], rdy[BlockSize], rdz[BlockSize];
+    alignas(16) float weight[BlockSize];
+    alignas(16) float diopters[BlockSize], confidence[BlockSize];
+    size_t measured = 0;
+    const Float4 minDepth2 = Splat(1.0f / (m_parameters.maxDiopters * m_parameters.maxDiopters));
+
+    for (size_t base = 0; base < count; base += BlockSize) {
+        const size_t n = std::min(BlockSize, count - base);
+        const size_t padded = (n + 3) & ~(size_t)3;
+        for (size_t i = 0; i < padded; i++) {
+            const float* left = NoLeftEye;
+            const float* right = NoRightEye;
+            const float* leftVector = NoGaze;
+            const float* rightVector = NoGaze;
+            weight[i] = 0.0f;
+            if (i < n) {
+                const GazeSample& sample = samples[base + i];
+                if ((sample.leftEyePoseStatus & RayBits) == RayBits &&
+                    (sample.rightEyePoseStatus & RayBits) == RayBits) {
+                    left = sample.leftEyeGazePoint;
+                    right = sample.rightEyeGazePoint;
+                    leftVector = sample.leftEyeGazeVector;
+                    rightVector = sample.rightEyeGazeVector;
+                    weight[i] = OpennessWeight(sample);
+                    measured++;
+                }
+            }
+            lx[i] = left[0];
+            ly[i] = left[1];
+            lz[i] = left[2];
+            rx[i] = right[0];
+            ry[i] = right[1];
+            rz[i] = right[2];
+            ldx[i] = leftVector[0];
+            ldy[i] = leftVector[1];
+            ldz[i] = leftVector[2];
+            rdx[i] = rightVector[0];
+            rdy[i] = rightVector[1];
+            rdz[i] = rightVector[2];
+        }
+
+        const Float4 zero = Splat(0.0f), one = Splat(1.0f);
+        for (size_t i = 0; i < padded; i += 4) {
+            const Float4 pLx = Load(lx + i), pLy = Load(ly + i), pLz = Load(lz + i);
+            const Float4 pRx = Load(rx + i), pRy = Load(ry + i), pRz = Load(rz + i);
+            const Float4 rawUX = Load(ldx + i), rawUY = Load(ldy + i), rawUZ = Load(ldz + i);
+            const Float4 rawVX = Load(rdx + i), rawVY = Load(rdy + i), rawVZ = Load(rdz + i);
+            const Float4 uScale = RSqrt(Max(rawUX * rawUX + rawUY * rawUY + rawUZ * rawUZ, Splat(1e-12f)));
+            const Float4 vScale = RSqrt(Max(rawVX * rawVX + rawVY * rawVY + rawVZ * rawVZ, Splat(1e-12f)));
+            const Float4 uX = rawUX * uScale, uY = rawUY * uScale, uZ = rawUZ * uScale;
+            const Float4 vX = rawVX * vScale, vY = rawVY * vScale, vZ = rawVZ * vScale;
+
+            // Closest approach of pL + s u and pR + t v, for unit u and v:
+            //   s = (b e - d) / (1 - b^2), t = (e - b d) / (1 - b^2)
+            // with b = u.v, d = u.(pL - pR), e = v.(pL - pR).
+            const Float4 wX = pLx - pRx, wY = pLy - pRy, wZ = pLz - pRz;
+            const Float4 b = uX * vX + uY * vY + uZ * vZ;
+            const Float4 d = uX * wX + uY * wY + uZ * wZ;
+            const Float4 e = vX * wX + vY * wY + vZ * wZ;
+            const Float4 sine2 = one - b * b;
+            const Float4 inverse = Reciprocal(Max(sine2, Splat(MinParallel)));
+            const Float4 s = (b * e - d) * inverse;
+            const Float4 t = (e - b * d) * inverse;
+
+            // Depth from the point between the eyes to the middle of the closest approach.
+            const Float4 aX = pLx + s * uX, aY = pLy + s * uY, aZ = pLz + s * uZ;
+            const Float4 cX = pRx + t * vX, cY = pRy + t * vY, cZ = pRz + t * vZ;
+            const Float4 half = Splat(0.5f);
+            const Float4 fX = half * (aX + cX - pLx - pRx), fY = half * (aY + cY - pLy - pRy),
+                         fZ = half * (aZ + cZ - pLz - pRz);
+            const Float4 depth2 = fX * fX + fY * fY + fZ * fZ;
+            // Nearer than maxDiopters counts as maxDiopters.
+            const Float4 inverseDepth = RSqrt(Max(depth2, minDepth2));
+            // Parallel or diverging rays meet at infinity, or beyond.
+            const Mask4 converging = (Splat(MinParallel) < sine2) & (zero < s) & (zero < t);
+            const Float4 raw = Select(converging, inverseDepth, zero);
+
+            // How far the rays pass from each other, as an angle seen from the eyes.
+            const Float4 mX = aX - cX, mY = aY - cY, mZ = aZ - cZ;
+            const Float4 missAngle = Sqrt(mX * mX + mY * mY + mZ * mZ) * raw * Splat(1.0f / MissScale);
+            const Float4 agreement = Reciprocal(one + missAngle * missAngle);
+            Store(diopters + i, raw);
+            Store(confidence + i, Clamp(Load(weight + i) * agreement, zero, one));
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            VergenceDepth& depth = out[base + i];
+            depth.timestampNs = samples[base + i].timestampNs;
+            depth.rawDiopters = diopters[i];
+            depth.confidence = confidence[i];
+            Filter(&depth, pickedDistances != nullptr ? pickedDistances[base + i] : 0.0f);
+        }
+    }
+    if (count != 0) {
+        std::lock_guard<std::mutex> lock(m_latestLock);
+        m_latest = out[count - 1];
+        m_hasLatest = true;
+    }
+    m_samples.fetch_add(count, std::memory_order_relaxed);
+    m_measured.fetch_add(measured, std::memory_order_relaxed);
+    return measured;
+}
+
+void VergenceEstimator::Filter(VergenceDepth* depth, float pickedDistance) {
+    depth->fused = false;
+    if (m_initialized && depth->timestampNs > m_lastNs) {
+        m_variance += m_parameters.processNoise * (depth->timestampNs - m_lastNs) * 1e-9f;
+    }
+    m_lastNs = std::max(m_lastNs, depth->timestampNs);
+
+    const VergenceParameters& p = m_parameters;
+    if (depth->confidence >= p.minConfidence) {
+        const float noise = p.measurementNoise * p.measurementNoise / depth->confidence;
+        if (!m_initialized) {
+            m_estimate = depth->rawDiopters;
+            m_variance = noise;
+            m_initialized = true;
+        } else {
+            const float gain = m_variance / (m_variance + noise);
+            m_estimate += gain * (depth->rawDiopters - m_estimate);
+            m_variance *= 1.0f - gain;
+        }
+    }
+
+    if (pickedDistance > 0.0f && m_initialized) {
+        const float picked = std::min(1.0f / pickedDistance, p.maxDiopters);
+        const float gate = 3.0f * std::sqrt(m_variance + p.pickNoise * p.pickNoise) + PickGateDiopters;
+        if (std::fabs(picked - m_estimate) <= gate) {
+            const float noise = p.pickNoise * p.pickNoise;
+            const float gain = m_variance / (m_variance + noise);
+            m_estimate += gain * (picked - m_estimate);
+            m_variance *= 1.0f - gain;
+            depth->fused = true;
+            m_fused.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            m_rejectedPicks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    m_estimate = std::min(std::max(m_estimate, 0.0f), p.maxDiopters);
+    depth->diopters = m_estimate;
+    depth->depth = m_estimate > 1.0f / p.maxDepth ? 1.0f / m_estimate : p.maxDepth;
+}
+
+bool VergenceEstimator::Latest(VergenceDepth* depth) const {
+    std::lock_guard<std::mutex> lock(m_latestLock);
+    *depth = m_latest;
+    return m_hasLatest;
+}
+
+void VergenceEstimator::Reset() {
+    m_initialized = false;
+    m_estimate = 0.0f;
+    m_variance = 0.0f;
+    m_lastNs = 0;
+}
+
+void VergenceEstimator::Report(std::ostringstream& out, double elapsedSeconds) {
+    const uint64_t samples = m_samples.load(std::memory_order_relaxed);
+    const uint64_t measured = m_measured.load(std::memory_order_relaxed);
+    const uint64_t fused = m_fused.load(std::memory_order_relaxed);
+    const uint64_t rejectedPicks = m_rejectedPicks.load(std::memory_order_relaxed);
+    const uint64_t newSamples = samples - m_reportedSamples;
+    VergenceDepth latest;
+    const bool hasLatest = Latest(&latest);
+
+    out << "samples/s=" << newSamples / elapsedSeconds
+        << " measured%=" << (newSamples != 0 ? 100.0 * (measured - m_reportedMeasured) / newSamples : 0.0)
+        << " fused%=" << (newSamples != 0 ? 100.0 * (fused - m_reportedFused) / newSamples : 0.0)
+        << " rejectedPicks=" << (rejectedPicks - m_reportedRejectedPicks)
+        << " depthM=" << (hasLatest ? latest.depth : 0.0f) << " confidence=" << (hasLatest ? latest.confidence : 0.0f);
+    m_reportedSamples = samples;
+    m_reportedMeasured = measured;
+    m_reportedFused = fused;
+    m_reportedRejectedPicks = rejectedPicks;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "gazesample.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+
+// Fixation depth of one gaze sample.
+struct VergenceDepth {
+    uint64_t timestampNs;
+    float rawDiopters;  // from this sample's eye rays alone; 0 is infinity
+    float confidence;   // 0 to 1, of rawDiopters
+    float diopters;     // filtered and fused with the picked depth
+    float depth;        // meters, 1 / diopters capped at VergenceParameters::maxDepth
+    bool fused;         // the picked surface was used
+};
+
+// Estimates how far away the eyes fixate from the vergence of the two eye rays: the point
+// where they pass closest to each other. Depth works in diopters (1 / meters), where the
+// error of a vergence measurement is about the same near and far, so parallel or slightly
+// diverging rays just mean "far" (0 diopters).
+//
+// Each sample gets a confidence from the eye openness and from how close the two rays
+// actually come, relative to the depth. A Kalman filter in diopters weighs the samples by
+// it. When the gaze picked a surface (the combined ray's hit distance), that is a far more
+// precise depth, fused in whenever it agrees with the vergence within the filter's
+// uncertainty; a hit on something the eyes are not converged on is ignored.
+//
+// The ray geometry runs four samples at a time; the filter then runs over them in order.
+// Nothing depends on the runtime: recorded samples give the same result offline.
+struct VergenceParameters {
+    float maxDiopters = 5.0f;       // nearer than 20 cm is not tracked
+    float maxDepth = 100.0f;        // meters, for 0 diopters
+    float measurementNoise = 0.3f;  // diopters, one confident sample
+    float pickNoise = 0.05f;        // diopters, the picked surface
+    float processNoise = 4.0f;      // diopters^2 per second of fixation change
+    float minConfidence = 0.05f;
+};
+
+class VergenceEstimator {
+public:
+    explicit VergenceEstimator(const VergenceParameters& parameters = VergenceParameters()) : m_parameters(parameters) {}
+
+    const VergenceParameters& Parameters() const { return m_parameters; }
+
+    // pickedDistances may be null; an entry <= 0 means nothing was picked for that sample.
+    // Returns the number of samples that had both eye rays.
+    size_t Process(const GazeSample* samples, size_t count, const float* pickedDistances, VergenceDepth* out);
+
+    // The last sample processed. Returns false until there is one.
+    bool Latest(VergenceDepth* depth) const;
+
+    void Reset();
+
+    // Instrumentation reporter; may run on another thread.
+    void Report(std::ostringstream& out, double elapsedSeconds);
+
+private:
+    void Filter(VergenceDepth* depth, float pickedDistance);
+
+    const VergenceParameters m_parameters;
+    bool m_initialized{false};
+    float m_estimate{0.0f};  // diopters
+    float m_variance{0.0f};
+    uint64_t m_lastNs{0};
+
+    mutable std::mutex m_latestLock;
+    VergenceDepth m_latest{};
+    bool m_hasLatest{false};
+
+    std::atomic<uint64_t> m_samples{0};
+    std::atomic<uint64_t> m_measured{0};
+    std::atomic<uint64_t> m_fused{0};
+    std::atomic<uint64_t> m_rejectedPicks{0};
+    uint64_t m_reportedSamples{0};
+    uint64_t m_reportedMeasured{0};
+    uint64_t m_reportedFused{0};
+    uint64_t m_reportedRejectedPicks{0};
+};
@@ -0,0 +1,187 @@
+// etvr_framescheduler_test: runs the frame scheduler (framescheduler.h) against a stand-in
+// runtime on desktop Linux and checks when it wakes the loop.
+//
+//     etvr_framescheduler_test
+//
+// The loop is the app's: poll() on TimerFd() and SignalFd() until Due(), then start a
+// frame. The stand-in runtime releases frames on a 72 Hz vsync grid, blocking until the
+// next vsync as Pxr_BeginFrame() does, and predicts display one period after release. It
+// checks the wakeup and frame rates at every vsync and every other one, that Signal()
+// wakes a stopped loop without starting frames, that the idle tick is slow, that going
+// back to every vsync makes an overdue frame due at once, and that skipped vsyncs are
+// counted from display times exactly, apart from the ones a frame interval leaves out.
+#include "common.h"
+#include "framescheduler.h"
+
+#include <poll.h>
+
+namespace {
+constexpr uint64_t PeriodNs = 1000000000 / 72;
+
+int g_failures = 0;
+
+void Check(bool condition, const std::string& what) {
+    printf("%s: %s\n", condition ? "ok" : "FAILED", what.c_str());
+    g_failures += condition ? 0 : 1;
+}
+
+void SleepUntil(uint64_t timeNs) {
+    timespec when = {(time_t)(timeNs / 1000000000), (long)(timeNs % 1000000000)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &when, nullptr) == EINTR) {
+    }
+}
+
+// Releases frames on a vsync grid, like the runtime behind Pxr_BeginFrame().
+class FakeRuntime {
+public:
+    // Blocks until the next vsync and returns it; the frame displays one period later.
+    uint64_t BeginFrame() {
+        const uint64_t nowNs = MonotonicNs();
+        const uint64_t releaseNs = m_baseNs + ((nowNs - m_baseNs) / PeriodNs + 1) * PeriodNs;
+        SleepUntil(releaseNs);
+        return releaseNs;
+    }
+    static double DisplayTimeMs(uint64_t releaseNs) { return (releaseNs + PeriodNs) / 1e6; }
+
+private:
+    uint64_t m_baseNs = MonotonicNs();
+};
+
+struct LoopCounts {
+    uint64_t timerWakeups = 0;
+    uint64_t signalWakeups = 0;
+    uint64_t frames = 0;
+};
+
+// The app's main loop for durationNs in the given mode.
+LoopCounts RunLoop(FrameScheduler* scheduler, FakeRuntime* runtime, FrameScheduler::Mode mode, uint64_t durationNs) {
+    LoopCounts counts;
+    const uint64_t endNs = MonotonicNs() + durationNs;
+    for (uint64_t nowNs = MonotonicNs(); nowNs < endNs; nowNs = MonotonicNs()) {
+        scheduler->Arm(mode);
+        const int timeoutMs = scheduler->Due(nowNs) ? 0 : (int)((endNs - nowNs) / 1000000 + 1);
+        pollfd fds[2] = {{scheduler->TimerFd(), POLLIN, 0}, {scheduler->SignalFd(), POLLIN, 0}};
+        if (poll(fds, 2, timeoutMs) > 0) {
+            scheduler->Waited(MonotonicNs() - nowNs);
+            if (fds[0].revents & POLLIN) {
+                scheduler->OnTimer();
+                counts.timerWakeups++;
+            }
+            if (fds[1].revents & POLLIN) {
+                scheduler->OnSignal();
+                counts.signalWakeups++;
+            }
+        }
+        if (!scheduler->Due(MonotonicNs())) {
+            continue;
+        }
+        if (mode == FrameScheduler::Mode::Running) {
+            const uint64_t releaseNs = runtime->BeginFrame();
+            scheduler->OnFrameStarted(releaseNs, FakeRuntime::DisplayTimeMs(releaseNs), PeriodNs);
+            counts.frames++;
+        }
+        scheduler->WorkDone(MonotonicNs());
+    }
+    return counts;
+}
+
+bool Near(uint64_t value, double expected, double tolerance) { return std::fabs(value - expected) <= tolerance; }
+
+// Over durationNs at the given interval, every vsync has to be either a frame's or
+// counted as skipped, and a timer wakeup per frame is all it takes. A loaded host may
+// wake late now and then; those frames slip a vsync and are counted, so at least 90% of
+// them have to be on time.
+void CheckRate(FrameScheduler* scheduler, FakeRuntime* runtime, int interval, const char* name) {
+    const uint64_t durationNs = 1000000000;
+    scheduler->SetFrameInterval(interval);
+    const uint64_t skippedBefore = scheduler->SkippedVsyncs();
+    const LoopCounts counts = RunLoop(scheduler, runtime, FrameScheduler::Mode::Running, durationNs);
+    const uint64_t skipped = scheduler->SkippedVsyncs() - skippedBefore;
+    const double vsyncs = (double)durationNs / PeriodNs;
+    printf("%s: %llu timer wakeups, %llu frames, %llu skipped vsyncs in 1 s\n", name,
+           (unsigned long long)counts.timerWakeups, (unsigned long long)counts.frames, (unsigned long long)skipped);
+    Check(Near(counts.frames * interval + skipped, vsyncs, interval + 1),
+          Fmt("%s: each of the %.0f vsyncs is a frame or a counted skip", name, vsyncs));
+    Check(counts.frames >= 0.9 * vsyncs / interval, Fmt("%s: at least 90%% of %.0f frames/s", name, vsyncs / interval));
+    Check(counts.timerWakeups <= counts.frames + 1, Fmt("%s: one timer wakeup per frame", name));
+}
+
+void CheckRunning(FrameScheduler* scheduler, FakeRuntime* runtime) {
+    CheckRate(scheduler, runtime, 1, "every vsync");
+    CheckRate(scheduler, runtime, 2, "every other vsync");
+
+    // One period after a frame at interval 2 nothing is due yet; at interval 1 it is overdue.
+    const uint64_t releaseNs = runtime->BeginFrame();
+    scheduler->OnFrameStarted(releaseNs, FakeRuntime::DisplayTimeMs(releaseNs), PeriodNs);
+    scheduler->WorkDone(MonotonicNs());
+    SleepUntil(releaseNs + PeriodNs);
+    const bool dueBefore = scheduler->Due(MonotonicNs());
+    scheduler->SetFrameInterval(1);
+    Check(!dueBefore && scheduler->Due(MonotonicNs()), "SetFrameInterval(1) makes an overdue frame due at once");
+}
+
+void CheckSignal(FrameScheduler* scheduler, FakeRuntime* runtime) {
+    const int signals = 5;
+    std::thread producer([scheduler]() {
+        for (int i = 0; i < signals; i++) {
+            SleepUntil(MonotonicNs() + 40000000);
+            scheduler->Signal();
+        }
+    });
+    const LoopCounts counts = RunLoop(scheduler, runtime, FrameScheduler::Mode::Stopped, 300000000);
+    producer.join();
+    Check(counts.signalWakeups == signals && counts.timerWakeups == 0,
+          Fmt("stopped: %llu signal and %llu timer wakeups for %d Signal() calls", (unsigned long long)counts.signalWakeups,
+              (unsigned long long)counts.timerWakeups, signals));
+}
+
+void CheckIdle(FrameScheduler* scheduler, FakeRuntime* runtime) {
+    const LoopCounts counts = RunLoop(scheduler, runtime, FrameScheduler::Mode::Idle, 500000000);
+    Check(Near(counts.timerWakeups, 500000000.0 / FrameScheduler::IdleTickNs, 1),
+          Fmt("idle: %llu timer wakeups in 0.5 s at a %.0f ms tick", (unsigned long long)counts.timerWakeups,
+              FrameScheduler::IdleTickNs / 1e6));
+}
+
+// Display times alone, no clock: every gap of n periods is n - interval skipped vsyncs.
+void CheckSkippedVsyncs() {
+    FrameScheduler scheduler;
+    const int gaps[] = {1, 1, 2, 1, 4, 1, 1, 3, 1};
+    uint64_t expected = 0;
+    uint64_t startNs = 1000000000;
+    double displayMs = 2000.0;
+    scheduler.OnFrameStarted(startNs, displayMs, PeriodNs);
+    for (int gap : gaps) {
+        startNs += gap * PeriodNs;
+        displayMs += gap * PeriodNs / 1e6;
+        scheduler.OnFrameStarted(startNs, displayMs, PeriodNs);
+        expected += gap - 1;
+    }
+    Check(scheduler.SkippedVsyncs() == expected,
+          Fmt("%llu skipped vsyncs counted, %llu expected", (unsigned long long)scheduler.SkippedVsyncs(),
+              (unsigned long long)expected));
+
+    scheduler.SetFrameInterval(2);
+    const uint64_t before = scheduler.SkippedVsyncs();
+    for (int gap : {2, 2, 3, 2, 5}) {
+        startNs += gap * PeriodNs;
+        displayMs += gap * PeriodNs / 1e6;
+        scheduler.OnFrameStarted(startNs, displayMs, PeriodNs);
+    }
+    Check(scheduler.SkippedVsyncs() - before == 4, "at interval 2, only gaps beyond two periods are skips");
+}
+}  // namespace
+
+int main() {
+    Log::SetLevel(Log::Level::Warning);
+    FrameScheduler scheduler;
+    if (!scheduler.Initialize()) {
+        printf("FAILED: no timerfd/eventfd\n");
+        return 1;
+    }
+    FakeRuntime runtime;
+    CheckRunning(&scheduler, &runtime);
+    CheckSignal(&scheduler, &runtime);
+    CheckIdle(&scheduler, &runtime);
+    CheckSkippedVsyncs();
+    return g_failures == 0 ? 0 : 1;
+}
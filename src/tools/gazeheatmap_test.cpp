@@ -0,0 +1,349 @@
+// etvr_gazeheatmap_test: checks the gaze heatmap (gazeheatmap.h) against a plain reference
+// splat, computed in double cell by cell.
+//
+//     etvr_gazeheatmap_test
+//
+// Splats anywhere on the world grid, across tile edges and around the yaw seam, have to
+// leave exactly the reference heat with a mass of one, and none anywhere else: whole
+// Float4 rows run on into the tile padding and over the kernel's zero tail, and neither may
+// show. Heat on an object face is clipped to the face. After one time constant the heat is
+// e^-1 of what it was; splats far enough apart for the tiles to be rebased (past e^8) keep
+// adding up to the same decayed sum, over more time constants than a float could scale
+// by. Last, an exported PNG is decoded (chunk CRCs, inflate, the left filter) and has to
+// match the snapshot scaled to its peak.
+#include "common.h"
+#include "gazeheatmap.h"
+
+#include <random>
+#include <zlib.h>
+
+namespace {
+using Heatmap = GazeHeatmap;
+constexpr uint64_t StartNs = 1000000000000;  // far past the tiles' initial base
+constexpr double Tolerance = 1e-6;           // per cell; heat is at most ~0.1 per splat
+
+int g_failures = 0;
+
+void Check(bool condition, const std::string& what) {
+    printf("%s: %s\n", condition ? "ok" : "FAILED", what.c_str());
+    g_failures += condition ? 0 : 1;
+}
+
+// The heat a splat at cell coordinates (x, y) leaves in each cell, clipped to [x0, x1) x
+// [y0, y1) or wrapped around in x.
+class Reference {
+public:
+    Reference(int width, int height) : m_width(width), m_values((size_t)width * height) {}
+
+    void Splat(double x, double y, int x0, int y0, int x1, int y1, bool wrap, double weight) {
+        const int cellX = (int)std::floor(x);
+        const int cellY = (int)std::floor(y);
+        double kernelX[2 * Heatmap::Radius + 1], kernelY[2 * Heatmap::Radius + 1];
+        Kernel(x - cellX, kernelX);
+        Kernel(y - cellY, kernelY);
+        for (int j = 0; j <= 2 * Heatmap::Radius; j++) {
+            const int row = cellY - Heatmap::Radius + j;
+            for (int i = 0; i <= 2 * Heatmap::Radius; i++) {
+                int column = cellX - Heatmap::Radius + i;
+                if (wrap) {
+                    column = (column % m_width + m_width) % m_width;
+                } else if (column < x0 || column >= x1) {
+                    continue;
+                }
+                if (row >= y0 && row < y1) {
+                    m_values[(size_t)row * m_width + column] += weight * kernelX[i] * kernelY[j];
+                }
+            }
+        }
+    }
+    void Scale(double scale) {
+        for (double& value : m_values) {
+            value *= scale;
+        }
+    }
+
+    // Largest difference to the heatmap's values.
+    double Error(const std::vector<float>& values) const {
+        if (values.size() != m_values.size()) {
+            return 1e30;
+        }
+        double error = 0.0;
+        for (size_t i = 0; i < values.size(); i++) {
+            error = std::max(error, std::fabs(values[i] - m_values[i]));
+        }
+        return error;
+    }
+
+private:
+    // The Gaussian of the sub-cell phase the offset falls in, normalized over its taps.
+    static void Kernel(double offset, double* taps) {
+        const int phase = std::min(Heatmap::Phases - 1, (int)(offset * Heatmap::Phases));
+        const double center = (phase + 0.5) / Heatmap::Phases;
+        double sum = 0.0;
+        for (int i = 0; i <= 2 * Heatmap::Radius; i++) {
+            const double d = i - Heatmap::Radius + 0.5 - center;
+            taps[i] = std::exp(-0.5 * d * d / (Heatmap::SigmaCells * Heatmap::SigmaCells));
+            sum += taps[i];
+        }
+        for (int i = 0; i <= 2 * Heatmap::Radius; i++) {
+            taps[i] /= sum;
+        }
+    }
+
+    int m_width;
+    std::vector<double> m_values;
+};
+
+// A ray towards the world grid's cell coordinates (x, y).
+WorldGaze RayAt(double x, double y) {
+    const double yaw = (x * Heatmap::CellDegrees - 180.0) * M_PI / 180.0;
+    const double pitch = (90.0 - y * Heatmap::CellDegrees) * M_PI / 180.0;
+    WorldGaze ray = {};
+    ray.direction = {(float)(std::sin(yaw) * std::cos(pitch)), (float)std::sin(pitch),
+                     (float)(-std::cos(yaw) * std::cos(pitch))};
+    ray.valid = true;
+    return ray;
+}
+
+// Cell coordinates in the middle of a sub-cell phase, clear of rounding on the way
+// through a ray.
+double PhaseCenter(int cell, int phase) { return cell + (phase + 0.5) / Heatmap::Phases; }
+
+double Sum(const std::vector<float>& values) {
+    double sum = 0.0;
+    for (float value : values) {
+        sum += value;
+    }
+    return sum;
+}
+
+void CheckSplats() {
+    std::mt19937 rng(3);
+    Heatmap heatmap;
+    Reference reference(Heatmap::Width, Heatmap::Height);
+    // Any column, with the kernel straddling tile edges on either side; rows clear of the poles.
+    const int count = 500;
+    for (int i = 0; i < count; i++) {
+        const double x = PhaseCenter(rng() % Heatmap::Width, rng() % Heatmap::Phases);
+        const double y = PhaseCenter(Heatmap::Radius + rng() % (Heatmap::Height - 2 * Heatmap::Radius),
+                                     rng() % Heatmap::Phases);
+        heatmap.Add(RayAt(x, y), StartNs);
+        reference.Splat(x, y, 0, 0, Heatmap::Width, Heatmap::Height, true, 1.0);
+    }
+    std::vector<float> values;
+    heatmap.Snapshot(StartNs, &values);
+    const double error = reference.Error(values);
+    Check(std::fabs(Sum(values) - count) < 1e-3 && error < Tolerance,
+          Fmt("%d splats: mass %.5f, largest cell error %.2g against the reference", count, Sum(values), error));
+}
+
+void CheckSeam() {
+    bool ok = true;
+    for (double x : {PhaseCenter(0, 2), PhaseCenter(Heatmap::Width - 1, 6), PhaseCenter(2, 0),
+                     PhaseCenter(Heatmap::Width - 3, 7)}) {
+        Heatmap heatmap;
+        Reference reference(Heatmap::Width, Heatmap::Height);
+        const double y = PhaseCenter(Heatmap::Height / 2, 3);
+        heatmap.Add(RayAt(x, y), StartNs);
+        reference.Splat(x, y, 0, 0, Heatmap::Width, Heatmap::Height, true, 1.0);
+        std::vector<float> values;
+        heatmap.Snapshot(StartNs, &values);
+        const size_t row = (size_t)(Heatmap::Height / 2) * Heatmap::Width;
+        ok &= std::fabs(Sum(values) - 1.0) < 1e-5 && reference.Error(values) < Tolerance && values[row] > 0.0f &&
+              values[row + Heatmap::Width - 1] > 0.0f;
+    }
+    Check(ok, "splats at the yaw seam wrap around: unit mass, heat on both edges");
+}
+
+void CheckObjectFaces() {
+    Heatmap heatmap;
+    Reference reference(Heatmap::ObjectWidth, Heatmap::ObjectHeight);
+    // +X face, cells [0, 16) x [0, 16): u = local z across, v = local y upwards.
+    const float edges[][3] = {{1.0f, 0.0f, 0.99f}, {1.0f, 0.99f, 0.0f}, {1.0f, -0.5f, -0.97f}};
+    for (const float* local : edges) {
+        heatmap.AddObject(0, local, StartNs);
+        const double x = 0.5 * (local[2] + 1.0f) * Heatmap::FaceCells;
+        const double y = 0.5 * (1.0f - local[1]) * Heatmap::FaceCells;
+        reference.Splat(x, y, 0, 0, Heatmap::FaceCells, Heatmap::FaceCells, false, 1.0);
+    }
+    std::vector<float> values;
+    const bool found = heatmap.SnapshotObject(0, StartNs, &values) && !heatmap.SnapshotObject(1, StartNs, &values);
+    heatmap.SnapshotObject(0, StartNs, &values);
+    double elsewhere = 0.0;
+    for (int y = 0; y < Heatmap::ObjectHeight; y++) {
+        for (int x = 0; x < Heatmap::ObjectWidth; x++) {
+            if (x >= Heatmap::FaceCells || y >= Heatmap::FaceCells) {
+                elsewhere += values[(size_t)y * Heatmap::ObjectWidth + x];
+            }
+        }
+    }
+    const double error = reference.Error(values);
+    Check(found && elsewhere == 0.0 && error < Tolerance,
+          Fmt("splats at face edges stay on the face (largest cell error %.2g)", error));
+}
+
+void CheckDecay() {
+    Heatmap heatmap;
+    Reference reference(Heatmap::Width, Heatmap::Height);
+    const double x = PhaseCenter(100, 1), y = PhaseCenter(60, 5);
+    heatmap.Add(RayAt(x, y), StartNs);
+    reference.Splat(x, y, 0, 0, Heatmap::Width, Heatmap::Height, true, 1.0);
+    std::vector<float> values;
+    heatmap.Snapshot(StartNs + Heatmap::DecayNs, &values);
+    const double once = Sum(values);
+    reference.Scale(std::exp(-1.0));
+    const double error = reference.Error(values);
+    heatmap.Snapshot(StartNs + 2 * Heatmap::DecayNs, &values);
+    const double twice = Sum(values);
+    Check(std::fabs(once - std::exp(-1.0)) < 1e-6 && std::fabs(twice - std::exp(-2.0)) < 1e-6 && error < Tolerance,
+          Fmt("decay: %.6f after one time constant, %.6f after two (e^-1 = %.6f)", once, twice, std::exp(-1.0)));
+}
+
+// Splats spacing time constants apart, each scaled up to the tile's base; only rebasing
+// at e^8 keeps that from overflowing.
+void CheckRebase(double spacing) {
+    Heatmap heatmap;
+    const double x = PhaseCenter(7, 4), y = PhaseCenter(71, 0);  // across a tile edge
+    const int count = 200;
+    uint64_t timeNs = StartNs;
+    double expected = 0.0;
+    for (int i = 0; i < count; i++) {
+        timeNs = StartNs + (uint64_t)(i * spacing * Heatmap::DecayNs);
+        heatmap.Add(RayAt(x, y), timeNs);
+        expected = expected * std::exp(-spacing) + 1.0;
+    }
+    std::vector<float> values;
+    heatmap.Snapshot(timeNs, &values);
+    Reference reference(Heatmap::Width, Heatmap::Height);
+    reference.Splat(x, y, 0, 0, Heatmap::Width, Heatmap::Height, true, expected);
+    const double error = reference.Error(values);
+    Check(std::fabs(Sum(values) - expected) < 1e-5 * expected && error < Tolerance * expected,
+          Fmt("%d splats %.1f time constants apart: mass %.6f, %.6f expected", count, spacing, Sum(values), expected));
+}
+
+uint32_t GetBigEndian(const uint8_t* p) { return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]; }
+
+// Decodes an 8-bit grayscale PNG of the kind the heatmap writes. Fails on a bad CRC.
+bool DecodePng(const std::string& path, int* width, int* height, std::vector<uint8_t>* pixels) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    for (size_t n; (n = fread(buffer, 1, sizeof(buffer), file)) > 0;) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(file);
+
+    static const uint8_t Signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    if (data.size() < 8 || memcmp(data.data(), Signature, 8) != 0) {
+        return false;
+    }
+    std::vector<uint8_t> compressed;
+    bool ended = false;
+    for (size_t at = 8; !ended;) {
+        if (at + 12 > data.size()) {
+            return false;
+        }
+        const uint32_t length = GetBigEndian(&data[at]);
+        if (at + 12 + length > data.size()) {
+            return false;
+        }
+        const uint8_t* type = &data[at + 4];
+        const uint8_t* body = &data[at + 8];
+        if (crc32(0, type, 4 + length) != GetBigEndian(body + length)) {
+            return false;
+        }
+        if (memcmp(type, "IHDR", 4) == 0) {
+            if (length != 13 || body[8] != 8 || body[9] != 0 || body[10] != 0 || body[11] != 0 || body[12] != 0) {
+                return false;
+            }
+            *width = (int)GetBigEndian(body);
+            *height = (int)GetBigEndian(body + 4);
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            compressed.insert(compressed.end(), body, body + length);
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            ended = at + 12 == data.size();
+            if (!ended) {
+                return false;
+            }
+        }
+        at += 12 + length;
+    }
+
+    std::vector<uint8_t> rows((size_t)(*width + 1) * *height);
+    uLongf rowsLength = rows.size();
+    if (uncompress(rows.data(), &rowsLength, compressed.data(), compressed.size()) != Z_OK ||
+        rowsLength != rows.size()) {
+        return false;
+    }
+    pixels->resize((size_t)*width * *height);
+    for (int y = 0; y < *height; y++) {
+        const uint8_t* row = rows.data() + (size_t)y * (*width + 1);
+        if (row[0] != 1) {
+            return false;
+        }
+        uint8_t left = 0;
+        for (int x = 0; x < *width; x++) {
+            left = (uint8_t)(left + row[1 + x]);
+            (*pixels)[(size_t)y * *width + x] = left;
+        }
+    }
+    return true;
+}
+
+// The pixels a snapshot has to come out as.
+std::vector<uint8_t> Quantize(const std::vector<float>& values) {
+    const float peak = *std::max_element(values.begin(), values.end());
+    const float scale = peak > 0.0f ? 255.0f / peak : 0.0f;
+    std::vector<uint8_t> pixels(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        pixels[i] = (uint8_t)std::lround(std::min(255.0f, values[i] * scale));
+    }
+    return pixels;
+}
+
+void CheckPng() {
+    Heatmap heatmap;
+    for (int i = 0; i < 40; i++) {
+        heatmap.Add(RayAt(PhaseCenter(10 + 7 * i, i % 8), PhaseCenter(40 + i, (i * 3) % 8)),
+                    StartNs + i * 500000000ull);
+        const float local[3] = {-0.3f + 0.02f * i, 0.2f, -1.0f};
+        heatmap.AddObject(3, local, StartNs + i * 500000000ull);
+    }
+    const uint64_t timeNs = StartNs + 30000000000ull;
+    char path[] = "/tmp/etvr_gazeheatmap_test_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    std::vector<float> values;
+    std::vector<uint8_t> pixels;
+    int width = 0, height = 0;
+    heatmap.Snapshot(timeNs, &values);
+    bool ok = fd >= 0 && heatmap.Export(path, timeNs) && DecodePng(path, &width, &height, &pixels) &&
+              width == Heatmap::Width && height == Heatmap::Height && pixels == Quantize(values);
+    Check(ok, Fmt("world PNG decodes to the snapshot scaled to its peak (%dx%d)", width, height));
+
+    heatmap.SnapshotObject(3, timeNs, &values);
+    ok = fd >= 0 && heatmap.ExportObject(3, path, timeNs) && DecodePng(path, &width, &height, &pixels) &&
+         width == Heatmap::ObjectWidth && height == Heatmap::ObjectHeight && pixels == Quantize(values) &&
+         !heatmap.ExportObject(4, path, timeNs);
+    Check(ok, Fmt("object PNG decodes to the snapshot scaled to its peak (%dx%d)", width, height));
+    unlink(path);
+}
+}  // namespace
+
+int main() {
+    Log::SetLevel(Log::Level::Warning);
+    CheckSplats();
+    CheckSeam();
+    CheckObjectFaces();
+    CheckDecay();
+    CheckRebase(8.5);
+    CheckRebase(3.0);
+    CheckPng();
+    return g_failures == 0 ? 0 : 1;
+}
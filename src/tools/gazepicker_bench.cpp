@@ -0,0 +1,137 @@
+// etvr_gazepicker_bench: build and pick times of the gaze picker BVH (gazepicker.h).
+//
+//     etvr_gazepicker_bench [-r rays] [cube counts...]
+//
+// For each count (1k, 100k and 1M by default) it scatters randomly rotated and sized cubes
+// at about one per cubic meter, builds the tree and picks random rays through the scene.
+// A sample of the rays is checked against a brute-force test of every cube. The last line
+// checks that a short glance away keeps the dwell on an object.
+#include "common.h"
+#include "gazepicker.h"
+
+#include "glm/gtx/quaternion.hpp"
+
+#include <random>
+
+namespace {
+// Entry distance of the ray into one cube as a rotated box, the slow way.
+bool BruteForceHit(const Cube& cube, const glm::vec3& origin, const glm::vec3& direction, float* distance) {
+    const glm::quat inverse = glm::conjugate(
+        glm::quat(cube.Pose.orientation.w, cube.Pose.orientation.x, cube.Pose.orientation.y, cube.Pose.orientation.z));
+    const glm::vec3 o = inverse * (origin - glm::vec3(cube.Pose.position.x, cube.Pose.position.y, cube.Pose.position.z));
+    const glm::vec3 d = inverse * direction;
+    const glm::vec3 half(0.5f * cube.Scale.x, 0.5f * cube.Scale.y, 0.5f * cube.Scale.z);
+    float near = 0.0f;
+    float far = 1e30f;
+    for (int axis = 0; axis < 3; axis++) {
+        if (std::fabs(d[axis]) < 1e-12f) {
+            if (o[axis] < -half[axis] || o[axis] > half[axis]) {
+                return false;
+            }
+            continue;
+        }
+        const float t1 = (-half[axis] - o[axis]) / d[axis];
+        const float t2 = (half[axis] - o[axis]) / d[axis];
+        near = std::max(near, std::min(t1, t2));
+        far = std::min(far, std::max(t1, t2));
+    }
+    *distance = near;
+    return near <= far;
+}
+
+bool RunScene(size_t count, size_t rayCount, std::mt19937* rng) {
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    const float side = std::cbrt((float)count);
+    std::vector<Cube> cubes(count);
+    for (Cube& cube : cubes) {
+        const glm::quat q = glm::normalize(glm::quat(uniform(*rng), uniform(*rng), uniform(*rng), uniform(*rng)));
+        const float size = 0.1f + 0.3f * (uniform(*rng) + 1.0f);
+        cube.Pose = {{q.x, q.y, q.z, q.w}, {uniform(*rng) * side, uniform(*rng) * side, uniform(*rng) * side}};
+        cube.Scale = {size, size, size};
+    }
+
+    GazePicker picker;
+    uint64_t startNs = MonotonicNs();
+    picker.Build(cubes);
+    const double buildMs = (MonotonicNs() - startNs) / 1e6;
+
+    std::vector<WorldGaze> rays(rayCount);
+    for (WorldGaze& ray : rays) {
+        const glm::vec3 d = glm::normalize(glm::vec3(uniform(*rng), uniform(*rng), uniform(*rng)));
+        ray = {{uniform(*rng) * side, uniform(*rng) * side, uniform(*rng) * side}, {d.x, d.y, d.z}, true};
+    }
+    std::vector<GazeHit> hits(rayCount);
+    startNs = MonotonicNs();
+    picker.Pick(rays.data(), rays.size(), hits.data());
+    const double usPerRay = (MonotonicNs() - startNs) / 1e3 / rayCount;
+
+    // Ties between overlapping cubes may go either way; the distance has to agree.
+    const size_t checks = std::min(rayCount, count <= 100000 ? (size_t)300 : (size_t)20);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < checks; i++) {
+        const glm::vec3 origin(rays[i].origin.x, rays[i].origin.y, rays[i].origin.z);
+        const glm::vec3 direction(rays[i].direction.x, rays[i].direction.y, rays[i].direction.z);
+        int32_t best = -1;
+        float bestDistance = 1e30f;
+        for (size_t k = 0; k < count; k++) {
+            float distance;
+            if (BruteForceHit(cubes[k], origin, direction, &distance) && distance < bestDistance) {
+                bestDistance = distance;
+                best = (int32_t)k;
+            }
+        }
+        const bool same = best == hits[i].object ||
+                          (best >= 0 && hits[i].object >= 0 && std::fabs(bestDistance - hits[i].distance) < 1e-4f);
+        mismatches += same ? 0 : 1;
+    }
+
+    // One ray per sample at 1 kHz.
+    printf("%8zu cubes: build %7.1f ms | pick %5.2f us/ray, %.3f%% of a core at 1 kHz | %zu/%zu match brute force\n",
+           count, buildMs, usPerRay, usPerRay / 10.0, checks - mismatches, checks);
+    return mismatches == 0;
+}
+
+bool CheckDwell() {
+    const std::vector<Cube> cubes = {Cube{{{0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -2.0f}}, {1.0f, 1.0f, 1.0f}}};
+    GazePicker picker;
+    picker.Build(cubes);
+    const WorldGaze on = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, true};
+    const WorldGaze away = {{0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, true};
+    // 120 Hz samples for 0.83 s with a 42 ms glance away in the middle.
+    GazeHit hit = {};
+    for (int i = 0; i < 100; i++) {
+        hit = picker.Track(i >= 40 && i < 45 ? away : on, 1000000000ull + i * 8333333ull);
+    }
+    const bool ok = hit.object == 0 && hit.dwellNs == 99 * 8333333ull;
+    printf("dwell through a short glance away: %.0f ms (%s)\n", hit.dwellNs / 1e6, ok ? "ok" : "FAILED");
+    return ok;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Log::SetLevel(Log::Level::Warning);
+    size_t rayCount = 20000;
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-r" && i + 1 < argc) {
+            rayCount = std::max(1ull, strtoull(argv[++i], nullptr, 10));
+        } else if (!arg.empty() && isdigit((unsigned char)arg[0])) {
+            counts.push_back(std::max(1ull, strtoull(arg.c_str(), nullptr, 10)));
+        } else {
+            fprintf(stderr, "usage: etvr_gazepicker_bench [-r rays] [cube counts...]\n");
+            return 2;
+        }
+    }
+    if (counts.empty()) {
+        counts = {1000, 100000, 1000000};
+    }
+
+    std::mt19937 rng(1);
+    bool ok = true;
+    for (size_t count : counts) {
+        ok &= RunScene(count, rayCount, &rng);
+    }
+    ok &= CheckDwell();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+// etvr_gazeshm_bench: hand-off latency of the shared memory gaze ring (gazeshm.h) to
+// several reader processes.
+//
+//     etvr_gazeshm_bench [-r readers] [-n samples] [-hz rate]
+//
+// The parent publishes through GazePublisher, as the app does, stamping each sample with
+// CLOCK_MONOTONIC right before Publish(). Forked readers connect over the socket, poll
+// gaze_shm_read() and take the difference to their own clock on receipt, so the latency
+// covers the whole path from the writer to another process. Readers that poll a core of
+// their own see the best case; with fewer cores than processes the scheduler dominates.
+//
+// Before that it checks that a slot left odd by a dead writer makes readers give up
+// instead of spinning.
+#include "common.h"
+#include "gazepublisher.h"
+
+#include <sched.h>
+#include <sys/wait.h>
+
+namespace {
+struct ReaderResult {
+    uint64_t received;
+    uint32_t lost;
+    uint32_t stalls;
+    uint64_t p50Ns;
+    uint64_t p99Ns;
+    uint64_t maxNs;
+    double readNsPerSample;  // time in gaze_shm_read() per sample it returned
+};
+
+uint64_t Percentile(std::vector<uint64_t>* values, double fraction) {
+    if (values->empty()) {
+        return 0;
+    }
+    const size_t i = std::min(values->size() - 1, (size_t)(fraction * values->size()));
+    std::nth_element(values->begin(), values->begin() + i, values->end());
+    return (*values)[i];
+}
+
+bool CheckDeadWriter() {
+    std::unique_ptr<GazeShmRing> ring(new GazeShmRing());
+    memset(ring.get(), 0, sizeof(GazeShmRing));
+    ring->head = 1;
+    ring->slots[0].seq = 1;  // the writer died inside slot 0
+    GazeSample sample;
+    uint32_t cursor = 0;
+    int stalled = 0;
+    const uint64_t startNs = MonotonicNs();
+    const int latest = gaze_shm_read_latest(ring.get(), &sample);
+    const uint32_t count = gaze_shm_read_ex(ring.get(), &cursor, &sample, 1, nullptr, &stalled);
+    const double us = (MonotonicNs() - startNs) / 1e3;
+    const bool ok = latest == 0 && count == 0 && stalled == 1 && cursor == 0;
+    printf("dead writer: readers gave up in %.1f us (%s)\n", us, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+void RunReader(const char* socketName, uint64_t samples, int readyFd, int resultFd) {
+    const GazeShmRing* ring = gaze_shm_connect(socketName);
+    char byte = ring != nullptr ? 1 : 0;
+    if (write(readyFd, &byte, 1) != 1 || ring == nullptr) {
+        _exit(1);
+    }
+    std::vector<uint64_t> latencies;
+    latencies.reserve(samples);
+    ReaderResult result = {};
+    uint64_t readNs = 0;
+    uint32_t cursor = 0;
+    GazeSample batch[16];
+    const uint64_t deadlineNs = MonotonicNs() + 60000000000ull;
+    while (cursor < samples && MonotonicNs() < deadlineNs) {
+        int stalled = 0;
+        const uint64_t t0 = MonotonicNs();
+        const uint32_t n = gaze_shm_read_ex(ring, &cursor, batch, 16, &result.lost, &stalled);
+        const uint64_t t1 = MonotonicNs();
+        result.stalls += stalled;
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        readNs += t1 - t0;
+        for (uint32_t i = 0; i < n; i++) {
+            latencies.push_back(t1 > batch[i].timestampNs ? t1 - batch[i].timestampNs : 0);
+        }
+        result.received += n;
+    }
+    result.readNsPerSample = result.received != 0 ? (double)readNs / result.received : 0.0;
+    result.p50Ns = Percentile(&latencies, 0.5);
+    result.p99Ns = Percentile(&latencies, 0.99);
+    result.maxNs = latencies.empty() ? 0 : *std::max_element(latencies.begin(), latencies.end());
+    gaze_shm_disconnect(ring);
+    _exit(write(resultFd, &result, sizeof(result)) == (ssize_t)sizeof(result) ? 0 : 1);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Log::SetLevel(Log::Level::Warning);
+    int readers = 4;
+    uint64_t samples = 100000;
+    double rateHz = 1000.0;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-r" && i + 1 < argc) {
+            readers = std::max(1, atoi(argv[++i]));
+        } else if (arg == "-n" && i + 1 < argc) {
+            samples = std::max(1ull, strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "-hz" && i + 1 < argc) {
+            rateHz = std::max(1.0, atof(argv[++i]));
+        } else {
+            fprintf(stderr, "usage: etvr_gazeshm_bench [-r readers] [-n samples] [-hz rate]\n");
+            return 2;
+        }
+    }
+    if (!CheckDeadWriter()) {
+        return 1;
+    }
+
+    const std::string socketName = Fmt("etvr.gaze.bench.%d", (int)getpid());
+    GazePublisher publisher;
+    if (!publisher.Start(socketName.c_str())) {
+        return 1;
+    }
+    int ready[2];
+    int results[2];
+    if (pipe(ready) != 0 || pipe(results) != 0) {
+        return 1;
+    }
+    std::vector<pid_t> children;
+    for (int i = 0; i < readers; i++) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            RunReader(socketName.c_str(), samples, ready[1], results[1]);
+        }
+        children.push_back(pid);
+    }
+    for (int i = 0; i < readers; i++) {
+        char byte = 0;
+        if (read(ready[0], &byte, 1) != 1 || byte != 1) {
+            fprintf(stderr, "a reader could not connect\n");
+            return 1;
+        }
+    }
+
+    const uint64_t periodNs = (uint64_t)(1e9 / rateHz);
+    uint64_t publishNs = 0;
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    GazeSample sample = {};
+    for (uint64_t i = 0; i < samples; i++) {
+        next.tv_nsec += (long)periodNs;
+        while (next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        sample.timestampNs = MonotonicNs();
+        publisher.Publish(sample);
+        publishNs += MonotonicNs() - sample.timestampNs;
+    }
+
+    bool failed = false;
+    printf("%d readers, %llu samples at %.0f Hz, %ld cores; Publish() %.0f ns\n", readers, (unsigned long long)samples,
+           rateHz, sysconf(_SC_NPROCESSORS_ONLN), (double)publishNs / samples);
+    for (int i = 0; i < readers; i++) {
+        ReaderResult result = {};
+        if (read(results[0], &result, sizeof(result)) != (ssize_t)sizeof(result)) {
+            failed = true;
+            continue;
+        }
+        printf("reader %d: received %llu lost %u stalls %u | latency p50 %.2f us p99 %.2f us max %.1f us | read %.0f ns/sample\n",
+               i, (unsigned long long)result.received, result.lost, result.stalls, result.p50Ns / 1e3,
+               result.p99Ns / 1e3, result.maxNs / 1e3, result.readNsPerSample);
+        failed |= result.received + result.lost < samples;
+    }
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    publisher.Stop();
+    return failed ? 1 : 0;
+}
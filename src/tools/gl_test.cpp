@@ -0,0 +1,336 @@
+// etvr_gl_test: drives the GLES plugin on a headless context and checks the GL calls it
+// makes, as counted by the wrapper layer in glcalls.h, and that every depth format and
+// load/store combination renders into a complete framebuffer with the expected clears
+// and invalidates.
+//
+//     etvr_gl_test [-v]
+//
+// Needs an EGL with the surfaceless platform (Mesa's llvmpipe will do); without one it
+// exits with 77, which ctest reports as skipped. With -v it prints the calls of one
+// steady-state frame by function.
+#include "common.h"
+#include "glcalls.h"
+#include "graphicsplugin.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace {
+constexpr int SkipExitCode = 77;
+constexpr GLsizei ImageSize = 64;
+constexpr uint32_t ImageCount = 3;
+
+int g_failures = 0;
+
+void Check(bool condition, const std::string& what) {
+    printf("%s: %s\n", condition ? "ok" : "FAILED", what.c_str());
+    g_failures += condition ? 0 : 1;
+}
+
+bool MakeHeadlessContext() {
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (getPlatformDisplay == nullptr || clientExtensions == nullptr ||
+        strstr(clientExtensions, "EGL_MESA_platform_surfaceless") == nullptr) {
+        return false;
+    }
+    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_ES_API)) {
+        return false;
+    }
+    const EGLint contextAttribs[] = {EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 2, EGL_NONE};
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+    return context != EGL_NO_CONTEXT && eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+}
+
+// Stand-ins for the swapchain images the runtime would hand out.
+void CreateImages(uint64_t* images) {
+    for (uint32_t i = 0; i < ImageCount; i++) {
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, ImageSize, ImageSize);
+        images[i] = texture;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+using Counts = std::vector<uint64_t>;
+
+Counts Snapshot() {
+    Counts counts(GlCalls::IdCount);
+    for (uint16_t id = 0; id < GlCalls::IdCount; id++) {
+        counts[id] = GlCalls::Calls((GlCalls::Id)id);
+    }
+    return counts;
+}
+
+uint64_t Sum(const Counts& from, const Counts& to) {
+    uint64_t sum = 0;
+    for (size_t id = 0; id < from.size(); id++) {
+        sum += to[id] - from[id];
+    }
+    return sum;
+}
+
+uint64_t Delta(const Counts& from, const Counts& to, GlCalls::Id id) { return to[id] - from[id]; }
+
+// RGBA8 of one pixel of a swapchain image.
+uint32_t ReadPixel(uint64_t image, GLint x, GLint y) {
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, (GLuint)image, 0);
+    uint8_t rgba[4] = {};
+    glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    return (uint32_t)rgba[0] << 24 | (uint32_t)rgba[1] << 16 | (uint32_t)rgba[2] << 8 | rgba[3];
+}
+
+struct Frame {
+    PxrProjectionView views[PXR_EYE_MAX];
+    std::vector<Cube> cubes;
+};
+
+Frame MakeFrame(GLsizei width, GLsizei height) {
+    Frame frame = {};
+    for (PxrProjectionView& view : frame.views) {
+        view.pose.orientation.w = 1.0f;
+        view.fov = {-0.785f, 0.785f, 0.785f, -0.785f};
+        view.imageRect = {0, 0, width, height};
+    }
+    frame.views[PXR_EYE_RIGHT].pose.position.x = 0.064f;
+    for (int i = 0; i < 8; i++) {
+        Cube cube;
+        cube.Pose = {};
+        cube.Pose.orientation.w = 1.0f;
+        cube.Pose.position = {(i % 4 - 1.5f) * 0.3f, (i / 4 - 0.5f) * 0.3f, -2.0f};
+        cube.Scale = {0.2f, 0.2f, 0.2f};
+        frame.cubes.push_back(cube);
+    }
+    return frame;
+}
+
+// Renders one frame and returns the calls made for each eye.
+void Render(IGraphicsPlugin* plugin, const Frame& frame, uint32_t imageIndex, uint64_t eyeCalls[PXR_EYE_MAX]) {
+    plugin->BeginFrame();
+    for (int eye = 0; eye < PXR_EYE_MAX; eye++) {
+        const uint64_t before = GlCalls::Total();
+        plugin->RenderView_N((PxrEyeType)eye, frame.views, imageIndex, frame.cubes, 1);
+        eyeCalls[eye] = GlCalls::Total() - before;
+    }
+    plugin->EndFrame();
+}
+
+void CheckCallCounts(IGraphicsPlugin* plugin, const uint64_t images[PXR_EYE_MAX][ImageCount], bool verbose) {
+    const Frame frame = MakeFrame(ImageSize, ImageSize);
+    uint64_t eyeCalls[PXR_EYE_MAX];
+    for (uint32_t i = 0; i < ImageCount; i++) {
+        Render(plugin, frame, i, eyeCalls);
+    }
+
+    const uint64_t totalBefore = GlCalls::Total();
+    Counts before = Snapshot();
+    Render(plugin, frame, 0, eyeCalls);
+    Counts after = Snapshot();
+    const uint64_t frameCalls = GlCalls::Total() - totalBefore;
+    Check(Sum(before, after) == frameCalls && frameCalls > eyeCalls[PXR_EYE_LEFT] + eyeCalls[PXR_EYE_RIGHT],
+          "per-function counts add up to the total");
+    Check(Delta(before, after, GlCalls::glDrawElementsInstanced) == PXR_EYE_MAX, "one instanced draw per eye");
+    Check(Delta(before, after, GlCalls::glBufferSubData) + Delta(before, after, GlCalls::glMapBufferRange) <= 1,
+          "instances are uploaded once for both eyes");
+    Check(eyeCalls[PXR_EYE_RIGHT] < eyeCalls[PXR_EYE_LEFT],
+          Fmt("the second eye makes fewer calls (%llu vs %llu)", (unsigned long long)eyeCalls[PXR_EYE_RIGHT],
+              (unsigned long long)eyeCalls[PXR_EYE_LEFT]));
+    if (verbose) {
+        for (uint16_t id = 0; id < GlCalls::IdCount; id++) {
+            if (after[id] != before[id]) {
+                printf("    %-32s %llu\n", GlCalls::Name((GlCalls::Id)id), (unsigned long long)(after[id] - before[id]));
+            }
+        }
+    }
+
+    bool steady = true;
+    for (uint32_t frameIndex = 1; frameIndex < 10; frameIndex++) {
+        const uint64_t start = GlCalls::Total();
+        Render(plugin, frame, frameIndex % ImageCount, eyeCalls);
+        steady &= GlCalls::Total() - start == frameCalls;
+    }
+    Check(steady, Fmt("every frame makes the same %llu calls", (unsigned long long)frameCalls));
+    Check(glGetError() == GL_NO_ERROR, "no GL errors");
+
+    // The clear color in a corner, the cube just below and left of the center on top.
+    const uint64_t image = images[PXR_EYE_LEFT][9 % ImageCount];
+    Check(ReadPixel(image, 0, 0) == 0x2f4f4fff, "background is cleared");
+    Check(ReadPixel(image, ImageSize / 2 - 4, ImageSize / 2 - 4) != 0x2f4f4fff, "cubes are drawn");
+
+    // Swapchain setup goes through the same layer: three framebuffers per eye plus the
+    // scaled target, each checked for completeness once.
+    before = Snapshot();
+    plugin->SetSwapchainImages(PXR_EYE_LEFT, images[PXR_EYE_LEFT], ImageCount, 1);
+    after = Snapshot();
+    Check(Delta(before, after, GlCalls::glCheckFramebufferStatus) == ImageCount + 1,
+          "framebuffer (re)builds are counted");
+}
+
+// Views below the swapchain size are upscaled in EndFrame() under a timer of their own;
+// full-size views are not, so their upscale time drops back to 0.
+void CheckUpscale(IGraphicsPlugin* plugin, const uint64_t images[PXR_EYE_MAX][ImageCount]) {
+    Frame frame = MakeFrame(ImageSize / 2, ImageSize / 2);
+    uint64_t eyeCalls[PXR_EYE_MAX];
+    Counts before = Snapshot();
+    for (uint32_t i = 0; i < 2 * ImageCount; i++) {
+        Render(plugin, frame, i % ImageCount, eyeCalls);
+        glFinish();
+    }
+    Counts after = Snapshot();
+    Check(Delta(before, after, GlCalls::glBlitFramebuffer) == 2 * ImageCount * PXR_EYE_MAX, "one upscale per eye");
+    // The cube below and left of the center, stretched from the quarter-size rect.
+    Check(ReadPixel(images[PXR_EYE_LEFT][0], ImageSize / 2 - 4, ImageSize / 2 - 4) != 0x2f4f4fff,
+          "upscaled image has the cubes");
+    if (plugin->GpuFrameTimeNs() == 0) {
+        printf("skipped: no timer queries\n");
+        return;
+    }
+    Check(plugin->GpuUpscaleTimeNs() > 0 && plugin->GpuUpscaleTimeNs() < plugin->GpuFrameTimeNs(),
+          Fmt("upscale is timed apart (%.1f of %.1f us)", plugin->GpuUpscaleTimeNs() / 1e3,
+              plugin->GpuFrameTimeNs() / 1e3));
+
+    frame = MakeFrame(ImageSize, ImageSize);
+    for (uint32_t i = 0; i < 2 * ImageCount; i++) {
+        Render(plugin, frame, i % ImageCount, eyeCalls);
+        glFinish();
+    }
+    Check(plugin->GpuUpscaleTimeNs() == 0, "full-size views are not upscaled");
+}
+
+const char* DepthFormatName(DepthFormat format) {
+    switch (format) {
+        case DepthFormat::D16: return "D16";
+        case DepthFormat::D32F: return "D32F";
+        default: return "D24";
+    }
+}
+
+// The framebuffer the plugin left bound after a view is the one it rendered into.
+void CheckBoundFramebuffer(DepthFormat format) {
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    GLint depthBits = 0;
+    GLint depthType = 0;
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE,
+                                          &depthBits);
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                          GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE, &depthType);
+    const GLint expectedBits = format == DepthFormat::D16 ? 16 : format == DepthFormat::D24 ? 24 : 32;
+    const GLint expectedType = format == DepthFormat::D32F ? GL_FLOAT : GL_UNSIGNED_NORMALIZED;
+    Check(status == GL_FRAMEBUFFER_COMPLETE && depthBits == expectedBits && depthType == expectedType,
+          Fmt("%s framebuffer is complete with a %d-bit depth attachment", DepthFormatName(format), depthBits));
+}
+
+void CheckDepthFormats(IGraphicsPlugin* plugin, const uint64_t images[PXR_EYE_MAX][ImageCount]) {
+    const Frame frame = MakeFrame(ImageSize, ImageSize);
+    // The second frame renders a partial rect, so the scaled target and blit run as well.
+    Frame scaled = frame;
+    for (PxrProjectionView& view : scaled.views) {
+        view.imageRect = {0, 0, ImageSize / 2, ImageSize / 2};
+    }
+    uint64_t eyeCalls[PXR_EYE_MAX];
+    for (DepthFormat format : {DepthFormat::D16, DepthFormat::D24, DepthFormat::D32F}) {
+        RenderPassActions actions;
+        actions.depthFormat = format;
+        plugin->SetRenderPassActions(actions);
+        for (int eye = 0; eye < PXR_EYE_MAX; eye++) {
+            plugin->SetSwapchainImages((PxrEyeType)eye, images[eye], ImageCount, 1);
+        }
+        Render(plugin, frame, 0, eyeCalls);
+        CheckBoundFramebuffer(format);
+        Render(plugin, scaled, 1, eyeCalls);
+        // After the upscale blit the scaled target is still the read framebuffer.
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        Check(glGetError() == GL_NO_ERROR, Fmt("%s renders without GL errors", DepthFormatName(format)));
+    }
+    plugin->SetRenderPassActions(RenderPassActions());
+    for (int eye = 0; eye < PXR_EYE_MAX; eye++) {
+        plugin->SetSwapchainImages((PxrEyeType)eye, images[eye], ImageCount, 1);
+    }
+}
+
+// Every combination of load and store actions: one glClear for whatever is cleared, one
+// invalidate at the start for what is don't-care and one at the end for what is not stored.
+void CheckRenderPassActions(IGraphicsPlugin* plugin, const uint64_t images[PXR_EYE_MAX][ImageCount]) {
+    const Frame frame = MakeFrame(ImageSize, ImageSize);
+    const LoadAction loads[] = {LoadAction::Load, LoadAction::Clear, LoadAction::DontCare};
+    const StoreAction stores[] = {StoreAction::Store, StoreAction::DontCare};
+    int mismatches = 0;
+    bool drawn = true;
+    for (LoadAction colorLoad : loads) {
+        for (LoadAction depthLoad : loads) {
+            for (StoreAction colorStore : stores) {
+                for (StoreAction depthStore : stores) {
+                    RenderPassActions actions;
+                    actions.colorLoad = colorLoad;
+                    actions.depthLoad = depthLoad;
+                    actions.colorStore = colorStore;
+                    actions.depthStore = depthStore;
+                    plugin->SetRenderPassActions(actions);
+
+                    const Counts before = Snapshot();
+                    plugin->BeginFrame();
+                    plugin->RenderView_N(PXR_EYE_LEFT, frame.views, 2, frame.cubes, 1);
+                    const Counts after = Snapshot();
+                    plugin->EndFrame();
+
+                    const uint64_t clears = colorLoad == LoadAction::Clear || depthLoad == LoadAction::Clear ? 1 : 0;
+                    const uint64_t invalidates =
+                        (colorLoad == LoadAction::DontCare || depthLoad == LoadAction::DontCare ? 1 : 0) +
+                        (colorStore == StoreAction::DontCare || depthStore == StoreAction::DontCare ? 1 : 0);
+                    if (Delta(before, after, GlCalls::glClear) != clears ||
+                        Delta(before, after, GlCalls::glInvalidateFramebuffer) != invalidates ||
+                        glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                        printf("    load %d/%d store %d/%d: %llu clears, %llu invalidates\n", (int)colorLoad,
+                               (int)depthLoad, (int)colorStore, (int)depthStore,
+                               (unsigned long long)Delta(before, after, GlCalls::glClear),
+                               (unsigned long long)Delta(before, after, GlCalls::glInvalidateFramebuffer));
+                        mismatches++;
+                    }
+                    // A clear-and-store pass must keep what was drawn.
+                    if (colorLoad == LoadAction::Clear && depthLoad == LoadAction::Clear &&
+                        colorStore == StoreAction::Store) {
+                        drawn &= ReadPixel(images[PXR_EYE_LEFT][2], 0, 0) == 0x2f4f4fff &&
+                                 ReadPixel(images[PXR_EYE_LEFT][2], ImageSize / 2 - 4, ImageSize / 2 - 4) != 0x2f4f4fff;
+                    }
+                }
+            }
+        }
+    }
+    plugin->SetRenderPassActions(RenderPassActions());
+    Check(mismatches == 0, "all 36 load/store combinations clear and invalidate as asked");
+    Check(drawn, "cleared and stored passes keep the image");
+    Check(glGetError() == GL_NO_ERROR, "no GL errors");
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Log::SetLevel(Log::Level::Warning);
+    const bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+    if (!MakeHeadlessContext()) {
+        printf("skipped: no surfaceless EGL\n");
+        return SkipExitCode;
+    }
+    printf("%s, %s\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+
+    std::shared_ptr<IGraphicsPlugin> plugin = CreateGraphicsPlugin_OpenGLES();
+    plugin->InitializeDevice();
+    uint64_t images[PXR_EYE_MAX][ImageCount];
+    for (int eye = 0; eye < PXR_EYE_MAX; eye++) {
+        CreateImages(images[eye]);
+        plugin->SetSwapchainImages((PxrEyeType)eye, images[eye], ImageCount, 1);
+    }
+
+    CheckCallCounts(plugin.get(), images, verbose);
+    CheckUpscale(plugin.get(), images);
+    CheckDepthFormats(plugin.get(), images);
+    CheckRenderPassActions(plugin.get(), images);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,5 @@
+// Host builds only. The Pico headers include <jni.h> for the one jobject parameter of
+// Pxr_GetLayerAndroidSurface(), which the tools never call.
+#pragma once
+
+typedef void* jobject;
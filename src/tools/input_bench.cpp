@@ -0,0 +1,150 @@
+// etvr_input_bench: runtime calls and time per InputSystem::Update() (inputsystem.h) against a
+// stand-in PXR input layer with both controllers connected.
+//
+//     etvr_input_bench [-n updates] [-cost ns]
+//
+// Frames where nothing changes, where a button and the trigger change on every frame,
+// where the runtime reports a controller change every frame, and with the runtime input
+// event path, are compared with invalidating every frame, which makes the calls the app
+// used to make (capabilities, connection and input state of both hands every frame). Each
+// stand-in runtime call can be made to spin for a given cost, to weigh the calls saved
+// against the work of diffing snapshots. The runtime calls and events per update are
+// checked against what each case has to cost.
+#include "common.h"
+#include "inputsystem.h"
+
+namespace {
+class FakeInputDevice : public IInputDevice {
+public:
+    explicit FakeInputDevice(uint64_t callCostNs) : m_callCostNs(callCostNs) {
+        for (PxrControllerInputState& state : m_states) {
+            state = {};
+            state.batteryValue = 5;
+        }
+    }
+
+    int GetCapabilities(uint32_t /*hand*/, PxrControllerCapability* capability) override {
+        Call();
+        *capability = {};
+        capability->Dof = PXR_CONTROLLER_6DOF;
+        return PXR_RET_SUCCESS;
+    }
+    int GetConnectStatus(uint32_t /*hand*/) override {
+        Call();
+        return 1;
+    }
+    int GetInputState(uint32_t hand, PxrControllerInputState* state) override {
+        Call();
+        *state = m_states[hand];
+        return PXR_RET_SUCCESS;
+    }
+    int GetInputEvent(uint32_t /*hand*/, PxrControllerInputEvent* event) override {
+        Call();
+        *event = {};
+        return PXR_RET_SUCCESS;
+    }
+    int SetInputEventCallback(bool /*enable*/) override { return PXR_RET_SUCCESS; }
+    int SetVibration(uint32_t /*hand*/, float /*strength*/, int /*durationMs*/) override { return PXR_RET_SUCCESS; }
+
+    PxrControllerInputState& State(uint32_t hand) { return m_states[hand]; }
+    uint64_t Calls() const { return m_calls; }
+
+private:
+    void Call() {
+        m_calls++;
+        if (m_callCostNs != 0) {
+            const uint64_t endNs = MonotonicNs() + m_callCostNs;
+            while (MonotonicNs() < endNs) {
+            }
+        }
+    }
+
+    uint64_t m_callCostNs;
+    uint64_t m_calls = 0;
+    PxrControllerInputState m_states[PXR_CONTROLLER_COUNT];
+};
+
+enum class Case { Unchanged, Edges, ControllerChanged, EventCallback, Invalidated };
+
+struct Result {
+    double ns = 0.0;
+    double calls = 0.0;
+    double events = 0.0;
+};
+
+Result Run(Case which, int updates, uint64_t callCostNs) {
+    auto device = std::make_shared<FakeInputDevice>(callCostNs);
+    InputSystem input(device);
+    input.SetUseInputEventCallback(which == Case::EventCallback);
+    input.OnResume();
+    input.Update();  // connects both controllers
+
+    PxrEventDataControllerChanged changed = {};
+    changed.type = PXR_TYPE_EVENT_DATA_CONTROLLER;
+    const uint64_t callsBefore = device->Calls();
+    const uint64_t eventsBefore = input.GetStats().events;
+    const uint64_t startNs = MonotonicNs();
+    for (int i = 0; i < updates; i++) {
+        switch (which) {
+            case Case::Edges: {
+                PxrControllerInputState& state = device->State(PXR_CONTROLLER_RIGHT);
+                state.AXValue = (i + 1) & 1;
+                state.triggerValue = i & 1 ? 0.25f : 0.75f;
+                break;
+            }
+            case Case::ControllerChanged:
+                changed.controller = (uint8_t)(i % PXR_CONTROLLER_COUNT);
+                input.OnControllerChanged(changed);
+                break;
+            case Case::Invalidated: input.Invalidate(); break;
+            default: break;
+        }
+        input.Update();
+    }
+    Result result;
+    result.ns = (double)(MonotonicNs() - startNs) / updates;
+    result.calls = (double)(device->Calls() - callsBefore) / updates;
+    result.events = (double)(input.GetStats().events - eventsBefore) / updates;
+    return result;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Log::SetLevel(Log::Level::Warning);
+    int updates = 1000000;
+    uint64_t callCostNs = 0;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            updates = std::max(1, atoi(argv[++i]));
+        } else if (arg == "-cost" && i + 1 < argc) {
+            callCostNs = (uint64_t)std::max(0, atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "usage: etvr_input_bench [-n updates] [-cost ns]\n");
+            return 2;
+        }
+    }
+
+    struct {
+        Case which;
+        const char* name;
+        double calls;   // runtime calls per update it has to take
+        double events;  // and events per update
+    } const cases[] = {
+        {Case::Unchanged, "nothing changes", 2.0, 0.0},
+        {Case::Edges, "button and trigger edges", 2.0, 2.0},
+        {Case::ControllerChanged, "controller changed", 4.0, 0.0},
+        {Case::EventCallback, "runtime event path", 4.0, 0.0},
+        {Case::Invalidated, "invalidated (per-frame queries)", 6.0, 0.0},
+    };
+    printf("%d updates, %llu ns per runtime call\n", updates, (unsigned long long)callCostNs);
+    bool ok = true;
+    for (const auto& c : cases) {
+        const Result result = Run(c.which, updates, callCostNs);
+        const bool expected = result.calls == c.calls && result.events == c.events;
+        ok &= expected;
+        printf("%-32s %8.1f ns/update %4.1f runtime calls/update %4.1f events/update (%s)\n", c.name, result.ns,
+               result.calls, result.events, expected ? "ok" : "FAILED");
+    }
+    return ok ? 0 : 1;
+}
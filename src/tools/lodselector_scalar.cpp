@@ -0,0 +1,20 @@
+// The LOD selector once more on the plain loops of simd4.h, under other names so it links
+// beside the vector build; lodselector_test.cpp checks that both pick the same LODs.
+#define SIMD4_SCALAR
+#define Simd SimdScalar
+#define LodSelector ScalarLodSelector
+#include "lodselector.cpp"
+#undef LodSelector
+#undef Simd
+
+namespace {
+ScalarLodSelector g_selector;
+}  // namespace
+
+void ScalarSetLods(const uint32_t* triangleCounts, uint32_t lodCount, uint32_t baselineTriangles) {
+    g_selector.SetLods(triangleCounts, lodCount, baselineTriangles);
+}
+
+void ScalarSelect(std::vector<Cube>& cubes, const PxrVector3f& origin, const PxrVector3f& direction) {
+    g_selector.Select(cubes, origin, direction);
+}
@@ -0,0 +1,211 @@
+// etvr_lodselector_test: checks the gaze driven LOD selection (lodselector.h) with four
+// LODs on synthetic scenes.
+//
+//     etvr_lodselector_test
+//
+// Single cubes are looked at from chosen eccentricities, found by inverting the demand
+// formula, and get the LOD the thresholds call for: coarser further from the gaze, finer
+// when bigger. A demand swinging inside the hysteresis band of a threshold keeps its LOD,
+// one leaving the band switches it. Last, a scene of a thousand cubes under a wandering
+// gaze is run through the vector build and the plain loop build of the selector
+// (lodselector_scalar.cpp), which have to pick the same LOD for every cube in every frame.
+#include "common.h"
+#include "lodselector.h"
+
+#include "glm/gtx/quaternion.hpp"
+
+#include <random>
+
+void ScalarSetLods(const uint32_t* triangleCounts, uint32_t lodCount, uint32_t baselineTriangles);
+void ScalarSelect(std::vector<Cube>& cubes, const PxrVector3f& origin, const PxrVector3f& direction);
+
+namespace {
+constexpr uint32_t LodCount = MaxMeshLods;
+constexpr uint32_t LodTriangles[LodCount] = {768, 192, 48, 12};
+constexpr float BoundingRadius = 0.8660254f;
+const PxrVector3f Origin = {0.0f, 0.0f, 0.0f};
+
+int g_failures = 0;
+
+void Check(bool condition, const std::string& what) {
+    printf("%s: %s\n", condition ? "ok" : "FAILED", what.c_str());
+    g_failures += condition ? 0 : 1;
+}
+
+Cube MakeCube(const glm::vec3& position, float scale) {
+    Cube cube;
+    cube.Pose = {{0.0f, 0.0f, 0.0f, 1.0f}, {position.x, position.y, position.z}};
+    cube.Scale = {scale, scale, scale};
+    return cube;
+}
+
+double AngularSize(const Cube& cube) {
+    const glm::vec3 p(cube.Pose.position.x, cube.Pose.position.y, cube.Pose.position.z);
+    return BoundingRadius * cube.Scale.x / glm::length(p);
+}
+
+// The selector's demand, in double, for a gaze eccentricity (radians) from the cube's center.
+double Demand(const Cube& cube, double eccentricity) {
+    const double size = AngularSize(cube);
+    const double chord = 2.0 * std::sin(0.5 * eccentricity);
+    return size / (1.0 + std::max(0.0, chord - size) / LodSelector::FoveaRadians);
+}
+
+// Gaze direction from the origin at the given eccentricity from the cube's center.
+PxrVector3f GazeAt(const Cube& cube, double eccentricity) {
+    const glm::vec3 toCube = glm::normalize(glm::vec3(cube.Pose.position.x, cube.Pose.position.y, cube.Pose.position.z));
+    const glm::vec3 axis = glm::normalize(glm::cross(toCube, glm::vec3(0.0f, 1.0f, 0.0f)));
+    const glm::vec3 d = glm::angleAxis((float)eccentricity, axis) * toCube;
+    return {d.x, d.y, d.z};
+}
+
+// The eccentricity at which the cube's demand is the given one; 0 if it is never that high.
+double EccentricityFor(const Cube& cube, double demand) {
+    const double size = AngularSize(cube);
+    if (demand >= size) {
+        return 0.0;
+    }
+    const double chord = LodSelector::FoveaRadians * (size / demand - 1.0) + size;
+    return 2.0 * std::asin(std::min(1.0, 0.5 * chord));
+}
+
+uint32_t ExpectedLod(double demand) {
+    uint32_t lod = 0;
+    for (float threshold : LodSelector::Thresholds) {
+        lod += demand < threshold ? 1 : 0;
+    }
+    return lod;
+}
+
+// Whether demand is clear of every hysteresis band, where the LOD depends on history.
+bool OutsideBands(double demand) {
+    for (float threshold : LodSelector::Thresholds) {
+        if (std::fabs(demand / threshold - 1.0) < LodSelector::Hysteresis + 0.01) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t SelectOnce(const Cube& cube, const PxrVector3f& direction) {
+    LodSelector selector;
+    selector.SetLods(LodTriangles, LodCount, LodTriangles[0]);
+    std::vector<Cube> cubes = {cube};
+    selector.Select(cubes, Origin, direction);
+    return cubes[0].Lod;
+}
+
+void CheckEccentricity() {
+    const Cube cube = MakeCube({0.3f, -0.2f, -2.0f}, 0.3f);
+    int checked = 0, mismatches = 0, reversals = 0;
+    uint32_t previous = 0;
+    for (double degrees = 0.0; degrees <= 60.0; degrees += 0.25) {
+        const double eccentricity = degrees * M_PI / 180.0;
+        const uint32_t lod = SelectOnce(cube, GazeAt(cube, eccentricity));
+        reversals += lod < previous ? 1 : 0;
+        previous = lod;
+        if (OutsideBands(Demand(cube, eccentricity))) {
+            mismatches += lod != ExpectedLod(Demand(cube, eccentricity)) ? 1 : 0;
+            checked++;
+        }
+    }
+    Check(mismatches == 0 && reversals == 0 && previous == LodCount - 1,
+          Fmt("eccentricity 0-60 degrees: %d/%d LODs as the thresholds say, coarser further out, coarsest at the edge",
+              checked - mismatches, checked));
+}
+
+void CheckSize() {
+    const double eccentricity = 5.0 * M_PI / 180.0;
+    int checked = 0, mismatches = 0, reversals = 0;
+    uint32_t previous = LodCount - 1;
+    for (float scale = 0.01f; scale <= 2.0f; scale *= 1.05f) {
+        const Cube cube = MakeCube({0.0f, 0.0f, -3.0f}, scale);
+        const uint32_t lod = SelectOnce(cube, GazeAt(cube, eccentricity));
+        reversals += lod > previous ? 1 : 0;
+        previous = lod;
+        if (OutsideBands(Demand(cube, eccentricity))) {
+            mismatches += lod != ExpectedLod(Demand(cube, eccentricity)) ? 1 : 0;
+            checked++;
+        }
+    }
+    Check(mismatches == 0 && reversals == 0 && previous == 0,
+          Fmt("size 0.01-2 m at 5 degrees: %d/%d LODs as the thresholds say, finer when bigger, finest at the top",
+              checked - mismatches, checked));
+}
+
+// Demand walks across each threshold: swings of 18% around it keep the LOD, 30% moves it.
+void CheckHysteresis() {
+    const Cube cube = MakeCube({0.0f, 0.0f, -2.0f}, 0.5f);
+    for (uint32_t k = 0; k + 1 < LodCount; k++) {
+        const double threshold = LodSelector::Thresholds[k];
+        LodSelector selector;
+        selector.SetLods(LodTriangles, LodCount, LodTriangles[0]);
+        std::vector<Cube> cubes = {cube};
+        auto select = [&](double demand) {
+            selector.Select(cubes, Origin, GazeAt(cube, EccentricityFor(cube, demand)));
+            return cubes[0].Lod;
+        };
+
+        bool ok = select(threshold * 1.3) == k;
+        int switches = 0;
+        for (int frame = 0; frame < 100; frame++) {
+            switches += select(threshold * (frame % 2 ? 1.18 : 0.82)) != k ? 1 : 0;
+        }
+        ok &= select(threshold * 0.7) == k + 1;
+        for (int frame = 0; frame < 100; frame++) {
+            switches += select(threshold * (frame % 2 ? 1.18 : 0.82)) != k + 1 ? 1 : 0;
+        }
+        ok &= select(threshold * 1.3) == k;
+        Check(ok && switches == 0, Fmt("threshold %.3f: no popping within +-18%%, switches beyond 30%% (%d pops)",
+                                       threshold, switches));
+    }
+}
+
+void CheckScalar() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::vector<Cube> cubes;
+    for (int i = 0; i < 1001; i++) {  // not a multiple of 4, so the padding is used
+        cubes.push_back(MakeCube({uniform(rng) * 4.0f, uniform(rng) * 2.0f, -0.5f - 6.0f * (uniform(rng) + 1.0f)},
+                                 0.05f + 0.2f * (uniform(rng) + 1.0f)));
+    }
+    std::vector<Cube> scalarCubes = cubes;
+    LodSelector selector;
+    selector.SetLods(LodTriangles, LodCount, LodTriangles[0]);
+    ScalarSetLods(LodTriangles, LodCount, LodTriangles[0]);
+
+    glm::vec3 gaze(0.0f, 0.0f, -1.0f);
+    uint64_t compared = 0, mismatches = 0, switches = 0;
+    uint64_t lodUse[LodCount] = {};
+    for (int frame = 0; frame < 300; frame++) {
+        gaze = glm::normalize(gaze + 0.05f * glm::vec3(uniform(rng), uniform(rng), 0.2f * uniform(rng)));
+        if (gaze.z > -0.5f) {
+            gaze = glm::normalize(glm::vec3(0.0f, 0.0f, -1.0f) + 0.1f * gaze);
+        }
+        const PxrVector3f direction = {gaze.x, gaze.y, gaze.z};
+        const std::vector<Cube> previous = cubes;
+        selector.Select(cubes, Origin, direction);
+        ScalarSelect(scalarCubes, Origin, direction);
+        for (size_t i = 0; i < cubes.size(); i++) {
+            mismatches += cubes[i].Lod != scalarCubes[i].Lod ? 1 : 0;
+            switches += frame > 0 && cubes[i].Lod != previous[i].Lod ? 1 : 0;
+            lodUse[cubes[i].Lod]++;
+            compared++;
+        }
+    }
+    Check(mismatches == 0 && switches > 0 && lodUse[0] > 0 && lodUse[LodCount - 1] > 0,
+          Fmt("vector and plain loops agree on %llu/%llu selections (%llu switches, LOD use %llu/%llu/%llu/%llu)",
+              (unsigned long long)(compared - mismatches), (unsigned long long)compared, (unsigned long long)switches,
+              (unsigned long long)lodUse[0], (unsigned long long)lodUse[1], (unsigned long long)lodUse[2],
+              (unsigned long long)lodUse[3]));
+}
+}  // namespace
+
+int main() {
+    Log::SetLevel(Log::Level::Warning);
+    CheckEccentricity();
+    CheckSize();
+    CheckHysteresis();
+    CheckScalar();
+    return g_failures == 0 ? 0 : 1;
+}
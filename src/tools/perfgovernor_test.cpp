@@ -0,0 +1,174 @@
+// etvr_perfgovernor_test: drives the performance governor (perfgovernor.h) with a stand-in
+// device and synthetic frame timings at 72 Hz.
+//
+//     etvr_perfgovernor_test
+//
+// Frames that miss vsyncs clock up whichever of CPU and GPU is the bottleneck, one window
+// after the settling one. With the GPU at its thermal cap, they lower render scale step by
+// step, then MSAA, and nothing below the limits. Headroom restores MSAA, then render scale,
+// then clocks down, each only after three headroom windows in a row; a window with a
+// missed frame starts the count over. The device is checked to see every level the
+// governor settles on.
+#include "common.h"
+#include "perfgovernor.h"
+
+namespace {
+constexpr uint64_t FrameNs = 1000000000 / 72;
+
+// Misses every other vsync with the GPU, or the CPU, over budget; or well within it.
+const FrameTiming GpuBound = {2 * FrameNs, 6000000, 16000000};
+const FrameTiming CpuBound = {2 * FrameNs, 16000000, 6000000};
+const FrameTiming Headroom = {FrameNs, 4000000, 5000000};
+
+int g_failures = 0;
+
+void Check(bool condition, const std::string& what) {
+    printf("%s: %s\n", condition ? "ok" : "FAILED", what.c_str());
+    g_failures += condition ? 0 : 1;
+}
+
+class FakePerfDevice : public IPerfDevice {
+public:
+    int SetPerformanceLevel(PxrPerfSettings which, int level) override {
+        m_levels[which] = level;
+        return PXR_RET_SUCCESS;
+    }
+    int GetPerformanceLevel(PxrPerfSettings which, int* level) override {
+        *level = m_levels[which];
+        return PXR_RET_SUCCESS;
+    }
+    int GetDisplayRefreshRate(float* refreshRate) override {
+        *refreshRate = 72.0f;
+        return PXR_RET_SUCCESS;
+    }
+
+    int Level(PxrPerfSettings which) const { return m_levels[which]; }
+
+private:
+    int m_levels[3] = {-1, -1, -1};  // indexed by PxrPerfSettings
+};
+
+PerfState MakeState(int cpuLevel, int gpuLevel, int samples, float renderScale) {
+    PerfState state;
+    state.cpuLevel = cpuLevel;
+    state.gpuLevel = gpuLevel;
+    state.samples = samples;
+    state.renderScale = renderScale;
+    return state;
+}
+
+std::string Describe(const PerfState& state) {
+    return Fmt("cpu %d gpu %d msaa %d scale %.2f", state.cpuLevel, state.gpuLevel, state.samples, state.renderScale);
+}
+
+// Feeds windows of the given timing until State() changes; returns the window it changed
+// in, counting from 1, or 0 if it did not within maxWindows.
+int WindowsToChange(PerfGovernor* governor, const FrameTiming& timing, int maxWindows) {
+    for (int window = 1; window <= maxWindows; window++) {
+        bool changed = false;
+        for (int frame = 0; frame < PerfGovernor::WindowFrames; frame++) {
+            changed |= governor->AddFrame(timing);
+        }
+        if (changed) {
+            return window;
+        }
+    }
+    return 0;
+}
+
+// The next change has to come in the given window and be to the given state, which the
+// device has to be at.
+void ExpectChange(PerfGovernor* governor, const FakePerfDevice& device, const FrameTiming& timing, int window,
+                  const PerfState& expected, const char* what) {
+    const int changedIn = WindowsToChange(governor, timing, 10);
+    const PerfState& state = governor->State();
+    Check(changedIn == window && state == expected && device.Level(PXR_PERF_SETTINGS_CPU) == state.cpuLevel &&
+              device.Level(PXR_PERF_SETTINGS_GPU) == state.gpuLevel,
+          Fmt("%s: %s in window %d (expected %s in window %d)", what, Describe(state).c_str(), changedIn,
+              Describe(expected).c_str(), window));
+}
+
+void CheckBottleneck() {
+    auto device = std::make_shared<FakePerfDevice>();
+    PerfGovernor governor(device);
+    governor.Start();
+    Check(device->Level(PXR_PERF_SETTINGS_CPU) == PXR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH &&
+              device->Level(PXR_PERF_SETTINGS_GPU) == PXR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH &&
+              governor.TargetFrameNs() == FrameNs,
+          "start: both clocks applied at sustained high, 72 Hz target");
+    // The first window after any change only settles.
+    ExpectChange(&governor, *device, GpuBound, 2,
+                 MakeState(PXR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH, PXR_PERF_SETTINGS_LEVEL_BOOST, 4, 1.0f),
+                 "gpu bound: gpu clocked up");
+    ExpectChange(&governor, *device, CpuBound, 2,
+                 MakeState(PXR_PERF_SETTINGS_LEVEL_BOOST, PXR_PERF_SETTINGS_LEVEL_BOOST, 4, 1.0f),
+                 "cpu bound: cpu clocked up");
+
+    // Without GPU timings, a missed frame with a fast CPU is the GPU's.
+    PerfGovernor blind(device);
+    blind.Start();
+    ExpectChange(&blind, *device, {2 * FrameNs, 6000000, 0}, 2,
+                 MakeState(PXR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH, PXR_PERF_SETTINGS_LEVEL_BOOST, 4, 1.0f),
+                 "no gpu timings, fast cpu: gpu clocked up");
+}
+
+void CheckThermalCapAndRestore() {
+    auto device = std::make_shared<FakePerfDevice>();
+    PerfGovernor governor(device);
+    governor.Start();
+
+    PxrEventDataPerfSettings event = {};
+    event.type = PXR_TYPE_EVENT_DATA_PERF_SETTINGS_EXT;
+    event.domain = PXR_PERF_SETTINGS_DOMAIN_GPU;
+    event.subDomain = PXR_PERF_SETTINGS_SUB_DOMAIN_THERMAL;
+    event.fromLevel = PXR_PERF_SETTINGS_NOTIF_LEVEL_LOW;
+    event.toLevel = PXR_PERF_SETTINGS_NOTIF_LEVEL_HIGH;
+    governor.OnPerfSettings(event);
+    const bool lowered = device->Level(PXR_PERF_SETTINGS_GPU) == PXR_PERF_SETTINGS_LEVEL_SUSTAINED_LOW;
+    Check(lowered && governor.AddFrame(GpuBound), "thermal high: gpu lowered to its cap at once, the next frame told");
+
+    // At the cap, render scale goes down to its limit first, then MSAA.
+    const int cpu = PXR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH;
+    const int gpu = PXR_PERF_SETTINGS_LEVEL_SUSTAINED_LOW;
+    ExpectChange(&governor, *device, GpuBound, 2, MakeState(cpu, gpu, 4, 0.9f), "gpu capped: render scale");
+    ExpectChange(&governor, *device, GpuBound, 2, MakeState(cpu, gpu, 4, 0.8f), "gpu capped: render scale");
+    ExpectChange(&governor, *device, GpuBound, 2, MakeState(cpu, gpu, 4, 0.7f), "gpu capped: render scale");
+    ExpectChange(&governor, *device, GpuBound, 2, MakeState(cpu, gpu, 2, 0.7f), "render scale at limit: msaa");
+    ExpectChange(&governor, *device, GpuBound, 2, MakeState(cpu, gpu, 1, 0.7f), "render scale at limit: msaa");
+    Check(WindowsToChange(&governor, GpuBound, 10) == 0 && device->Level(PXR_PERF_SETTINGS_GPU) == gpu,
+          "everything at its limit: no further changes, gpu stays at its cap");
+
+    // Headroom counts only in whole runs of RelaxWindows: a window with one missed frame,
+    // not enough to be over budget, starts over.
+    WindowsToChange(&governor, Headroom, PerfGovernor::RelaxWindows - 1);
+    FrameTiming oneMiss = Headroom;
+    bool changed = false;
+    for (int frame = 0; frame < PerfGovernor::WindowFrames; frame++) {
+        oneMiss.intervalNs = frame == 0 ? 2 * FrameNs : FrameNs;
+        changed |= governor.AddFrame(oneMiss);
+    }
+    Check(!changed, "a window with one missed frame changes nothing");
+    ExpectChange(&governor, *device, Headroom, PerfGovernor::RelaxWindows, MakeState(cpu, gpu, 2, 0.7f),
+                 "headroom: msaa restored after three windows in a row");
+
+    // After each change, a settling window and three more of headroom.
+    const int window = PerfGovernor::RelaxWindows + 1;
+    ExpectChange(&governor, *device, Headroom, window, MakeState(cpu, gpu, 4, 0.7f), "headroom: msaa restored");
+    ExpectChange(&governor, *device, Headroom, window, MakeState(cpu, gpu, 4, 0.8f), "headroom: render scale");
+    ExpectChange(&governor, *device, Headroom, window, MakeState(cpu, gpu, 4, 0.9f), "headroom: render scale");
+    ExpectChange(&governor, *device, Headroom, window, MakeState(cpu, gpu, 4, 1.0f), "headroom: render scale");
+    ExpectChange(&governor, *device, Headroom, window,
+                 MakeState(cpu, PXR_PERF_SETTINGS_LEVEL_POWER_SAVINGS, 4, 1.0f),
+                 "quality restored: gpu clocked down first");
+    ExpectChange(&governor, *device, Headroom, window,
+                 MakeState(PXR_PERF_SETTINGS_LEVEL_SUSTAINED_LOW, PXR_PERF_SETTINGS_LEVEL_POWER_SAVINGS, 4, 1.0f),
+                 "then the cpu");
+}
+}  // namespace
+
+int main() {
+    Log::SetLevel(Log::Level::Warning);
+    CheckBottleneck();
+    CheckThermalCapAndRestore();
+    return g_failures == 0 ? 0 : 1;
+}
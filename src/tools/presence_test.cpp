@@ -0,0 +1,148 @@
+// etvr_presence_test: drives the presence state machine (presencemonitor.h) with synthetic
+// 120 Hz gaze samples and a synthetic clock.
+//
+//     etvr_presence_test
+//
+// Checks that it goes idle exactly EnterIdleNs after the last present sample and not
+// before, that blinks and tracking gaps shorter than that never make it idle, that one
+// present sample brings it back (OnSample() returning true to wake the loop), and that it
+// never goes idle before the first sample, however long Update() runs.
+#include "common.h"
+#include "presencemonitor.h"
+
+namespace {
+constexpr uint64_t SampleNs = 1000000000 / 120;
+
+int g_failures = 0;
+
+void Check(bool condition, const std::string& what) {
+    printf("%s: %s\n", condition ? "ok" : "FAILED", what.c_str());
+    g_failures += condition ? 0 : 1;
+}
+
+enum class Eyes { Open, Closed, Lost };
+
+GazeSample MakeSample(Eyes eyes) {
+    GazeSample sample = {};
+    if (eyes != Eyes::Lost) {
+        sample.combinedEyePoseStatus = GAZE_STATUS_GAZE_POINT_VALID | GAZE_STATUS_GAZE_VECTOR_VALID;
+        sample.leftEyePoseStatus = sample.rightEyePoseStatus = GAZE_STATUS_OPENNESS_VALID;
+        sample.leftEyeOpenness = sample.rightEyeOpenness = eyes == Eyes::Open ? 0.9f : 0.0f;
+    }
+    return sample;
+}
+
+// A sampler feeding one kind of sample and a main loop calling Update() once per sample
+// period, from *nowNs for durationNs. Returns the number of state changes.
+int Run(PresenceMonitor* monitor, Eyes eyes, uint64_t durationNs, uint64_t* nowNs, bool* woken = nullptr) {
+    int changes = 0;
+    const GazeSample sample = MakeSample(eyes);
+    for (const uint64_t endNs = *nowNs + durationNs; *nowNs < endNs; *nowNs += SampleNs) {
+        const bool wake = monitor->OnSample(sample, *nowNs);
+        if (woken != nullptr) {
+            *woken |= wake;
+        }
+        changes += monitor->Update(*nowNs) ? 1 : 0;
+    }
+    return changes;
+}
+
+void CheckNoSamples() {
+    PresenceMonitor monitor;
+    int changes = 0;
+    for (uint64_t nowNs = 0; nowNs < 60000000000ull; nowNs += SampleNs) {
+        changes += monitor.Update(nowNs) ? 1 : 0;
+    }
+    Check(changes == 0 && monitor.GetState() == PresenceMonitor::State::Active,
+          "never idle before the first sample (60 s of Update() alone)");
+}
+
+void CheckEnterIdle() {
+    PresenceMonitor monitor;
+    uint64_t nowNs = 1000000000;
+    Run(&monitor, Eyes::Open, 2000000000, &nowNs);
+    const uint64_t lastPresentNs = nowNs - SampleNs;
+    // Up to the last sample period before EnterIdleNs has passed, still active.
+    int changes = Run(&monitor, Eyes::Lost, PresenceMonitor::EnterIdleNs - SampleNs, &nowNs);
+    const bool activeBefore = changes == 0 && monitor.GetState() == PresenceMonitor::State::Active;
+    uint64_t idleNs = 0;
+    while (monitor.GetState() == PresenceMonitor::State::Active && nowNs < lastPresentNs + 2 * PresenceMonitor::EnterIdleNs) {
+        monitor.OnSample(MakeSample(Eyes::Lost), nowNs);
+        if (monitor.Update(nowNs)) {
+            idleNs = nowNs;
+        }
+        nowNs += SampleNs;
+    }
+    Check(activeBefore && idleNs >= lastPresentNs + PresenceMonitor::EnterIdleNs &&
+              idleNs < lastPresentNs + PresenceMonitor::EnterIdleNs + SampleNs,
+          Fmt("idle %.1f ms after the last present sample, EnterIdleNs is %.0f ms", (idleNs - lastPresentNs) / 1e6,
+              PresenceMonitor::EnterIdleNs / 1e6));
+
+    // Closed eyes keep it idle and do not wake the loop.
+    bool woken = false;
+    changes = Run(&monitor, Eyes::Closed, 1000000000, &nowNs, &woken);
+    Check(changes == 0 && !woken && monitor.GetState() == PresenceMonitor::State::Idle,
+          "closed eyes while idle: stays idle, no wakeup");
+
+    // One present sample: OnSample() asks for a wakeup, the next Update() restores.
+    const bool wake = monitor.OnSample(MakeSample(Eyes::Open), nowNs);
+    const bool changed = monitor.Update(nowNs + 1000000);
+    Check(wake && changed && monitor.GetState() == PresenceMonitor::State::Active,
+          "one present sample returns to active, OnSample() returns true");
+    nowNs += SampleNs;
+    woken = false;
+    changes = Run(&monitor, Eyes::Open, 1000000000, &nowNs, &woken);
+    Check(changes == 0 && !woken, "present samples while active ask for no wakeups");
+}
+
+void CheckBlinks() {
+    PresenceMonitor monitor;
+    uint64_t nowNs = 1000000000;
+    int changes = Run(&monitor, Eyes::Open, 1000000000, &nowNs);
+    // Ordinary blinks, long ones and tracking gaps up to just under EnterIdleNs.
+    const uint64_t gapsNs[] = {150000000, 400000000, 1000000000, PresenceMonitor::EnterIdleNs - 2 * SampleNs};
+    for (uint64_t gapNs : gapsNs) {
+        changes += Run(&monitor, Eyes::Closed, gapNs, &nowNs);
+        changes += Run(&monitor, Eyes::Open, 500000000, &nowNs);
+        changes += Run(&monitor, Eyes::Lost, gapNs, &nowNs);
+        changes += Run(&monitor, Eyes::Open, 500000000, &nowNs);
+    }
+    Check(changes == 0 && monitor.GetState() == PresenceMonitor::State::Active,
+          "blinks and tracking gaps shorter than EnterIdleNs never go idle");
+}
+
+void CheckFirstSample() {
+    // The first sample starts the clock even when nobody is there.
+    PresenceMonitor monitor;
+    uint64_t nowNs = 5000000000;
+    int changes = Run(&monitor, Eyes::Lost, PresenceMonitor::EnterIdleNs - SampleNs, &nowNs);
+    const bool activeBefore = changes == 0;
+    changes += Run(&monitor, Eyes::Lost, 2 * SampleNs, &nowNs);
+    Check(activeBefore && changes == 1 && monitor.GetState() == PresenceMonitor::State::Idle,
+          "without any present sample: idle EnterIdleNs after the first one");
+}
+
+void CheckIsPresent() {
+    GazeSample foveated = MakeSample(Eyes::Lost);
+    foveated.foveatedGazeTrackingState = 1;
+    GazeSample noOpenness = MakeSample(Eyes::Open);
+    noOpenness.leftEyePoseStatus = noOpenness.rightEyePoseStatus = 0;
+    noOpenness.leftEyeOpenness = noOpenness.rightEyeOpenness = 0.0f;
+    GazeSample oneEye = MakeSample(Eyes::Closed);
+    oneEye.rightEyeOpenness = PresenceMonitor::MinOpenness;
+    Check(PresenceMonitor::IsPresent(MakeSample(Eyes::Open)) && !PresenceMonitor::IsPresent(MakeSample(Eyes::Closed)) &&
+              !PresenceMonitor::IsPresent(MakeSample(Eyes::Lost)) && PresenceMonitor::IsPresent(foveated) &&
+              PresenceMonitor::IsPresent(noOpenness) && PresenceMonitor::IsPresent(oneEye),
+          "present: tracked with an eye open, or openness not reported");
+}
+}  // namespace
+
+int main() {
+    Log::SetLevel(Log::Level::Warning);
+    CheckIsPresent();
+    CheckNoSamples();
+    CheckEnterIdle();
+    CheckBlinks();
+    CheckFirstSample();
+    return g_failures == 0 ? 0 : 1;
+}
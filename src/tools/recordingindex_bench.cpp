@@ -0,0 +1,179 @@
+// etvr_recordingindex_bench: open and query times of the recording index (recordingindex.h)
+// on a large recording.
+//
+//     etvr_recordingindex_bench [-gb size] [-q queries] recording
+//
+// If the recording does not exist, a synthetic 1 kHz session of about size GB (10 by
+// default) is written there first: a pupil random walk, blinks every few seconds and a
+// short tracking loss every ten seconds. Opening it builds the index on the first run and
+// loads it after that. Then mean pupil and blink queries at random positions over 1 s,
+// 1 min, 1 h and the whole file report their time and the blocks they read. A few 1 s
+// queries are checked against the records read directly.
+#include "common.h"
+#include "gazerecording.h"
+#include "recordingindex.h"
+
+#include <fcntl.h>
+#include <random>
+
+namespace {
+class Generator {
+public:
+    void Next(RecordedSample* record) {
+        memset(record, 0, sizeof(*record));
+        m_timeNs += 1000000 + (m_rng() % 3) * 1000;
+        m_pupil = std::min(6.0f, std::max(2.0f, m_pupil + ((int)(m_rng() % 2001) - 1000) * 1e-5f));
+        if (m_timeNs >= m_nextBlinkNs) {
+            m_blinkEndNs = m_timeNs + 50000000ull + m_rng() % 600000000ull;
+            m_nextBlinkNs = m_blinkEndNs + 1500000000ull + m_rng() % 4000000000ull;
+        }
+        const bool lost = (m_timeNs / 1000000) % 10007 < 20;
+        const float openness = m_timeNs < m_blinkEndNs ? 0.02f : 0.9f;
+
+        GazeSample& gaze = record->gaze;
+        gaze.timestampNs = m_timeNs;
+        gaze.leftEyePoseStatus = gaze.rightEyePoseStatus =
+            lost ? 0 : GAZE_STATUS_GAZE_POINT_VALID | GAZE_STATUS_GAZE_VECTOR_VALID | GAZE_STATUS_OPENNESS_VALID |
+                           GAZE_STATUS_PUPIL_DILATION_VALID;
+        gaze.combinedEyePoseStatus = lost ? 0 : GAZE_STATUS_GAZE_POINT_VALID | GAZE_STATUS_GAZE_VECTOR_VALID;
+        gaze.leftEyeOpenness = gaze.rightEyeOpenness = openness;
+        gaze.leftEyePupilDilation = m_pupil;
+        gaze.rightEyePupilDilation = m_pupil + 0.1f;
+        record->head.orientation[3] = 1.0f;
+        record->headValid = 1;
+    }
+
+private:
+    std::mt19937_64 m_rng{42};
+    uint64_t m_timeNs = 1000000000ull;
+    float m_pupil = 3.5f;
+    uint64_t m_nextBlinkNs = 2000000000ull;
+    uint64_t m_blinkEndNs = 0;
+};
+
+bool Generate(const std::string& path, uint64_t bytes) {
+    const uint64_t records = bytes / sizeof(RecordedSample);
+    const uint64_t startNs = MonotonicNs();
+    RecordingWriter writer;
+    if (!writer.Open(path, 0)) {
+        return false;
+    }
+    Generator generator;
+    RecordedSample record;
+    for (uint64_t i = 0; i < records; i++) {
+        generator.Next(&record);
+        writer.Append(record);
+    }
+    writer.Close();
+    printf("wrote %llu records to %s in %.1f s\n", (unsigned long long)records, path.c_str(),
+           (MonotonicNs() - startNs) / 1e9);
+    return true;
+}
+
+// Left pupil over [fromNs, toNs) from the records themselves.
+bool ScanPupil(int fd, const RecordingIndex& index, uint64_t fromNs, uint64_t toNs, RecordingIndex::Stats* stats) {
+    const uint64_t first = index.FindRecord(fromNs);
+    const uint64_t end = index.FindRecord(toNs);
+    std::vector<RecordedSample> records(end - first);
+    const size_t bytes = records.size() * sizeof(RecordedSample);
+    if (pread(fd, records.data(), bytes, sizeof(RecordingHeader) + first * sizeof(RecordedSample)) != (ssize_t)bytes) {
+        return false;
+    }
+    *stats = {};
+    for (const RecordedSample& record : records) {
+        if (record.gaze.leftEyePoseStatus & GAZE_STATUS_PUPIL_DILATION_VALID) {
+            stats->Add(record.gaze.leftEyePupilDilation);
+        }
+    }
+    return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Log::SetLevel(Log::Level::Warning);
+    double gigabytes = 10.0;
+    int queries = 50;
+    std::string path;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-gb" && i + 1 < argc) {
+            gigabytes = std::max(0.001, atof(argv[++i]));
+        } else if (arg == "-q" && i + 1 < argc) {
+            queries = std::max(1, atoi(argv[++i]));
+        } else if (path.empty() && !arg.empty() && arg[0] != '-') {
+            path = arg;
+        } else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty()) {
+        fprintf(stderr, "usage: etvr_recordingindex_bench [-gb size] [-q queries] recording\n");
+        return 2;
+    }
+    if (access(path.c_str(), F_OK) != 0 && !Generate(path, (uint64_t)(gigabytes * 1e9))) {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        return 1;
+    }
+
+    const bool hadIndex = access(RecordingIndex::IndexPath(path).c_str(), F_OK) == 0;
+    RecordingIndex index;
+    uint64_t startNs = MonotonicNs();
+    if (!index.Open(path) || index.Records() == 0) {
+        fprintf(stderr, "cannot open %s\n", path.c_str());
+        return 1;
+    }
+    const uint64_t durationNs = index.LastNs() - index.FirstNs();
+    printf("open (%s index) %.2f ms: %llu records, %.1f h, %zu levels\n", hadIndex ? "loading the" : "building the",
+           (MonotonicNs() - startNs) / 1e6, (unsigned long long)index.Records(), durationNs / 3.6e12, index.Levels());
+
+    std::mt19937_64 rng(11);
+    const uint64_t spans[] = {1000000000ull, 60000000000ull, 3600000000000ull, durationNs};
+    const char* const names[] = {"1 s", "1 min", "1 h", "whole file"};
+    for (size_t k = 0; k < ArraySize(spans); k++) {
+        const uint64_t span = std::min(spans[k], durationNs);
+        double queryMs = 0.0, worstQueryMs = 0.0, blinkMs = 0.0, worstBlinkMs = 0.0;
+        size_t blinkCount = 0;
+        const uint64_t blocksBefore = index.BlocksRead();
+        for (int q = 0; q < queries; q++) {
+            const uint64_t fromNs = index.FirstNs() + (span < durationNs ? rng() % (durationNs - span) : 0);
+            RecordingIndex::Stats stats;
+            startNs = MonotonicNs();
+            index.Query(RecordingIndex::LeftPupil, fromNs, fromNs + span, &stats);
+            const double ms = (MonotonicNs() - startNs) / 1e6;
+            queryMs += ms;
+            worstQueryMs = std::max(worstQueryMs, ms);
+
+            std::vector<RecordingIndex::Blink> blinks;
+            startNs = MonotonicNs();
+            index.Blinks(fromNs, fromNs + span, &blinks);
+            const double blinksMs = (MonotonicNs() - startNs) / 1e6;
+            blinkMs += blinksMs;
+            worstBlinkMs = std::max(worstBlinkMs, blinksMs);
+            blinkCount += blinks.size();
+        }
+        printf("%-10s mean pupil: avg %.2f ms max %.2f ms | blinks: avg %.2f ms max %.2f ms, %.1f per query | "
+               "%.1f blocks read/query\n",
+               names[k], queryMs / queries, worstQueryMs, blinkMs / queries, worstBlinkMs, (double)blinkCount / queries,
+               (double)(index.BlocksRead() - blocksBefore) / (2 * queries));
+    }
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    int mismatches = 0;
+    const int checks = 20;
+    for (int i = 0; i < checks && fd >= 0; i++) {
+        const uint64_t span = std::min(spans[0], durationNs);
+        const uint64_t fromNs = index.FirstNs() + (span < durationNs ? rng() % (durationNs - span) : 0);
+        RecordingIndex::Stats indexed, scanned;
+        const bool same = index.Query(RecordingIndex::LeftPupil, fromNs, fromNs + span, &indexed) &&
+                          ScanPupil(fd, index, fromNs, fromNs + span, &scanned) && indexed.count == scanned.count &&
+                          std::fabs(indexed.Mean() - scanned.Mean()) < 1e-6;
+        mismatches += same ? 0 : 1;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    const bool ok = fd >= 0 && mismatches == 0;
+    printf("1 s queries against the records: %d/%d match (%s)\n", checks - mismatches, checks, ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,469 @@
+// etvr_reprocess: runs gaze recordings (gazerecording.h) back through the app's gaze
+// pipeline on a desktop machine, to re-derive events and depth after the classification
+// or filter code changed.
+//
+//     etvr_reprocess [-j threads] [-o output dir] [-p name=value ...] <recording dir>
+//
+// Every <name>.etrec in the directory gets a <name>.etproc beside it (or in the output
+// directory): a ProcessedHeader followed by one ProcessedSample per recorded sample, and a
+// summary line on stdout. -p sets one of the GazeMetricsParameters or VergenceParameters,
+// by the names in ParameterFlags; the usage message lists them with their defaults.
+//
+// Recordings are memory-mapped and cut into blocks of BlockSamples, which all threads take
+// in turn across files. Each block runs its own pipeline, first over the WarmupNs of
+// samples before it (twice blinkMaxNs if that is longer): event classification only looks
+// back one sample (a blink at most blinkMaxNs), so it comes out as in one pass over the
+// file, and the vergence filter has long converged to the same estimate. Finished blocks
+// are written out in order as soon as the ones before them are.
+//
+// Recordings hold no gaze picks, so the vergence filter gets pickedDistances == nullptr:
+// depths here are from vergence alone and differ from the app's, which fuse the distance
+// to the picked object where there is one.
+#include "common.h"
+#include "gazemetrics.h"
+#include "gazerecording.h"
+#include "vergence.h"
+
+#include <atomic>
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+const uint64_t BlockSamples = 1 << 16;
+const uint64_t WarmupNs = 2000000000;
+const size_t BatchSamples = 256;  // gathered for the vergence estimator at a time
+const size_t OutputBufferBytes = 1 << 20;
+const char* const RecordingSuffix = ".etrec";
+const char* const OutputSuffix = ".etproc";
+
+// The output is this header followed by ProcessedSamples, one per recorded sample.
+struct ProcessedHeader {
+    static constexpr uint32_t Magic = 0x52505445;  // 'ETPR'
+    static constexpr uint32_t Version = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+    uint64_t startNs;  // of the recording
+    uint64_t reserved2[5];
+};
+static_assert(sizeof(ProcessedHeader) == 64, "the output header is part of the file format");
+
+struct ProcessedSample {
+    uint64_t timestampNs;
+    float direction[3];  // combined gaze as recorded, head frame
+    float diopters;      // VergenceDepth::diopters, 0 without a vergence measurement yet
+    float depth;         // meters
+    float confidence;    // of this sample's own vergence
+    uint8_t event;       // GazeMetrics::Event
+    uint8_t reserved[7];
+};
+static_assert(sizeof(ProcessedSample) == 40, "the output record is part of the file format");
+
+struct Recording {
+    std::string path;
+    std::string outputPath;
+    int fd = -1;
+    void* map = MAP_FAILED;
+    size_t mapBytes = 0;
+    const RecordedSample* samples = nullptr;
+    uint64_t count = 0;
+    uint64_t startNs = 0;
+
+    std::mutex lock;
+    FILE* output = nullptr;
+    bool failed = false;
+    uint64_t blocks = 0;
+    uint64_t blocksDone = 0;
+    uint64_t nextBlock = 0;  // to write
+    std::map<uint64_t, std::vector<ProcessedSample>> pending;
+    uint64_t events[GazeMetrics::Closed + 1] = {};
+    uint64_t fixations = 0;
+    uint64_t blinks = 0;
+};
+
+struct Parameters {
+    GazeMetricsParameters metrics;
+    VergenceParameters vergence;
+};
+
+// -p names; durations are in milliseconds.
+struct ParameterFlag {
+    const char* name;
+    double (*get)(const Parameters&);
+    void (*set)(Parameters*, double);
+};
+
+const ParameterFlag ParameterFlags[] = {
+    {"window_ms", [](const Parameters& p) { return p.metrics.windowNs / 1e6; },
+     [](Parameters* p, double v) { p->metrics.windowNs = (uint64_t)(v * 1e6); }},
+    {"saccade_deg_per_s", [](const Parameters& p) { return p.metrics.saccadeDegreesPerSecond; },
+     [](Parameters* p, double v) { p->metrics.saccadeDegreesPerSecond = v; }},
+    {"max_gap_ms", [](const Parameters& p) { return p.metrics.maxGapNs / 1e6; },
+     [](Parameters* p, double v) { p->metrics.maxGapNs = (uint64_t)(v * 1e6); }},
+    {"min_fixation_samples", [](const Parameters& p) { return (double)p.metrics.minFixationSamples; },
+     [](Parameters* p, double v) { p->metrics.minFixationSamples = (uint32_t)v; }},
+    {"closed_openness", [](const Parameters& p) { return (double)p.metrics.closedOpenness; },
+     [](Parameters* p, double v) { p->metrics.closedOpenness = (float)v; }},
+    {"blink_min_ms", [](const Parameters& p) { return p.metrics.blinkMinNs / 1e6; },
+     [](Parameters* p, double v) { p->metrics.blinkMinNs = (uint64_t)(v * 1e6); }},
+    {"blink_max_ms", [](const Parameters& p) { return p.metrics.blinkMaxNs / 1e6; },
+     [](Parameters* p, double v) { p->metrics.blinkMaxNs = (uint64_t)(v * 1e6); }},
+    {"max_diopters", [](const Parameters& p) { return (double)p.vergence.maxDiopters; },
+     [](Parameters* p, double v) { p->vergence.maxDiopters = (float)v; }},
+    {"max_depth", [](const Parameters& p) { return (double)p.vergence.maxDepth; },
+     [](Parameters* p, double v) { p->vergence.maxDepth = (float)v; }},
+    {"measurement_noise", [](const Parameters& p) { return (double)p.vergence.measurementNoise; },
+     [](Parameters* p, double v) { p->vergence.measurementNoise = (float)v; }},
+    {"pick_noise", [](const Parameters& p) { return (double)p.vergence.pickNoise; },
+     [](Parameters* p, double v) { p->vergence.pickNoise = (float)v; }},
+    {"process_noise", [](const Parameters& p) { return (double)p.vergence.processNoise; },
+     [](Parameters* p, double v) { p->vergence.processNoise = (float)v; }},
+    {"min_confidence", [](const Parameters& p) { return (double)p.vergence.minConfidence; },
+     [](Parameters* p, double v) { p->vergence.minConfidence = (float)v; }},
+};
+
+// Applies one name=value; false for an unknown name or a value that is not a positive number.
+bool SetParameter(const std::string& assignment, Parameters* parameters) {
+    const size_t equals = assignment.find('=');
+    if (equals == std::string::npos) {
+        return false;
+    }
+    const std::string name = assignment.substr(0, equals);
+    char* end = nullptr;
+    const double value = strtod(assignment.c_str() + equals + 1, &end);
+    if (end == assignment.c_str() + equals + 1 || *end != '\0' || !(value > 0.0)) {
+        return false;
+    }
+    for (const ParameterFlag& flag : ParameterFlags) {
+        if (name == flag.name) {
+            flag.set(parameters, value);
+            return true;
+        }
+    }
+    return false;
+}
+
+struct WorkItem {
+    Recording* recording;
+    uint64_t block;
+};
+
+struct Totals {
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> files{0};
+};
+
+bool EndsWith(const std::string& s, const char* suffix) {
+    const size_t length = strlen(suffix);
+    return s.size() > length && s.compare(s.size() - length, length, suffix) == 0;
+}
+
+std::vector<std::string> ListRecordings(const std::string& dir) {
+    std::vector<std::string> names;
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) {
+        Log::Write(Log::Level::Error, Fmt("Cannot open %s: %s", dir.c_str(), strerror(errno)));
+        return names;
+    }
+    while (const dirent* entry = readdir(d)) {
+        if (EndsWith(entry->d_name, RecordingSuffix)) {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+void Unmap(Recording* recording) {
+    if (recording->map != MAP_FAILED) {
+        munmap(recording->map, recording->mapBytes);
+        recording->map = MAP_FAILED;
+    }
+    if (recording->fd >= 0) {
+        close(recording->fd);
+        recording->fd = -1;
+    }
+}
+
+bool Map(Recording* recording) {
+    recording->fd = open(recording->path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (recording->fd < 0 || fstat(recording->fd, &st) != 0) {
+        Log::Write(Log::Level::Warning, Fmt("Cannot open %s: %s", recording->path.c_str(), strerror(errno)));
+        Unmap(recording);
+        return false;
+    }
+    if ((uint64_t)st.st_size < sizeof(RecordingHeader)) {
+        Log::Write(Log::Level::Warning, Fmt("%s is not a recording", recording->path.c_str()));
+        Unmap(recording);
+        return false;
+    }
+    recording->mapBytes = (size_t)st.st_size;
+    recording->map = mmap(nullptr, recording->mapBytes, PROT_READ, MAP_PRIVATE, recording->fd, 0);
+    if (recording->map == MAP_FAILED) {
+        Log::Write(Log::Level::Warning, Fmt("Cannot map %s: %s", recording->path.c_str(), strerror(errno)));
+        Unmap(recording);
+        return false;
+    }
+    madvise(recording->map, recording->mapBytes, MADV_SEQUENTIAL);
+    const RecordingHeader* header = (const RecordingHeader*)recording->map;
+    if (!header->Valid()) {
+        Log::Write(Log::Level::Warning, Fmt("%s is not a recording of this version", recording->path.c_str()));
+        Unmap(recording);
+        return false;
+    }
+    recording->startNs = header->startNs;
+    recording->samples = (const RecordedSample*)((const uint8_t*)recording->map + sizeof(RecordingHeader));
+    // A trailing partial record is dropped, as RecordingIndex does.
+    recording->count = (recording->mapBytes - sizeof(RecordingHeader)) / sizeof(RecordedSample);
+    recording->blocks = (recording->count + BlockSamples - 1) / BlockSamples;
+    return true;
+}
+
+bool OpenOutput(Recording* recording) {
+    recording->output = fopen(recording->outputPath.c_str(), "wb");
+    if (recording->output == nullptr) {
+        Log::Write(Log::Level::Warning, Fmt("Cannot create %s: %s", recording->outputPath.c_str(), strerror(errno)));
+        return false;
+    }
+    setvbuf(recording->output, nullptr, _IOFBF, OutputBufferBytes);
+    ProcessedHeader header = {};
+    header.magic = ProcessedHeader::Magic;
+    header.version = ProcessedHeader::Version;
+    header.recordSize = sizeof(ProcessedSample);
+    header.startNs = recording->startNs;
+    return fwrite(&header, sizeof(header), 1, recording->output) == 1;
+}
+
+void PrintSummary(const Recording& recording) {
+    const uint64_t count = std::max<uint64_t>(recording.count, 1);
+    const double minutes =
+        recording.count > 1 ? (recording.samples[recording.count - 1].gaze.timestampNs - recording.samples[0].gaze.timestampNs) / 60e9
+                            : 0.0;
+    printf("%s samples=%llu minutes=%.1f lost%%=%.1f fixation%%=%.1f saccade%%=%.1f closed%%=%.1f fixations=%llu "
+           "blinks/min=%.1f\n",
+           recording.path.c_str(), (unsigned long long)recording.count, minutes,
+           100.0 * recording.events[GazeMetrics::Lost] / count, 100.0 * recording.events[GazeMetrics::Fixation] / count,
+           100.0 * recording.events[GazeMetrics::Saccade] / count, 100.0 * recording.events[GazeMetrics::Closed] / count,
+           (unsigned long long)recording.fixations, minutes > 0.0 ? recording.blinks / minutes : 0.0);
+}
+
+// Runs one block through its own pipeline, warmed up on the samples before it.
+void ProcessBlock(const Recording& recording, uint64_t block, const Parameters& parameters,
+                  std::vector<ProcessedSample>* out, uint64_t* events, uint64_t* fixations, uint64_t* blinks) {
+    const RecordedSample* samples = recording.samples;
+    const uint64_t first = block * BlockSamples;
+    const uint64_t end = std::min(first + BlockSamples, recording.count);
+    uint64_t warmup = first;
+    if (first != 0) {
+        const uint64_t startNs = samples[first].gaze.timestampNs;
+        const uint64_t warmupNs = std::max(WarmupNs, 2 * parameters.metrics.blinkMaxNs);
+        const uint64_t fromNs = startNs > warmupNs ? startNs - warmupNs : 0;
+        warmup = std::lower_bound(samples, samples + first, fromNs,
+                                  [](const RecordedSample& s, uint64_t t) { return s.gaze.timestampNs < t; }) -
+                 samples;
+    }
+
+    GazeMetrics metrics(parameters.metrics);
+    VergenceEstimator vergence(parameters.vergence);
+    GazeSample batch[BatchSamples];
+    VergenceDepth depths[BatchSamples];
+    uint64_t fixationsBefore = 0;
+    uint64_t blinksBefore = 0;
+    out->resize(end - first);
+    for (uint64_t i = warmup; i < end;) {
+        // Batches never straddle the block start, so the counters can be read there.
+        const uint64_t batchEnd = std::min<uint64_t>(i + BatchSamples, i < first ? first : end);
+        const size_t n = (size_t)(batchEnd - i);
+        for (size_t k = 0; k < n; k++) {
+            batch[k] = samples[i + k].gaze;
+        }
+        vergence.Process(batch, n, nullptr, depths);
+        for (size_t k = 0; k < n; k++) {
+            const GazeMetrics::Event event = metrics.OnSample(batch[k]);
+            if (i + k < first) {
+                continue;
+            }
+            ProcessedSample& p = (*out)[i + k - first];
+            p = {};
+            p.timestampNs = batch[k].timestampNs;
+            memcpy(p.direction, batch[k].combinedEyeGazeVector, sizeof(p.direction));
+            p.diopters = depths[k].diopters;
+            p.depth = depths[k].depth;
+            p.confidence = depths[k].confidence;
+            p.event = event;
+            events[event]++;
+        }
+        i = batchEnd;
+        if (i == first) {
+            fixationsBefore = metrics.Fixations();
+            blinksBefore = metrics.Blinks();
+        }
+    }
+    *fixations = metrics.Fixations() - fixationsBefore;
+    *blinks = metrics.Blinks() - blinksBefore;
+}
+
+// Hands a finished block to its recording and writes out whatever is now in order.
+// Returns true when this was the recording's last block.
+bool FinishBlock(Recording* recording, uint64_t block, std::vector<ProcessedSample>&& out, const uint64_t* events,
+                 uint64_t fixations, uint64_t blinks) {
+    std::lock_guard<std::mutex> lock(recording->lock);
+    for (int e = 0; e <= GazeMetrics::Closed; e++) {
+        recording->events[e] += events[e];
+    }
+    recording->fixations += fixations;
+    recording->blinks += blinks;
+    recording->pending.emplace(block, std::move(out));
+    for (auto it = recording->pending.begin(); it != recording->pending.end() && it->first == recording->nextBlock;
+         it = recording->pending.erase(it)) {
+        const std::vector<ProcessedSample>& samples = it->second;
+        if (!recording->failed &&
+            fwrite(samples.data(), sizeof(ProcessedSample), samples.size(), recording->output) != samples.size()) {
+            Log::Write(Log::Level::Warning, Fmt("Writing %s failed", recording->outputPath.c_str()));
+            recording->failed = true;
+        }
+        recording->nextBlock++;
+    }
+    return ++recording->blocksDone == recording->blocks;
+}
+
+void Complete(Recording* recording, Totals* totals) {
+    if (fclose(recording->output) != 0) {
+        recording->failed = true;
+    }
+    recording->output = nullptr;
+    if (recording->failed) {
+        Log::Write(Log::Level::Warning, Fmt("Removing incomplete %s", recording->outputPath.c_str()));
+        remove(recording->outputPath.c_str());
+    }
+    PrintSummary(*recording);
+    totals->samples += recording->count;
+    totals->bytes += recording->mapBytes;
+    totals->files++;
+    Unmap(recording);
+}
+
+void Worker(std::vector<WorkItem>* items, std::atomic<size_t>* next, const Parameters* parameters, Totals* totals) {
+    std::vector<ProcessedSample> out;
+    for (size_t i = (*next)++; i < items->size(); i = (*next)++) {
+        Recording* recording = (*items)[i].recording;
+        const uint64_t block = (*items)[i].block;
+        uint64_t events[GazeMetrics::Closed + 1] = {};
+        uint64_t fixations = 0;
+        uint64_t blinks = 0;
+        ProcessBlock(*recording, block, *parameters, &out, events, &fixations, &blinks);
+        if (FinishBlock(recording, block, std::move(out), events, fixations, blinks)) {
+            Complete(recording, totals);
+        }
+        out = std::vector<ProcessedSample>();
+    }
+}
+
+void Usage() {
+    fprintf(stderr, "usage: etvr_reprocess [-j threads] [-o output dir] [-p name=value ...] <recording dir>\n"
+                    "parameters (default):\n");
+    const Parameters defaults;
+    for (const ParameterFlag& flag : ParameterFlags) {
+        fprintf(stderr, "    %-22s %g\n", flag.name, flag.get(defaults));
+    }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Log::SetLevel(Log::Level::Info);
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string inputDir;
+    std::string outputDir;
+    Parameters parameters;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            threads = (unsigned)std::max(1, atoi(argv[++i]));
+        } else if (arg == "-o" && i + 1 < argc) {
+            outputDir = argv[++i];
+        } else if (arg == "-p" && i + 1 < argc) {
+            if (!SetParameter(argv[++i], &parameters)) {
+                fprintf(stderr, "bad parameter %s\n", argv[i]);
+                Usage();
+                return 2;
+            }
+        } else if (arg[0] != '-' && inputDir.empty()) {
+            inputDir = arg;
+        } else {
+            Usage();
+            return 2;
+        }
+    }
+    if (inputDir.empty()) {
+        Usage();
+        return 2;
+    }
+    if (outputDir.empty()) {
+        outputDir = inputDir;
+    }
+    std::string used;
+    for (const ParameterFlag& flag : ParameterFlags) {
+        used += Fmt(" %s=%g", flag.name, flag.get(parameters));
+    }
+    Log::Write(Log::Level::Info, "Parameters:" + used);
+
+    const std::vector<std::string> names = ListRecordings(inputDir);
+    Totals totals;
+    std::vector<std::unique_ptr<Recording>> recordings;
+    std::vector<WorkItem> items;
+    for (const std::string& name : names) {
+        std::unique_ptr<Recording> recording(new Recording());
+        recording->path = inputDir + "/" + name;
+        recording->outputPath =
+            outputDir + "/" + name.substr(0, name.size() - strlen(RecordingSuffix)) + OutputSuffix;
+        if (!Map(recording.get())) {
+            continue;
+        }
+        if (!OpenOutput(recording.get())) {
+            Unmap(recording.get());
+            continue;
+        }
+        if (recording->blocks == 0) {
+            Complete(recording.get(), &totals);
+            continue;
+        }
+        for (uint64_t block = 0; block < recording->blocks; block++) {
+            items.push_back({recording.get(), block});
+        }
+        recordings.push_back(std::move(recording));
+    }
+    if (items.empty()) {
+        Log::Write(Log::Level::Warning, Fmt("No recordings with samples in %s", inputDir.c_str()));
+        return names.empty() ? 1 : 0;
+    }
+
+    const uint64_t startNs = MonotonicNs();
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    threads = (unsigned)std::min<size_t>(threads, items.size());
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back(Worker, &items, &next, &parameters, &totals);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const double seconds = std::max(1e-9, (MonotonicNs() - startNs) / 1e9);
+
+    bool failed = false;
+    for (const std::unique_ptr<Recording>& recording : recordings) {
+        failed |= recording->failed;
+    }
+    printf("%llu files, %llu samples in %.2f s on %u threads: %.3g samples/s, %.0f MB/s\n",
+           (unsigned long long)totals.files.load(), (unsigned long long)totals.samples.load(), seconds, threads,
+           totals.samples / seconds, totals.bytes / seconds / 1e6);
+    return failed ? 1 : 0;
+}